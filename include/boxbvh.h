@@ -0,0 +1,69 @@
+#ifndef _BOXBVH_H
+#define _BOXBVH_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "boxgrid.h"
+
+// Hierarquia de volumes envolventes (BVH) estática sobre as AABBs das caixas,
+// para os raycasts (tiros do jogador e dos inimigos). Veja "boxbvh.cpp".
+//
+// A árvore é construída uma única vez por BoxBVH_Build(), com a heurística
+// de área de superfície (SAH), e guardada "achatada" em um vetor: cada nó tem
+// até BOX_BVH_WIDTH filhos, com as AABBs dos filhos lado a lado (um vetor por
+// coordenada), para que um raio seja testado contra os quatro filhos de uma
+// vez com SSE2. Os nós ficam em profundidade, com os filhos logo depois do
+// pai. Cada caixa é um filho (folha) de algum nó.
+
+#define BOX_BVH_WIDTH 4       // Filhos por nó
+#define BOX_BVH_PACKET_SIZE 8 // Raios por pacote em BoxBVH_RaycastPacket()
+
+struct BoxBVHNode
+{
+    // AABBs dos filhos: bounds[0..2] são o mínimo em X, Y e Z e bounds[3..5]
+    // o máximo. Filhos vazios têm mínimo maior que o máximo (nenhum raio os
+    // atinge).
+    float bounds[6][BOX_BVH_WIDTH];
+
+    // > 0: índice do nó filho; < 0: caixa -(child + 1); 0: vazio (a raiz,
+    // nó 0, nunca é filho)
+    int32_t child[BOX_BVH_WIDTH];
+};
+
+struct BoxBVH
+{
+    std::vector<BoxBVHNode> nodes; // nodes[0] é a raiz; vazio se não há caixas
+    int depth;                     // Número de níveis
+
+    BoxBVH() : depth(0) {}
+};
+
+// (Re)constrói a árvore para as AABBs "aabbs" (BoxGrid::aabbs)
+void BoxBVH_Build(BoxBVH& bvh, const std::vector<BoxAABB>& aabbs);
+
+// Caixa mais próxima atingida pelo raio com 0 < t < max_distance, com o mesmo
+// resultado de RayAABBIntersection() em todas as caixas ("simulation.h").
+// Retorna false se não há nenhuma; senão armazena a distância em t.
+bool BoxBVH_Raycast(const BoxBVH& bvh, const glm::vec4& origin, const glm::vec4& direction,
+                    float max_distance, float& t);
+
+// BoxBVH_Raycast() para "count" (até BOX_BVH_PACKET_SIZE) raios de uma vez:
+// a árvore é percorrida uma única vez pelo pacote, visitando os nós que algum
+// dos raios atinge. Com raios coerentes (origens próximas e direções
+// parecidas) os raios atingem quase os mesmos nós, então cada nó é lido uma
+// vez por pacote em vez de uma vez por raio. Na entrada, t[i] é a distância
+// máxima do raio i; na saída, hit[i] diz se alguma caixa foi atingida e,
+// nesse caso, t[i] é a distância da mais próxima.
+void BoxBVH_RaycastPacket(const BoxBVH& bvh, const glm::vec4* origins, const glm::vec4* directions,
+                          int count, float* t, bool* hit);
+
+// true se alguma caixa é atingida com 0 < t <= max_distance. Para na
+// primeira encontrada, então é mais rápido que BoxBVH_Raycast() quando só
+// interessa se algo está bloqueando o raio.
+bool BoxBVH_Occluded(const BoxBVH& bvh, const glm::vec4& origin, const glm::vec4& direction,
+                     float max_distance);
+
+#endif // _BOXBVH_H
@@ -0,0 +1,56 @@
+#ifndef _BOXGRID_H
+#define _BOXGRID_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+// Grade uniforme com as caixas do mapa, para consultas de colisão que só
+// olham as caixas próximas. Veja "boxgrid.cpp".
+//
+// As caixas não se movem: a AABB de cada uma (conservadora, cobrindo
+// qualquer rotação em Y) é calculada uma única vez por BoxGrid_Build(), e a
+// caixa é inserida em todas as células do plano XZ que a AABB cobre. Uma
+// consulta visita só as células que a esfera consultada cobre. As células
+// ficam em "compressed sparse row": as caixas da célula c são
+// cell_boxes[cell_start[c]] até cell_boxes[cell_start[c + 1] - 1].
+//
+// A grade cobre os limites do mapa (MAP_MIN_X ... MAP_MAX_Z, em
+// "simulation.h"); o que estiver fora deles cai nas células da borda.
+
+#define BOX_GRID_CELL_SIZE 2.5f // Lado de uma célula, em unidades do mundo
+
+struct Box;
+
+// AABB de uma caixa em coordenadas do mundo
+struct BoxAABB
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct BoxGrid
+{
+    std::vector<BoxAABB> aabbs; // Uma por caixa, no mesmo índice de World::boxes
+
+    int   cells_x, cells_z;
+    float origin_x, origin_z;   // Canto da célula (0, 0)
+
+    std::vector<uint32_t> cell_start; // cells_x * cells_z + 1 posições em cell_boxes
+    std::vector<uint32_t> cell_boxes; // Índices das caixas de cada célula
+
+    BoxGrid() : cells_x(0), cells_z(0), origin_x(0.0f), origin_z(0.0f) {}
+};
+
+// AABB conservadora de uma caixa: a maior extensão horizontal possível
+// (diagonal do quadrado) em X e Z
+BoxAABB BoxGrid_ComputeAABB(const Box& box);
+
+// (Re)constrói a grade para "boxes"
+void BoxGrid_Build(BoxGrid& grid, const std::vector<Box>& boxes);
+
+// true se a esfera toca a AABB de alguma caixa
+bool BoxGrid_OverlapsSphere(const BoxGrid& grid, const glm::vec3& center, float radius);
+
+#endif // _BOXGRID_H
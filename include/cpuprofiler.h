@@ -0,0 +1,106 @@
+#ifndef _CPUPROFILER_H
+#define _CPUPROFILER_H
+
+// Profiler de CPU com zonas de tempo ("scoped zones"). Veja "cpuprofiler.cpp".
+//
+// Uma zona mede o tempo entre sua declaração e o fim do escopo onde foi
+// declarada:
+//
+//     void UpdateWaves(float delta_time)
+//     {
+//         CPU_PROFILE_ZONE("UpdateWaves");
+//         ...
+//     }
+//
+// e CPU_PROFILE_END_FRAME() fecha o quadro corrente (uma vez por iteração do
+// loop principal). As amostras são escritas em um ring buffer lock-free, então
+// zonas podem ser usadas de qualquer thread; CPU_PROFILE_THREAD_NAME(name) dá
+// um nome à thread corrente nos traces (veja "tracerecorder.h").
+//
+// CPU_PROFILE_ZONE_TEXT(name, text) também guarda um texto curto (ex.: o nome
+// do arquivo sendo carregado), copiado no momento em que a zona termina.
+//
+// Para compilar o programa sem o profiler, defina CPU_PROFILER_DISABLED (no
+// CMake: -DFCG_CPU_PROFILER=OFF). As macros passam a não gerar código algum.
+
+#define CPU_PROFILER_MAX_ZONES      32
+#define CPU_PROFILER_RING_SIZE      4096  // Amostras em trânsito (potência de 2)
+#define CPU_PROFILER_HISTORY_FRAMES 2048  // Quadros guardados
+#define CPU_PROFILER_WINDOW_SECONDS 5.0   // Janela das estatísticas mostradas
+#define CPU_PROFILER_MAX_THREADS    64
+#define CPU_PROFILER_DETAIL_LENGTH  48    // Tamanho máximo do texto de uma zona
+
+#ifndef CPU_PROFILER_DISABLED
+
+#include <cstddef>
+#include <cstdint>
+
+// Registra uma zona pelo nome (string com tempo de vida estático) e retorna
+// seu índice. Chamada uma única vez por CPU_PROFILE_ZONE (variável static).
+int CpuProfiler_RegisterZone(const char* name);
+
+// Tempo monotônico em nanossegundos
+uint64_t CpuProfiler_Now();
+
+// Insere uma amostra no ring buffer. "detail" pode ser NULL.
+void CpuProfiler_Record(int zone, uint64_t begin_ns, uint64_t end_ns, const char* detail = NULL);
+
+// Objeto que mede o tempo de vida do escopo onde foi declarado
+struct CpuProfilerScope
+{
+    int         zone;
+    uint64_t    begin_ns;
+    const char* detail;
+
+    explicit CpuProfilerScope(int zone, const char* detail = NULL)
+        : zone(zone), begin_ns(CpuProfiler_Now()), detail(detail) {}
+    ~CpuProfilerScope() { CpuProfiler_Record(zone, begin_ns, CpuProfiler_Now(), detail); }
+};
+
+// Índice da thread corrente (atribuído no primeiro uso) e nomes das threads
+int         CpuProfiler_ThreadIndex();
+void        CpuProfiler_SetThreadName(const char* name);
+int         CpuProfiler_ThreadCount();
+const char* CpuProfiler_ThreadName(int thread); // NULL se a thread não tem nome
+
+// Fecha o quadro: consome as amostras do ring buffer e mede o tempo do quadro.
+// Deve ser chamada sempre da mesma thread.
+void CpuProfiler_EndFrame();
+
+// Estatísticas dos quadros dos últimos CPU_PROFILER_WINDOW_SECONDS segundos
+int         CpuProfiler_ZoneCount();
+const char* CpuProfiler_ZoneName(int zone);
+double      CpuProfiler_ZoneAverageMs(int zone); // Média do tempo por quadro
+double      CpuProfiler_ZoneMaxMs(int zone);     // Maior tempo em um quadro
+void        CpuProfiler_FramePercentiles(double* p50_ms, double* p95_ms, double* p99_ms);
+int         CpuProfiler_DroppedSamples();        // Amostras perdidas (ring buffer cheio)
+
+// Copia para "frame_ms" os tempos dos últimos "max_frames" quadros, do mais
+// antigo para o mais recente. Retorna o número de quadros copiados.
+int CpuProfiler_RecentFrameTimes(float* frame_ms, int max_frames);
+
+#define CPU_PROFILER_CONCAT_(a, b) a##b
+#define CPU_PROFILER_CONCAT(a, b)  CPU_PROFILER_CONCAT_(a, b)
+
+#define CPU_PROFILE_ZONE(name) \
+    static const int CPU_PROFILER_CONCAT(cpu_profiler_zone_, __LINE__) = CpuProfiler_RegisterZone(name); \
+    CpuProfilerScope CPU_PROFILER_CONCAT(cpu_profiler_scope_, __LINE__)(CPU_PROFILER_CONCAT(cpu_profiler_zone_, __LINE__))
+
+#define CPU_PROFILE_ZONE_TEXT(name, text) \
+    static const int CPU_PROFILER_CONCAT(cpu_profiler_zone_, __LINE__) = CpuProfiler_RegisterZone(name); \
+    CpuProfilerScope CPU_PROFILER_CONCAT(cpu_profiler_scope_, __LINE__)(CPU_PROFILER_CONCAT(cpu_profiler_zone_, __LINE__), text)
+
+#define CPU_PROFILE_THREAD_NAME(name) CpuProfiler_SetThreadName(name)
+
+#define CPU_PROFILE_END_FRAME() CpuProfiler_EndFrame()
+
+#else // CPU_PROFILER_DISABLED
+
+#define CPU_PROFILE_ZONE(name)            do {} while (0)
+#define CPU_PROFILE_ZONE_TEXT(name, text) do {} while (0)
+#define CPU_PROFILE_THREAD_NAME(name)     do {} while (0)
+#define CPU_PROFILE_END_FRAME()           do {} while (0)
+
+#endif // CPU_PROFILER_DISABLED
+
+#endif // _CPUPROFILER_H
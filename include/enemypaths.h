@@ -0,0 +1,96 @@
+#ifndef _ENEMYPATHS_H
+#define _ENEMYPATHS_H
+
+#include <cstddef>
+#include <vector>
+
+// Movimento dos inimigos ao longo das curvas Bezier cúbicas, em "structure of
+// arrays". Veja "enemypaths.cpp".
+//
+// Cada campo é um vetor contíguo com um valor por inimigo: o inimigo i de
+// World::enemies usa a posição i de todos os vetores. Só o que é lido a cada
+// tick para mover os inimigos fica aqui, inclusive a posição e a direção, que
+// não são copiadas para Enemy; o resto (vida, tiro) continua em Enemy e os
+// raycasts de debug em World::enemy_raycasts.
+//
+// Cada curva tem uma tabela de comprimento de arco, calculada uma vez por
+// EnemyPaths_SetCurve(): o comprimento da curva de 0 até t = k /
+// ENEMY_PATHS_ARC_SAMPLES. O inimigo avança uma distância fixa por segundo ao
+// longo da curva, e a tabela converte a distância percorrida no parâmetro t,
+// então a velocidade é a mesma em toda a curva (avançar t linearmente anda
+// mais rápido onde os pontos de controle estão mais afastados).
+//
+// EnemyPaths_Update() avança todos os inimigos de uma vez, sem desvios: a
+// distância percorrida, o parâmetro t (pela tabela), a posição B(t) e a
+// direção do movimento, calculada pela derivada analítica B'(t). Com AVX
+// (compilando com -mavx2 ou -DFCG_AVX2=ON no CMake) são processados oito
+// inimigos por iteração, com SSE2 quatro, e os que sobram (ou tudo, em outras
+// arquiteturas) pela versão escalar. Todas as versões fazem as mesmas
+// operações na mesma ordem, então dão o mesmo resultado. O que depende de
+// desvios (gerar uma nova curva, colisão com as caixas) fica em
+// UpdateEnemies() ("simulation.cpp"), que lê as saídas do kernel e as corrige
+// no lugar: limita a posição ao mapa e, se o inimigo não pode andar, volta à
+// posição e à direção do tick anterior.
+
+#define ENEMY_PATHS_ARC_SAMPLES 16 // Entradas da tabela de comprimento de arco
+
+struct EnemyPaths
+{
+    // Pontos de controle no plano XZ: p0 é o início da curva e p3 o destino
+    std::vector<float> p0_x, p0_z;
+    std::vector<float> p1_x, p1_z;
+    std::vector<float> p2_x, p2_z;
+    std::vector<float> p3_x, p3_z;
+
+    // arc_length[k][i]: comprimento da curva do inimigo i de t = 0 até
+    // t = (k + 1) / ENEMY_PATHS_ARC_SAMPLES. A última entrada é o comprimento
+    // total.
+    std::vector<float> arc_length[ENEMY_PATHS_ARC_SAMPLES];
+
+    std::vector<float> distance; // Distância percorrida na curva
+    std::vector<float> speed;    // Distância por segundo
+    std::vector<float> y;        // Altura do inimigo (não muda)
+
+    // Saídas de EnemyPaths_Update(), recalculadas a cada tick. Depois de
+    // UpdateEnemies(), x, z e heading_x, heading_z são a posição e a direção
+    // (normalizada, no plano XZ) do inimigo.
+    std::vector<float> progress;             // Parâmetro t da curva (0.0 a 1.0); 1.0 no fim da curva
+    std::vector<float> x, z;                 // Posição B(t)
+    std::vector<float> heading_x, heading_z; // B'(t) normalizada; zero se t = 1 ou se o inimigo quase não anda
+
+    // Posição e direção antes do último tick, para interpolar a renderização
+    std::vector<float> previous_x, previous_z;
+    std::vector<float> previous_heading_x, previous_heading_z;
+
+    size_t Size() const { return progress.size(); }
+};
+
+// Número de inimigos ou remove todos. Os vetores mantêm a memória alocada;
+// os inimigos novos ficam na origem, olhando para -Z.
+void EnemyPaths_Resize(EnemyPaths& paths, size_t size);
+void EnemyPaths_Clear(EnemyPaths& paths);
+
+// Remove o inimigo "index", movendo o último para o lugar dele (como
+// World::enemies em Simulation_RemoveDeadEnemies())
+void EnemyPaths_SwapRemove(EnemyPaths& paths, size_t index);
+
+// Nova curva para o inimigo "index", com os pontos de controle (x[j], z[j])
+// de P0 a P3: calcula a tabela de comprimento de arco e recomeça do início,
+// andando "speed" unidades por segundo
+void EnemyPaths_SetCurve(EnemyPaths& paths, size_t index, const float x[4], const float z[4], float speed);
+
+// Avança delta_time segundos em todas as curvas e calcula as saídas, com o
+// melhor kernel compilado. EnemyPaths_UpdateRange() faz o mesmo só nos
+// inimigos [begin, end), para dividir o trabalho entre threads
+// ("jobsystem.h"), e EnemyPaths_UpdateScalar() sem SIMD.
+void EnemyPaths_Update(EnemyPaths& paths, float delta_time);
+void EnemyPaths_UpdateRange(EnemyPaths& paths, size_t begin, size_t end, float delta_time);
+void EnemyPaths_UpdateScalar(EnemyPaths& paths, size_t begin, size_t end, float delta_time);
+
+// Guarda a posição e a direção atuais como as do tick anterior
+void EnemyPaths_SavePrevious(EnemyPaths& paths);
+
+// Nome do kernel usado por EnemyPaths_Update(): "AVX", "SSE2" ou "escalar"
+const char* EnemyPaths_KernelName();
+
+#endif // _ENEMYPATHS_H
@@ -0,0 +1,130 @@
+#ifndef _EVENTBUS_H
+#define _EVENTBUS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Eventos da simulação (tiros, dano, mortes, waves) para quem precisa
+// reagir a eles: HUD, log, métricas e gravação de replays. Veja
+// "eventbus.cpp".
+//
+// Cada World tem um EventBus (World::events): um ring buffer de GameEvent
+// com um único produtor (a thread que roda Simulation_Step()) e qualquer
+// número de consumidores. Cada consumidor tem o seu EventSubscriber, com a
+// sua posição de leitura, e lê os eventos novos em lotes com
+// EventBus_Poll(), por exemplo uma vez por quadro; ninguém precisa percorrer
+// World::enemies para descobrir o que mudou. O produtor nunca espera: um
+// consumidor que fica mais de EVENT_BUS_CAPACITY eventos atrás perde os mais
+// antigos (EventSubscriber::lost).
+//
+// O anel só é alocado no primeiro EventBus_Subscribe(); sem consumidores
+// (ex.: os jogos em lote de "simulationbatch.h") publicar não custa nada.
+
+#define EVENT_BUS_CAPACITY 8192 // Eventos no anel (potência de 2)
+
+enum GameEventType
+{
+    GAME_EVENT_SHOT = 0,       // Tiro resolvido, com ou sem alvo (GameEvent::shot)
+    GAME_EVENT_ENEMY_DAMAGED,  // GameEvent::damage
+    GAME_EVENT_ENEMY_KILLED,   // GameEvent::kill
+    GAME_EVENT_PLAYER_DAMAGED, // GameEvent::damage
+    GAME_EVENT_PLAYER_KILLED,
+    GAME_EVENT_WAVE_STARTED,   // GameEvent::wave
+    GAME_EVENT_WAVE_COMPLETE,  // GameEvent::wave
+    GAME_EVENT_GAME_FINISHED,  // Todas as waves completas
+    GAME_NUM_EVENT_TYPES
+};
+
+#define GAME_EVENT_MASK(type) (1u << (type))
+#define GAME_EVENT_ALL        (~0u)
+
+struct GameEventShot
+{
+    uint32_t shooter;  // RayLayer de quem atirou
+    uint32_t layer;    // RayLayer atingida (RAY_LAYER_NONE se não atingiu nada)
+    float    distance; // Até o ponto atingido
+};
+
+struct GameEventDamage
+{
+    float amount;
+    float health;      // Vida depois do dano
+    float max_health;
+};
+
+struct GameEventKill
+{
+    float x, y, z;     // Posição do inimigo
+};
+
+struct GameEventWave
+{
+    int32_t wave;      // Número da wave (a primeira é 1)
+    int32_t enemy_count;
+    float   health_multiplier;
+    float   speed_multiplier;
+};
+
+// Evento sem ponteiros nem construtores, copiado como bytes (inclusive para
+// os replays). Campos não usados pelo tipo são zero.
+struct GameEvent
+{
+    uint32_t tick;             // World::tick em que aconteceu
+    uint32_t type;             // GameEventType
+    uint32_t enemy_slot;       // EnemyHandle do inimigo atingido, morto ou, nos tiros
+    uint32_t enemy_generation; // de inimigos, do que atirou (0, 0 se nenhum)
+    union
+    {
+        GameEventShot   shot;
+        GameEventDamage damage;
+        GameEventKill   kill;
+        GameEventWave   wave;
+    };
+};
+
+struct EventBus
+{
+    // Consumidores não alteram o estado do jogo, então podem se inscrever
+    // em um World const
+    mutable std::vector<GameEvent> events;  // Anel de EVENT_BUS_CAPACITY eventos
+    mutable std::atomic<int> num_subscribers;
+    std::atomic<uint64_t> write_index;      // Eventos já publicados
+
+    EventBus() : num_subscribers(0), write_index(0) {}
+
+    // Os consumidores se inscrevem em um World, não no estado dele: copiar
+    // um World (ex.: em Simulation_LoadState()) não copia os eventos, e o
+    // destino mantém o seu anel e os seus consumidores
+    EventBus(const EventBus&) : num_subscribers(0), write_index(0) {}
+    EventBus& operator=(const EventBus&) { return *this; }
+};
+
+struct EventSubscriber
+{
+    uint64_t read_index; // Próximo evento a ler
+    uint32_t mask;       // Tipos lidos (GAME_EVENT_MASK)
+    uint64_t lost;       // Eventos sobrescritos antes de serem lidos
+
+    EventSubscriber() : read_index(0), mask(GAME_EVENT_ALL), lost(0) {}
+};
+
+// Inscreve "subscriber" para receber os eventos publicados daqui em diante,
+// dos tipos em "mask". Deve ser chamada na thread do produtor, ou com a
+// simulação parada.
+void EventBus_Subscribe(const EventBus& bus, EventSubscriber& subscriber, uint32_t mask = GAME_EVENT_ALL);
+void EventBus_Unsubscribe(const EventBus& bus, EventSubscriber& subscriber);
+
+// Publica um evento (sem consumidores, não faz nada)
+void EventBus_Publish(EventBus& bus, const GameEvent& event);
+
+// Copia para "events" até "max_events" eventos ainda não lidos, na ordem em
+// que foram publicados. Retorna quantos foram copiados; 0 quando não há mais.
+size_t EventBus_Poll(const EventBus& bus, EventSubscriber& subscriber, GameEvent* events, size_t max_events);
+
+// Consumidor do log: escreve os eventos novos como mensagens de "logger.h"
+// (categorias LOG_CATEGORY_COMBAT e LOG_CATEGORY_WAVES)
+void EventBus_LogEvents(const EventBus& bus, EventSubscriber& subscriber);
+
+#endif // _EVENTBUS_H
@@ -0,0 +1,59 @@
+#ifndef _FLOWFIELD_H
+#define _FLOWFIELD_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "boxgrid.h"
+
+// Campo de fluxo ("flow field") até o jogador, compartilhado por todos os
+// inimigos. Veja "flowfield.cpp".
+//
+// O mapa é dividido em células de FLOW_FIELD_CELL_SIZE; as que encostam em
+// alguma caixa (AABB aumentada pelo raio do inimigo) ficam bloqueadas. Para
+// cada célula livre, o campo guarda a distância até a célula do jogador,
+// andando só por células livres (Dijkstra com vizinhos em oito direções, sem
+// cortar quinas de células bloqueadas), e qual é a próxima célula nesse
+// caminho. O campo só é recalculado quando o jogador entra em outra célula;
+// consultá-lo custa o mesmo com 10 ou 10 mil inimigos.
+
+#define FLOW_FIELD_CELL_SIZE   1.0f // Lado das células, em unidades do mundo
+#define FLOW_FIELD_UNREACHABLE 1e30f // FlowField::distance das células bloqueadas ou sem caminho
+
+struct FlowField
+{
+    float origin_x, origin_z; // Canto mínimo da célula (0, 0)
+    int cells_x, cells_z;
+
+    std::vector<uint8_t> blocked; // 1 se a célula encosta em uma caixa
+    std::vector<float> distance;  // Distância até target_cell, ou FLOW_FIELD_UNREACHABLE
+    std::vector<int32_t> next;    // Próxima célula no caminho; -1 em target_cell e nas inalcançáveis
+    int target_cell;              // Célula do jogador no último cálculo; -1 antes do primeiro
+
+    std::vector<std::pair<float, int32_t> > heap; // Fila de prioridade do Dijkstra (mantém a memória)
+
+    FlowField() : origin_x(0.0f), origin_z(0.0f), cells_x(0), cells_z(0), target_cell(-1) {}
+};
+
+// (Re)cria a grade sobre os limites do mapa e bloqueia as células que
+// encostam nas AABBs "aabbs" (BoxGrid::aabbs) aumentadas de agent_radius.
+// O campo fica sem alvo até o próximo FlowField_Update().
+void FlowField_Build(FlowField& field, const std::vector<BoxAABB>& aabbs, float agent_radius);
+
+// Recalcula o campo se "target" (posição do jogador) está em outra célula
+// que no último cálculo. Retorna true se recalculou.
+bool FlowField_Update(FlowField& field, const glm::vec4& target);
+
+// Célula que contém o ponto (x, z), limitada à grade
+int FlowField_Cell(const FlowField& field, float x, float z);
+
+// Centro da célula "cell" no plano XZ
+void FlowField_CellCenter(const FlowField& field, int cell, float& x, float& z);
+
+// true se o segmento de (x0, z0) a (x1, z1) não passa por células bloqueadas
+bool FlowField_LineOfSight(const FlowField& field, float x0, float z0, float x1, float z1);
+
+#endif // _FLOWFIELD_H
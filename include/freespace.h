@@ -0,0 +1,60 @@
+#ifndef _FREESPACE_H
+#define _FREESPACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "boxgrid.h"
+
+// Grade de espaço livre para validar curvas inteiras dos inimigos antes de
+// elas serem usadas. Veja "freespace.cpp".
+//
+// O mapa é dividido em células de FREE_SPACE_CELL_SIZE. Uma célula é livre
+// se a hitbox do inimigo (esfera de raio "radius", deslocada de "offset" da
+// posição) não encosta em nenhuma caixa, em nenhum ponto da célula, mesmo
+// aumentada de FREE_SPACE_SAMPLE_SPACING / 2. As outras ficam marcadas como
+// "perto de caixas" e, nelas, os pontos são testados com as caixas de
+// BoxGrid, como em CheckEnemyBoxCollision().
+//
+// FreeSpace_SweepBezier() divide a curva (de Casteljau) até cada pedaço ter
+// no máximo FREE_SPACE_SAMPLE_SPACING de comprimento e testa o fim de cada
+// pedaço: como todo ponto do pedaço fica a menos de metade disso de um ponto
+// testado, a esfera aumentada cobre a hitbox varrida pela curva inteira.
+
+#define FREE_SPACE_CELL_SIZE      0.5f  // Lado das células, em unidades do mundo
+#define FREE_SPACE_SAMPLE_SPACING 0.25f // Comprimento máximo entre pontos testados da curva
+
+struct FreeSpaceGrid
+{
+    float origin_x, origin_z; // Canto mínimo da célula (0, 0)
+    int cells_x, cells_z;
+
+    float radius;             // Raio da hitbox, sem o aumento
+    glm::vec3 offset;         // Centro da hitbox em relação à posição do inimigo
+    std::vector<uint8_t> free_cells; // 1 se a célula está longe de todas as caixas
+
+    FreeSpaceGrid() : origin_x(0.0f), origin_z(0.0f), cells_x(0), cells_z(0), radius(0.0f), offset(0.0f) {}
+};
+
+// (Re)cria a grade sobre os limites do mapa para as AABBs "aabbs"
+// (BoxGrid::aabbs) e uma hitbox de raio "radius" com centro em
+// posição + "offset"
+void FreeSpace_Build(FreeSpaceGrid& grid, const std::vector<BoxAABB>& aabbs, float radius, const glm::vec3& offset);
+
+// true se a hitbox aumentada, com o inimigo em (x, y, z), não encosta em
+// nenhuma caixa de "boxes"
+bool FreeSpace_IsFree(const FreeSpaceGrid& grid, const BoxGrid& boxes, float x, float y, float z);
+
+// true se a hitbox, andando pela curva Bezier de pontos de controle (x[i],
+// z[i]) na altura y, não encosta em nenhuma caixa. O início da curva não é
+// testado (o inimigo já está lá), e os pontos até a curva se afastar das
+// caixas em volta dele são testados sem o aumento da hitbox (ou nem são
+// testados, se ele já encosta em uma caixa). "samples", se não for NULL,
+// recebe o número de pontos testados.
+bool FreeSpace_SweepBezier(const FreeSpaceGrid& grid, const BoxGrid& boxes, const float x[4], const float z[4],
+                           float y, int* samples = NULL);
+
+#endif // _FREESPACE_H
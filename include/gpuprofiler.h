@@ -0,0 +1,48 @@
+#ifndef _GPUPROFILER_H
+#define _GPUPROFILER_H
+
+// Profiler de GPU baseado em timer queries (GL_TIMESTAMP). Veja
+// "gpuprofiler.cpp".
+//
+// Cada quadro é dividido em passes lógicos (chão, caixas, jogador, ...):
+//
+//     GpuProfiler_BeginFrame();
+//     GpuProfiler_BeginPass("ground");
+//     ... desenhos ...
+//     GpuProfiler_EndPass();
+//     ...
+//     GpuProfiler_EndFrame();
+//
+// As queries de um quadro só são lidas GPU_PROFILER_FRAMES_IN_FLIGHT quadros
+// depois, então a leitura nunca bloqueia a CPU esperando pela GPU.
+
+#define GPU_PROFILER_MAX_PASSES        16  // Passes distintos (por nome)
+#define GPU_PROFILER_FRAMES_IN_FLIGHT  4   // Tamanho do anel de queries
+#define GPU_PROFILER_AVERAGE_FRAMES    60  // Janela da média móvel mostrada na tela
+#define GPU_PROFILER_HISTORY_FRAMES    600 // Quadros guardados para o CSV
+
+// Cria as queries. Deve ser chamada depois de inicializar o OpenGL.
+void GpuProfiler_Init();
+
+void GpuProfiler_BeginFrame();
+void GpuProfiler_EndFrame();
+
+// "name" deve ser uma string com tempo de vida estático (ex.: literal). Passes
+// não podem ser aninhados; iniciar um novo pass encerra o anterior.
+void GpuProfiler_BeginPass(const char* name);
+void GpuProfiler_EndPass();
+
+// Resultados (em milissegundos) dos quadros já lidos da GPU
+int         GpuProfiler_PassCount();
+const char* GpuProfiler_PassName(int pass);
+double      GpuProfiler_PassAverageMs(int pass); // Média móvel dos quadros em que o pass executou
+double      GpuProfiler_PassMaxMs(int pass);     // Máximo na mesma janela
+double      GpuProfiler_FrameAverageMs();        // Tempo de GPU do quadro inteiro (média móvel)
+int         GpuProfiler_DroppedFrames();         // Quadros cujas queries não ficaram prontas a tempo
+
+// Escreve o histórico dos últimos GPU_PROFILER_HISTORY_FRAMES quadros em um
+// arquivo CSV (uma linha por quadro, uma coluna por pass). Retorna false em
+// caso de erro.
+bool GpuProfiler_DumpCSV(const char* filename);
+
+#endif // _GPUPROFILER_H
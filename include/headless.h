@@ -0,0 +1,41 @@
+#ifndef _HEADLESS_H
+#define _HEADLESS_H
+
+#include <glad/glad.h>
+
+// Renderização sem janela ("headless"), para benchmarks e capturas de tela em
+// servidores sem display nem GPU. Veja "headless.cpp".
+//
+// Um contexto OpenGL 3.3 core é criado com EGL (plataforma "surfaceless" do
+// Mesa, que funciona com o rasterizador por software llvmpipe) ou, caso EGL
+// não esteja disponível, com OSMesa. As bibliotecas são carregadas com
+// dlopen(), então o executável não passa a depender delas. Como não existe
+// framebuffer padrão, tudo é renderizado em um FBO do tamanho pedido; use
+// Headless_GetFramebuffer() onde o código normalmente usaria o framebuffer 0.
+//
+// Disponível apenas no Linux.
+
+#define HEADLESS_BACKEND_AUTO   "auto"   // EGL, e OSMesa se EGL falhar
+#define HEADLESS_BACKEND_EGL    "egl"
+#define HEADLESS_BACKEND_OSMESA "osmesa"
+
+#define HEADLESS_DEFAULT_FRAMES 600 // Quadros renderizados se --frames não for dado
+
+// Cria o contexto, carrega as funções OpenGL (GLAD) e cria o FBO de
+// width x height pixels. Retorna false em caso de erro.
+bool Headless_Init(const char* backend, int width, int height);
+void Headless_Terminate();
+
+bool        Headless_IsActive();
+const char* Headless_BackendName(); // "EGL" ou "OSMesa"
+GLuint      Headless_GetFramebuffer();
+void        Headless_GetFramebufferSize(int* width, int* height);
+
+// Segundos desde Headless_Init(), equivalente a glfwGetTime()
+double Headless_GetTime();
+
+// Salva o conteúdo do FBO em um arquivo PPM (binário). Retorna false em caso
+// de erro.
+bool Headless_SaveScreenshot(const char* filename);
+
+#endif // _HEADLESS_H
@@ -0,0 +1,59 @@
+#ifndef _INPUTQUEUE_H
+#define _INPUTQUEUE_H
+
+#include <cstdint>
+
+// Fila de eventos de entrada (teclado e mouse) com o instante de cada um.
+// Veja "inputqueue.cpp".
+//
+// Os callbacks da GLFW só colocam o evento na fila, com o tempo em que ele
+// chegou (para os eventos da janela, o da chamada a glfwPollEvents() que os
+// entregou, feita uma vez por quadro); quem aplica os eventos é o loop
+// principal, no início de cada tick da simulação (os eventos até o fim do
+// tick) e, logo antes de calcular a matriz da câmera, todos os que ainda
+// estão na fila ("late latching"). Assim o movimento do mouse chega na
+// câmera do quadro que está sendo desenhado, e não só no próximo.
+//
+// A fila é lock-free e aceita vários produtores: além dos callbacks (que a
+// GLFW só chama na thread principal), uma thread pode gerar entrada sintética
+// (InputQueue_StartSyntheticMouse()), usada para medir a latência entre a
+// entrada e a apresentação do quadro no modo headless.
+
+#define INPUT_QUEUE_SIZE 1024 // Eventos na fila (potência de 2)
+
+enum InputEventType
+{
+    INPUT_EVENT_KEY = 0,      // key, scancode, action, mods
+    INPUT_EVENT_MOUSE_BUTTON, // key (o botão), action, mods
+    INPUT_EVENT_CURSOR,       // x, y
+    INPUT_EVENT_SCROLL        // x, y
+};
+
+struct InputEvent
+{
+    double  time;    // Instante em que o evento chegou (relógio de quem o colocou na fila)
+    int32_t type;    // InputEventType
+    int32_t key;
+    int32_t scancode;
+    int32_t action;
+    int32_t mods;
+    double  x, y;
+};
+
+// Coloca o evento na fila. Retorna false (e conta o evento como descartado)
+// se a fila está cheia.
+bool InputQueue_Push(const InputEvent& event);
+
+// Tira o evento mais antigo da fila, se ele chegou até "max_time". Só a
+// thread principal deve chamar.
+bool InputQueue_Pop(double max_time, InputEvent* event);
+
+// Eventos descartados porque a fila estava cheia
+int InputQueue_DroppedEvents();
+
+// Cria uma thread que coloca na fila um movimento do mouse (INPUT_EVENT_CURSOR)
+// "rate" vezes por segundo, com o tempo de "clock"
+void InputQueue_StartSyntheticMouse(double rate, double (*clock)());
+void InputQueue_StopSyntheticMouse();
+
+#endif // _INPUTQUEUE_H
@@ -0,0 +1,77 @@
+#ifndef _JOBSYSTEM_H
+#define _JOBSYSTEM_H
+
+#include <cstddef>
+#include <vector>
+
+// Sistema de jobs com roubo de trabalho ("work stealing"), para dividir o
+// trabalho de um tick entre os núcleos. Veja "jobsystem.cpp".
+//
+// Um job é uma função chamada em um intervalo [begin, end) de índices (ex.:
+// inimigos de World::enemies). Cada thread tem a sua própria fila de jobs
+// (deque): a dona coloca e tira jobs do fim da fila, e uma thread sem
+// trabalho rouba do início da fila de outra. A thread que chama
+// JobSystem_Init() é a thread 0: só ela distribui trabalho, e também
+// trabalha enquanto espera.
+//
+// O trabalho de um tick é descrito por um JobGraph: cada nó é uma função
+// dividida em jobs de até "grain" índices, e só começa depois que os nós de
+// que depende terminaram. Um job não deve alterar estado compartilhado (vida
+// do jogador, RandomStream, vetores de World): ele escreve comandos em um
+// buffer da sua thread (JobSystem_ThreadIndex()), e um nó seguinte com um só
+// job aplica os comandos em uma ordem que não depende de qual thread rodou
+// cada intervalo. Assim o resultado é o mesmo com qualquer número de threads.
+//
+// Sem JobSystem_Init(), ou chamado de outra thread que não a 0 (ex.: dentro
+// de um job ou nas threads de "simulationbatch.h"), JobGraph_Run() roda
+// todos os nós na thread que chama, um intervalo [0, count) por nó.
+
+#define JOB_SYSTEM_MAX_THREADS 64
+
+// Função de um nó, chamada para cada intervalo [begin, end) de índices
+typedef void (*JobFunction)(void* data, size_t begin, size_t end);
+
+struct JobGraphNode
+{
+    JobFunction      function;
+    void*            data;
+    size_t           count;            // Índices [0, count)
+    size_t           grain;            // Máximo de índices por job
+    int              num_dependencies; // Nós que precisam terminar antes
+    std::vector<int> dependents;       // Nós que esperam este
+};
+
+struct JobGraph
+{
+    std::vector<JobGraphNode> nodes;
+};
+
+// Cria as threads: num_threads ao todo, contando a que chama; 0 usa uma por
+// núcleo. Retorna o número de threads.
+int  JobSystem_Init(int num_threads);
+void JobSystem_Terminate();
+
+// Número de threads do sistema (1 sem JobSystem_Init()) e índice da thread
+// corrente, de 0 a JobSystem_NumThreads() - 1, ou -1 se ela não é do sistema
+int JobSystem_NumThreads();
+int JobSystem_ThreadIndex();
+
+// Remove todos os nós. O vetor de nós mantém a memória alocada, então um
+// grafo reconstruído a cada tick quase não aloca depois do primeiro.
+void JobGraph_Clear(JobGraph& graph);
+
+// Adiciona um nó que chama "function" em [0, count), em jobs de até "grain"
+// índices (count = 1 para um job serial). Retorna o índice do nó.
+int JobGraph_Add(JobGraph& graph, JobFunction function, void* data, size_t count, size_t grain);
+
+// O nó "node" só começa depois que "dependency" terminar. O grafo não pode
+// ter ciclos.
+void JobGraph_AddDependency(JobGraph& graph, int node, int dependency);
+
+// Roda todos os nós e retorna quando terminarem
+void JobGraph_Run(JobGraph& graph);
+
+// Grafo com um único nó: "function" em [0, count), em jobs de até "grain"
+void JobSystem_ParallelFor(size_t count, size_t grain, JobFunction function, void* data);
+
+#endif // _JOBSYSTEM_H
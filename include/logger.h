@@ -0,0 +1,239 @@
+#ifndef _LOGGER_H
+#define _LOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Log assíncrono com níveis e categorias. Veja "logger.cpp".
+//
+// As mensagens são escritas com as macros LOG_DEBUG, LOG_INFO, LOG_WARNING e
+// LOG_ERROR, com a mesma sintaxe de printf() (sem o '\n' final):
+//
+//     LOG_DEBUG(LOG_CATEGORY_COMBAT, "Raycast hit: BOX at distance %.2f", hit.t);
+//
+// Quem escreve não formata nada: a string de formato (que deve ser um literal,
+// com tempo de vida estático) e os argumentos são copiados para um ring
+// buffer lock-free, e uma thread do logger formata e escreve as mensagens no
+// terminal ou em um arquivo. Strings passadas com %s são copiadas (até
+// LOG_TEXT_SIZE bytes no total por mensagem). Se o ring buffer enche, as
+// mensagens novas são descartadas e contadas, em vez de bloquear quem
+// escreve.
+//
+// No modo binário (Logger_Init() com binary = true) a thread escreve as
+// mensagens sem formatá-las; Logger_DecodeFile() (fcg_headless --decode-log)
+// as converte em texto depois.
+//
+// Mensagens abaixo de LOG_COMPILE_LEVEL não geram código algum (no CMake:
+// -DFCG_LOG_LEVEL=INFO, por exemplo); as outras podem ser filtradas em tempo
+// de execução por nível (Logger_SetLevel()) e categoria
+// (Logger_SetCategoryEnabled()). Sem Logger_Init(), as mensagens são
+// formatadas e escritas no terminal na hora, por quem chama.
+
+#define LOG_LEVEL_DEBUG   0
+#define LOG_LEVEL_INFO    1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR   3
+#define LOG_LEVEL_NONE    4
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RING_SIZE         8192 // Mensagens em trânsito (potência de 2)
+#define LOG_MAX_ARGUMENTS     8    // Argumentos por mensagem
+#define LOG_TEXT_SIZE         64   // Bytes das strings (%s) de uma mensagem
+#define LOG_FLUSH_INTERVAL_MS 10   // Maior espera da thread do logger entre escritas
+
+enum LogCategory
+{
+    LOG_CATEGORY_GENERAL = 0,
+    LOG_CATEGORY_SIMULATION, // Inicialização e estado do jogo
+    LOG_CATEGORY_COMBAT,     // Tiros, dano e mortes
+    LOG_CATEGORY_WAVES,      // Spawn e fim das waves
+    LOG_NUM_CATEGORIES
+};
+
+enum LogArgumentType
+{
+    LOG_ARGUMENT_INT = 0,
+    LOG_ARGUMENT_UINT,
+    LOG_ARGUMENT_DOUBLE,
+    LOG_ARGUMENT_STRING // Posição da string em LogMessage::text
+};
+
+struct LogArgument
+{
+    uint8_t type; // LogArgumentType
+    union
+    {
+        int64_t  i;
+        uint64_t u;
+        double   d;
+    };
+};
+
+// Mensagem ainda não formatada
+struct LogMessage
+{
+    uint64_t    time_ns;       // Desde Logger_Init()
+    const char* format;
+    uint8_t     level;
+    uint8_t     category;      // LogCategory
+    uint8_t     num_arguments;
+    uint8_t     text_size;     // Bytes usados de "text"
+    LogArgument arguments[LOG_MAX_ARGUMENTS];
+    char        text[LOG_TEXT_SIZE];
+};
+
+// Filtros de tempo de execução, lidos por Logger_IsEnabled() em toda mensagem
+extern std::atomic<int>      g_LogLevel;
+extern std::atomic<uint32_t> g_LogCategories; // Um bit por LogCategory
+
+// Cria a thread do logger, que escreve em "filename" (NULL: na saída padrão),
+// em texto ou, com binary = true, no formato de Logger_DecodeFile(). Retorna
+// false se o arquivo não pode ser criado. Logger_Terminate() é chamada
+// também na saída do programa.
+bool Logger_Init(const char* filename, bool binary);
+
+// Escreve as mensagens pendentes e termina a thread. Deve ser chamada depois
+// que as outras threads pararam de escrever mensagens.
+void Logger_Terminate();
+
+// Espera até as mensagens escritas antes da chamada estarem no arquivo (ex.:
+// antes de imprimir algo com printf() que deve vir depois delas)
+void Logger_Flush();
+
+void Logger_SetLevel(int level);
+void Logger_SetCategoryEnabled(LogCategory category, bool enabled);
+int  Logger_ParseLevel(const char* name); // "debug", "info"...; -1 se inválido
+
+// Mensagens descartadas porque o ring buffer estava cheio
+int Logger_DroppedMessages();
+
+// Formata o texto da mensagem (sem nível e categoria) em "buffer". Retorna o
+// tamanho do texto.
+size_t Logger_FormatMessage(const LogMessage& message, char* buffer, size_t size);
+
+// Converte um log binário em texto, escrito em "output"
+bool Logger_DecodeFile(const char* filename, FILE* output);
+
+// Coloca a mensagem no ring buffer (ou a escreve na hora, sem Logger_Init())
+void Logger_Push(LogMessage& message);
+
+inline bool Logger_IsEnabled(int level, LogCategory category)
+{
+    return level >= g_LogLevel.load(std::memory_order_relaxed) &&
+           (g_LogCategories.load(std::memory_order_relaxed) & (1u << category)) != 0;
+}
+
+// Cópia dos argumentos para a mensagem. Tipos menores que int são promovidos
+// a int, e float a double, como em printf().
+inline void Logger_PackInt(LogMessage& message, int64_t value)
+{
+    LogArgument& argument = message.arguments[message.num_arguments++];
+    argument.type = LOG_ARGUMENT_INT;
+    argument.i = value;
+}
+
+inline void Logger_PackUint(LogMessage& message, uint64_t value)
+{
+    LogArgument& argument = message.arguments[message.num_arguments++];
+    argument.type = LOG_ARGUMENT_UINT;
+    argument.u = value;
+}
+
+inline void Logger_PackArgument(LogMessage& message, int value)                { Logger_PackInt(message, value); }
+inline void Logger_PackArgument(LogMessage& message, long value)               { Logger_PackInt(message, value); }
+inline void Logger_PackArgument(LogMessage& message, long long value)          { Logger_PackInt(message, value); }
+inline void Logger_PackArgument(LogMessage& message, unsigned int value)       { Logger_PackUint(message, value); }
+inline void Logger_PackArgument(LogMessage& message, unsigned long value)      { Logger_PackUint(message, value); }
+inline void Logger_PackArgument(LogMessage& message, unsigned long long value) { Logger_PackUint(message, value); }
+
+inline void Logger_PackArgument(LogMessage& message, double value)
+{
+    LogArgument& argument = message.arguments[message.num_arguments++];
+    argument.type = LOG_ARGUMENT_DOUBLE;
+    argument.d = value;
+}
+
+inline void Logger_PackArgument(LogMessage& message, const char* value)
+{
+    LogArgument& argument = message.arguments[message.num_arguments++];
+    argument.type = LOG_ARGUMENT_STRING;
+    argument.u = message.text_size;
+
+    // Strings que não cabem são cortadas; a última sempre termina em '\0'
+    if (!value)
+        value = "(null)";
+    size_t size = message.text_size;
+    while (*value && size + 1 < LOG_TEXT_SIZE)
+        message.text[size++] = *value++;
+    if (size < LOG_TEXT_SIZE)
+        message.text[size++] = '\0';
+    else
+        message.text[LOG_TEXT_SIZE - 1] = '\0';
+    message.text_size = (uint8_t)size;
+}
+
+inline void Logger_PackArguments(LogMessage&) {}
+
+template <typename T, typename... Rest>
+inline void Logger_PackArguments(LogMessage& message, T first, Rest... rest)
+{
+    Logger_PackArgument(message, first);
+    Logger_PackArguments(message, rest...);
+}
+
+template <typename... Args>
+inline void Logger_Write(int level, LogCategory category, const char* format, Args... args)
+{
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGUMENTS, "Mensagem de log com argumentos demais");
+    if (!Logger_IsEnabled(level, category))
+        return;
+
+    LogMessage message;
+    message.format = format;
+    message.level = (uint8_t)level;
+    message.category = (uint8_t)category;
+    message.num_arguments = 0;
+    message.text_size = 0;
+    Logger_PackArguments(message, args...);
+    Logger_Push(message);
+}
+
+// Nunca chamada: só faz o compilador conferir o formato contra os argumentos
+#ifdef __GNUC__
+__attribute__((format(printf, 1, 2)))
+#endif
+inline void Logger_CheckFormat(const char*, ...) {}
+
+#define LOG_WRITE(level, category, ...) \
+    do { if (false) Logger_CheckFormat(__VA_ARGS__); Logger_Write(level, category, __VA_ARGS__); } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(category, ...) LOG_WRITE(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(category, ...) LOG_WRITE(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(category, ...) LOG_WRITE(LOG_LEVEL_WARNING, category, __VA_ARGS__)
+#else
+#define LOG_WARNING(category, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(category, ...) LOG_WRITE(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+#else
+#define LOG_ERROR(category, ...) do {} while (0)
+#endif
+
+#endif // _LOGGER_H
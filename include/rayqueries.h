@@ -0,0 +1,31 @@
+#ifndef _RAYQUERIES_H
+#define _RAYQUERIES_H
+
+#include <cstddef>
+
+#include "simulation.h"
+
+// Serviço de raycasts da simulação. Veja "rayqueries.cpp".
+//
+// O código do jogo pede raios com RayQueries_Submit() durante o tick (tiro
+// do jogador em Simulation_ApplyAction(), tiros dos inimigos em
+// UpdateEnemies()), e Simulation_ResolveShots() resolve todos de uma vez com
+// RayQueries_Resolve() em um ponto fixo do tick, aplicando os resultados na
+// ordem em que os raios foram pedidos. Assim o resultado não depende de onde
+// o tiro foi pedido, e cada objeto é testado uma vez por raio.
+//
+// Os raios que atingem caixas (RAY_LAYER_WORLD) são agrupados em pacotes de
+// raios coerentes, com a mesma combinação de sinais da direção e origens
+// próximas, e cada pacote percorre a BVH das caixas uma única vez
+// (BoxBVH_RaycastPacket()).
+
+#define RAY_PACKET_CELL_SIZE 10.0f // Lado das células que agrupam as origens dos raios em pacotes
+
+// Adiciona "query" ao fim de World::ray_queries e retorna o índice dela
+size_t RayQueries_Submit(World& world, const RayQuery& query);
+
+// Resolve todos os raios de World::ray_queries: World::ray_hits[i] recebe o
+// resultado de World::ray_queries[i]. Não altera nada além de ray_hits.
+void RayQueries_Resolve(World& world);
+
+#endif // _RAYQUERIES_H
@@ -0,0 +1,69 @@
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+#include <cstdint>
+
+#include "simulation.h"
+
+// Gravação e reprodução de partidas. Veja "replay.cpp".
+//
+// Como a simulação é determinística (mesma semente e mesmas SimulationAction
+// a cada tick produzem o mesmo jogo), um replay guarda só a entrada do
+// jogador de cada tick, em um arquivo binário compacto: por tick, um byte
+// indicando quais campos mudaram desde o tick anterior, seguido apenas dos
+// campos alterados. Ticks sem mudança ocupam um byte.
+//
+// A cada REPLAY_KEYFRAME_INTERVAL ticks é gravado também um "keyframe" com
+// todo o estado do World (Simulation_SaveState()). Para ir a um tick
+// qualquer, Replay_Seek() carrega o último keyframe antes dele e simula só
+// os ticks restantes, em vez de simular desde o tick 0.
+//
+// Os eventos da simulação ("eventbus.h") são gravados junto com as entradas.
+// Na reprodução, Replay_CheckEvents() compara os eventos de cada tick com os
+// gravados e avisa se a simulação divergiu (ex.: replay gravado antes de uma
+// mudança que não incrementou REPLAY_VERSION).
+//
+// Os keyframes são cópias da memória das estruturas, então um replay só
+// pode ser reproduzido pelo mesmo executável que o gravou (e com o mesmo
+// descritor de bounding boxes).
+
+#define REPLAY_KEYFRAME_INTERVAL 600 // Ticks entre keyframes (10 s a 60 Hz)
+
+// Começa a gravar em "filename" a partida de "world", que deve estar no
+// início de um tick; tick_rate é a frequência com que ela será simulada.
+// Retorna false em caso de erro.
+bool Replay_BeginRecording(const char* filename, const World& world, int tick_rate);
+
+// Grava a entrada do próximo tick de "world", antes de
+// Simulation_ApplyAction() e Simulation_Step()
+void Replay_RecordTick(const World& world, const SimulationAction& action);
+
+// Termina a gravação e fecha o arquivo
+void Replay_EndRecording();
+bool Replay_IsRecording();
+
+// Abre um replay para reprodução: lê as entradas e o índice dos keyframes.
+// Retorna false em caso de erro.
+bool Replay_Open(const char* filename);
+void Replay_Close();
+
+int      Replay_GetTickRate();
+uint32_t Replay_GetNumTicks(); // Ticks gravados
+
+// Coloca em "world" o estado no início do tick "tick" (limitado ao fim do
+// replay): carrega o último keyframe anterior e simula até lá. Retorna
+// false em caso de erro.
+bool Replay_Seek(World& world, uint32_t tick);
+
+// Entrada gravada para o próximo tick de "world" (World::tick). Retorna
+// false se o replay acabou.
+bool Replay_GetAction(const World& world, SimulationAction* action);
+
+// Compara os eventos publicados em "world" desde Replay_Seek() com os
+// gravados; deve ser chamada depois de cada Simulation_Step() da reprodução.
+// Retorna false (e avisa no terminal uma vez) se a simulação divergiu.
+bool     Replay_CheckEvents(const World& world);
+uint32_t Replay_GetCheckedEvents(); // Eventos conferidos desde Replay_Seek()
+bool     Replay_HasEvents();        // Se o replay aberto tem eventos gravados
+
+#endif // _REPLAY_H
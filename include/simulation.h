@@ -0,0 +1,728 @@
+#ifndef _SIMULATION_H
+#define _SIMULATION_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "boxbvh.h"
+#include "boxgrid.h"
+#include "enemypaths.h"
+#include "eventbus.h"
+#include "flowfield.h"
+#include "freespace.h"
+#include "wavegenerator.h"
+
+// Lógica do jogo (jogador, inimigos, caixas e waves), sem dependências de
+// OpenGL nem GLFW. Veja "simulation.cpp".
+//
+// Todo o estado de um jogo fica em um World; as funções recebem o World que
+// devem alterar, então vários jogos independentes podem rodar no mesmo
+// processo (veja "simulationbatch.h"). O único estado global são as bounding
+// boxes dos modelos, iguais para todos os jogos e só lidas durante a
+// simulação.
+//
+// É usada pelo jogo ("main.cpp"), que tem um único World e chama
+// Simulation_Step() uma vez por quadro, e pela biblioteca "fcgsim" (executável
+// "fcg_headless"), que roda a simulação com passo fixo o mais rápido possível,
+// sem janela e sem carregar os modelos: as bounding boxes do cowboy e do
+// bandit vêm do descritor SIMULATION_BOUNDS_FILE, gravado pelo jogo ao
+// carregar os modelos.
+
+#define SIMULATION_BOUNDS_FILE "../../data/model_bounds.txt"
+
+// A simulação avança em passos ("ticks") de duração fixa, independente da
+// taxa de quadros. O jogo acumula o tempo real de cada quadro, executa
+// quantos ticks couberem (no máximo SIMULATION_MAX_CATCHUP_TICKS) e renderiza
+// interpolando entre as transformações do tick anterior e do atual.
+#define SIMULATION_TICK_RATE          60 // Ticks por segundo
+#define SIMULATION_MAX_CATCHUP_TICKS  8  // Ticks por quadro, no máximo
+
+// Câmera
+enum CameraMode {
+    CAMERA_THIRD_PERSON,
+    CAMERA_FIRST_PERSON
+};
+
+// Limites do mapa (baseado no plane.obj: -25 a 25 em X e Z)
+const float MAP_MIN_X = -25.0f;
+const float MAP_MAX_X = 25.0f;
+const float MAP_MIN_Z = -25.0f;
+const float MAP_MAX_Z = 25.0f;
+
+// Axis-Aligned Bounding Box de um modelo, em coordenadas de modelo
+struct ModelBounds
+{
+    glm::vec3 bbox_min;
+    glm::vec3 bbox_max;
+};
+
+struct World;
+
+// Gerador de números pseudo-aleatórios PCG32 (M. O'Neill, pcg-random.org):
+// 64 bits de estado e um incremento ímpar que seleciona uma de 2^63
+// sequências ("streams") independentes. Cada sistema da simulação sorteia da
+// sua própria stream, então mudar quantos números um sistema sorteia não
+// altera os dos outros, e a sequência é a mesma em qualquer plataforma
+// (ao contrário de rand() e das distribuições de <random>).
+struct RandomStream
+{
+    uint64_t state;
+    uint64_t increment;
+
+    RandomStream() : state(0), increment(1) {}
+
+    void Seed(uint64_t seed, uint64_t stream)
+    {
+        state = 0;
+        increment = (stream << 1) | 1u;
+        Next();
+        state += seed;
+        Next();
+    }
+
+    uint32_t Next()
+    {
+        uint64_t old_state = state;
+        state = old_state * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = (uint32_t)(((old_state >> 18) ^ old_state) >> 27);
+        uint32_t rotation = (uint32_t)(old_state >> 59);
+        return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+    }
+
+    // Inteiro em [0, bound), sem viés
+    uint32_t NextBelow(uint32_t bound)
+    {
+        uint32_t threshold = (0u - bound) % bound;
+        for (;;)
+        {
+            uint32_t r = Next();
+            if (r >= threshold)
+                return r % bound;
+        }
+    }
+
+    // Float em [min, max), com 24 bits de precisão
+    float NextFloat(float min, float max)
+    {
+        return min + (max - min) * ((Next() >> 8) * (1.0f / 16777216.0f));
+    }
+};
+
+// Streams de números aleatórios de um World (segundo argumento de
+// RandomStream::Seed())
+enum SimulationStream {
+    SIMULATION_STREAM_ENEMY_PATHS = 1, // Destinos das curvas Bezier
+    SIMULATION_STREAM_ENEMY_SHOTS,     // Decisão de atirar
+    SIMULATION_STREAM_ENEMY_SPAWN,     // Estado inicial de cada inimigo
+    SIMULATION_STREAM_BOXES            // Layout das caixas (semente fixa)
+};
+
+// Interpolação linear entre dois ângulos (em radianos) pelo menor arco
+inline float Simulation_InterpolateAngle(float from, float to, float alpha)
+{
+    const float pi = 3.141592f;
+    float difference = std::fmod(to - from, 2.0f * pi);
+    if (difference > pi)
+        difference -= 2.0f * pi;
+    else if (difference < -pi)
+        difference += 2.0f * pi;
+    return from + difference * alpha;
+}
+
+// Estrutura que representa o jogador
+struct Player
+{
+    // Posição e orientação
+    glm::vec4 position;           // Posição do jogador no mundo (x, y, z, 1.0)
+    float rotation_y;            // Rotação em torno do eixo Y (em radianos) - direção que o jogador está olhando
+    glm::vec4 forward_vector;    // Vetor direção para frente do jogador (normalizado)
+    glm::vec4 right_vector;      // Vetor direção para direita do jogador (normalizado)
+    glm::vec3 model_center; 	// centro do modelo em coordenadas de modelo
+
+    // Transformação antes do último tick, para interpolar a renderização
+    glm::vec4 previous_position;
+    float previous_rotation_y;
+
+    // Estados de movimento
+    enum MovementState {
+        IDLE,
+        WALKING,
+        RUNNING
+    };
+    MovementState movement_state;
+
+    // Velocidades
+    float walk_speed;            // Velocidade de caminhada
+    float run_speed;             // Velocidade de corrida
+    float current_speed;         // Velocidade atual (calculada baseada no estado)
+
+    // Controles de movimento
+    bool moving_forward;         // Tecla para frente pressionada
+    bool moving_backward;        // Tecla para trás pressionada
+    bool moving_left;            // Tecla para esquerda pressionada
+    bool moving_right;           // Tecla para direita pressionada
+    bool is_running;             // Shift pressionado para correr
+
+    // Status do jogador
+    float health;                // Vida do jogador (0.0 a 100.0)
+    float max_health;            // Vida máxima
+
+    // Sistema de tiro
+    int magazine_ammo;           // Munição atual no carregador
+    int magazine_size;           // Tamanho do carregador (12 balas)
+    float shoot_cooldown;        // Tempo restante do cooldown de tiro (em segundos)
+    float shoot_cooldown_time;   // Tempo total do cooldown de tiro (em segundos)
+    float reload_time;           // Tempo restante do reload (em segundos)
+    float reload_time_total;     // Tempo total do reload (em segundos)
+    bool is_reloading;           // Se está recarregando
+
+    // Câmera em terceira pessoa
+    float camera_distance;       // Distância da câmera ao jogador
+    float camera_height;         // Altura da câmera em relação ao jogador
+    float camera_angle_horizontal; // Ângulo horizontal da câmera (em radianos)
+    float camera_angle_vertical;   // Ângulo vertical da câmera (em radianos)
+
+    // Construtor
+    Player()
+        : position(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f))
+        , rotation_y(0.0f)
+        , forward_vector(glm::vec4(0.0f, 0.0f, -1.0f, 0.0f))
+        , right_vector(glm::vec4(1.0f, 0.0f, 0.0f, 0.0f))
+        , model_center(glm::vec3(0.0f))
+        , previous_position(position)
+        , previous_rotation_y(rotation_y)
+        , movement_state(IDLE)
+        , walk_speed(2.0f)
+        , run_speed(5.0f)
+        , current_speed(0.0f)
+        , moving_forward(false)
+        , moving_backward(false)
+        , moving_left(false)
+        , moving_right(false)
+        , is_running(false)
+        , health(100.0f)
+        , max_health(100.0f)
+        , magazine_ammo(20)
+        , magazine_size(20)
+        , shoot_cooldown(0.0f)
+        , shoot_cooldown_time(0.2f)  // 0.2 segundos de cooldown entre tiros
+        , reload_time(0.0f)
+        , reload_time_total(2.0f)     // 2 segundos para recarregar
+        , is_reloading(false)
+        , camera_distance(4.0f)
+        , camera_height(1.5f)
+        , camera_angle_horizontal(0.0f)
+        , camera_angle_vertical(0.3f)  // Câmera ligeiramente acima
+    {
+    }
+
+    // Atualiza os vetores de direção baseado na rotação Y
+    void UpdateDirectionVectors()
+    {
+        forward_vector = glm::vec4(
+            sin(rotation_y),
+            0.0f,
+            -cos(rotation_y),
+            0.0f
+        );
+        right_vector = glm::vec4(
+            cos(rotation_y),
+            0.0f,
+            sin(rotation_y),
+            0.0f
+        );
+    }
+
+    // Guarda a transformação atual como a do tick anterior
+    void SavePreviousTransform()
+    {
+        previous_position = position;
+        previous_rotation_y = rotation_y;
+    }
+
+    // Transformação entre o tick anterior (alpha = 0) e o atual (alpha = 1)
+    glm::vec4 GetInterpolatedPosition(float alpha) const
+    {
+        return previous_position + (position - previous_position) * alpha;
+    }
+    float GetInterpolatedRotationY(float alpha) const
+    {
+        return Simulation_InterpolateAngle(previous_rotation_y, rotation_y, alpha);
+    }
+
+    // Atualiza o estado de movimento baseado nas teclas pressionadas
+    void UpdateMovementState()
+    {
+        bool is_moving = moving_forward || moving_backward || moving_left || moving_right;
+
+        if (is_moving)
+        {
+            movement_state = is_running ? RUNNING : WALKING;
+            current_speed = is_running ? run_speed : walk_speed;
+        }
+        else
+        {
+            movement_state = IDLE;
+            current_speed = 0.0f;
+        }
+    }
+
+    // Calcula a posição da câmera em terceira pessoa
+    glm::vec4 GetThirdPersonCameraPosition()
+    {
+        float x = position.x + camera_distance * cos(camera_angle_vertical) * sin(camera_angle_horizontal);
+        float y = position.y + camera_height + camera_distance * sin(camera_angle_vertical);
+        float z = position.z + camera_distance * cos(camera_angle_vertical) * cos(camera_angle_horizontal);
+        return glm::vec4(x, y, z, 1.0f);
+    }
+
+    glm::vec4 GetCameraLookAt()
+    {
+        // Compensa o fato de que o modelo foi escalado com 0.3f
+        float scale = 0.3f;
+
+        // Calcula o ponto de referência do jogador (centro do modelo)
+        // Olha diretamente para o centro do cowboy para mantê-lo centralizado
+        glm::vec4 player_reference = glm::vec4(
+            position.x - model_center.x * scale,
+            position.y - model_center.y * scale + camera_height,
+            position.z - model_center.z * scale,
+            1.0f
+        );
+
+        // Retorna o centro do jogador para manter o cowboy centralizado
+        // O crosshair ainda funciona porque é desenhado no centro da tela
+        // e o raycast usa o vetor de visualização da câmera
+        return player_reference;
+    }
+
+    // Aplica dano ao jogador
+    void TakeDamage(float damage)
+    {
+        if (health <= 0.0f)
+            return; // Já está morto
+
+        health -= damage;
+        if (health < 0.0f)
+            health = 0.0f;
+    }
+
+    // Verifica se o jogador está morto
+    bool IsDead() const
+    {
+        return health <= 0.0f;
+    }
+
+    // Atualiza a posição do jogador baseado no movimento e no tempo decorrido
+    // O movimento é relativo à direção da câmera (terceira pessoa ou primeira pessoa)
+    void UpdatePosition(World& world, float delta_time);
+};
+
+// Referência a um inimigo que continua válida enquanto ele estiver vivo,
+// mesmo que ele mude de posição em World::enemies. Quando o inimigo é
+// removido, a geração do slot é incrementada e os handles antigos deixam de
+// valer (Simulation_GetEnemy() retorna NULL).
+struct EnemyHandle
+{
+    uint32_t slot;       // Posição em World::enemy_slots
+    uint32_t generation; // Geração do slot quando o inimigo foi criado
+};
+
+// Entrada de World::enemy_slots
+struct EnemySlot
+{
+    uint32_t index;      // Posição do inimigo em World::enemies (se o slot estiver ocupado)
+    uint32_t generation; // Incrementada a cada inimigo removido do slot
+};
+
+// Estrutura que representa um inimigo. A posição, a direção e a velocidade
+// ficam em World::enemy_paths, no mesmo índice de World::enemies (veja
+// Simulation_EnemyPosition()), e a linha de debug do último tiro em
+// World::enemy_raycasts.
+struct Enemy
+{
+    // Status do inimigo
+    float max_health;            // Vida máxima
+    float health;                // Vida do inimigo (0.0 a 100.0)
+
+    // Sistema de tiro
+    float shoot_cooldown;         // Tempo restante do cooldown de tiro (em segundos)
+    float shoot_cooldown_time;    // Tempo total do cooldown de tiro (em segundos)
+    float shoot_probability_check_timer; // Timer para verificar probabilidade de tiro (verifica a cada 1 segundo)
+    float shoot_probability;      // Probabilidade de atirar por segundo (0.0 a 1.0)
+
+    // Construtor. A posição e a curva inicial são definidas por SpawnWave(),
+    // ao adicionar o inimigo ao World.
+    Enemy(World& world, int wave = -1, float health_multiplier = 1.0f);
+
+    // Aplica dano ao inimigo
+    void TakeDamage(float damage)
+    {
+        if (health <= 0.0f)
+            return; // Já está morto
+
+        health -= damage;
+        if (health < 0.0f)
+            health = 0.0f;
+    }
+
+    // Verifica se o inimigo está morto
+    bool IsDead() const
+    {
+        return health <= 0.0f;
+    }
+
+    // ID da wave à qual este inimigo pertence (-1 se não pertence a nenhuma wave)
+    int wave_id;
+
+    EnemyHandle handle; // Handle deste inimigo (veja EnemyHandle)
+};
+
+// Último tiro de um inimigo, desenhado como uma linha amarela (debug). Só a
+// renderização lê; fica fora de Enemy e do estado salvo.
+struct EnemyRaycast
+{
+    bool draw;                    // Se deve desenhar o raycast deste inimigo
+    glm::vec4 start;              // Ponto inicial do raycast
+    glm::vec4 end;                // Ponto final do raycast
+    double time;                  // Tempo de simulação (World::time) quando o raycast foi realizado
+
+    EnemyRaycast() : draw(false), start(0.0f), end(0.0f), time(0.0) {}
+};
+
+// Estrutura que representa uma caixa ou barril no mundo
+struct Box
+{
+    glm::vec4 position;    // Posição da caixa no mundo (x, y, z, 1.0)
+    float rotation_y;      // Rotação em torno do eixo Y (em radianos)
+    glm::vec3 scale;       // Escala da caixa (largura, altura, profundidade)
+
+    Box(glm::vec4 pos, float rot_y = 0.0f, glm::vec3 scl = glm::vec3(0.5f, 0.5f, 0.5f))
+        : position(pos), rotation_y(rot_y), scale(scl)
+    {
+    }
+};
+
+// Estrutura que representa uma wave de monstros
+struct Wave
+{
+    int wave_id;                    // ID único da wave
+    std::vector<EnemyHandle> enemy_handles; // Inimigos desta wave (liberado quando a wave é completada)
+    bool is_active;                  // Se a wave está ativa (ainda tem inimigos vivos)
+    bool is_complete;                // Se todos os inimigos da wave foram derrotados
+
+    Wave(int id) : wave_id(id), is_active(true), is_complete(false)
+    {
+    }
+
+    // Verifica se todos os inimigos da wave estão mortos
+    bool CheckCompletion(const World& world);
+};
+
+// Camadas que um raio pode atingir (RayQuery::layers)
+enum RayLayer
+{
+    RAY_LAYER_NONE    = 0,
+    RAY_LAYER_WORLD   = 1 << 0, // Caixas
+    RAY_LAYER_PLAYER  = 1 << 1,
+    RAY_LAYER_ENEMIES = 1 << 2
+};
+
+// Tiro pedido durante o tick. Os tiros não são resolvidos na hora: ficam em
+// World::ray_queries e são resolvidos todos juntos por Simulation_Step(),
+// depois de UpdateEnemies(), na ordem em que foram pedidos (veja
+// "rayqueries.h").
+struct RayQuery
+{
+    glm::vec4 origin;
+    glm::vec4 direction;  // Normalizada
+    float max_distance;
+    uint32_t layers;      // Combinação de RAY_LAYER_* que o raio pode atingir
+    RayLayer shooter;     // RAY_LAYER_PLAYER ou RAY_LAYER_ENEMIES
+    EnemyHandle shooter_enemy; // Inimigo que atirou (se shooter == RAY_LAYER_ENEMIES)
+    float damage;         // Dano em quem for atingido
+};
+
+// Resultado de um RayQuery: o objeto mais próximo atingido. Em distâncias
+// iguais vale a ordem de RayLayer (uma caixa bloqueia o tiro).
+struct RayHit
+{
+    RayLayer layer;       // RAY_LAYER_NONE se nada foi atingido
+    float t;              // Distância até o ponto atingido
+    EnemyHandle enemy;    // Inimigo atingido (se layer == RAY_LAYER_ENEMIES)
+};
+
+// Comando adiado de UpdateEnemies(): o que um inimigo precisa fazer com
+// estado compartilhado (RandomStream, World::ray_queries). As partes
+// paralelas do tick escrevem os comandos e uma parte serial os aplica, na
+// ordem de "type" e depois de "enemy", qualquer que seja a thread que os
+// escreveu (veja "jobsystem.h").
+enum EnemyCommandType
+{
+    ENEMY_COMMAND_NEW_PATH = 0, // Sortear uma nova curva Bezier
+    ENEMY_COMMAND_REPLAN,       // Idem, porque a curva atual encostou em uma caixa
+    ENEMY_COMMAND_SHOOT_CHECK   // Sortear se atira neste segundo
+};
+
+struct EnemyCommand
+{
+    EnemyCommandType type;
+    uint32_t enemy;       // Índice em World::enemies
+};
+
+// Contadores do planejamento das curvas dos inimigos, desde
+// Simulation_Init(). Cada curva nova é testada inteira contra as caixas
+// ("freespace.h"); se a primeira tentativa encosta em uma caixa, são tentados
+// outros pontos de controle e outros destinos.
+struct EnemyPathStats
+{
+    uint32_t paths;         // Curvas geradas
+    uint32_t perturbed;     // ... que precisaram de mais de uma tentativa
+    uint32_t unresolved;    // ... sem nenhuma tentativa livre (ficam em linha reta mesmo assim)
+    uint32_t replans;       // Curvas abandonadas por colisão durante o movimento
+    uint32_t curves_tested; // Tentativas testadas ao todo
+    uint32_t samples;       // Pontos das curvas testados ao todo
+
+    EnemyPathStats() : paths(0), perturbed(0), unresolved(0), replans(0), curves_tested(0), samples(0) {}
+};
+
+const float g_WaveClearedDelay = 3.0f; // Tempo em segundos antes de iniciar próxima wave
+
+// As caixas do mapa e as estruturas calculadas a partir delas. Nada aqui muda
+// durante a partida, então todos os World com as mesmas caixas (ex.: os
+// milhares de SimulationBatch_Step()) compartilham uma única cópia, criada na
+// primeira vez que Simulation_Init() precisa dela; reiniciar um World não
+// reconstrói nada.
+struct WorldMap
+{
+    std::vector<Box> boxes;         // Lista de caixas/barrils no mundo
+    BoxGrid box_grid;               // "boxes" em uma grade uniforme
+    BoxBVH box_bvh;                 // BVH de box_grid.aabbs para os raycasts
+    FlowField flow_field;           // Células bloqueadas, sem alvo: cada World copia para o seu World::flow_field
+    FreeSpaceGrid enemy_free_space; // Onde a hitbox dos inimigos não encosta em caixas
+};
+
+// Estado completo de um jogo
+struct World
+{
+    Player player;              // Instância do jogador
+    // Inimigos vivos, contíguos e em qualquer ordem: os mortos são removidos
+    // por Simulation_RemoveDeadEnemies(), que move o último inimigo para o
+    // lugar do removido. Índices mudam; para guardar uma referência a um
+    // inimigo, use o seu EnemyHandle.
+    std::vector<Enemy> enemies;
+    EnemyPaths enemy_paths;     // Curvas Bezier, posição e direção dos inimigos, no mesmo índice de "enemies"
+    std::vector<EnemyRaycast> enemy_raycasts; // Debug, no mesmo índice de "enemies" (fora do estado salvo)
+    std::vector<EnemySlot> enemy_slots;     // Tabela dos EnemyHandle; cresce só até o máximo de inimigos vivos
+    std::vector<uint32_t> enemy_free_slots; // Slots livres, reutilizados antes de criar novos
+    uint32_t enemies_dying;     // Inimigos mortos que ainda estão em "enemies"
+    uint32_t enemies_killed;    // Inimigos mortos desde Simulation_Init()
+    float enemy_damage_total;   // Dano causado aos inimigos desde Simulation_Init()
+    EnemyPathStats enemy_path_stats; // Planejamento das curvas dos inimigos
+    std::shared_ptr<const WorldMap> map; // Caixas e estruturas derivadas, compartilhadas (só leitura)
+    FlowField flow_field;       // Caminhos até o jogador (cópia de map->flow_field, FlowField_Update() a cada tick)
+    std::vector<Wave> waves;    // Waves de monstros ainda não completas (UpdateWaves() remove as completas)
+    WaveConfig wave_config;     // Tamanho, formação e dificuldade das waves (mantida por Simulation_Init())
+    std::vector<RayQuery> ray_queries; // Tiros deste tick ainda não resolvidos (vazio entre os ticks)
+    std::vector<RayHit> ray_hits;      // Resultados de ray_queries, no mesmo índice
+    std::vector<glm::vec4> spawn_positions; // Posições da wave sendo criada por SpawnNextWave() (vazio entre os ticks)
+    std::vector<std::vector<EnemyCommand> > enemy_commands; // Comandos adiados, um vetor por thread (vazios entre os ticks)
+    EventBus events;            // Tiros, dano, mortes e waves, para HUD, log, métricas e replays (fora do estado salvo)
+
+    int next_wave_id;           // Contador para gerar IDs únicos de waves
+    int current_wave_number;    // Número da wave atual (1-5)
+    bool wave_cleared;          // Se a wave atual foi completada
+    float wave_cleared_timer;   // Timer para mostrar mensagem e iniciar próxima wave
+
+    CameraMode camera_mode;     // Define como o movimento e o tiro do jogador são orientados
+    double time;                // Tempo simulado, em segundos (soma dos delta_time passados a Simulation_Step())
+    uint32_t tick;              // Ticks executados desde Simulation_Init()
+
+    // Números aleatórios, uma stream por sistema (veja SimulationStream).
+    // Todas derivam de "seed", passada a Simulation_Init().
+    uint32_t seed;
+    RandomStream enemy_paths_rng;
+    RandomStream enemy_shots_rng;
+    RandomStream enemy_spawn_rng;
+
+    World()
+        : enemies_dying(0)
+        , enemies_killed(0)
+        , enemy_damage_total(0.0f)
+        , next_wave_id(0)
+        , current_wave_number(0)
+        , wave_cleared(false)
+        , wave_cleared_timer(0.0f)
+        , camera_mode(CAMERA_THIRD_PERSON) // modo padrão
+        , time(0.0)
+        , tick(0)
+        , seed(0)
+    {
+    }
+};
+
+// Posição (x, y, z, 1.0) e rotação em torno do eixo Y (em radianos) do
+// inimigo "index" de World::enemies, guardadas em World::enemy_paths. As
+// versões interpoladas vão do tick anterior (alpha = 0) ao atual (alpha = 1),
+// para a renderização.
+inline glm::vec4 Simulation_EnemyPosition(const World& world, size_t index)
+{
+    const EnemyPaths& paths = world.enemy_paths;
+    return glm::vec4(paths.x[index], paths.y[index], paths.z[index], 1.0f);
+}
+inline glm::vec4 Simulation_EnemyInterpolatedPosition(const World& world, size_t index, float alpha)
+{
+    const EnemyPaths& paths = world.enemy_paths;
+    return glm::vec4(paths.previous_x[index] + (paths.x[index] - paths.previous_x[index]) * alpha,
+                     paths.y[index],
+                     paths.previous_z[index] + (paths.z[index] - paths.previous_z[index]) * alpha,
+                     1.0f);
+}
+inline float Simulation_EnemyInterpolatedRotationY(const World& world, size_t index, float alpha)
+{
+    // A direção (sin, -cos) de rotation_y, como a do jogador
+    const EnemyPaths& paths = world.enemy_paths;
+    float previous = std::atan2(paths.previous_heading_x[index], -paths.previous_heading_z[index]);
+    float current = std::atan2(paths.heading_x[index], -paths.heading_z[index]);
+    return Simulation_InterpolateAngle(previous, current, alpha);
+}
+
+// Botões de SimulationAction::buttons
+#define SIMULATION_ACTION_FORWARD        (1u << 0)
+#define SIMULATION_ACTION_BACKWARD       (1u << 1)
+#define SIMULATION_ACTION_LEFT           (1u << 2)
+#define SIMULATION_ACTION_RIGHT          (1u << 3)
+#define SIMULATION_ACTION_RUN            (1u << 4)
+#define SIMULATION_ACTION_SHOOT          (1u << 5)
+#define SIMULATION_ACTION_RELOAD         (1u << 6)
+#define SIMULATION_ACTION_THIRD_PERSON   (1u << 7) // Sem este bit, câmera em primeira pessoa
+#define SIMULATION_ACTION_ENEMY_RAYCASTS (1u << 8) // Debug (tecla E): todos os inimigos atiram
+
+// Tudo o que o jogador controla em um tick. O jogo, os agentes de
+// "simulationbatch.h" e os replays ("replay.h") alteram o jogador apenas por
+// meio dela, então gravar uma SimulationAction por tick basta para
+// reproduzir uma partida. yaw e pitch (em radianos) são
+// Player::camera_angle_horizontal e Player::camera_angle_vertical.
+struct SimulationAction
+{
+    unsigned int buttons;  // Combinação de SIMULATION_ACTION_*
+    float yaw;
+    float pitch;
+    float camera_distance; // Player::camera_distance (só em terceira pessoa)
+};
+
+// Tempo acumulado (em segundos) em cada sistema por Simulation_Step()
+struct SimulationTimings
+{
+    double player;
+    double enemies;
+    double waves;
+};
+
+// Bounding boxes dos modelos e valores derivados, compartilhados por todos os
+// World
+extern ModelBounds g_CowboyBounds;
+extern ModelBounds g_BanditBounds;
+extern float g_CowboyMinY; // menor y do cowboy em coordenadas de modelo
+extern float g_BanditMinY;
+extern glm::vec3 g_CowboyCenterModel; // centro do cowboy em coordenadas de modelo
+extern glm::vec3 g_BanditCenterModel; // centro do bandit em coordenadas de modelo
+
+// Guarda as bounding boxes dos modelos e deriva delas os centros e alturas
+// usados no posicionamento e nas colisões.
+void Simulation_SetModelBounds(const ModelBounds& cowboy, const ModelBounds& bandit);
+
+// Lê e grava o descritor com as bounding boxes (arquivo texto). Retornam
+// false em caso de erro.
+bool Simulation_LoadModelBounds(const char* filename);
+bool Simulation_SaveModelBounds(const char* filename);
+
+// (Re)inicia um jogo: posiciona o jogador no mapa compartilhado (WorldMap) e
+// spawna a primeira wave. Deve ser chamada depois de
+// Simulation_SetModelBounds(). "seed" inicializa as streams de números
+// aleatórios do World; o layout das caixas não depende dela. O modo de
+// câmera e a configuração das waves (World::wave_config, que deve ser
+// alterada antes) são mantidos. Dada a mesma semente e as mesmas entradas
+// (SimulationAction) a cada tick, a simulação é sempre a mesma.
+void Simulation_Init(World& world, uint32_t seed);
+
+// Avança a simulação em um tick de delta_time segundos (normalmente
+// 1/SIMULATION_TICK_RATE): jogador, inimigos, tiros e waves. As transformações do
+// jogador antes do tick ficam em previous_position e previous_rotation_y, e
+// as dos inimigos nos campos previous_* de World::enemy_paths. Se "timings"
+// não for NULL, o tempo gasto em cada sistema é somado a ele.
+void Simulation_Step(World& world, float delta_time, SimulationTimings* timings = NULL);
+
+// Aplica a entrada do jogador antes de um tick: câmera, teclas de movimento
+// e, se pedidos, tiro (resolvido no Simulation_Step() seguinte) e recarga.
+// Chamar de novo com a mesma ação e sem os botões SHOOT, RELOAD e
+// ENEMY_RAYCASTS não muda nada, o que permite atualizar a câmera a cada
+// quadro entre os ticks.
+void Simulation_ApplyAction(World& world, const SimulationAction& action);
+
+// Ações do jogador. Simulation_PlayerShoot() atira do centro da câmera, se
+// houver munição e o cooldown tiver acabado, e retorna true se atirou.
+bool Simulation_PlayerShoot(World& world);
+void Simulation_PlayerReload(World& world);
+
+// Versão do formato de Simulation_SaveState(). Incrementada quando a ordem
+// dos valores escritos muda ou quando um campo é acrescentado, removido ou
+// alterado em uma das estruturas copiadas (Player, Enemy, EnemySlot,
+// EnemyHandle, EnemyPathStats, Box, WaveConfig, RandomStream) ou em
+// EnemyPaths. Os snapshots ("snapshot.h") guardam a versão e recusam outras.
+#define SIMULATION_STATE_VERSION 1
+
+// Copia todo o estado de um World (inclusive as streams de números
+// aleatórios) para um bloco de bytes, e de volta. O formato é uma cópia da
+// memória das estruturas: só vale para o mesmo executável. Simulation_LoadState()
+// copia o estado para os vetores que "world" já tem, sem realocá-los se
+// couber; retorna false, sem alterar "world", se os bytes não formam um
+// estado válido.
+void Simulation_SaveState(const World& world, std::vector<unsigned char>* out);
+bool Simulation_LoadState(World& world, const unsigned char* data, size_t size);
+
+// true se todas as waves foram completadas
+bool Simulation_IsFinished(const World& world);
+
+// Inimigo referenciado por "handle", ou NULL se ele já foi removido
+Enemy* Simulation_GetEnemy(World& world, EnemyHandle handle);
+const Enemy* Simulation_GetEnemy(const World& world, EnemyHandle handle);
+
+// Resolve os tiros pedidos (World::ray_queries) e aplica o dano, na ordem em
+// que foram pedidos. Simulation_Step() a chama depois de mover os inimigos;
+// quem chamar diretamente CameraRaycast() ou EnemyToPlayerRaycast() fora de
+// um tick deve chamá-la depois.
+void Simulation_ResolveShots(World& world);
+
+// Remove de World::enemies os inimigos mortos, liberando seus slots.
+// Simulation_Step() a chama ao terminar, então entre os ticks World::enemies
+// só tem inimigos vivos; quem chamar Simulation_ResolveShots() diretamente
+// deve chamá-la depois.
+void Simulation_RemoveDeadEnemies(World& world);
+
+// Liga ou desliga as mensagens de tiros, dano e waves (categorias
+// LOG_CATEGORY_SIMULATION, LOG_CATEGORY_COMBAT e LOG_CATEGORY_WAVES de
+// "logger.h")
+void Simulation_SetVerbose(bool verbose);
+
+bool CheckPlayerBoxCollision(const World& world, const glm::vec4& player_position); // Verifica colisão entre jogador e caixas
+bool CheckEnemyBoxCollision(const World& world, const glm::vec4& enemy_position); // Verifica colisão entre inimigo e caixas
+bool RayAABBIntersection(const glm::vec4& ray_origin, const glm::vec4& ray_dir,
+                         const glm::vec3& box_min, const glm::vec3& box_max, float& t); // Interseção raio-AABB
+void CameraRaycast(World& world, glm::vec4 camera_position, glm::vec4 ray_direction); // Pede um tiro do jogador (veja RayQuery)
+void PlayerRaycast(World& world); // Pede um tiro a partir do centro do jogador na direção que ele está olhando
+void EnemyToPlayerRaycast(World& world, size_t enemy_index); // Vira um inimigo para o jogador e pede um tiro dele
+int SpawnWave(World& world, const std::vector<glm::vec4>& spawn_positions, float enemy_health_multiplier = 1.0f, float enemy_speed_multiplier = 1.0f); // Spawna uma wave de monstros nas posições especificadas, retorna o ID da wave
+bool IsWaveComplete(World& world, int wave_id); // Verifica se todos os monstros de uma wave estão mortos
+void UpdateWaves(World& world, float delta_time); // Atualiza o status de todas as waves
+void SpawnNextWave(World& world); // Spawna a próxima wave de World::wave_config, com dificuldade crescente
+std::vector<int> GetActiveWaves(const World& world); // Retorna os IDs de todas as waves ativas
+std::vector<int> GetCompleteWaves(const World& world); // Retorna os IDs de todas as waves completas
+
+#endif // _SIMULATION_H
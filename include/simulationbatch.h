@@ -0,0 +1,74 @@
+#ifndef _SIMULATIONBATCH_H
+#define _SIMULATIONBATCH_H
+
+#include "simulation.h"
+
+// Passo em lote de muitos jogos independentes (World), para treinar agentes.
+// Veja "simulationbatch.cpp".
+//
+// A cada SimulationBatch_Step() todos os World recebem uma ação
+// (SimulationAction), avançam delta_time segundos e escrevem o que o agente
+// observa em um SimulationObservations. Os World são divididos entre as
+// threads de um pool criado por SimulationBatch_Init(); a thread que chama
+// SimulationBatch_Step() também trabalha e só retorna quando todos terminam.
+//
+// As observações ficam em "structure of arrays": cada campo é um vetor
+// contíguo com um valor por World (ou SIMULATION_OBS_MAX_ENEMIES valores por
+// World, no caso dos inimigos), todos em um único bloco alocado uma vez por
+// SimulationBatch_AllocObservations(). Nada é alocado durante o passo.
+//
+// Um World que terminou (jogador morto ou todas as waves completas) é
+// reiniciado automaticamente no início do passo seguinte; "done" indica que o
+// episódio terminou naquele passo.
+
+// Inimigos observados por World: os primeiros SIMULATION_OBS_MAX_ENEMIES
+// vivos da wave atual, na ordem em que foram criados. Posições que sobram têm
+// vida zero.
+#define SIMULATION_OBS_MAX_ENEMIES 16
+
+// Observações de num_worlds jogos, em "structure of arrays"
+struct SimulationObservations
+{
+    int num_worlds;
+
+    // Um valor por World
+    float* player_x;
+    float* player_z;
+    float* player_health;
+    float* player_ammo;      // Balas no carregador
+    float* player_reloading; // 1.0 se está recarregando
+    float* wave;             // Número da wave atual
+    float* enemies_alive;    // Inimigos vivos na wave atual
+    float* reward;           // (dano causado - dano recebido) / 100 neste passo
+    float* done;             // 1.0 se o episódio terminou neste passo
+
+    // SIMULATION_OBS_MAX_ENEMIES valores por World; o inimigo j do World i
+    // está no índice i*SIMULATION_OBS_MAX_ENEMIES + j
+    float* enemy_x;
+    float* enemy_z;
+    float* enemy_health;
+
+    float* storage; // Bloco único com todos os vetores acima
+};
+
+// Aloca (e zera) ou libera as observações de num_worlds jogos
+bool SimulationBatch_AllocObservations(SimulationObservations* observations, int num_worlds);
+void SimulationBatch_FreeObservations(SimulationObservations* observations);
+
+// Cria o pool com num_threads threads ao todo, contando a que chama
+// SimulationBatch_Step(); 0 usa uma por núcleo. Retorna o número de threads.
+int  SimulationBatch_Init(int num_threads);
+void SimulationBatch_Terminate();
+
+// Escreve as observações de um World na posição "index". Usada por
+// SimulationBatch_Step(), mas também serve para rodar um único World.
+void SimulationBatch_Observe(const World& world, SimulationObservations* observations, int index);
+
+// Avança os num_worlds jogos em paralelo, aplicando actions[i] ao World i, e
+// escreve as observações em "observations", que deve ter sido alocado para
+// pelo menos num_worlds jogos. Sem SimulationBatch_Init(), roda tudo na
+// thread que chama.
+void SimulationBatch_Step(World* worlds, const SimulationAction* actions, int num_worlds,
+                          float delta_time, SimulationObservations* observations);
+
+#endif // _SIMULATIONBATCH_H
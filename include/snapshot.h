@@ -0,0 +1,33 @@
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+#include "simulation.h"
+
+// Snapshots: o estado completo de um World salvo em um arquivo, para voltar
+// a ele depois. Veja "snapshot.cpp".
+//
+// Um snapshot é o mesmo estado dos keyframes dos replays
+// (Simulation_SaveState(): jogador, inimigos com as curvas, caixas, waves,
+// timers e streams de números aleatórios), com um cabeçalho com a versão do
+// formato, a do estado (SIMULATION_STATE_VERSION) e o layout das estruturas
+// copiadas. Serve para benchmarks
+// repetíveis: em vez de jogar até uma cena pesada a cada execução, ela é
+// salva uma vez (fcg_headless --save-snapshot) e carregada em milissegundos
+// (--load-snapshot no fcg_headless e no main).
+//
+// Como nos replays, o estado é uma cópia da memória das estruturas: um
+// snapshot só pode ser carregado pelo mesmo executável que o salvou (e com o
+// mesmo descritor de bounding boxes).
+
+#define SNAPSHOT_VERSION 2 // Incrementada quando o cabeçalho muda (o estado tem a sua versão)
+
+// Salva "world", simulado a tick_rate ticks por segundo, em "filename".
+// Retorna false em caso de erro.
+bool Snapshot_Save(const char* filename, const World& world, int tick_rate);
+
+// Carrega o snapshot de "filename" em "world" e a frequência com que ele foi
+// simulado em "tick_rate". Em caso de erro, imprime o motivo, retorna false
+// e não altera "world".
+bool Snapshot_Load(const char* filename, World& world, int* tick_rate);
+
+#endif // _SNAPSHOT_H
@@ -0,0 +1,47 @@
+#ifndef _STREAMBUFFER_H
+#define _STREAMBUFFER_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// Alocador de geometria dinâmica ("transient"), válido apenas durante um
+// quadro. Veja "streambuffer.cpp".
+//
+// Um único VBO é dividido em STREAM_BUFFER_REGION_COUNT regiões. A cada quadro
+// os vértices são escritos sequencialmente (bump allocation) na região
+// corrente, e um fence (glFenceSync) é inserido no fim do quadro. Uma região
+// só é reutilizada depois que a GPU sinaliza o fence correspondente, então a
+// escrita pode ser feita sem sincronização implícita do driver.
+//
+// Uso típico:
+//
+//     GLint first = StreamBuffer_Upload(vertices, sizeof(vertices), 4*sizeof(float));
+//     glBindVertexArray(vao); // VAO cujos atributos apontam para StreamBuffer_GetBufferID()
+//     glDrawArrays(GL_LINES, first, 2);
+
+#define STREAM_BUFFER_REGION_COUNT 3
+#define STREAM_BUFFER_REGION_SIZE  (512 * 1024)
+
+// Cria o VBO. Deve ser chamada depois de inicializar o OpenGL.
+void StreamBuffer_Init();
+
+// Marca o início e o fim de um quadro. StreamBuffer_BeginFrame() espera (se
+// necessário) a GPU terminar de ler a região que será reutilizada.
+void StreamBuffer_BeginFrame();
+void StreamBuffer_EndFrame();
+
+// Copia "bytes" bytes de "data" para o buffer e retorna o índice do primeiro
+// vértice, assumindo vértices de tamanho "vertex_stride" bytes e atributos
+// especificados com offset 0 no buffer. Retorna -1 em caso de erro.
+GLint StreamBuffer_Upload(const void* data, size_t bytes, size_t vertex_stride);
+
+// Identificador do VBO, para configurar os VAOs que leem dele
+GLuint StreamBuffer_GetBufferID();
+
+// Estatísticas do último quadro completo
+size_t StreamBuffer_BytesLastFrame();   // Bytes enviados para a GPU
+int    StreamBuffer_UploadsLastFrame(); // Número de chamadas a StreamBuffer_Upload()
+int    StreamBuffer_StallsLastFrame();  // Vezes em que foi preciso esperar a GPU
+
+#endif // _STREAMBUFFER_H
@@ -0,0 +1,54 @@
+#ifndef _TRACERECORDER_H
+#define _TRACERECORDER_H
+
+// Gravação de traces no formato "Trace Event" do Chrome (JSON), que pode ser
+// aberto em chrome://tracing ou em https://ui.perfetto.dev. Veja
+// "tracerecorder.cpp".
+//
+// Os eventos são as zonas do profiler de CPU ("cpuprofiler.h"), de todas as
+// threads, mais um evento por quadro. Um trace é gravado em três situações:
+//
+//   - inicialização: do início de main() até o fim do primeiro quadro
+//     (carregamento de modelos, texturas, compilação de shaders, ...);
+//   - captura explícita dos próximos N quadros (tecla ou linha de comando);
+//   - automaticamente, quando um quadro excede o orçamento de tempo
+//     configurado. Como os últimos TRACE_RECORDER_HISTORY_FRAMES quadros são
+//     sempre mantidos em memória, o trace inclui o que aconteceu antes do
+//     "hitch", e não só depois dele.
+
+#define TRACE_RECORDER_HISTORY_FRAMES     120   // Quadros mantidos antes de um hitch
+#define TRACE_RECORDER_POST_HITCH_FRAMES  30    // Quadros gravados depois de um hitch
+#define TRACE_RECORDER_DEFAULT_FRAMES     120   // Quadros de uma captura explícita
+#define TRACE_RECORDER_DEFAULT_BUDGET_MS  100.0 // Orçamento de tempo de um quadro
+#define TRACE_RECORDER_MAX_HITCH_TRACES   3     // Traces automáticos por execução
+
+#ifndef CPU_PROFILER_DISABLED
+
+#include <cstdint>
+
+// Marca o início da inicialização. Deve ser a primeira chamada de main(). Se
+// "capture_startup" for true, a inicialização é gravada em um trace.
+void TraceRecorder_Init(bool capture_startup);
+
+// Orçamento (em ms) acima do qual um quadro dispara um trace. Zero desabilita.
+void TraceRecorder_SetHitchBudget(double budget_ms);
+
+// Grava um trace com os próximos "num_frames" quadros
+void TraceRecorder_CaptureFrames(int num_frames);
+bool TraceRecorder_IsCapturing();
+
+// Chamadas pelo profiler de CPU ao consumir as amostras de um quadro
+void TraceRecorder_AddZone(const char* name, int thread, uint64_t begin_ns, uint64_t end_ns, const char* detail);
+void TraceRecorder_EndFrame(int thread, uint64_t end_ns);
+
+#else // CPU_PROFILER_DISABLED
+
+// Sem o profiler de CPU não há zonas para gravar
+inline void TraceRecorder_Init(bool) {}
+inline void TraceRecorder_SetHitchBudget(double) {}
+inline void TraceRecorder_CaptureFrames(int) {}
+inline bool TraceRecorder_IsCapturing() { return false; }
+
+#endif // CPU_PROFILER_DISABLED
+
+#endif // _TRACERECORDER_H
@@ -0,0 +1,72 @@
+#ifndef _WAVEGENERATOR_H
+#define _WAVEGENERATOR_H
+
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "freespace.h"
+
+// Gerador das waves: quantos inimigos cada wave tem, com que vida e
+// velocidade, e onde eles nascem. Veja "wavegenerator.cpp".
+//
+// Tudo é controlado por um WaveConfig (World::wave_config). O padrão é o
+// jogo de sempre: 5 waves de 4, 6, 8, 10 e 12 inimigos em um anel em volta
+// do jogador. Com max_waves = 0 as waves não acabam, e count_growth > 1 faz
+// o número de inimigos crescer exponencialmente (até max_count). As posições
+// ficam sempre em células livres de FreeSpaceGrid ("freespace.h"), então
+// nenhum inimigo nasce dentro de uma caixa.
+
+#define WAVE_ENDLESS_GROWTH 1.25f // Crescimento das waves no modo sem fim (25% por wave, além de count_step)
+
+struct RandomStream;
+
+// Como os inimigos de uma wave são distribuídos
+enum WaveFormation
+{
+    WAVE_FORMATION_RING = 0, // Anéis em volta do jogador, a partir de spawn_distance
+    WAVE_FORMATION_SCATTER,  // Espalhados pelo mapa, a pelo menos spawn_distance do jogador
+    WAVE_FORMATION_CLUSTERS  // Em num_clusters grupos espalhados pelo mapa
+};
+
+struct WaveConfig
+{
+    int max_waves;              // Número total de waves; 0 para waves sem fim
+    int first_wave;             // Wave em que o jogo começa (1: desde o início)
+    int base_count;             // Inimigos na primeira wave
+    int count_step;             // Inimigos a mais em cada wave
+    float count_growth;         // Multiplicador de base_count a cada wave (1 para crescimento linear)
+    int max_count;              // Máximo de inimigos em uma wave
+    float health_step;          // Vida: 1 + health_step * (wave - 1)
+    float speed_step;           // Velocidade: 1 + speed_step * (wave - 1), até max_speed_multiplier
+    float max_speed_multiplier;
+    WaveFormation formation;
+    float spawn_distance;       // Raio do primeiro anel, ou distância mínima do jogador
+    int num_clusters;           // Grupos de WAVE_FORMATION_CLUSTERS
+
+    WaveConfig()
+        : max_waves(5), first_wave(1), base_count(4), count_step(2), count_growth(1.0f), max_count(1000000)
+        , health_step(0.5f), speed_step(0.2f), max_speed_multiplier(3.0f)
+        , formation(WAVE_FORMATION_RING), spawn_distance(8.0f), num_clusters(4)
+    {
+    }
+};
+
+// Modo sem fim do jogo e do fcg_headless (--endless): max_waves = 0 e
+// count_growth = WAVE_ENDLESS_GROWTH, mantendo o resto de "config"
+void WaveGenerator_SetEndless(WaveConfig& config);
+
+// Número de inimigos e multiplicadores de vida e velocidade da wave "wave"
+// (a primeira é 1)
+int   WaveGenerator_EnemyCount(const WaveConfig& config, int wave);
+float WaveGenerator_HealthMultiplier(const WaveConfig& config, int wave);
+float WaveGenerator_SpeedMultiplier(const WaveConfig& config, int wave);
+
+// Posições de "count" inimigos na formação de "config", em volta de
+// "player" e na altura y, em células livres de "free_space". Sorteios (se a
+// formação precisar) saem de "rng".
+void WaveGenerator_SpawnPositions(const WaveConfig& config, int count, const FreeSpaceGrid& free_space,
+                                  const glm::vec4& player, float y, RandomStream& rng,
+                                  std::vector<glm::vec4>& positions);
+
+#endif // _WAVEGENERATOR_H
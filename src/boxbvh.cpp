@@ -0,0 +1,516 @@
+// BVH das caixas para os raycasts. Veja "boxbvh.h".
+//
+// A construção é feita em duas etapas: primeiro uma árvore binária com uma
+// caixa por folha, dividindo cada nó no plano (entre BOX_BVH_BINS candidatos
+// por eixo) de menor custo pela SAH, e depois a árvore binária é "achatada"
+// em nós de BOX_BVH_WIDTH filhos, abrindo sempre o filho interno de maior
+// área.
+//
+// O teste raio-AABB é o mesmo de RayAABBIntersection() ("simulation.cpp"),
+// com as mesmas operações na mesma ordem, então as distâncias calculadas são
+// idênticas às da busca linear. A versão SSE2 testa os quatro filhos de um nó
+// de uma vez; em outras arquiteturas é usada a versão escalar.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include <glm/common.hpp>
+
+#include "boxbvh.h"
+
+#define BOX_BVH_BINS 12 // Planos candidatos por eixo, para a SAH
+
+// Abaixo desta profundidade da árvore binária os nós são divididos na
+// mediana, o que limita a altura da árvore (e a pilha das consultas) mesmo
+// com caixas em posições degeneradas
+#define BOX_BVH_MAX_SAH_DEPTH 32
+
+// Pilha das consultas: no máximo BOX_BVH_WIDTH - 1 nós por nível ficam
+// esperando, e a árvore tem no máximo BOX_BVH_MAX_SAH_DEPTH + 32 níveis
+#define BOX_BVH_STACK_SIZE 256
+
+// Nó da árvore binária usada na construção
+struct BuildNode
+{
+    BoxAABB bounds;
+    int32_t left, right; // Filhos (nós internos)
+    int32_t box;         // Caixa (folhas); -1 em nós internos
+};
+
+static BoxAABB EmptyAABB()
+{
+    BoxAABB aabb;
+    aabb.min = glm::vec3(FLT_MAX);
+    aabb.max = glm::vec3(-FLT_MAX);
+    return aabb;
+}
+
+static void Grow(BoxAABB& aabb, const glm::vec3& min, const glm::vec3& max)
+{
+    aabb.min = glm::min(aabb.min, min);
+    aabb.max = glm::max(aabb.max, max);
+}
+
+static float SurfaceArea(const BoxAABB& aabb)
+{
+    glm::vec3 extent = aabb.max - aabb.min;
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+static glm::vec3 Centroid(const BoxAABB& aabb)
+{
+    return (aabb.min + aabb.max) * 0.5f;
+}
+
+// Bin da SAH em que cai o centro "center" no eixo "axis"
+static int Bin(const BoxAABB& centroids, int axis, float center)
+{
+    float extent = centroids.max[axis] - centroids.min[axis];
+    int bin = (int)((center - centroids.min[axis]) / extent * BOX_BVH_BINS);
+    return std::min(bin, BOX_BVH_BINS - 1);
+}
+
+// Constrói o nó da árvore binária com as caixas boxes[begin, end) e retorna
+// o índice dele em "nodes"
+static int32_t BuildBinary(std::vector<BuildNode>& nodes, const std::vector<BoxAABB>& aabbs,
+                           std::vector<uint32_t>& boxes, size_t begin, size_t end, int depth)
+{
+    int32_t index = (int32_t)nodes.size();
+    nodes.push_back(BuildNode());
+
+    BoxAABB bounds = EmptyAABB();
+    BoxAABB centroids = EmptyAABB();
+    for (size_t i = begin; i < end; ++i)
+    {
+        const BoxAABB& aabb = aabbs[boxes[i]];
+        glm::vec3 center = Centroid(aabb);
+        Grow(bounds, aabb.min, aabb.max);
+        Grow(centroids, center, center);
+    }
+
+    if (end - begin == 1)
+    {
+        nodes[index].bounds = bounds;
+        nodes[index].left = nodes[index].right = -1;
+        nodes[index].box = (int32_t)boxes[begin];
+        return index;
+    }
+
+    // Procura o plano de menor custo: área * número de caixas de cada lado
+    int best_axis = -1;
+    int best_bin = 0;
+    float best_cost = FLT_MAX;
+    for (int axis = 0; axis < 3 && depth < BOX_BVH_MAX_SAH_DEPTH; ++axis)
+    {
+        if (centroids.max[axis] <= centroids.min[axis])
+            continue;
+
+        BoxAABB bin_bounds[BOX_BVH_BINS];
+        size_t bin_count[BOX_BVH_BINS] = { 0 };
+        for (int b = 0; b < BOX_BVH_BINS; ++b)
+            bin_bounds[b] = EmptyAABB();
+        for (size_t i = begin; i < end; ++i)
+        {
+            const BoxAABB& aabb = aabbs[boxes[i]];
+            int b = Bin(centroids, axis, Centroid(aabb)[axis]);
+            Grow(bin_bounds[b], aabb.min, aabb.max);
+            bin_count[b] += 1;
+        }
+
+        // Custo do lado direito de cada plano, da direita para a esquerda
+        float right_cost[BOX_BVH_BINS];
+        BoxAABB right = EmptyAABB();
+        size_t right_count = 0;
+        for (int b = BOX_BVH_BINS - 1; b > 0; --b)
+        {
+            Grow(right, bin_bounds[b].min, bin_bounds[b].max);
+            right_count += bin_count[b];
+            right_cost[b] = right_count > 0 ? SurfaceArea(right) * right_count : 0.0f;
+        }
+
+        // O plano "b" separa os bins [0, b] dos bins [b + 1, BOX_BVH_BINS)
+        BoxAABB left = EmptyAABB();
+        size_t left_count = 0;
+        for (int b = 0; b < BOX_BVH_BINS - 1; ++b)
+        {
+            Grow(left, bin_bounds[b].min, bin_bounds[b].max);
+            left_count += bin_count[b];
+            if (left_count == 0 || left_count == end - begin)
+                continue;
+
+            float cost = SurfaceArea(left) * left_count + right_cost[b + 1];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = b;
+            }
+        }
+    }
+
+    size_t middle;
+    if (best_axis >= 0)
+    {
+        std::vector<uint32_t>::iterator split = std::partition(
+            boxes.begin() + begin, boxes.begin() + end, [&](uint32_t box)
+            {
+                return Bin(centroids, best_axis, Centroid(aabbs[box])[best_axis]) <= best_bin;
+            });
+        middle = split - boxes.begin();
+    }
+    else
+    {
+        // Todos os centros no mesmo ponto (ou árvore já muito alta): divide
+        // na mediana do eixo mais longo
+        glm::vec3 extent = centroids.max - centroids.min;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        middle = begin + (end - begin) / 2;
+        std::nth_element(boxes.begin() + begin, boxes.begin() + middle, boxes.begin() + end,
+                         [&](uint32_t a, uint32_t b)
+                         {
+                             return Centroid(aabbs[a])[axis] < Centroid(aabbs[b])[axis];
+                         });
+    }
+
+    int32_t left = BuildBinary(nodes, aabbs, boxes, begin, middle, depth + 1);
+    int32_t right = BuildBinary(nodes, aabbs, boxes, middle, end, depth + 1);
+    nodes[index].bounds = bounds;
+    nodes[index].left = left;
+    nodes[index].right = right;
+    nodes[index].box = -1;
+    return index;
+}
+
+// Cria o nó de BOX_BVH_WIDTH filhos correspondente ao nó "build_index" da
+// árvore binária (e, recursivamente, os nós abaixo dele) e retorna o índice
+// dele em bvh.nodes
+static int32_t Flatten(BoxBVH& bvh, const std::vector<BuildNode>& build, int32_t build_index, int level)
+{
+    int32_t index = (int32_t)bvh.nodes.size();
+    bvh.nodes.push_back(BoxBVHNode());
+    bvh.depth = std::max(bvh.depth, level);
+
+    int32_t children[BOX_BVH_WIDTH];
+    int count = 0;
+    if (build[build_index].box >= 0)
+    {
+        children[count++] = build_index;
+    }
+    else
+    {
+        children[count++] = build[build_index].left;
+        children[count++] = build[build_index].right;
+    }
+
+    // Abre o filho interno de maior área até completar o nó
+    while (count < BOX_BVH_WIDTH)
+    {
+        int largest = -1;
+        float largest_area = -1.0f;
+        for (int c = 0; c < count; ++c)
+        {
+            const BuildNode& node = build[children[c]];
+            if (node.box < 0 && SurfaceArea(node.bounds) > largest_area)
+            {
+                largest = c;
+                largest_area = SurfaceArea(node.bounds);
+            }
+        }
+        if (largest < 0)
+            break;
+
+        const BuildNode& node = build[children[largest]];
+        children[largest] = node.left;
+        children[count++] = node.right;
+    }
+
+    for (int c = 0; c < BOX_BVH_WIDTH; ++c)
+    {
+        BoxAABB bounds = EmptyAABB();
+        int32_t child = 0;
+        if (c < count)
+        {
+            const BuildNode& node = build[children[c]];
+            bounds = node.bounds;
+            child = node.box >= 0 ? -(node.box + 1) : Flatten(bvh, build, children[c], level + 1);
+        }
+
+        // Flatten() pode ter realocado bvh.nodes
+        BoxBVHNode& flat = bvh.nodes[index];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            flat.bounds[axis][c] = bounds.min[axis];
+            flat.bounds[axis + 3][c] = bounds.max[axis];
+        }
+        flat.child[c] = child;
+    }
+
+    return index;
+}
+
+void BoxBVH_Build(BoxBVH& bvh, const std::vector<BoxAABB>& aabbs)
+{
+    bvh.nodes.clear();
+    bvh.depth = 0;
+    if (aabbs.empty())
+        return;
+
+    std::vector<uint32_t> boxes(aabbs.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+        boxes[i] = (uint32_t)i;
+
+    std::vector<BuildNode> build;
+    build.reserve(2 * aabbs.size());
+    BuildBinary(build, aabbs, boxes, 0, boxes.size(), 0);
+
+    bvh.nodes.reserve(aabbs.size());
+    Flatten(bvh, build, 0, 1);
+}
+
+// Raio preparado para os testes com os nós
+struct BVHRay
+{
+    float origin[3];
+    float inverse_direction[3];
+    bool  parallel[3];  // Raio paralelo ao eixo (como em RayAABBIntersection())
+    int   near_bound[3]; // Índice em BoxBVHNode::bounds do plano de entrada em cada eixo
+    int   far_bound[3];  // e do plano de saída
+};
+
+static BVHRay MakeRay(const glm::vec4& origin, const glm::vec4& direction)
+{
+    BVHRay ray;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        ray.origin[axis] = origin[axis];
+        ray.parallel[axis] = fabs(direction[axis]) < 1e-6f;
+        ray.inverse_direction[axis] = ray.parallel[axis] ? 0.0f : 1.0f / direction[axis];
+
+        // Com direção negativa o raio entra pelo máximo e sai pelo mínimo
+        bool negative = ray.inverse_direction[axis] < 0.0f;
+        ray.near_bound[axis] = negative ? axis + 3 : axis;
+        ray.far_bound[axis] = negative ? axis : axis + 3;
+    }
+    return ray;
+}
+
+// Testa o raio contra as AABBs dos filhos de "node". Retorna uma máscara com
+// o bit c ligado se o filho c é atingido, e armazena em t_near[c] a distância
+// de entrada (0 se a origem está dentro).
+static int SlabTest(const BoxBVHNode& node, const BVHRay& ray, float t_near[BOX_BVH_WIDTH])
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128 tmin = _mm_setzero_ps();
+    __m128 tmax = _mm_set1_ps(FLT_MAX);
+    __m128 outside = _mm_setzero_ps();
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        __m128 origin = _mm_set1_ps(ray.origin[axis]);
+        if (ray.parallel[axis])
+        {
+            // Só verifica se a origem está dentro da AABB neste eixo
+            outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(origin, _mm_loadu_ps(node.bounds[axis])),
+                                                   _mm_cmpgt_ps(origin, _mm_loadu_ps(node.bounds[axis + 3]))));
+            continue;
+        }
+
+        __m128 inverse_direction = _mm_set1_ps(ray.inverse_direction[axis]);
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[ray.near_bound[axis]]), origin), inverse_direction);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[ray.far_bound[axis]]), origin), inverse_direction);
+        tmin = _mm_max_ps(t0, tmin);
+        tmax = _mm_min_ps(t1, tmax);
+    }
+    _mm_storeu_ps(t_near, tmin);
+    return _mm_movemask_ps(_mm_andnot_ps(outside, _mm_cmpge_ps(tmax, tmin)));
+#else
+    int mask = 0;
+    for (int c = 0; c < BOX_BVH_WIDTH; ++c)
+    {
+        float tmin = 0.0f;
+        float tmax = FLT_MAX;
+        bool outside = false;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (ray.parallel[axis])
+            {
+                outside = outside || ray.origin[axis] < node.bounds[axis][c] ||
+                                     ray.origin[axis] > node.bounds[axis + 3][c];
+                continue;
+            }
+
+            float t0 = (node.bounds[ray.near_bound[axis]][c] - ray.origin[axis]) * ray.inverse_direction[axis];
+            float t1 = (node.bounds[ray.far_bound[axis]][c] - ray.origin[axis]) * ray.inverse_direction[axis];
+            tmin = t0 > tmin ? t0 : tmin;
+            tmax = t1 < tmax ? t1 : tmax;
+        }
+        t_near[c] = tmin;
+        if (!outside && tmax >= tmin)
+            mask |= 1 << c;
+    }
+    return mask;
+#endif
+}
+
+bool BoxBVH_Raycast(const BoxBVH& bvh, const glm::vec4& origin, const glm::vec4& direction,
+                    float max_distance, float& t)
+{
+    if (bvh.nodes.empty())
+        return false;
+
+    BVHRay ray = MakeRay(origin, direction);
+    float closest = max_distance;
+    bool hit = false;
+
+    // Nós a visitar e a distância de entrada em cada um
+    int32_t stack[BOX_BVH_STACK_SIZE];
+    float stack_t[BOX_BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size] = 0;
+    stack_t[stack_size] = 0.0f;
+    stack_size += 1;
+
+    while (stack_size > 0)
+    {
+        stack_size -= 1;
+        // Nenhuma caixa dentro do nó pode estar mais perto que a entrada nele
+        if (stack_t[stack_size] >= closest)
+            continue;
+
+        const BoxBVHNode& node = bvh.nodes[stack[stack_size]];
+        float t_near[BOX_BVH_WIDTH];
+        int mask = SlabTest(node, ray, t_near);
+
+        // Nós filhos atingidos, do mais distante ao mais próximo, para que o
+        // mais próximo seja visitado primeiro
+        int32_t inner[BOX_BVH_WIDTH];
+        float inner_t[BOX_BVH_WIDTH];
+        int num_inner = 0;
+        for (int c = 0; c < BOX_BVH_WIDTH; ++c)
+        {
+            if (!(mask & (1 << c)))
+                continue;
+
+            if (node.child[c] < 0)
+            {
+                // Caixa: mesmo critério de CameraRaycast() com RayAABBIntersection()
+                if (t_near[c] > 0.0f && t_near[c] < closest)
+                {
+                    closest = t_near[c];
+                    hit = true;
+                }
+            }
+            else if (t_near[c] < closest)
+            {
+                int position = num_inner++;
+                while (position > 0 && inner_t[position - 1] < t_near[c])
+                {
+                    inner[position] = inner[position - 1];
+                    inner_t[position] = inner_t[position - 1];
+                    position -= 1;
+                }
+                inner[position] = node.child[c];
+                inner_t[position] = t_near[c];
+            }
+        }
+
+        for (int c = 0; c < num_inner; ++c)
+        {
+            stack[stack_size] = inner[c];
+            stack_t[stack_size] = inner_t[c];
+            stack_size += 1;
+        }
+    }
+
+    if (hit)
+        t = closest;
+    return hit;
+}
+
+void BoxBVH_RaycastPacket(const BoxBVH& bvh, const glm::vec4* origins, const glm::vec4* directions,
+                          int count, float* t, bool* hit)
+{
+    BVHRay rays[BOX_BVH_PACKET_SIZE];
+    for (int r = 0; r < count; ++r)
+    {
+        rays[r] = MakeRay(origins[r], directions[r]);
+        hit[r] = false;
+    }
+    if (bvh.nodes.empty())
+        return;
+
+    // Um nó é visitado se algum raio ainda pode encontrar nele uma caixa mais
+    // próxima que a sua atual. Cada raio testa o nó inteiro, então o
+    // resultado de cada um é o mesmo de BoxBVH_Raycast().
+    int32_t stack[BOX_BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const BoxBVHNode& node = bvh.nodes[stack[--stack_size]];
+        int needed = 0; // Filhos internos que algum raio precisa visitar
+
+        for (int r = 0; r < count; ++r)
+        {
+            float t_near[BOX_BVH_WIDTH];
+            int mask = SlabTest(node, rays[r], t_near);
+            for (int c = 0; c < BOX_BVH_WIDTH; ++c)
+            {
+                if (!(mask & (1 << c)) || t_near[c] >= t[r])
+                    continue;
+
+                if (node.child[c] >= 0)
+                    needed |= 1 << c;
+                else if (t_near[c] > 0.0f)
+                {
+                    t[r] = t_near[c];
+                    hit[r] = true;
+                }
+            }
+        }
+
+        // Em ordem inversa, para que o primeiro filho seja visitado primeiro
+        for (int c = BOX_BVH_WIDTH - 1; c >= 0; --c)
+            if (needed & (1 << c))
+                stack[stack_size++] = node.child[c];
+    }
+}
+
+bool BoxBVH_Occluded(const BoxBVH& bvh, const glm::vec4& origin, const glm::vec4& direction,
+                     float max_distance)
+{
+    if (bvh.nodes.empty())
+        return false;
+
+    BVHRay ray = MakeRay(origin, direction);
+    int32_t stack[BOX_BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const BoxBVHNode& node = bvh.nodes[stack[--stack_size]];
+        float t_near[BOX_BVH_WIDTH];
+        int mask = SlabTest(node, ray, t_near);
+
+        for (int c = 0; c < BOX_BVH_WIDTH; ++c)
+        {
+            if (!(mask & (1 << c)) || t_near[c] > max_distance)
+                continue;
+
+            if (node.child[c] >= 0)
+                stack[stack_size++] = node.child[c];
+            else if (t_near[c] > 0.0f)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// vim: set spell spelllang=pt_br :
@@ -0,0 +1,110 @@
+// Grade uniforme de caixas para consultas de colisão. Veja "boxgrid.h".
+
+#include <cmath>
+
+#include <glm/common.hpp>
+
+#include "boxgrid.h"
+#include "simulation.h"
+
+BoxAABB BoxGrid_ComputeAABB(const Box& box)
+{
+    // O cubo base tem coordenadas de -1 a 1. Como a rotação é apenas em torno
+    // do eixo Y, a extensão em Y não muda, mas em X e Z usamos a diagonal
+    // máxima após a rotação.
+    float max_horizontal_extent = sqrt(box.scale.x * box.scale.x + box.scale.z * box.scale.z);
+
+    BoxAABB aabb;
+    aabb.min = glm::vec3(
+        box.position.x - max_horizontal_extent,
+        box.position.y - box.scale.y,
+        box.position.z - max_horizontal_extent
+    );
+    aabb.max = glm::vec3(
+        box.position.x + max_horizontal_extent,
+        box.position.y + box.scale.y,
+        box.position.z + max_horizontal_extent
+    );
+    return aabb;
+}
+
+// Célula que contém a coordenada, limitada à grade
+static int CellX(const BoxGrid& grid, float x)
+{
+    int cell = (int)floorf((x - grid.origin_x) / BOX_GRID_CELL_SIZE);
+    return glm::clamp(cell, 0, grid.cells_x - 1);
+}
+
+static int CellZ(const BoxGrid& grid, float z)
+{
+    int cell = (int)floorf((z - grid.origin_z) / BOX_GRID_CELL_SIZE);
+    return glm::clamp(cell, 0, grid.cells_z - 1);
+}
+
+void BoxGrid_Build(BoxGrid& grid, const std::vector<Box>& boxes)
+{
+    grid.origin_x = MAP_MIN_X;
+    grid.origin_z = MAP_MIN_Z;
+    grid.cells_x = (int)ceilf((MAP_MAX_X - MAP_MIN_X) / BOX_GRID_CELL_SIZE);
+    grid.cells_z = (int)ceilf((MAP_MAX_Z - MAP_MIN_Z) / BOX_GRID_CELL_SIZE);
+
+    grid.aabbs.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+        grid.aabbs[i] = BoxGrid_ComputeAABB(boxes[i]);
+
+    // Duas passadas: conta as caixas de cada célula, transforma as contagens
+    // em posições iniciais e então preenche
+    size_t num_cells = (size_t)grid.cells_x * grid.cells_z;
+    grid.cell_start.assign(num_cells + 1, 0);
+    for (const BoxAABB& aabb : grid.aabbs)
+        for (int z = CellZ(grid, aabb.min.z); z <= CellZ(grid, aabb.max.z); ++z)
+            for (int x = CellX(grid, aabb.min.x); x <= CellX(grid, aabb.max.x); ++x)
+                grid.cell_start[z * grid.cells_x + x + 1] += 1;
+
+    for (size_t c = 0; c < num_cells; ++c)
+        grid.cell_start[c + 1] += grid.cell_start[c];
+
+    std::vector<uint32_t> next(grid.cell_start.begin(), grid.cell_start.end() - 1);
+    grid.cell_boxes.resize(grid.cell_start[num_cells]);
+    for (size_t i = 0; i < grid.aabbs.size(); ++i)
+    {
+        const BoxAABB& aabb = grid.aabbs[i];
+        for (int z = CellZ(grid, aabb.min.z); z <= CellZ(grid, aabb.max.z); ++z)
+            for (int x = CellX(grid, aabb.min.x); x <= CellX(grid, aabb.max.x); ++x)
+                grid.cell_boxes[next[z * grid.cells_x + x]++] = (uint32_t)i;
+    }
+}
+
+bool BoxGrid_OverlapsSphere(const BoxGrid& grid, const glm::vec3& center, float radius)
+{
+    if (grid.cell_boxes.empty())
+        return false;
+
+    // Uma caixa que ocupa várias células pode ser testada mais de uma vez;
+    // como só interessa se há colisão, não vale a pena evitar isso
+    int min_x = CellX(grid, center.x - radius);
+    int max_x = CellX(grid, center.x + radius);
+    int min_z = CellZ(grid, center.z - radius);
+    int max_z = CellZ(grid, center.z + radius);
+    for (int z = min_z; z <= max_z; ++z)
+    {
+        for (int x = min_x; x <= max_x; ++x)
+        {
+            int cell = z * grid.cells_x + x;
+            for (uint32_t i = grid.cell_start[cell]; i < grid.cell_start[cell + 1]; ++i)
+            {
+                const BoxAABB& aabb = grid.aabbs[grid.cell_boxes[i]];
+
+                // Ponto da AABB mais próximo do centro da esfera
+                glm::vec3 closest_point = glm::clamp(center, aabb.min, aabb.max);
+                glm::vec3 offset = center - closest_point;
+                float distance_sq = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+                if (distance_sq < radius * radius)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+// vim: set spell spelllang=pt_br :
@@ -0,0 +1,263 @@
+// Profiler de CPU. Veja "cpuprofiler.h".
+//
+// As zonas escrevem suas amostras em um ring buffer multi-produtor com um
+// único consumidor (CpuProfiler_EndFrame()), o mesmo anel da fila de entrada
+// ("inputqueue.cpp"): cada posição guarda um número de sequência que diz se
+// ela está livre para a volta corrente do anel ou já tem uma amostra
+// publicada. Um produtor reserva a posição com um compare_exchange no índice
+// de escrita; se o consumidor ainda não a leu, o anel está cheio e a amostra
+// é descartada, em vez de sobrescrever uma posição que pode estar sendo lida.
+// Nenhuma thread bloqueia esperando por outra.
+
+#ifndef CPU_PROFILER_DISABLED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "cpuprofiler.h"
+#include "tracerecorder.h"
+
+struct CpuProfilerSample
+{
+    std::atomic<uint32_t> sequence; // Início da volta do anel + 0 (livre), 1 (publicada) ou CPU_PROFILER_RING_SIZE (lida)
+    int                   zone;
+    int                   thread;
+    uint64_t              begin_ns;
+    uint64_t              end_ns;
+    char                  detail[CPU_PROFILER_DETAIL_LENGTH];
+};
+
+// Tempos de um quadro já fechado
+struct CpuProfilerFrame
+{
+    uint64_t end_ns;
+    float    frame_ms;
+    float    zone_ms[CPU_PROFILER_MAX_ZONES];
+};
+
+static CpuProfilerSample     g_Samples[CPU_PROFILER_RING_SIZE];
+static std::atomic<uint32_t> g_WriteIndex(0);
+static uint32_t              g_ReadIndex = 0;
+static std::atomic<int>      g_DroppedSamples(0);
+
+static const char* g_ZoneNames[CPU_PROFILER_MAX_ZONES];
+static std::atomic<int> g_NumZones(0);
+static std::mutex g_ZoneMutex;
+
+static const char*      g_ThreadNames[CPU_PROFILER_MAX_THREADS];
+static std::atomic<int> g_NumThreads(0);
+static thread_local int t_ThreadIndex = -1;
+
+static CpuProfilerFrame g_Frames[CPU_PROFILER_HISTORY_FRAMES];
+static int              g_FrameCount = 0; // Quadros válidos em g_Frames
+static int              g_FrameNext = 0;  // Próxima posição de escrita (anel)
+static float            g_CurrentZoneMs[CPU_PROFILER_MAX_ZONES];
+static uint64_t         g_LastFrameEnd = 0;
+
+uint64_t CpuProfiler_Now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int CpuProfiler_RegisterZone(const char* name)
+{
+    std::lock_guard<std::mutex> lock(g_ZoneMutex);
+
+    int num_zones = g_NumZones.load();
+    for (int i = 0; i < num_zones; ++i)
+        if (strcmp(g_ZoneNames[i], name) == 0)
+            return i;
+
+    if (num_zones == CPU_PROFILER_MAX_ZONES)
+        return -1;
+
+    g_ZoneNames[num_zones] = name;
+    g_NumZones.store(num_zones + 1);
+    return num_zones;
+}
+
+int CpuProfiler_ThreadIndex()
+{
+    if (t_ThreadIndex < 0)
+        t_ThreadIndex = std::min(g_NumThreads.fetch_add(1), CPU_PROFILER_MAX_THREADS - 1);
+    return t_ThreadIndex;
+}
+
+void CpuProfiler_SetThreadName(const char* name)
+{
+    g_ThreadNames[CpuProfiler_ThreadIndex()] = name;
+}
+
+int CpuProfiler_ThreadCount()
+{
+    return std::min(g_NumThreads.load(), CPU_PROFILER_MAX_THREADS);
+}
+
+const char* CpuProfiler_ThreadName(int thread)
+{
+    return g_ThreadNames[thread];
+}
+
+void CpuProfiler_Record(int zone, uint64_t begin_ns, uint64_t end_ns, const char* detail)
+{
+    if (zone < 0)
+        return;
+
+    const uint32_t lap_mask = ~(uint32_t)(CPU_PROFILER_RING_SIZE - 1);
+    uint32_t index = g_WriteIndex.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        CpuProfilerSample& slot = g_Samples[index & (CPU_PROFILER_RING_SIZE - 1)];
+        int32_t difference = (int32_t)(slot.sequence.load(std::memory_order_acquire) - (index & lap_mask));
+        if (difference == 0)
+        {
+            if (g_WriteIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            g_DroppedSamples.fetch_add(1, std::memory_order_relaxed); // Ainda não lida: anel cheio
+            return;
+        }
+        else
+            index = g_WriteIndex.load(std::memory_order_relaxed); // Outro produtor pegou a posição
+    }
+
+    CpuProfilerSample& sample = g_Samples[index & (CPU_PROFILER_RING_SIZE - 1)];
+    sample.zone = zone;
+    sample.thread = CpuProfiler_ThreadIndex();
+    sample.begin_ns = begin_ns;
+    sample.end_ns = end_ns;
+    sample.detail[0] = '\0';
+    if (detail)
+    {
+        strncpy(sample.detail, detail, CPU_PROFILER_DETAIL_LENGTH - 1);
+        sample.detail[CPU_PROFILER_DETAIL_LENGTH - 1] = '\0';
+    }
+    sample.sequence.store((index & lap_mask) + 1, std::memory_order_release);
+}
+
+void CpuProfiler_EndFrame()
+{
+    uint32_t write_index = g_WriteIndex.load(std::memory_order_acquire);
+    while (g_ReadIndex != write_index)
+    {
+        CpuProfilerSample& sample = g_Samples[g_ReadIndex & (CPU_PROFILER_RING_SIZE - 1)];
+        uint32_t lap = g_ReadIndex & ~(uint32_t)(CPU_PROFILER_RING_SIZE - 1);
+        // Posição reservada mas ainda não publicada: lemos no próximo quadro
+        if (sample.sequence.load(std::memory_order_acquire) != lap + 1)
+            break;
+
+        g_CurrentZoneMs[sample.zone] += (sample.end_ns - sample.begin_ns) / 1.0e6f;
+        TraceRecorder_AddZone(g_ZoneNames[sample.zone], sample.thread, sample.begin_ns, sample.end_ns, sample.detail);
+        sample.sequence.store(lap + CPU_PROFILER_RING_SIZE, std::memory_order_release);
+        g_ReadIndex += 1;
+    }
+
+    uint64_t now = CpuProfiler_Now();
+    TraceRecorder_EndFrame(CpuProfiler_ThreadIndex(), now);
+    if (g_LastFrameEnd != 0)
+    {
+        CpuProfilerFrame& frame = g_Frames[g_FrameNext];
+        frame.end_ns = now;
+        frame.frame_ms = (now - g_LastFrameEnd) / 1.0e6f;
+        memcpy(frame.zone_ms, g_CurrentZoneMs, sizeof(g_CurrentZoneMs));
+
+        g_FrameNext = (g_FrameNext + 1) % CPU_PROFILER_HISTORY_FRAMES;
+        g_FrameCount = std::min(g_FrameCount + 1, CPU_PROFILER_HISTORY_FRAMES);
+    }
+    g_LastFrameEnd = now;
+
+    memset(g_CurrentZoneMs, 0, sizeof(g_CurrentZoneMs));
+}
+
+// Número de quadros (a partir do mais recente) dentro da janela de estatísticas
+static int FramesInWindow()
+{
+    const uint64_t window_ns = (uint64_t)(CPU_PROFILER_WINDOW_SECONDS * 1.0e9);
+    int n = 0;
+    while (n < g_FrameCount)
+    {
+        const CpuProfilerFrame& frame = g_Frames[(g_FrameNext - 1 - n + CPU_PROFILER_HISTORY_FRAMES) % CPU_PROFILER_HISTORY_FRAMES];
+        if (g_LastFrameEnd - frame.end_ns > window_ns)
+            break;
+        n += 1;
+    }
+    return n;
+}
+
+static const CpuProfilerFrame& RecentFrame(int i)
+{
+    return g_Frames[(g_FrameNext - 1 - i + CPU_PROFILER_HISTORY_FRAMES) % CPU_PROFILER_HISTORY_FRAMES];
+}
+
+int CpuProfiler_ZoneCount()
+{
+    return g_NumZones.load();
+}
+
+const char* CpuProfiler_ZoneName(int zone)
+{
+    return g_ZoneNames[zone];
+}
+
+double CpuProfiler_ZoneAverageMs(int zone)
+{
+    int n = FramesInWindow();
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i)
+        sum += RecentFrame(i).zone_ms[zone];
+    return n > 0 ? sum / n : 0.0;
+}
+
+double CpuProfiler_ZoneMaxMs(int zone)
+{
+    int n = FramesInWindow();
+    double max = 0.0;
+    for (int i = 0; i < n; ++i)
+        max = std::max(max, (double)RecentFrame(i).zone_ms[zone]);
+    return max;
+}
+
+void CpuProfiler_FramePercentiles(double* p50_ms, double* p95_ms, double* p99_ms)
+{
+    int n = FramesInWindow();
+    if (n == 0)
+    {
+        *p50_ms = *p95_ms = *p99_ms = 0.0;
+        return;
+    }
+
+    static std::vector<float> frame_ms;
+    frame_ms.resize(n);
+    for (int i = 0; i < n; ++i)
+        frame_ms[i] = RecentFrame(i).frame_ms;
+    std::sort(frame_ms.begin(), frame_ms.end());
+
+    // Percentil pelo método "nearest rank": o menor valor que é maior ou
+    // igual a p% das amostras.
+    *p50_ms = frame_ms[std::max(0, (int)ceil(0.50 * n) - 1)];
+    *p95_ms = frame_ms[std::max(0, (int)ceil(0.95 * n) - 1)];
+    *p99_ms = frame_ms[std::max(0, (int)ceil(0.99 * n) - 1)];
+}
+
+int CpuProfiler_DroppedSamples()
+{
+    return g_DroppedSamples.load();
+}
+
+int CpuProfiler_RecentFrameTimes(float* frame_ms, int max_frames)
+{
+    int n = std::min(max_frames, g_FrameCount);
+    for (int i = 0; i < n; ++i)
+        frame_ms[n - 1 - i] = RecentFrame(i).frame_ms;
+    return n;
+}
+
+#endif // CPU_PROFILER_DISABLED
@@ -0,0 +1,430 @@
+// Kernel de movimento dos inimigos ao longo das curvas Bezier. Veja
+// "enemypaths.h".
+//
+// Para cada inimigo, com u = 1 - t:
+//
+//     B(t)  = u³ P0 + 3u²t P1 + 3ut² P2 + t³ P3
+//     B'(t) = 3u² (P1 - P0) + 6ut (P2 - P1) + 3t² (P3 - P2)
+//
+// A direção do movimento vem da derivada, em vez de avaliar a curva uma
+// segunda vez em t + 0.01, e é normalizada aqui: é a própria direção do
+// inimigo, sem sin() nem cos().
+//
+// O parâmetro t vem da distância percorrida s: a tabela de comprimento de
+// arco diz em qual intervalo [k, k + 1] / ENEMY_PATHS_ARC_SAMPLES está s, e
+// dentro do intervalo t é interpolado linearmente. A versão escalar acha o
+// intervalo por busca binária. Nos kernels SIMD, em que cada inimigo tomaria
+// um caminho diferente na busca, s é comparado com todas as entradas da
+// tabela: como ela é crescente, o número de entradas até s é o intervalo, e
+// as comparações são as mesmas para os quatro ou oito inimigos.
+//
+// Os kernels SIMD só usam soma, multiplicação, divisão, raiz quadrada,
+// mínimo e comparações, que dão o mesmo resultado que as operações escalares,
+// na mesma ordem. Assim a simulação é a mesma com qualquer kernel (desde que
+// o compilador não junte multiplicações e somas em FMA).
+
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "enemypaths.h"
+
+// Inimigos com |B'(t)| menor que isto não mudam de direção (mesmo limiar de
+// 0.001 que era usado para a diferença entre B(t + 0.01) e B(t))
+#define ENEMY_PATHS_MIN_HEADING_SQ 0.01f
+
+// Cordas por entrada da tabela ao medir o comprimento da curva
+#define ENEMY_PATHS_ARC_SUBSTEPS 4
+
+#define ENEMY_PATHS_NUM_FIELDS (20 + ENEMY_PATHS_ARC_SAMPLES)
+
+// Todos os vetores de "paths"
+static void GetFields(EnemyPaths& paths, std::vector<float>* fields[ENEMY_PATHS_NUM_FIELDS])
+{
+    std::vector<float>* all[20] = {
+        &paths.p0_x, &paths.p0_z, &paths.p1_x, &paths.p1_z,
+        &paths.p2_x, &paths.p2_z, &paths.p3_x, &paths.p3_z,
+        &paths.distance, &paths.speed, &paths.y,
+        &paths.progress, &paths.x, &paths.z, &paths.heading_x, &paths.heading_z,
+        &paths.previous_x, &paths.previous_z, &paths.previous_heading_x, &paths.previous_heading_z
+    };
+    for (int i = 0; i < 20; ++i)
+        fields[i] = all[i];
+    for (int k = 0; k < ENEMY_PATHS_ARC_SAMPLES; ++k)
+        fields[20 + k] = &paths.arc_length[k];
+}
+
+void EnemyPaths_Resize(EnemyPaths& paths, size_t size)
+{
+    std::vector<float>* fields[ENEMY_PATHS_NUM_FIELDS];
+    GetFields(paths, fields);
+    for (std::vector<float>* field : fields)
+    {
+        // Direção inicial (0, -1): rotação zero em torno do eixo Y
+        bool heading_z = field == &paths.heading_z || field == &paths.previous_heading_z;
+        field->resize(size, heading_z ? -1.0f : 0.0f);
+    }
+}
+
+void EnemyPaths_SavePrevious(EnemyPaths& paths)
+{
+    // Mesmo tamanho: as cópias não realocam
+    paths.previous_x = paths.x;
+    paths.previous_z = paths.z;
+    paths.previous_heading_x = paths.heading_x;
+    paths.previous_heading_z = paths.heading_z;
+}
+
+void EnemyPaths_SwapRemove(EnemyPaths& paths, size_t index)
+{
+    std::vector<float>* fields[ENEMY_PATHS_NUM_FIELDS];
+    GetFields(paths, fields);
+    for (std::vector<float>* field : fields)
+    {
+        (*field)[index] = field->back();
+        field->pop_back();
+    }
+}
+
+void EnemyPaths_Clear(EnemyPaths& paths)
+{
+    EnemyPaths_Resize(paths, 0);
+}
+
+void EnemyPaths_SetCurve(EnemyPaths& paths, size_t index, const float x[4], const float z[4], float speed)
+{
+    paths.p0_x[index] = x[0];
+    paths.p0_z[index] = z[0];
+    paths.p1_x[index] = x[1];
+    paths.p1_z[index] = z[1];
+    paths.p2_x[index] = x[2];
+    paths.p2_z[index] = z[2];
+    paths.p3_x[index] = x[3];
+    paths.p3_z[index] = z[3];
+
+    // Soma das cordas entre pontos próximos da curva. A diferença para o
+    // comprimento exato é desprezível com tantos pontos.
+    const int num_steps = ENEMY_PATHS_ARC_SAMPLES * ENEMY_PATHS_ARC_SUBSTEPS;
+    float length = 0.0f;
+    float previous_x = x[0];
+    float previous_z = z[0];
+    for (int step = 1; step <= num_steps; ++step)
+    {
+        float t = (float)step / num_steps;
+        float u = 1.0f - t;
+        float b0 = u * u * u;
+        float b1 = 3.0f * u * u * t;
+        float b2 = 3.0f * u * t * t;
+        float b3 = t * t * t;
+        float point_x = b0 * x[0] + b1 * x[1] + b2 * x[2] + b3 * x[3];
+        float point_z = b0 * z[0] + b1 * z[1] + b2 * z[2] + b3 * z[3];
+
+        length += sqrtf((point_x - previous_x) * (point_x - previous_x) +
+                        (point_z - previous_z) * (point_z - previous_z));
+        previous_x = point_x;
+        previous_z = point_z;
+
+        if (step % ENEMY_PATHS_ARC_SUBSTEPS == 0)
+            paths.arc_length[step / ENEMY_PATHS_ARC_SUBSTEPS - 1][index] = length;
+    }
+
+    paths.distance[index] = 0.0f;
+    paths.speed[index] = speed;
+    paths.progress[index] = 0.0f;
+}
+
+void EnemyPaths_UpdateScalar(EnemyPaths& paths, size_t begin, size_t end, float delta_time)
+{
+    const float* p0_x = paths.p0_x.data();
+    const float* p0_z = paths.p0_z.data();
+    const float* p1_x = paths.p1_x.data();
+    const float* p1_z = paths.p1_z.data();
+    const float* p2_x = paths.p2_x.data();
+    const float* p2_z = paths.p2_z.data();
+    const float* p3_x = paths.p3_x.data();
+    const float* p3_z = paths.p3_z.data();
+    const float* speed = paths.speed.data();
+    float* distance = paths.distance.data();
+    float* progress = paths.progress.data();
+    float* x = paths.x.data();
+    float* z = paths.z.data();
+    float* heading_x = paths.heading_x.data();
+    float* heading_z = paths.heading_z.data();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        float total = paths.arc_length[ENEMY_PATHS_ARC_SAMPLES - 1][i];
+        float s = distance[i] + speed[i] * delta_time;
+        if (s > total)
+            s = total;
+        distance[i] = s;
+
+        // Intervalo da tabela que contém s, por busca binária: "samples"
+        // entradas (sem contar a última, o total) são <= s; lo e hi são o
+        // comprimento no início e no fim do intervalo. Dá o mesmo intervalo
+        // que as comparações com todas as entradas dos kernels SIMD.
+        int samples = 0;
+        int remaining = ENEMY_PATHS_ARC_SAMPLES - 1;
+        while (remaining > 0)
+        {
+            int half = remaining / 2;
+            if (s >= paths.arc_length[samples + half][i])
+            {
+                samples += half + 1;
+                remaining -= half + 1;
+            }
+            else
+                remaining = half;
+        }
+        float lo = samples > 0 ? paths.arc_length[samples - 1][i] : 0.0f;
+        float hi = paths.arc_length[samples][i];
+        float interval = hi - lo;
+        float fraction = interval > 0.0f ? (s - lo) / interval : 0.0f;
+        float t = ((float)samples + fraction) * (1.0f / ENEMY_PATHS_ARC_SAMPLES);
+        if (s >= total)
+            t = 1.0f;
+        progress[i] = t;
+
+        float u = 1.0f - t;
+        float uu = u * u;
+        float tt = t * t;
+
+        // Posição
+        float b0 = uu * u;
+        float b1 = 3.0f * uu * t;
+        float b2 = 3.0f * u * tt;
+        float b3 = tt * t;
+        x[i] = b0 * p0_x[i] + b1 * p1_x[i] + b2 * p2_x[i] + b3 * p3_x[i];
+        z[i] = b0 * p0_z[i] + b1 * p1_z[i] + b2 * p2_z[i] + b3 * p3_z[i];
+
+        // Derivada
+        float d0 = 3.0f * uu;
+        float d1 = 6.0f * u * t;
+        float d2 = 3.0f * tt;
+        float dx = d0 * (p1_x[i] - p0_x[i]) + d1 * (p2_x[i] - p1_x[i]) + d2 * (p3_x[i] - p2_x[i]);
+        float dz = d0 * (p1_z[i] - p0_z[i]) + d1 * (p2_z[i] - p1_z[i]) + d2 * (p3_z[i] - p2_z[i]);
+
+        float length_sq = dx * dx + dz * dz;
+        if (length_sq > ENEMY_PATHS_MIN_HEADING_SQ && t < 1.0f)
+        {
+            float inverse_length = 1.0f / sqrtf(length_sq);
+            heading_x[i] = dx * inverse_length;
+            heading_z[i] = dz * inverse_length;
+        }
+        else
+        {
+            heading_x[i] = 0.0f;
+            heading_z[i] = 0.0f;
+        }
+    }
+}
+
+#if defined(__AVX__)
+
+// Oito inimigos por iteração, a partir de "begin". Retorna o índice do
+// primeiro que não foi processado.
+static size_t UpdateAVX(EnemyPaths& paths, size_t begin, size_t end, float delta_time)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 six = _mm256_set1_ps(6.0f);
+    const __m256 min_heading_sq = _mm256_set1_ps(ENEMY_PATHS_MIN_HEADING_SQ);
+    const __m256 dt = _mm256_set1_ps(delta_time);
+    const __m256 inverse_samples = _mm256_set1_ps(1.0f / ENEMY_PATHS_ARC_SAMPLES);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 p0x = _mm256_loadu_ps(&paths.p0_x[i]);
+        __m256 p0z = _mm256_loadu_ps(&paths.p0_z[i]);
+        __m256 p1x = _mm256_loadu_ps(&paths.p1_x[i]);
+        __m256 p1z = _mm256_loadu_ps(&paths.p1_z[i]);
+        __m256 p2x = _mm256_loadu_ps(&paths.p2_x[i]);
+        __m256 p2z = _mm256_loadu_ps(&paths.p2_z[i]);
+        __m256 p3x = _mm256_loadu_ps(&paths.p3_x[i]);
+        __m256 p3z = _mm256_loadu_ps(&paths.p3_z[i]);
+
+        __m256 total = _mm256_loadu_ps(&paths.arc_length[ENEMY_PATHS_ARC_SAMPLES - 1][i]);
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(&paths.distance[i]),
+                                 _mm256_mul_ps(_mm256_loadu_ps(&paths.speed[i]), dt));
+        s = _mm256_min_ps(s, total);
+        _mm256_storeu_ps(&paths.distance[i], s);
+
+        __m256 samples = _mm256_setzero_ps();
+        __m256 lo = _mm256_setzero_ps();
+        __m256 hi = total;
+        for (int k = 0; k < ENEMY_PATHS_ARC_SAMPLES - 1; ++k)
+        {
+            __m256 length = _mm256_loadu_ps(&paths.arc_length[k][i]);
+            __m256 reached = _mm256_cmp_ps(s, length, _CMP_GE_OQ);
+            samples = _mm256_add_ps(samples, _mm256_and_ps(reached, one));
+            lo = _mm256_blendv_ps(lo, length, reached);
+            hi = _mm256_min_ps(hi, _mm256_blendv_ps(length, total, reached));
+        }
+        __m256 interval = _mm256_sub_ps(hi, lo);
+        __m256 fraction = _mm256_and_ps(_mm256_cmp_ps(interval, _mm256_setzero_ps(), _CMP_GT_OQ),
+                                        _mm256_div_ps(_mm256_sub_ps(s, lo), interval));
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(samples, fraction), inverse_samples);
+        t = _mm256_blendv_ps(t, one, _mm256_cmp_ps(s, total, _CMP_GE_OQ));
+        _mm256_storeu_ps(&paths.progress[i], t);
+
+        __m256 u = _mm256_sub_ps(one, t);
+        __m256 uu = _mm256_mul_ps(u, u);
+        __m256 tt = _mm256_mul_ps(t, t);
+
+        // Posição
+        __m256 b0 = _mm256_mul_ps(uu, u);
+        __m256 b1 = _mm256_mul_ps(_mm256_mul_ps(three, uu), t);
+        __m256 b2 = _mm256_mul_ps(_mm256_mul_ps(three, u), tt);
+        __m256 b3 = _mm256_mul_ps(tt, t);
+        __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b0, p0x), _mm256_mul_ps(b1, p1x)),
+                                               _mm256_mul_ps(b2, p2x)), _mm256_mul_ps(b3, p3x));
+        __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b0, p0z), _mm256_mul_ps(b1, p1z)),
+                                               _mm256_mul_ps(b2, p2z)), _mm256_mul_ps(b3, p3z));
+        _mm256_storeu_ps(&paths.x[i], x);
+        _mm256_storeu_ps(&paths.z[i], z);
+
+        // Derivada
+        __m256 d0 = _mm256_mul_ps(three, uu);
+        __m256 d1 = _mm256_mul_ps(_mm256_mul_ps(six, u), t);
+        __m256 d2 = _mm256_mul_ps(three, tt);
+        __m256 dx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d0, _mm256_sub_ps(p1x, p0x)),
+                                                _mm256_mul_ps(d1, _mm256_sub_ps(p2x, p1x))),
+                                  _mm256_mul_ps(d2, _mm256_sub_ps(p3x, p2x)));
+        __m256 dz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d0, _mm256_sub_ps(p1z, p0z)),
+                                                _mm256_mul_ps(d1, _mm256_sub_ps(p2z, p1z))),
+                                  _mm256_mul_ps(d2, _mm256_sub_ps(p3z, p2z)));
+
+        __m256 length_sq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz));
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(length_sq, min_heading_sq, _CMP_GT_OQ),
+                                     _mm256_cmp_ps(t, one, _CMP_LT_OQ));
+        __m256 inverse_length = _mm256_div_ps(one, _mm256_sqrt_ps(length_sq));
+        _mm256_storeu_ps(&paths.heading_x[i], _mm256_and_ps(valid, _mm256_mul_ps(dx, inverse_length)));
+        _mm256_storeu_ps(&paths.heading_z[i], _mm256_and_ps(valid, _mm256_mul_ps(dz, inverse_length)));
+    }
+    return i;
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+// "a" onde "mask" é verdadeira, "b" nas outras posições
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Quatro inimigos por iteração, a partir de "begin". Retorna o índice do
+// primeiro que não foi processado.
+static size_t UpdateSSE2(EnemyPaths& paths, size_t begin, size_t end, float delta_time)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 six = _mm_set1_ps(6.0f);
+    const __m128 min_heading_sq = _mm_set1_ps(ENEMY_PATHS_MIN_HEADING_SQ);
+    const __m128 dt = _mm_set1_ps(delta_time);
+    const __m128 inverse_samples = _mm_set1_ps(1.0f / ENEMY_PATHS_ARC_SAMPLES);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 p0x = _mm_loadu_ps(&paths.p0_x[i]);
+        __m128 p0z = _mm_loadu_ps(&paths.p0_z[i]);
+        __m128 p1x = _mm_loadu_ps(&paths.p1_x[i]);
+        __m128 p1z = _mm_loadu_ps(&paths.p1_z[i]);
+        __m128 p2x = _mm_loadu_ps(&paths.p2_x[i]);
+        __m128 p2z = _mm_loadu_ps(&paths.p2_z[i]);
+        __m128 p3x = _mm_loadu_ps(&paths.p3_x[i]);
+        __m128 p3z = _mm_loadu_ps(&paths.p3_z[i]);
+
+        __m128 total = _mm_loadu_ps(&paths.arc_length[ENEMY_PATHS_ARC_SAMPLES - 1][i]);
+        __m128 s = _mm_add_ps(_mm_loadu_ps(&paths.distance[i]),
+                              _mm_mul_ps(_mm_loadu_ps(&paths.speed[i]), dt));
+        s = _mm_min_ps(s, total);
+        _mm_storeu_ps(&paths.distance[i], s);
+
+        __m128 samples = _mm_setzero_ps();
+        __m128 lo = _mm_setzero_ps();
+        __m128 hi = total;
+        for (int k = 0; k < ENEMY_PATHS_ARC_SAMPLES - 1; ++k)
+        {
+            __m128 length = _mm_loadu_ps(&paths.arc_length[k][i]);
+            __m128 reached = _mm_cmpge_ps(s, length);
+            samples = _mm_add_ps(samples, _mm_and_ps(reached, one));
+            lo = Select(reached, length, lo);
+            hi = _mm_min_ps(hi, Select(reached, total, length));
+        }
+        __m128 interval = _mm_sub_ps(hi, lo);
+        __m128 fraction = _mm_and_ps(_mm_cmpgt_ps(interval, _mm_setzero_ps()),
+                                     _mm_div_ps(_mm_sub_ps(s, lo), interval));
+        __m128 t = _mm_mul_ps(_mm_add_ps(samples, fraction), inverse_samples);
+        t = Select(_mm_cmpge_ps(s, total), one, t);
+        _mm_storeu_ps(&paths.progress[i], t);
+
+        __m128 u = _mm_sub_ps(one, t);
+        __m128 uu = _mm_mul_ps(u, u);
+        __m128 tt = _mm_mul_ps(t, t);
+
+        // Posição
+        __m128 b0 = _mm_mul_ps(uu, u);
+        __m128 b1 = _mm_mul_ps(_mm_mul_ps(three, uu), t);
+        __m128 b2 = _mm_mul_ps(_mm_mul_ps(three, u), tt);
+        __m128 b3 = _mm_mul_ps(tt, t);
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, p0x), _mm_mul_ps(b1, p1x)),
+                                         _mm_mul_ps(b2, p2x)), _mm_mul_ps(b3, p3x));
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, p0z), _mm_mul_ps(b1, p1z)),
+                                         _mm_mul_ps(b2, p2z)), _mm_mul_ps(b3, p3z));
+        _mm_storeu_ps(&paths.x[i], x);
+        _mm_storeu_ps(&paths.z[i], z);
+
+        // Derivada
+        __m128 d0 = _mm_mul_ps(three, uu);
+        __m128 d1 = _mm_mul_ps(_mm_mul_ps(six, u), t);
+        __m128 d2 = _mm_mul_ps(three, tt);
+        __m128 dx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d0, _mm_sub_ps(p1x, p0x)),
+                                          _mm_mul_ps(d1, _mm_sub_ps(p2x, p1x))),
+                               _mm_mul_ps(d2, _mm_sub_ps(p3x, p2x)));
+        __m128 dz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d0, _mm_sub_ps(p1z, p0z)),
+                                          _mm_mul_ps(d1, _mm_sub_ps(p2z, p1z))),
+                               _mm_mul_ps(d2, _mm_sub_ps(p3z, p2z)));
+
+        __m128 length_sq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+        __m128 valid = _mm_and_ps(_mm_cmpgt_ps(length_sq, min_heading_sq), _mm_cmplt_ps(t, one));
+        __m128 inverse_length = _mm_div_ps(one, _mm_sqrt_ps(length_sq));
+        _mm_storeu_ps(&paths.heading_x[i], _mm_and_ps(valid, _mm_mul_ps(dx, inverse_length)));
+        _mm_storeu_ps(&paths.heading_z[i], _mm_and_ps(valid, _mm_mul_ps(dz, inverse_length)));
+    }
+    return i;
+}
+
+#endif
+
+void EnemyPaths_Update(EnemyPaths& paths, float delta_time)
+{
+    EnemyPaths_UpdateRange(paths, 0, paths.Size(), delta_time);
+}
+
+void EnemyPaths_UpdateRange(EnemyPaths& paths, size_t begin, size_t end, float delta_time)
+{
+    size_t done = begin;
+#if defined(__AVX__)
+    done = UpdateAVX(paths, begin, end, delta_time);
+#elif defined(__SSE2__) || defined(_M_X64)
+    done = UpdateSSE2(paths, begin, end, delta_time);
+#endif
+    EnemyPaths_UpdateScalar(paths, done, end, delta_time);
+}
+
+const char* EnemyPaths_KernelName()
+{
+#if defined(__AVX__)
+    return "AVX";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "SSE2";
+#else
+    return "escalar";
+#endif
+}
+
+// vim: set spell spelllang=pt_br :
@@ -0,0 +1,144 @@
+// Eventos da simulação. Veja "eventbus.h".
+//
+// O produtor grava o evento na posição write_index do anel e só depois
+// publica write_index + 1 (release). Os consumidores não escrevem nada no
+// EventBus: cada um só avança a sua posição de leitura. Como o produtor não
+// espera por ninguém, um consumidor confere depois de copiar cada evento se
+// o produtor não deu a volta no anel enquanto isso (a cópia pode ter pego um
+// evento pela metade); se deu, a cópia é descartada e o evento conta como
+// perdido.
+
+#include "eventbus.h"
+#include "logger.h"
+#include "simulation.h"
+
+#define EVENT_BUS_LOG_BATCH 64 // Eventos lidos de uma vez por EventBus_LogEvents()
+
+void EventBus_Subscribe(const EventBus& bus, EventSubscriber& subscriber, uint32_t mask)
+{
+    if (bus.events.empty())
+        bus.events.resize(EVENT_BUS_CAPACITY);
+    bus.num_subscribers.fetch_add(1);
+
+    subscriber.read_index = bus.write_index.load(std::memory_order_acquire);
+    subscriber.mask = mask;
+    subscriber.lost = 0;
+}
+
+void EventBus_Unsubscribe(const EventBus& bus, EventSubscriber& subscriber)
+{
+    bus.num_subscribers.fetch_sub(1);
+    subscriber.mask = 0;
+}
+
+void EventBus_Publish(EventBus& bus, const GameEvent& event)
+{
+    if (bus.num_subscribers.load(std::memory_order_relaxed) == 0)
+        return;
+
+    uint64_t index = bus.write_index.load(std::memory_order_relaxed);
+    bus.events[index & (EVENT_BUS_CAPACITY - 1)] = event;
+    bus.write_index.store(index + 1, std::memory_order_release);
+}
+
+size_t EventBus_Poll(const EventBus& bus, EventSubscriber& subscriber, GameEvent* events, size_t max_events)
+{
+    if (bus.events.empty())
+        return 0;
+
+    size_t count = 0;
+    uint64_t write_index = bus.write_index.load(std::memory_order_acquire);
+    while (count < max_events && subscriber.read_index < write_index)
+    {
+        // A posição write_index pode estar sendo escrita agora, então só as
+        // EVENT_BUS_CAPACITY - 1 anteriores são seguras
+        uint64_t oldest = write_index >= EVENT_BUS_CAPACITY ? write_index - (EVENT_BUS_CAPACITY - 1) : 0;
+        if (subscriber.read_index < oldest)
+        {
+            subscriber.lost += oldest - subscriber.read_index;
+            subscriber.read_index = oldest;
+        }
+
+        GameEvent event = bus.events[subscriber.read_index & (EVENT_BUS_CAPACITY - 1)];
+        uint64_t current = bus.write_index.load(std::memory_order_acquire);
+        if (current - subscriber.read_index >= EVENT_BUS_CAPACITY)
+        {
+            write_index = current; // Sobrescrito durante a cópia
+            continue;
+        }
+
+        subscriber.read_index += 1;
+        if (subscriber.mask & GAME_EVENT_MASK(event.type))
+            events[count++] = event;
+    }
+    return count;
+}
+
+static const char* LayerName(uint32_t layer)
+{
+    switch (layer)
+    {
+        case RAY_LAYER_WORLD:   return "BOX";
+        case RAY_LAYER_PLAYER:  return "PLAYER";
+        case RAY_LAYER_ENEMIES: return "ENEMY";
+        default:                return "NONE";
+    }
+}
+
+void EventBus_LogEvents(const EventBus& bus, EventSubscriber& subscriber)
+{
+    GameEvent events[EVENT_BUS_LOG_BATCH];
+    size_t count;
+    while ((count = EventBus_Poll(bus, subscriber, events, EVENT_BUS_LOG_BATCH)) > 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const GameEvent& event = events[i];
+            switch (event.type)
+            {
+                case GAME_EVENT_SHOT:
+                    if (event.shot.layer == RAY_LAYER_NONE)
+                        LOG_DEBUG(LOG_CATEGORY_COMBAT, "Raycast (%s): No hit", LayerName(event.shot.shooter));
+                    else
+                        LOG_DEBUG(LOG_CATEGORY_COMBAT, "Raycast (%s) hit: %s at distance %.2f",
+                                  LayerName(event.shot.shooter), LayerName(event.shot.layer), event.shot.distance);
+                    break;
+                case GAME_EVENT_ENEMY_DAMAGED:
+                    LOG_DEBUG(LOG_CATEGORY_COMBAT, "ENEMY (slot %u) damaged: %.1f - Health: %.1f/%.1f",
+                              event.enemy_slot, event.damage.amount, event.damage.health, event.damage.max_health);
+                    break;
+                case GAME_EVENT_ENEMY_KILLED:
+                    LOG_DEBUG(LOG_CATEGORY_COMBAT, "ENEMY (slot %u) DEFEATED at (%.2f, %.2f, %.2f)!",
+                              event.enemy_slot, event.kill.x, event.kill.y, event.kill.z);
+                    break;
+                case GAME_EVENT_PLAYER_DAMAGED:
+                    LOG_DEBUG(LOG_CATEGORY_COMBAT, "PLAYER damaged: %.1f - Health: %.1f/%.1f",
+                              event.damage.amount, event.damage.health, event.damage.max_health);
+                    break;
+                case GAME_EVENT_PLAYER_KILLED:
+                    LOG_INFO(LOG_CATEGORY_COMBAT, "PLAYER DEFEATED!");
+                    break;
+                case GAME_EVENT_WAVE_STARTED:
+                    LOG_INFO(LOG_CATEGORY_WAVES, "Wave %d started with %d enemies (health: %.1fx, speed: %.1fx)",
+                             event.wave.wave, event.wave.enemy_count, event.wave.health_multiplier,
+                             event.wave.speed_multiplier);
+                    break;
+                case GAME_EVENT_WAVE_COMPLETE:
+                    LOG_INFO(LOG_CATEGORY_WAVES, "Wave %d COMPLETE! All enemies defeated!", event.wave.wave);
+                    break;
+                case GAME_EVENT_GAME_FINISHED:
+                    LOG_INFO(LOG_CATEGORY_WAVES, "All waves completed! Game finished!");
+                    break;
+            }
+        }
+    }
+
+    if (subscriber.lost > 0)
+    {
+        LOG_WARNING(LOG_CATEGORY_GENERAL, "%llu simulation events not logged (event bus full)",
+                    (unsigned long long)subscriber.lost);
+        subscriber.lost = 0;
+    }
+}
+
+// vim: set spell spelllang=pt_br :
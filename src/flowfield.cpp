@@ -0,0 +1,176 @@
+// Campo de fluxo até o jogador. Veja "flowfield.h".
+//
+// O campo é recalculado do zero (Dijkstra a partir da célula do jogador)
+// quando o jogador muda de célula. Com 50x50 células isso leva bem menos que
+// um tick, e acontece algumas vezes por segundo no máximo; os inimigos só
+// leem o resultado, então o custo não depende de quantos existem.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <glm/common.hpp>
+
+#include "flowfield.h"
+#include "simulation.h"
+
+#define FLOW_FIELD_DIAGONAL_COST 1.41421356f // sqrt(2), em células
+
+// Coluna e linha que contêm a coordenada, limitadas à grade
+static int CellX(const FlowField& field, float x)
+{
+    int cell = (int)floorf((x - field.origin_x) / FLOW_FIELD_CELL_SIZE);
+    return glm::clamp(cell, 0, field.cells_x - 1);
+}
+
+static int CellZ(const FlowField& field, float z)
+{
+    int cell = (int)floorf((z - field.origin_z) / FLOW_FIELD_CELL_SIZE);
+    return glm::clamp(cell, 0, field.cells_z - 1);
+}
+
+int FlowField_Cell(const FlowField& field, float x, float z)
+{
+    return CellZ(field, z) * field.cells_x + CellX(field, x);
+}
+
+void FlowField_CellCenter(const FlowField& field, int cell, float& x, float& z)
+{
+    x = field.origin_x + (cell % field.cells_x + 0.5f) * FLOW_FIELD_CELL_SIZE;
+    z = field.origin_z + (cell / field.cells_x + 0.5f) * FLOW_FIELD_CELL_SIZE;
+}
+
+void FlowField_Build(FlowField& field, const std::vector<BoxAABB>& aabbs, float agent_radius)
+{
+    field.origin_x = MAP_MIN_X;
+    field.origin_z = MAP_MIN_Z;
+    field.cells_x = (int)ceilf((MAP_MAX_X - MAP_MIN_X) / FLOW_FIELD_CELL_SIZE);
+    field.cells_z = (int)ceilf((MAP_MAX_Z - MAP_MIN_Z) / FLOW_FIELD_CELL_SIZE);
+
+    size_t num_cells = (size_t)field.cells_x * field.cells_z;
+    field.blocked.assign(num_cells, 0);
+    field.distance.assign(num_cells, FLOW_FIELD_UNREACHABLE);
+    field.next.assign(num_cells, -1);
+    field.target_cell = -1;
+
+    // Toda célula que a AABB aumentada toca, mesmo que só em parte
+    for (const BoxAABB& aabb : aabbs)
+        for (int z = CellZ(field, aabb.min.z - agent_radius); z <= CellZ(field, aabb.max.z + agent_radius); ++z)
+            for (int x = CellX(field, aabb.min.x - agent_radius); x <= CellX(field, aabb.max.x + agent_radius); ++x)
+                field.blocked[z * field.cells_x + x] = 1;
+}
+
+bool FlowField_Update(FlowField& field, const glm::vec4& target)
+{
+    if (field.blocked.empty())
+        return false;
+
+    int target_cell = FlowField_Cell(field, target.x, target.z);
+    if (target_cell == field.target_cell)
+        return false;
+    field.target_cell = target_cell;
+
+    std::fill(field.distance.begin(), field.distance.end(), FLOW_FIELD_UNREACHABLE);
+    std::fill(field.next.begin(), field.next.end(), -1);
+
+    // Dijkstra a partir do jogador. A célula dele pode estar bloqueada (ele
+    // pode chegar mais perto das caixas que a margem dos inimigos), mas
+    // ainda assim é a origem.
+    typedef std::pair<float, int32_t> HeapEntry;
+    std::greater<HeapEntry> closest_first;
+    field.heap.clear();
+    field.distance[target_cell] = 0.0f;
+    field.heap.push_back(HeapEntry(0.0f, target_cell));
+
+    while (!field.heap.empty())
+    {
+        std::pop_heap(field.heap.begin(), field.heap.end(), closest_first);
+        HeapEntry entry = field.heap.back();
+        field.heap.pop_back();
+
+        int cell = entry.second;
+        if (entry.first > field.distance[cell])
+            continue; // Já foi alcançada por um caminho mais curto
+
+        int cell_x = cell % field.cells_x;
+        int cell_z = cell / field.cells_x;
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                int x = cell_x + dx;
+                int z = cell_z + dz;
+                if ((dx == 0 && dz == 0) || x < 0 || x >= field.cells_x || z < 0 || z >= field.cells_z)
+                    continue;
+
+                int neighbor = z * field.cells_x + x;
+                if (field.blocked[neighbor])
+                    continue;
+
+                // Na diagonal, as duas células do lado também devem estar
+                // livres, para o caminho não raspar na quina de uma caixa
+                bool diagonal = dx != 0 && dz != 0;
+                if (diagonal && (field.blocked[cell_z * field.cells_x + x] || field.blocked[z * field.cells_x + cell_x]))
+                    continue;
+
+                float distance = entry.first + (diagonal ? FLOW_FIELD_DIAGONAL_COST : 1.0f) * FLOW_FIELD_CELL_SIZE;
+                if (distance < field.distance[neighbor])
+                {
+                    field.distance[neighbor] = distance;
+                    field.next[neighbor] = cell;
+                    field.heap.push_back(HeapEntry(distance, neighbor));
+                    std::push_heap(field.heap.begin(), field.heap.end(), closest_first);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool FlowField_LineOfSight(const FlowField& field, float x0, float z0, float x1, float z1)
+{
+    // Percorre as células cortadas pelo segmento (Amanatides e Woo). A célula
+    // inicial não é testada: quem está nela já está lá.
+    int x = CellX(field, x0);
+    int z = CellZ(field, z0);
+    int end_x = CellX(field, x1);
+    int end_z = CellZ(field, z1);
+
+    float dx = x1 - x0;
+    float dz = z1 - z0;
+    int step_x = dx > 0.0f ? 1 : -1;
+    int step_z = dz > 0.0f ? 1 : -1;
+
+    const float infinity = FLOW_FIELD_UNREACHABLE;
+    float next_x = field.origin_x + (x + (step_x > 0 ? 1 : 0)) * FLOW_FIELD_CELL_SIZE;
+    float next_z = field.origin_z + (z + (step_z > 0 ? 1 : 0)) * FLOW_FIELD_CELL_SIZE;
+    float t_max_x = dx != 0.0f ? (next_x - x0) / dx : infinity;
+    float t_max_z = dz != 0.0f ? (next_z - z0) / dz : infinity;
+    float t_delta_x = dx != 0.0f ? FLOW_FIELD_CELL_SIZE / fabsf(dx) : infinity;
+    float t_delta_z = dz != 0.0f ? FLOW_FIELD_CELL_SIZE / fabsf(dz) : infinity;
+
+    // Cada passo anda uma célula em X ou em Z; o limite só protege contra
+    // erros de arredondamento perto do fim
+    int max_steps = abs(end_x - x) + abs(end_z - z);
+    for (int step = 0; step < max_steps && (x != end_x || z != end_z); ++step)
+    {
+        if (t_max_x < t_max_z)
+        {
+            x += step_x;
+            t_max_x += t_delta_x;
+        }
+        else
+        {
+            z += step_z;
+            t_max_z += t_delta_z;
+        }
+
+        if (x < 0 || x >= field.cells_x || z < 0 || z >= field.cells_z)
+            break;
+        if (field.blocked[z * field.cells_x + x])
+            return false;
+    }
+    return true;
+}
+
+// vim: set spell spelllang=pt_br :
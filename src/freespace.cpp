@@ -0,0 +1,171 @@
+// Grade de espaço livre e validação de curvas. Veja "freespace.h".
+//
+// A classificação das células só olha o plano XZ (como se toda caixa fosse
+// infinitamente alta), então é conservadora: uma célula livre é livre em
+// qualquer altura. Nas células perto de caixas o teste é o de BoxGrid, em
+// 3D, com a esfera aumentada.
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/common.hpp>
+
+#include "freespace.h"
+#include "simulation.h"
+
+#define FREE_SPACE_MAX_DEPTH 12 // Limite de divisões da curva (4096 pedaços)
+
+// Raio usado nos testes: o da hitbox mais metade do espaço entre os pontos
+static float SweepRadius(const FreeSpaceGrid& grid)
+{
+    return grid.radius + FREE_SPACE_SAMPLE_SPACING * 0.5f;
+}
+
+void FreeSpace_Build(FreeSpaceGrid& grid, const std::vector<BoxAABB>& aabbs, float radius, const glm::vec3& offset)
+{
+    grid.origin_x = MAP_MIN_X;
+    grid.origin_z = MAP_MIN_Z;
+    grid.cells_x = (int)ceilf((MAP_MAX_X - MAP_MIN_X) / FREE_SPACE_CELL_SIZE);
+    grid.cells_z = (int)ceilf((MAP_MAX_Z - MAP_MIN_Z) / FREE_SPACE_CELL_SIZE);
+    grid.radius = radius;
+    grid.offset = offset;
+    grid.free_cells.assign((size_t)grid.cells_x * grid.cells_z, 1);
+
+    float sweep_radius = SweepRadius(grid);
+    for (const BoxAABB& aabb : aabbs)
+    {
+        // AABB nas coordenadas da posição do inimigo (sem o deslocamento do
+        // centro da hitbox)
+        float min_x = aabb.min.x - offset.x;
+        float max_x = aabb.max.x - offset.x;
+        float min_z = aabb.min.z - offset.z;
+        float max_z = aabb.max.z - offset.z;
+
+        int first_x = std::max(0, (int)floorf((min_x - sweep_radius - grid.origin_x) / FREE_SPACE_CELL_SIZE));
+        int last_x = std::min(grid.cells_x - 1, (int)floorf((max_x + sweep_radius - grid.origin_x) / FREE_SPACE_CELL_SIZE));
+        int first_z = std::max(0, (int)floorf((min_z - sweep_radius - grid.origin_z) / FREE_SPACE_CELL_SIZE));
+        int last_z = std::min(grid.cells_z - 1, (int)floorf((max_z + sweep_radius - grid.origin_z) / FREE_SPACE_CELL_SIZE));
+
+        for (int z = first_z; z <= last_z; ++z)
+        {
+            for (int x = first_x; x <= last_x; ++x)
+            {
+                // Menor distância entre a célula e a AABB, no plano XZ
+                float cell_min_x = grid.origin_x + x * FREE_SPACE_CELL_SIZE;
+                float cell_min_z = grid.origin_z + z * FREE_SPACE_CELL_SIZE;
+                float dx = std::max(0.0f, std::max(min_x - (cell_min_x + FREE_SPACE_CELL_SIZE), cell_min_x - max_x));
+                float dz = std::max(0.0f, std::max(min_z - (cell_min_z + FREE_SPACE_CELL_SIZE), cell_min_z - max_z));
+                if (dx * dx + dz * dz < sweep_radius * sweep_radius)
+                    grid.free_cells[z * grid.cells_x + x] = 0;
+            }
+        }
+    }
+}
+
+bool FreeSpace_IsFree(const FreeSpaceGrid& grid, const BoxGrid& boxes, float x, float y, float z)
+{
+    int cell_x = (int)floorf((x - grid.origin_x) / FREE_SPACE_CELL_SIZE);
+    int cell_z = (int)floorf((z - grid.origin_z) / FREE_SPACE_CELL_SIZE);
+    if (cell_x >= 0 && cell_x < grid.cells_x && cell_z >= 0 && cell_z < grid.cells_z &&
+        grid.free_cells[cell_z * grid.cells_x + cell_x])
+        return true;
+
+    glm::vec3 center = glm::vec3(x, y, z) + grid.offset;
+    return !BoxGrid_OverlapsSphere(boxes, center, SweepRadius(grid));
+}
+
+// Pedaço da curva ainda não testado: pontos de controle e profundidade
+struct BezierPiece
+{
+    float x[4];
+    float z[4];
+    int depth;
+};
+
+// Comprimento do polígono de controle, que é maior ou igual ao da curva
+static float ControlPolygonLength(const BezierPiece& piece)
+{
+    float length = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        float dx = piece.x[i + 1] - piece.x[i];
+        float dz = piece.z[i + 1] - piece.z[i];
+        length += sqrtf(dx * dx + dz * dz);
+    }
+    return length;
+}
+
+// Divide a curva em t = 0.5 (de Casteljau)
+static void SplitBezier(const BezierPiece& piece, BezierPiece& left, BezierPiece& right)
+{
+    const float* coordinates[2] = { piece.x, piece.z };
+    float* left_coordinates[2] = { left.x, left.z };
+    float* right_coordinates[2] = { right.x, right.z };
+    for (int c = 0; c < 2; ++c)
+    {
+        const float* p = coordinates[c];
+        float p01 = (p[0] + p[1]) * 0.5f;
+        float p12 = (p[1] + p[2]) * 0.5f;
+        float p23 = (p[2] + p[3]) * 0.5f;
+        float p012 = (p01 + p12) * 0.5f;
+        float p123 = (p12 + p23) * 0.5f;
+        float middle = (p012 + p123) * 0.5f;
+
+        float* l = left_coordinates[c];
+        float* r = right_coordinates[c];
+        l[0] = p[0]; l[1] = p01;  l[2] = p012; l[3] = middle;
+        r[0] = middle; r[1] = p123; r[2] = p23; r[3] = p[3];
+    }
+    left.depth = right.depth = piece.depth + 1;
+}
+
+bool FreeSpace_SweepBezier(const FreeSpaceGrid& grid, const BoxGrid& boxes, const float x[4], const float z[4],
+                           float y, int* samples)
+{
+    // Pilha de pedaços: o da esquerda sai primeiro, então os pontos são
+    // testados na ordem da curva e a busca para na primeira colisão
+    BezierPiece stack[FREE_SPACE_MAX_DEPTH + 1];
+    int stack_size = 1;
+    for (int i = 0; i < 4; ++i)
+    {
+        stack[0].x[i] = x[i];
+        stack[0].z[i] = z[i];
+    }
+    stack[0].depth = 0;
+
+    // Um inimigo parado perto de uma caixa (ex.: depois de uma colisão) já
+    // está dentro da margem FREE_SPACE_SAMPLE_SPACING / 2. Até a curva sair
+    // dela, os pontos são testados só com o raio da hitbox, como no
+    // movimento; senão nenhuma curva a partir dali seria aceita. Se o
+    // inimigo já encosta em uma caixa (ex.: nasceu dentro dela), esses
+    // pontos são aceitos de qualquer forma, para ele poder sair.
+    bool start_inside = BoxGrid_OverlapsSphere(boxes, glm::vec3(x[0], y, z[0]) + grid.offset, grid.radius);
+    bool leaving_start = true;
+    int num_samples = 0;
+    bool free = true;
+    while (stack_size > 0 && free)
+    {
+        BezierPiece piece = stack[--stack_size];
+        if (piece.depth < FREE_SPACE_MAX_DEPTH && ControlPolygonLength(piece) > FREE_SPACE_SAMPLE_SPACING)
+        {
+            SplitBezier(piece, stack[stack_size + 1], stack[stack_size]);
+            stack_size += 2;
+            continue;
+        }
+
+        num_samples += 1;
+        float sample_x = piece.x[3];
+        float sample_z = piece.z[3];
+        if (FreeSpace_IsFree(grid, boxes, sample_x, y, sample_z))
+            leaving_start = false;
+        else
+            free = leaving_start &&
+                   (start_inside || !BoxGrid_OverlapsSphere(boxes, glm::vec3(sample_x, y, sample_z) + grid.offset, grid.radius));
+    }
+
+    if (samples)
+        *samples = num_samples;
+    return free;
+}
+
+// vim: set spell spelllang=pt_br :
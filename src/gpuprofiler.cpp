@@ -0,0 +1,260 @@
+// Profiler de GPU. Veja "gpuprofiler.h".
+//
+// Usamos queries GL_TIMESTAMP (glQueryCounter()) em vez de GL_TIME_ELAPSED:
+// apenas uma query GL_TIME_ELAPSED pode estar ativa por vez, enquanto
+// timestamps podem ser emitidos livremente, inclusive para medir o quadro
+// inteiro ao mesmo tempo em que cada pass.
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "gpuprofiler.h"
+#include "utils.h"
+
+// Queries de um quadro do anel
+struct GpuProfilerFrame
+{
+    GLuint frame_queries[2];                           // Início e fim do quadro
+    GLuint pass_queries[GPU_PROFILER_MAX_PASSES][2];   // Início e fim de cada pass emitido
+    int    pass_ids[GPU_PROFILER_MAX_PASSES];          // Pass correspondente a cada par de queries
+    int    num_passes;                                 // Número de passes emitidos no quadro
+    bool   pending;                                    // Queries emitidas e ainda não lidas
+    unsigned int frame_number;
+};
+
+// Tempos (ms) de um quadro já lido da GPU. Valores negativos indicam que o
+// pass não executou naquele quadro.
+struct GpuProfilerSample
+{
+    unsigned int frame_number;
+    double frame_ms;
+    double pass_ms[GPU_PROFILER_MAX_PASSES];
+};
+
+static GpuProfilerFrame g_Frames[GPU_PROFILER_FRAMES_IN_FLIGHT];
+static unsigned int     g_FrameNumber = 0;
+static int              g_OpenPass = -1; // Índice em pass_queries do pass aberto
+static bool             g_Initialized = false;
+
+static const char* g_PassNames[GPU_PROFILER_MAX_PASSES];
+static int         g_NumPassNames = 0;
+
+static GpuProfilerSample g_History[GPU_PROFILER_HISTORY_FRAMES];
+static int               g_HistoryCount = 0; // Amostras válidas em g_History
+static int               g_HistoryNext = 0;  // Próxima posição de escrita (anel)
+static int               g_DroppedFrames = 0;
+
+void GpuProfiler_Init()
+{
+    for (int i = 0; i < GPU_PROFILER_FRAMES_IN_FLIGHT; ++i)
+    {
+        glGenQueries(2, g_Frames[i].frame_queries);
+        glGenQueries(2 * GPU_PROFILER_MAX_PASSES, &g_Frames[i].pass_queries[0][0]);
+        g_Frames[i].num_passes = 0;
+        g_Frames[i].pending = false;
+    }
+    glCheckError();
+    g_Initialized = true;
+}
+
+static int FindOrAddPass(const char* name)
+{
+    for (int i = 0; i < g_NumPassNames; ++i)
+        if (g_PassNames[i] == name || strcmp(g_PassNames[i], name) == 0)
+            return i;
+
+    if (g_NumPassNames == GPU_PROFILER_MAX_PASSES)
+        return -1;
+
+    g_PassNames[g_NumPassNames] = name;
+    return g_NumPassNames++;
+}
+
+// Lê as queries de um quadro do anel, caso já estejam disponíveis
+static void ReadBackFrame(GpuProfilerFrame& frame)
+{
+    // Timestamps são escritos na ordem em que foram emitidos, então se o
+    // último (fim do quadro) está disponível, todos os outros também estão.
+    GLint available = 0;
+    glGetQueryObjectiv(frame.frame_queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    frame.pending = false;
+    if (!available)
+    {
+        g_DroppedFrames += 1;
+        return;
+    }
+
+    GpuProfilerSample& sample = g_History[g_HistoryNext];
+    sample.frame_number = frame.frame_number;
+    for (int i = 0; i < GPU_PROFILER_MAX_PASSES; ++i)
+        sample.pass_ms[i] = -1.0;
+
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(frame.frame_queries[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(frame.frame_queries[1], GL_QUERY_RESULT, &end);
+    sample.frame_ms = (end - begin) / 1.0e6;
+
+    for (int i = 0; i < frame.num_passes; ++i)
+    {
+        glGetQueryObjectui64v(frame.pass_queries[i][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.pass_queries[i][1], GL_QUERY_RESULT, &end);
+
+        // Um mesmo pass pode ser emitido mais de uma vez no quadro; somamos
+        double& pass_ms = sample.pass_ms[frame.pass_ids[i]];
+        pass_ms = std::max(pass_ms, 0.0) + (end - begin) / 1.0e6;
+    }
+
+    g_HistoryNext = (g_HistoryNext + 1) % GPU_PROFILER_HISTORY_FRAMES;
+    g_HistoryCount = std::min(g_HistoryCount + 1, GPU_PROFILER_HISTORY_FRAMES);
+}
+
+void GpuProfiler_BeginFrame()
+{
+    if (!g_Initialized)
+        return;
+
+    GpuProfilerFrame& frame = g_Frames[g_FrameNumber % GPU_PROFILER_FRAMES_IN_FLIGHT];
+    if (frame.pending)
+        ReadBackFrame(frame);
+
+    frame.frame_number = g_FrameNumber;
+    frame.num_passes = 0;
+    g_OpenPass = -1;
+    glQueryCounter(frame.frame_queries[0], GL_TIMESTAMP);
+}
+
+void GpuProfiler_EndFrame()
+{
+    if (!g_Initialized)
+        return;
+
+    GpuProfiler_EndPass();
+
+    GpuProfilerFrame& frame = g_Frames[g_FrameNumber % GPU_PROFILER_FRAMES_IN_FLIGHT];
+    glQueryCounter(frame.frame_queries[1], GL_TIMESTAMP);
+    frame.pending = true;
+    g_FrameNumber += 1;
+}
+
+void GpuProfiler_BeginPass(const char* name)
+{
+    if (!g_Initialized)
+        return;
+
+    GpuProfiler_EndPass();
+
+    GpuProfilerFrame& frame = g_Frames[g_FrameNumber % GPU_PROFILER_FRAMES_IN_FLIGHT];
+    int pass = FindOrAddPass(name);
+    if (pass < 0 || frame.num_passes == GPU_PROFILER_MAX_PASSES)
+        return;
+
+    g_OpenPass = frame.num_passes++;
+    frame.pass_ids[g_OpenPass] = pass;
+    glQueryCounter(frame.pass_queries[g_OpenPass][0], GL_TIMESTAMP);
+}
+
+void GpuProfiler_EndPass()
+{
+    if (!g_Initialized || g_OpenPass < 0)
+        return;
+
+    GpuProfilerFrame& frame = g_Frames[g_FrameNumber % GPU_PROFILER_FRAMES_IN_FLIGHT];
+    glQueryCounter(frame.pass_queries[g_OpenPass][1], GL_TIMESTAMP);
+    g_OpenPass = -1;
+}
+
+int GpuProfiler_PassCount()
+{
+    return g_NumPassNames;
+}
+
+const char* GpuProfiler_PassName(int pass)
+{
+    return g_PassNames[pass];
+}
+
+// Percorre as últimas GPU_PROFILER_AVERAGE_FRAMES amostras, da mais recente
+// para a mais antiga. Se pass < 0, considera o tempo do quadro inteiro.
+static void ComputeRecentStats(int pass, double* average_ms, double* max_ms)
+{
+    double sum = 0.0, max = 0.0;
+    int count = 0;
+    int n = std::min(g_HistoryCount, GPU_PROFILER_AVERAGE_FRAMES);
+    for (int i = 0; i < n; ++i)
+    {
+        int index = (g_HistoryNext - 1 - i + GPU_PROFILER_HISTORY_FRAMES) % GPU_PROFILER_HISTORY_FRAMES;
+        double ms = pass < 0 ? g_History[index].frame_ms : g_History[index].pass_ms[pass];
+        if (ms < 0.0)
+            continue;
+        sum += ms;
+        max = std::max(max, ms);
+        count += 1;
+    }
+    *average_ms = count > 0 ? sum / count : 0.0;
+    *max_ms = max;
+}
+
+double GpuProfiler_PassAverageMs(int pass)
+{
+    double average_ms, max_ms;
+    ComputeRecentStats(pass, &average_ms, &max_ms);
+    return average_ms;
+}
+
+double GpuProfiler_PassMaxMs(int pass)
+{
+    double average_ms, max_ms;
+    ComputeRecentStats(pass, &average_ms, &max_ms);
+    return max_ms;
+}
+
+double GpuProfiler_FrameAverageMs()
+{
+    double average_ms, max_ms;
+    ComputeRecentStats(-1, &average_ms, &max_ms);
+    return average_ms;
+}
+
+int GpuProfiler_DroppedFrames()
+{
+    return g_DroppedFrames;
+}
+
+bool GpuProfiler_DumpCSV(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: Não foi possível criar o arquivo \"%s\".\n", filename);
+        return false;
+    }
+
+    fprintf(file, "frame,frame_ms");
+    for (int p = 0; p < g_NumPassNames; ++p)
+        fprintf(file, ",%s_ms", g_PassNames[p]);
+    fprintf(file, "\n");
+
+    // Da amostra mais antiga para a mais recente. Passes que não executaram
+    // em um quadro ficam com a coluna vazia.
+    int first = (g_HistoryNext - g_HistoryCount + GPU_PROFILER_HISTORY_FRAMES) % GPU_PROFILER_HISTORY_FRAMES;
+    for (int i = 0; i < g_HistoryCount; ++i)
+    {
+        const GpuProfilerSample& sample = g_History[(first + i) % GPU_PROFILER_HISTORY_FRAMES];
+        fprintf(file, "%u,%.4f", sample.frame_number, sample.frame_ms);
+        for (int p = 0; p < g_NumPassNames; ++p)
+        {
+            if (sample.pass_ms[p] >= 0.0)
+                fprintf(file, ",%.4f", sample.pass_ms[p]);
+            else
+                fprintf(file, ",");
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    printf("Perfil de GPU (%d quadros) salvo em \"%s\".\n", g_HistoryCount, filename);
+    return true;
+}
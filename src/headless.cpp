@@ -0,0 +1,412 @@
+// Renderização sem janela. Veja "headless.h".
+//
+// Os tipos e constantes de EGL e OSMesa usados aqui são definidos localmente
+// (com os mesmos valores dos headers oficiais), para que o projeto compile
+// sem os headers de desenvolvimento dessas bibliotecas instalados.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "headless.h"
+#include "utils.h"
+
+#ifdef __linux__
+#include <dlfcn.h>
+#endif
+
+static bool        g_Active = false;
+static const char* g_BackendName = "";
+static int         g_Width = 0;
+static int         g_Height = 0;
+static GLuint      g_Framebuffer = 0;
+static GLuint      g_Renderbuffers[2] = { 0, 0 }; // Cor e profundidade
+
+static std::chrono::steady_clock::time_point g_StartTime;
+
+#ifdef __linux__
+
+// ---------------------------------------------------------------------------
+// EGL
+// ---------------------------------------------------------------------------
+
+typedef void*        EGLDisplay;
+typedef void*        EGLConfig;
+typedef void*        EGLContext;
+typedef void*        EGLSurface;
+typedef int          EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+#define EGL_NONE                            0x3038
+#define EGL_SURFACE_TYPE                    0x3033
+#define EGL_PBUFFER_BIT                     0x0001
+#define EGL_RENDERABLE_TYPE                 0x3040
+#define EGL_OPENGL_BIT                      0x0008
+#define EGL_OPENGL_API                      0x30A2
+#define EGL_CONTEXT_MAJOR_VERSION           0x3098
+#define EGL_CONTEXT_MINOR_VERSION           0x30FB
+#define EGL_CONTEXT_OPENGL_PROFILE_MASK     0x30FD
+#define EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT 0x0001
+#define EGL_PLATFORM_SURFACELESS_MESA       0x31DD
+
+typedef void*      (*PFN_eglGetProcAddress)(const char*);
+typedef EGLDisplay (*PFN_eglGetDisplay)(void*);
+typedef EGLDisplay (*PFN_eglGetPlatformDisplayEXT)(EGLenum, void*, const EGLint*);
+typedef EGLBoolean (*PFN_eglInitialize)(EGLDisplay, EGLint*, EGLint*);
+typedef EGLBoolean (*PFN_eglChooseConfig)(EGLDisplay, const EGLint*, EGLConfig*, EGLint, EGLint*);
+typedef EGLBoolean (*PFN_eglBindAPI)(EGLenum);
+typedef EGLContext (*PFN_eglCreateContext)(EGLDisplay, EGLConfig, EGLContext, const EGLint*);
+typedef EGLBoolean (*PFN_eglMakeCurrent)(EGLDisplay, EGLSurface, EGLSurface, EGLContext);
+typedef EGLBoolean (*PFN_eglDestroyContext)(EGLDisplay, EGLContext);
+typedef EGLBoolean (*PFN_eglTerminate)(EGLDisplay);
+
+static void*                 g_EGLLibrary = NULL;
+static PFN_eglGetProcAddress g_eglGetProcAddress = NULL;
+static PFN_eglDestroyContext g_eglDestroyContext = NULL;
+static PFN_eglMakeCurrent    g_eglMakeCurrent = NULL;
+static PFN_eglTerminate      g_eglTerminate = NULL;
+static EGLDisplay            g_EGLDisplay = NULL;
+static EGLContext            g_EGLContext = NULL;
+
+static bool InitEGL()
+{
+    g_EGLLibrary = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!g_EGLLibrary)
+    {
+        fprintf(stderr, "Headless: libEGL.so.1 não encontrada.\n");
+        return false;
+    }
+
+    g_eglGetProcAddress = (PFN_eglGetProcAddress) dlsym(g_EGLLibrary, "eglGetProcAddress");
+    PFN_eglGetDisplay     eglGetDisplay     = (PFN_eglGetDisplay)     dlsym(g_EGLLibrary, "eglGetDisplay");
+    PFN_eglInitialize     eglInitialize     = (PFN_eglInitialize)     dlsym(g_EGLLibrary, "eglInitialize");
+    PFN_eglChooseConfig   eglChooseConfig   = (PFN_eglChooseConfig)   dlsym(g_EGLLibrary, "eglChooseConfig");
+    PFN_eglBindAPI        eglBindAPI        = (PFN_eglBindAPI)        dlsym(g_EGLLibrary, "eglBindAPI");
+    PFN_eglCreateContext  eglCreateContext  = (PFN_eglCreateContext)  dlsym(g_EGLLibrary, "eglCreateContext");
+    g_eglMakeCurrent    = (PFN_eglMakeCurrent)    dlsym(g_EGLLibrary, "eglMakeCurrent");
+    g_eglDestroyContext = (PFN_eglDestroyContext) dlsym(g_EGLLibrary, "eglDestroyContext");
+    g_eglTerminate      = (PFN_eglTerminate)      dlsym(g_EGLLibrary, "eglTerminate");
+    if (!g_eglGetProcAddress || !eglGetDisplay || !eglInitialize || !eglChooseConfig || !eglBindAPI
+        || !eglCreateContext || !g_eglMakeCurrent || !g_eglDestroyContext || !g_eglTerminate)
+    {
+        fprintf(stderr, "Headless: libEGL.so.1 incompleta.\n");
+        return false;
+    }
+
+    // Preferimos a plataforma "surfaceless" do Mesa, que não precisa de
+    // display (X11/Wayland) nem de um dispositivo DRM.
+    PFN_eglGetPlatformDisplayEXT eglGetPlatformDisplayEXT =
+        (PFN_eglGetPlatformDisplayEXT) g_eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (eglGetPlatformDisplayEXT)
+        g_EGLDisplay = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, NULL, NULL);
+    if (!g_EGLDisplay)
+        g_EGLDisplay = eglGetDisplay(NULL);
+
+    EGLint major, minor;
+    if (!g_EGLDisplay || !eglInitialize(g_EGLDisplay, &major, &minor))
+    {
+        fprintf(stderr, "Headless: eglInitialize() falhou.\n");
+        g_EGLDisplay = NULL;
+        return false;
+    }
+
+    // O padrão de EGL_SURFACE_TYPE é EGL_WINDOW_BIT, que não existe sem
+    // display; pedimos configurações de pbuffer, oferecidas pelo surfaceless.
+    const EGLint config_attribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config;
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(g_EGLDisplay, config_attribs, &config, 1, &num_configs) || num_configs == 0)
+    {
+        fprintf(stderr, "Headless: nenhuma configuração EGL com suporte a OpenGL.\n");
+        return false;
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    g_EGLContext = eglCreateContext(g_EGLDisplay, config, NULL, context_attribs);
+    if (!g_EGLContext)
+    {
+        fprintf(stderr, "Headless: eglCreateContext() falhou (OpenGL 3.3 core).\n");
+        return false;
+    }
+
+    // Sem surface: requer EGL_KHR_surfaceless_context
+    if (!g_eglMakeCurrent(g_EGLDisplay, NULL, NULL, g_EGLContext))
+    {
+        fprintf(stderr, "Headless: eglMakeCurrent() sem surface falhou.\n");
+        return false;
+    }
+
+    printf("Headless: EGL %d.%d\n", major, minor);
+    return true;
+}
+
+static void TerminateEGL()
+{
+    if (g_EGLDisplay)
+    {
+        g_eglMakeCurrent(g_EGLDisplay, NULL, NULL, NULL);
+        if (g_EGLContext)
+            g_eglDestroyContext(g_EGLDisplay, g_EGLContext);
+        g_eglTerminate(g_EGLDisplay);
+    }
+    g_EGLDisplay = NULL;
+    g_EGLContext = NULL;
+}
+
+// ---------------------------------------------------------------------------
+// OSMesa
+// ---------------------------------------------------------------------------
+
+typedef void* OSMesaContext;
+
+#define OSMESA_FORMAT                0x22
+#define OSMESA_DEPTH_BITS            0x30
+#define OSMESA_PROFILE               0x33
+#define OSMESA_CORE_PROFILE          0x34
+#define OSMESA_CONTEXT_MAJOR_VERSION 0x36
+#define OSMESA_CONTEXT_MINOR_VERSION 0x37
+
+typedef OSMesaContext (*PFN_OSMesaCreateContextAttribs)(const int*, OSMesaContext);
+typedef GLboolean     (*PFN_OSMesaMakeCurrent)(OSMesaContext, void*, GLenum, GLsizei, GLsizei);
+typedef void          (*PFN_OSMesaDestroyContext)(OSMesaContext);
+typedef void*         (*PFN_OSMesaGetProcAddress)(const char*);
+
+static void*                    g_OSMesaLibrary = NULL;
+static PFN_OSMesaGetProcAddress g_OSMesaGetProcAddress = NULL;
+static PFN_OSMesaDestroyContext g_OSMesaDestroyContext = NULL;
+static OSMesaContext            g_OSMesaContext = NULL;
+
+// OSMesa exige um buffer de cor próprio, mesmo que renderizemos em um FBO
+static std::vector<unsigned char> g_OSMesaBuffer;
+
+static bool InitOSMesa(int width, int height)
+{
+    g_OSMesaLibrary = dlopen("libOSMesa.so.8", RTLD_NOW | RTLD_LOCAL);
+    if (!g_OSMesaLibrary)
+        g_OSMesaLibrary = dlopen("libOSMesa.so", RTLD_NOW | RTLD_LOCAL);
+    if (!g_OSMesaLibrary)
+    {
+        fprintf(stderr, "Headless: libOSMesa não encontrada.\n");
+        return false;
+    }
+
+    PFN_OSMesaCreateContextAttribs OSMesaCreateContextAttribs =
+        (PFN_OSMesaCreateContextAttribs) dlsym(g_OSMesaLibrary, "OSMesaCreateContextAttribs");
+    PFN_OSMesaMakeCurrent OSMesaMakeCurrent = (PFN_OSMesaMakeCurrent) dlsym(g_OSMesaLibrary, "OSMesaMakeCurrent");
+    g_OSMesaGetProcAddress = (PFN_OSMesaGetProcAddress) dlsym(g_OSMesaLibrary, "OSMesaGetProcAddress");
+    g_OSMesaDestroyContext = (PFN_OSMesaDestroyContext) dlsym(g_OSMesaLibrary, "OSMesaDestroyContext");
+    if (!OSMesaCreateContextAttribs || !OSMesaMakeCurrent || !g_OSMesaGetProcAddress || !g_OSMesaDestroyContext)
+    {
+        fprintf(stderr, "Headless: libOSMesa incompleta (requer OSMesaCreateContextAttribs).\n");
+        return false;
+    }
+
+    const int attribs[] = {
+        OSMESA_FORMAT, GL_RGBA,
+        OSMESA_DEPTH_BITS, 24,
+        OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, 3,
+        OSMESA_CONTEXT_MINOR_VERSION, 3,
+        0
+    };
+    g_OSMesaContext = OSMesaCreateContextAttribs(attribs, NULL);
+    if (!g_OSMesaContext)
+    {
+        fprintf(stderr, "Headless: OSMesaCreateContextAttribs() falhou (OpenGL 3.3 core).\n");
+        return false;
+    }
+
+    g_OSMesaBuffer.resize((size_t)width * height * 4);
+    if (!OSMesaMakeCurrent(g_OSMesaContext, g_OSMesaBuffer.data(), GL_UNSIGNED_BYTE, width, height))
+    {
+        fprintf(stderr, "Headless: OSMesaMakeCurrent() falhou.\n");
+        return false;
+    }
+
+    return true;
+}
+
+static void TerminateOSMesa()
+{
+    if (g_OSMesaContext)
+        g_OSMesaDestroyContext(g_OSMesaContext);
+    g_OSMesaContext = NULL;
+    g_OSMesaBuffer.clear();
+}
+
+// ---------------------------------------------------------------------------
+
+// Função passada para o GLAD
+static void* GetProcAddress(const char* name)
+{
+    if (g_OSMesaContext)
+        return g_OSMesaGetProcAddress(name);
+
+    // eglGetProcAddress() só é obrigada a retornar funções core a partir de
+    // EGL 1.5; para versões anteriores, procuramos também na libGL.
+    void* proc = g_eglGetProcAddress(name);
+    if (!proc)
+    {
+        static void* libgl = dlopen("libGL.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (libgl)
+            proc = dlsym(libgl, name);
+    }
+    return proc;
+}
+
+#endif // __linux__
+
+// Cria o FBO que faz o papel do framebuffer padrão
+static bool CreateFramebuffer(int width, int height)
+{
+    glGenRenderbuffers(2, g_Renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, g_Renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, g_Renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &g_Framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_Framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, g_Renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_Renderbuffers[1]);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        fprintf(stderr, "Headless: FBO incompleto (status 0x%x).\n", status);
+        return false;
+    }
+    glCheckError();
+
+    return true;
+}
+
+bool Headless_Init(const char* backend, int width, int height)
+{
+#ifdef __linux__
+    bool is_auto = strcmp(backend, HEADLESS_BACKEND_AUTO) == 0;
+    bool try_egl    = is_auto || strcmp(backend, HEADLESS_BACKEND_EGL) == 0;
+    bool try_osmesa = is_auto || strcmp(backend, HEADLESS_BACKEND_OSMESA) == 0;
+    if (!try_egl && !try_osmesa)
+    {
+        fprintf(stderr, "Headless: backend desconhecido \"%s\".\n", backend);
+        return false;
+    }
+
+    if (try_egl && InitEGL())
+        g_BackendName = "EGL";
+    else
+    {
+        TerminateEGL();
+        if (try_osmesa && InitOSMesa(width, height))
+            g_BackendName = "OSMesa";
+        else
+        {
+            TerminateOSMesa();
+            fprintf(stderr, "ERROR: Não foi possível criar um contexto OpenGL 3.3 sem janela.\n");
+            return false;
+        }
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc) GetProcAddress))
+    {
+        fprintf(stderr, "ERROR: gladLoadGLLoader() falhou no contexto %s.\n", g_BackendName);
+        Headless_Terminate();
+        return false;
+    }
+
+    g_Width = width;
+    g_Height = height;
+    if (!CreateFramebuffer(width, height))
+    {
+        Headless_Terminate();
+        return false;
+    }
+
+    g_StartTime = std::chrono::steady_clock::now();
+    g_Active = true;
+    return true;
+#else
+    (void)backend; (void)width; (void)height;
+    fprintf(stderr, "ERROR: Renderização sem janela só é suportada no Linux.\n");
+    return false;
+#endif
+}
+
+void Headless_Terminate()
+{
+#ifdef __linux__
+    if (g_Framebuffer)
+    {
+        glDeleteFramebuffers(1, &g_Framebuffer);
+        glDeleteRenderbuffers(2, g_Renderbuffers);
+        g_Framebuffer = 0;
+    }
+    TerminateEGL();
+    TerminateOSMesa();
+#endif
+    g_Active = false;
+}
+
+bool Headless_IsActive()
+{
+    return g_Active;
+}
+
+const char* Headless_BackendName()
+{
+    return g_BackendName;
+}
+
+GLuint Headless_GetFramebuffer()
+{
+    return g_Framebuffer;
+}
+
+void Headless_GetFramebufferSize(int* width, int* height)
+{
+    *width = g_Width;
+    *height = g_Height;
+}
+
+double Headless_GetTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - g_StartTime).count();
+}
+
+bool Headless_SaveScreenshot(const char* filename)
+{
+    if (!g_Active)
+        return false;
+
+    std::vector<unsigned char> pixels((size_t)g_Width * g_Height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, g_Framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, g_Width, g_Height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glCheckError();
+
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: Não foi possível criar o arquivo \"%s\".\n", filename);
+        return false;
+    }
+
+    // OpenGL começa pela linha de baixo, PPM pela de cima
+    fprintf(file, "P6\n%d %d\n255\n", g_Width, g_Height);
+    for (int row = g_Height - 1; row >= 0; --row)
+        fwrite(&pixels[(size_t)row * g_Width * 3], 1, (size_t)g_Width * 3, file);
+
+    fclose(file);
+    printf("Captura de tela salva em \"%s\".\n", filename);
+    return true;
+}
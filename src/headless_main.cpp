@@ -0,0 +1,1257 @@
+//     Universidade Federal do Rio Grande do Sul
+//             Instituto de Informática
+//       Departamento de Informática Aplicada
+//
+//    INF01047 Fundamentos de Computação Gráfica
+//               Prof. Eduardo Gastal
+
+// Executável "fcg_headless": roda a simulação do jogo ("simulation.h") sem
+// janela, sem OpenGL e sem carregar os modelos, com passo de tempo fixo e o
+// mais rápido possível. Serve para testes de longa duração ("soak tests") e
+// para medir o custo de cada sistema da simulação.
+//
+// O jogador é controlado por um script (--script) ou, por padrão, por um bot
+// aleatório que anda pelo mapa e atira no inimigo mais próximo. Ao final são
+// impressos os ticks por segundo e o tempo gasto em cada sistema.
+//
+// Com --record, a partida é gravada em um replay ("replay.h"); com --replay,
+// a entrada vem de um replay, a partir do segundo --seek (carregando o
+// keyframe mais próximo em vez de simular desde o início), útil para rodar
+// um trecho de uma partida longa com o profiler.
+//
+// Com --worlds N, roda N jogos independentes em lote ("simulationbatch.h"),
+// divididos entre --threads threads, cada um controlado por um bot que só vê
+// as observações e responde com ações, como um agente em treinamento. Nesse
+// modo --ticks é o número de passos do lote e o resultado é dado em passos de
+// ambiente (World x tick) por segundo.
+//
+// Sem --worlds, --threads é o número de threads do sistema de jobs
+// ("jobsystem.h"), que divide entre elas o trabalho de cada tick (por padrão,
+// uma por núcleo).
+//
+// Com --bench-enemies, mede o kernel de movimento dos inimigos
+// ("enemypaths.h"), escalar e SIMD, e o sistema de inimigos inteiro com 10
+// mil e 100 mil inimigos, com 1, 2, 4... até --threads threads no sistema de
+// jobs. Com --bench-raycasts, compara os raycasts contra
+// as caixas na BVH ("boxbvh.h") com a busca linear em todas as caixas, e a
+// BVH com um raio por vez com a BVH em pacotes de raios.
+//
+// As waves seguem "wavegenerator.h": --endless faz as waves não acabarem,
+// --wave-size e --wave-growth mudam o tamanho da primeira wave e o
+// crescimento a cada wave, --start-wave começa o jogo em uma wave adiante e
+// --formation escolhe onde os inimigos nascem.
+// Com --stress N, roda waves únicas de N, 2N, 4N... inimigos até os ticks
+// passarem de --budget milissegundos (padrão: a duração de um tick) e
+// imprime a curva de escalabilidade. --budget-metric escolhe o que é
+// comparado com o orçamento: o percentil 95 dos ticks (padrão), o tick médio
+// ou o mais lento.
+//
+// As mensagens da simulação (--verbose) passam pelo logger assíncrono
+// ("logger.h"): --log as escreve em um arquivo em vez do terminal (com
+// --log-binary, sem formatá-las), --log-level escolhe o nível mínimo e
+// --decode-log converte um log binário em texto.
+//
+// Os tiros, o dano e as waves chegam pelos eventos da simulação
+// ("eventbus.h"): --metrics grava em um arquivo CSV, a cada segundo
+// simulado, quantos tiros, acertos, dano e mortes houve. Com --replay, os
+// eventos são conferidos com os gravados no replay.
+//
+// Com --save-snapshot, o estado do jogo no fim da simulação (ou, com
+// --snapshot-wave N, no início da wave N) é salvo em um snapshot
+// ("snapshot.h"); --load-snapshot começa a simulação de um snapshot em vez
+// do início do jogo, para medir sempre a mesma cena.
+//
+// Uso:
+//
+//     ./fcg_headless [--ticks N] [--tick-rate HZ] [--seed S] [--script ARQUIVO]
+//                    [--bounds ARQUIVO] [--verbose] [--record ARQUIVO]
+//                    [--replay ARQUIVO [--seek SEGUNDOS]] [--worlds N] [--threads T]
+//                    [--bench-enemies] [--bench-raycasts] [--endless] [--wave-size N]
+//                    [--wave-growth G] [--start-wave N] [--formation ring|scatter|clusters]
+//                    [--stress N [--budget MS] [--budget-metric mean|p95|max]]
+//                    [--log ARQUIVO [--log-binary]]
+//                    [--log-level debug|info|warning|error] [--decode-log ARQUIVO]
+//                    [--metrics ARQUIVO] [--load-snapshot ARQUIVO]
+//                    [--save-snapshot ARQUIVO [--snapshot-wave N]]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <glm/geometric.hpp>
+
+#include "boxbvh.h"
+#include "enemypaths.h"
+#include "eventbus.h"
+#include "jobsystem.h"
+#include "logger.h"
+#include "replay.h"
+#include "simulation.h"
+#include "simulationbatch.h"
+#include "snapshot.h"
+
+#define HEADLESS_DEFAULT_TICKS     100000
+#define HEADLESS_DEFAULT_TICK_RATE SIMULATION_TICK_RATE
+#define HEADLESS_DEFAULT_BATCH_TICKS 1000 // Passos do lote se --ticks não for dado com --worlds
+#define HEADLESS_BENCH_UPDATES 50000000    // Atualizações de inimigo por medida do kernel
+#define HEADLESS_BENCH_TICKS   120         // Ticks por medida do sistema de inimigos
+#define HEADLESS_BENCH_RAYS    1000000     // Raios por medida dos raycasts
+#define HEADLESS_STRESS_WARMUP 30          // Ticks antes de cada medida de --stress
+#define HEADLESS_STRESS_TICKS  120         // Ticks medidos em cada passo de --stress
+#define HEADLESS_STRESS_MAX_ENEMIES 4000000 // Maior wave tentada por --stress
+
+// Um comando de um script de entrada. Formato do arquivo, um comando por
+// linha ('#' inicia um comentário):
+//
+//     <tick> forward|backward|left|right|run 0|1
+//     <tick> yaw <graus>      (direção para onde o jogador olha)
+//     <tick> shoot
+//     <tick> reload
+//
+// As linhas devem estar em ordem crescente de tick. Teclas continuam
+// pressionadas até serem soltas por outro comando.
+struct ScriptCommand
+{
+    long        tick;
+    std::string action;
+    float       value;
+};
+
+static std::vector<ScriptCommand> g_Script;
+static size_t g_ScriptNext = 0;
+
+static RandomStream g_BotRng;
+static long g_BotNextMoveTick = 0;
+
+// Exportador de métricas: consumidor dos eventos que conta tiros, acertos,
+// dano e mortes, no jogo inteiro e em janelas de um segundo simulado
+// (linhas do CSV de --metrics)
+struct HeadlessMetrics
+{
+    uint32_t player_shots;
+    uint32_t player_hits;
+    uint32_t enemy_shots;
+    uint32_t enemy_hits;
+    float    damage_to_enemies;
+    float    damage_to_player;
+    uint32_t kills;
+    uint32_t waves_completed;
+};
+
+static EventSubscriber g_MetricsSubscriber;
+static HeadlessMetrics g_MetricsTotal;
+static HeadlessMetrics g_MetricsWindow;
+static uint32_t g_MetricsWindowStart = 0; // Primeiro tick da janela
+static uint32_t g_MetricsWindowTicks = 1; // Ticks por janela
+static FILE* g_MetricsFile = NULL;
+
+static EventSubscriber g_LogSubscriber;
+
+// Jogo simulado no modo de um único World e a entrada do próximo tick, em
+// primeira pessoa. Os botões SHOOT e RELOAD valem só para um tick.
+static World g_World;
+static SimulationAction g_Action = { 0, 0.0f, 0.0f, 0.0f };
+
+static void AddEvent(HeadlessMetrics& metrics, const GameEvent& event)
+{
+    switch (event.type)
+    {
+        case GAME_EVENT_SHOT:
+            if (event.shot.shooter == RAY_LAYER_PLAYER)
+            {
+                metrics.player_shots += 1;
+                metrics.player_hits += event.shot.layer == RAY_LAYER_ENEMIES ? 1 : 0;
+            }
+            else
+            {
+                metrics.enemy_shots += 1;
+                metrics.enemy_hits += event.shot.layer == RAY_LAYER_PLAYER ? 1 : 0;
+            }
+            break;
+        case GAME_EVENT_ENEMY_DAMAGED:  metrics.damage_to_enemies += event.damage.amount; break;
+        case GAME_EVENT_PLAYER_DAMAGED: metrics.damage_to_player += event.damage.amount; break;
+        case GAME_EVENT_ENEMY_KILLED:   metrics.kills += 1; break;
+        case GAME_EVENT_WAVE_COMPLETE:  metrics.waves_completed += 1; break;
+    }
+}
+
+// Escreve a linha da janela corrente e começa a próxima
+static void WriteMetricsWindow()
+{
+    if (g_MetricsFile)
+    {
+        const HeadlessMetrics& m = g_MetricsWindow;
+        fprintf(g_MetricsFile, "%u,%u,%u,%u,%u,%.1f,%.1f,%u,%u\n", g_MetricsWindowStart / g_MetricsWindowTicks,
+                m.player_shots, m.player_hits, m.enemy_shots, m.enemy_hits,
+                m.damage_to_enemies, m.damage_to_player, m.kills, m.waves_completed);
+    }
+    memset(&g_MetricsWindow, 0, sizeof(g_MetricsWindow));
+    g_MetricsWindowStart += g_MetricsWindowTicks;
+}
+
+static void BeginMetrics(const World& world, int tick_rate)
+{
+    EventBus_Subscribe(world.events, g_MetricsSubscriber);
+    memset(&g_MetricsTotal, 0, sizeof(g_MetricsTotal));
+    memset(&g_MetricsWindow, 0, sizeof(g_MetricsWindow));
+    g_MetricsWindowTicks = (uint32_t)tick_rate;
+    g_MetricsWindowStart = world.tick - world.tick % g_MetricsWindowTicks;
+    if (g_MetricsFile)
+        fprintf(g_MetricsFile, "segundo,tiros_jogador,acertos_jogador,tiros_inimigos,acertos_inimigos,"
+                               "dano_inimigos,dano_jogador,mortes,waves\n");
+}
+
+// Lê os eventos publicados desde a última chamada
+static void UpdateMetrics(const World& world)
+{
+    GameEvent events[256];
+    size_t count;
+    while ((count = EventBus_Poll(world.events, g_MetricsSubscriber, events, 256)) > 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            while (events[i].tick >= g_MetricsWindowStart + g_MetricsWindowTicks)
+                WriteMetricsWindow();
+            AddEvent(g_MetricsTotal, events[i]);
+            AddEvent(g_MetricsWindow, events[i]);
+        }
+    }
+}
+
+static bool LoadScript(const char* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if (!file)
+        return false;
+
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        line_number += 1;
+
+        char* comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        ScriptCommand command;
+        char action[32];
+        command.value = 0.0f;
+        int n = sscanf(line, "%ld %31s %f", &command.tick, action, &command.value);
+        if (n <= 0)
+            continue; // Linha vazia
+        if (n == 1)
+        {
+            fprintf(stderr, "ERROR: %s:%d: comando faltando.\n", filename, line_number);
+            fclose(file);
+            return false;
+        }
+
+        command.action = action;
+        g_Script.push_back(command);
+    }
+    fclose(file);
+
+    std::stable_sort(g_Script.begin(), g_Script.end(),
+                     [](const ScriptCommand& a, const ScriptCommand& b) { return a.tick < b.tick; });
+    return true;
+}
+
+// Faz o jogador olhar na direção "yaw" (em radianos, 0 = -Z, como
+// Player::rotation_y), no plano horizontal. O yaw da câmera em primeira
+// pessoa é medido a partir de +Z.
+static void SetPlayerYaw(float yaw)
+{
+    g_Action.yaw = 3.141592f - yaw;
+    g_Action.pitch = 0.0f;
+}
+
+static void SetButton(unsigned int button, bool pressed)
+{
+    if (pressed)
+        g_Action.buttons |= button;
+    else
+        g_Action.buttons &= ~button;
+}
+
+static void ApplyScript(long tick)
+{
+    for (; g_ScriptNext < g_Script.size() && g_Script[g_ScriptNext].tick <= tick; ++g_ScriptNext)
+    {
+        const ScriptCommand& command = g_Script[g_ScriptNext];
+        bool pressed = command.value != 0.0f;
+
+        if (command.action == "forward")
+            SetButton(SIMULATION_ACTION_FORWARD, pressed);
+        else if (command.action == "backward")
+            SetButton(SIMULATION_ACTION_BACKWARD, pressed);
+        else if (command.action == "left")
+            SetButton(SIMULATION_ACTION_LEFT, pressed);
+        else if (command.action == "right")
+            SetButton(SIMULATION_ACTION_RIGHT, pressed);
+        else if (command.action == "run")
+            SetButton(SIMULATION_ACTION_RUN, pressed);
+        else if (command.action == "yaw")
+            SetPlayerYaw(command.value * 3.141592f / 180.0f);
+        else if (command.action == "shoot")
+            SetButton(SIMULATION_ACTION_SHOOT, true);
+        else if (command.action == "reload")
+            SetButton(SIMULATION_ACTION_RELOAD, true);
+        else
+            fprintf(stderr, "WARNING: comando desconhecido \"%s\" no tick %ld.\n", command.action.c_str(), command.tick);
+    }
+}
+
+// Bot aleatório: troca as teclas de movimento a cada 0.5 a 2 segundos, mira
+// no inimigo vivo mais próximo e atira sempre que pode.
+static void ApplyRandomInput(long tick, int tick_rate)
+{
+    if (tick >= g_BotNextMoveTick)
+    {
+        SetButton(SIMULATION_ACTION_FORWARD,  g_BotRng.NextBelow(4) == 0);
+        SetButton(SIMULATION_ACTION_BACKWARD, g_BotRng.NextBelow(4) == 0);
+        SetButton(SIMULATION_ACTION_LEFT,     g_BotRng.NextBelow(4) == 0);
+        SetButton(SIMULATION_ACTION_RIGHT,    g_BotRng.NextBelow(4) == 0);
+        SetButton(SIMULATION_ACTION_RUN,      g_BotRng.NextBelow(4) == 0);
+        g_BotNextMoveTick = tick + tick_rate / 2 + g_BotRng.NextBelow(tick_rate * 2 - tick_rate / 2 + 1);
+    }
+
+    // A mesma origem usada por Simulation_PlayerShoot(g_World) em primeira pessoa
+    glm::vec4 eye = g_World.player.position + glm::vec4(0.0f, 1.5f, 0.0f, 0.0f);
+
+    bool found_target = false;
+    glm::vec4 target;
+    float target_distance = 15.0f; // Alcance do bot
+    for (size_t i = 0; i < g_World.enemies.size(); ++i)
+    {
+        glm::vec4 position = Simulation_EnemyPosition(g_World, i);
+        float distance = glm::length(glm::vec3(position - eye));
+        if (distance < target_distance)
+        {
+            found_target = true;
+            target = position;
+            target_distance = distance;
+        }
+    }
+
+    if (found_target)
+    {
+        glm::vec3 direction = glm::normalize(glm::vec3(target - eye));
+        g_Action.yaw = atan2(direction.x, direction.z);
+        g_Action.pitch = asin(direction.y);
+        SetButton(SIMULATION_ACTION_SHOOT, true);
+    }
+
+    if (g_World.player.magazine_ammo == 0)
+        SetButton(SIMULATION_ACTION_RELOAD, true);
+}
+
+// Bot do modo em lote: a mesma ideia de ApplyRandomInput(), mas usando só as
+// observações. Mira no inimigo vivo mais próximo e troca as teclas de
+// movimento de vez em quando, com um gerador simples por World.
+static void ChooseBatchActions(const SimulationObservations& observations, std::vector<unsigned int>& bot_state,
+                               std::vector<SimulationAction>& actions)
+{
+    for (int i = 0; i < observations.num_worlds; ++i)
+    {
+        SimulationAction& action = actions[i];
+
+        // xorshift32
+        unsigned int x = bot_state[i];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        bot_state[i] = x;
+
+        if ((x & 63) == 0) // ~1 vez por segundo a 60 Hz
+            action.buttons = (x >> 8) & (SIMULATION_ACTION_FORWARD | SIMULATION_ACTION_BACKWARD |
+                                         SIMULATION_ACTION_LEFT | SIMULATION_ACTION_RIGHT | SIMULATION_ACTION_RUN);
+        action.buttons &= ~(SIMULATION_ACTION_SHOOT | SIMULATION_ACTION_RELOAD);
+        action.pitch = 0.0f;
+
+        float player_x = observations.player_x[i];
+        float player_z = observations.player_z[i];
+        const float* enemy_x = observations.enemy_x + (size_t)i * SIMULATION_OBS_MAX_ENEMIES;
+        const float* enemy_z = observations.enemy_z + (size_t)i * SIMULATION_OBS_MAX_ENEMIES;
+        const float* enemy_health = observations.enemy_health + (size_t)i * SIMULATION_OBS_MAX_ENEMIES;
+
+        int target = -1;
+        float target_distance2 = 15.0f * 15.0f; // Alcance do bot
+        for (int j = 0; j < SIMULATION_OBS_MAX_ENEMIES; ++j)
+        {
+            if (enemy_health[j] <= 0.0f)
+                continue;
+            float dx = enemy_x[j] - player_x;
+            float dz = enemy_z[j] - player_z;
+            float distance2 = dx*dx + dz*dz;
+            if (distance2 < target_distance2)
+            {
+                target = j;
+                target_distance2 = distance2;
+            }
+        }
+
+        if (target >= 0)
+        {
+            action.yaw = atan2f(enemy_x[target] - player_x, enemy_z[target] - player_z);
+            action.buttons |= SIMULATION_ACTION_SHOOT;
+        }
+
+        if (observations.player_ammo[i] == 0.0f && observations.player_reloading[i] == 0.0f)
+            action.buttons |= SIMULATION_ACTION_RELOAD;
+    }
+}
+
+static int RunBatch(int num_worlds, int num_threads, long max_ticks, int tick_rate, unsigned int seed)
+{
+    std::vector<World> worlds(num_worlds);
+    for (int i = 0; i < num_worlds; ++i)
+    {
+        worlds[i].camera_mode = CAMERA_FIRST_PERSON;
+        Simulation_Init(worlds[i], seed + i);
+    }
+
+    SimulationObservations observations;
+    if (!SimulationBatch_AllocObservations(&observations, num_worlds))
+    {
+        fprintf(stderr, "ERROR: Não foi possível alocar as observações de %d jogos.\n", num_worlds);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<SimulationAction> actions(num_worlds);
+    std::vector<unsigned int> bot_state(num_worlds);
+    for (int i = 0; i < num_worlds; ++i)
+    {
+        SimulationAction none = { 0, 0.0f, 0.0f, 0.0f };
+        actions[i] = none;
+        bot_state[i] = (seed + 1) * 2654435761u + i * 40503u;
+        if (bot_state[i] == 0) // xorshift nunca sai do zero
+            bot_state[i] = 1;
+        SimulationBatch_Observe(worlds[i], &observations, i);
+    }
+
+    num_threads = SimulationBatch_Init(num_threads);
+    printf("Simulando %d jogos por %ld ticks a %d Hz com %d threads (semente %u)...\n",
+           num_worlds, max_ticks, tick_rate, num_threads, seed);
+
+    const float delta_time = 1.0f / tick_rate;
+    long episodes = 0;
+    double total_reward = 0.0;
+    double step_seconds = 0.0; // Só SimulationBatch_Step(), sem o bot
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (long tick = 0; tick < max_ticks; ++tick)
+    {
+        ChooseBatchActions(observations, bot_state, actions);
+
+        std::chrono::steady_clock::time_point step_begin = std::chrono::steady_clock::now();
+        SimulationBatch_Step(worlds.data(), actions.data(), num_worlds, delta_time, &observations);
+        step_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - step_begin).count();
+
+        for (int i = 0; i < num_worlds; ++i)
+        {
+            total_reward += observations.reward[i];
+            if (observations.done[i] != 0.0f)
+                episodes += 1;
+        }
+    }
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    SimulationBatch_Terminate();
+    SimulationBatch_FreeObservations(&observations);
+
+    double env_steps = (double)num_worlds * max_ticks;
+    printf("\n%.0f passos de ambiente em %.3f s (%.3f s em SimulationBatch_Step).\n",
+           env_steps, wall_seconds, step_seconds);
+    printf("%.0f passos/s no total, %.0f passos/s no passo em lote (%.0f por thread).\n",
+           env_steps / wall_seconds, env_steps / step_seconds, env_steps / step_seconds / num_threads);
+    printf("%ld episódios terminados, recompensa média por jogo %.2f.\n",
+           episodes, total_reward / num_worlds);
+
+    return EXIT_SUCCESS;
+}
+
+// Segundos gastos em "repetitions" chamadas de EnemyPaths_Update() (ou da
+// versão escalar)
+static double TimeEnemyPaths(EnemyPaths& paths, int repetitions, float delta_time, bool scalar)
+{
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        if (scalar)
+            EnemyPaths_UpdateScalar(paths, 0, paths.Size(), delta_time);
+        else
+            EnemyPaths_Update(paths, delta_time);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Hash FNV-1a do estado dos inimigos e do jogador, para comparar execuções
+static uint64_t HashEnemies(const World& world)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (int byte = 0; byte < 4; ++byte)
+        {
+            hash ^= (bits >> (8 * byte)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    };
+    for (size_t i = 0; i < world.enemies.size(); ++i)
+    {
+        const Enemy& enemy = world.enemies[i];
+        add(world.enemy_paths.x[i]);
+        add(world.enemy_paths.z[i]);
+        add(world.enemy_paths.heading_x[i]);
+        add(world.enemy_paths.heading_z[i]);
+        add(enemy.health);
+        add(enemy.shoot_cooldown);
+    }
+    add(world.player.health);
+    return hash;
+}
+
+// Milissegundos por tick do sistema de inimigos com os inimigos em
+// "spawn_positions" e "num_threads" threads no sistema de jobs
+static double TimeEnemySystem(const std::vector<glm::vec4>& spawn_positions, int num_threads,
+                              float delta_time, unsigned int seed, uint64_t& hash)
+{
+    JobSystem_Init(num_threads);
+
+    World world;
+    Simulation_Init(world, seed);
+    std::vector<glm::vec4> positions = spawn_positions;
+    for (glm::vec4& position : positions)
+        position.y = world.enemy_paths.y[0];
+    SpawnWave(world, positions);
+
+    SimulationTimings timings = { 0.0, 0.0, 0.0 };
+    for (int tick = 0; tick < HEADLESS_BENCH_TICKS; ++tick)
+        Simulation_Step(world, delta_time, &timings);
+
+    hash = HashEnemies(world);
+    return timings.enemies * 1e3 / HEADLESS_BENCH_TICKS;
+}
+
+// --bench-enemies: kernel de movimento e sistema de inimigos com muitos
+// inimigos, com até max_threads threads (0: uma por núcleo)
+static int RunEnemyBenchmark(int tick_rate, unsigned int seed, int max_threads)
+{
+    if (max_threads <= 0)
+        max_threads = JobSystem_Init(0);
+    const size_t sizes[] = { 10000, 100000 };
+    const float delta_time = 1.0f / tick_rate;
+
+    printf("Kernel de movimento dos inimigos: %s\n", EnemyPaths_KernelName());
+    for (size_t size : sizes)
+    {
+        int repetitions = (int)(HEADLESS_BENCH_UPDATES / size);
+
+        // Curvas aleatórias pelo mapa, lentas o bastante para nenhuma chegar
+        // ao fim durante a medida (o kernel faria menos trabalho)
+        RandomStream rng;
+        rng.Seed(seed, size);
+        EnemyPaths scalar_paths;
+        EnemyPaths_Resize(scalar_paths, size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            float control_x[4], control_z[4];
+            for (int j = 0; j < 4; ++j)
+            {
+                control_x[j] = rng.NextFloat(MAP_MIN_X, MAP_MAX_X);
+                control_z[j] = rng.NextFloat(MAP_MIN_Z, MAP_MAX_Z);
+            }
+            float length = rng.NextFloat(0.0f, 0.5f); // Fração da curva percorrida na medida
+            EnemyPaths_SetCurve(scalar_paths, i, control_x, control_z, 0.0f);
+
+            float total = scalar_paths.arc_length[ENEMY_PATHS_ARC_SAMPLES - 1][i];
+            scalar_paths.distance[i] = rng.NextFloat(0.0f, 0.5f) * total;
+            scalar_paths.speed[i] = length * total / (repetitions * delta_time);
+        }
+        EnemyPaths simd_paths = scalar_paths;
+
+        double scalar_seconds = TimeEnemyPaths(scalar_paths, repetitions, delta_time, true);
+        double simd_seconds = TimeEnemyPaths(simd_paths, repetitions, delta_time, false);
+        bool identical = scalar_paths.distance == simd_paths.distance &&
+                         scalar_paths.progress == simd_paths.progress &&
+                         scalar_paths.x == simd_paths.x && scalar_paths.z == simd_paths.z &&
+                         scalar_paths.heading_x == simd_paths.heading_x &&
+                         scalar_paths.heading_z == simd_paths.heading_z;
+
+        double updates = (double)size * repetitions;
+        printf("\n%zu inimigos, %d ticks:\n", size, repetitions);
+        printf("  kernel escalar: %6.2f ns por inimigo\n", scalar_seconds * 1e9 / updates);
+        printf("  kernel %-7s %6.2f ns por inimigo (%.1fx), resultados %s\n",
+               (std::string(EnemyPaths_KernelName()) + ":").c_str(), simd_seconds * 1e9 / updates,
+               scalar_seconds / simd_seconds, identical ? "idênticos" : "DIFERENTES");
+
+        // Sistema de inimigos inteiro em um World (curvas, colisão com as
+        // caixas e tiros), com 1, 2, 4... até max_threads threads
+        std::vector<glm::vec4> spawn_positions(size);
+        for (size_t i = 0; i < size; ++i)
+            spawn_positions[i] = glm::vec4(rng.NextFloat(MAP_MIN_X, MAP_MAX_X), 0.0f,
+                                           rng.NextFloat(MAP_MIN_Z, MAP_MAX_Z), 1.0f);
+
+        double single_thread_ms = 0.0;
+        uint64_t single_thread_hash = 0;
+        for (int threads = 1;; threads = std::min(threads * 2, max_threads))
+        {
+            uint64_t hash = 0;
+            double ms = TimeEnemySystem(spawn_positions, threads, delta_time, seed, hash);
+            if (threads == 1)
+            {
+                single_thread_ms = ms;
+                single_thread_hash = hash;
+            }
+            printf("  sistema de inimigos, %2d threads: %.2f ms por tick, %.2f ns por inimigo (%.2fx), resultados %s\n",
+                   threads, ms, ms * 1e6 / size, single_thread_ms / ms,
+                   hash == single_thread_hash ? "idênticos" : "DIFERENTES");
+            if (threads == max_threads)
+                break;
+        }
+    }
+    JobSystem_Terminate();
+
+    return EXIT_SUCCESS;
+}
+
+// Formação de --formation; false se o nome não é conhecido
+static bool ParseFormation(const char* name, WaveFormation& formation)
+{
+    const char* names[] = { "ring", "scatter", "clusters" };
+    for (int i = 0; i < 3; ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            formation = (WaveFormation)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tempo dos ticks de --stress comparado com --budget
+enum StressMetric
+{
+    STRESS_METRIC_MEAN = 0, // Tick médio
+    STRESS_METRIC_P95,      // Percentil 95: no máximo um tick em vinte passa do orçamento
+    STRESS_METRIC_MAX       // Tick mais lento: nenhum passa
+};
+
+static const char* g_StressMetricNames[] = { "mean", "p95", "max" };
+
+// Métrica de --budget-metric; false se o nome não é conhecido
+static bool ParseStressMetric(const char* name, StressMetric& metric)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (strcmp(name, g_StressMetricNames[i]) == 0)
+        {
+            metric = (StressMetric)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --stress: uma wave só de "count" inimigos na formação de "config", com o
+// número de inimigos dobrando a cada passo até a métrica "metric" dos ticks
+// passar de budget_ms. Imprime, para cada passo, o tempo do spawn (posições e
+// curvas iniciais) e o tempo médio, o percentil 95 e o máximo dos ticks. O
+// jogador fica parado.
+static int RunStress(int tick_rate, unsigned int seed, int count, double budget_ms, StressMetric metric,
+                     int num_threads, const WaveConfig& config)
+{
+    const char* metric_descriptions[] = { "tick médio", "percentil 95 dos ticks", "tick mais lento" };
+    num_threads = JobSystem_Init(num_threads);
+    const float delta_time = 1.0f / tick_rate;
+    const char* formations[] = { "ring", "scatter", "clusters" };
+    printf("Escalabilidade: wave única em formação %s, %s de até %.2f ms, %d threads.\n",
+           formations[config.formation], metric_descriptions[metric], budget_ms, num_threads);
+    printf("\n%10s %10s %10s %10s %10s %12s\n", "inimigos", "spawn ms", "ms/tick", "p95 ms", "máx ms", "ns/inimigo");
+
+    int last_within_budget = 0;
+    std::vector<double> tick_ms(HEADLESS_STRESS_TICKS);
+    for (; count <= HEADLESS_STRESS_MAX_ENEMIES; count *= 2)
+    {
+        World world;
+        world.wave_config = config;
+        world.wave_config.max_waves = 1;
+        world.wave_config.base_count = count;
+        world.wave_config.count_step = 0;
+        world.wave_config.count_growth = 1.0f;
+        world.wave_config.max_count = count;
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        Simulation_Init(world, seed);
+        double spawn_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        for (int tick = 0; tick < HEADLESS_STRESS_WARMUP; ++tick)
+            Simulation_Step(world, delta_time);
+
+        double total_ms = 0.0;
+        for (int tick = 0; tick < HEADLESS_STRESS_TICKS; ++tick)
+        {
+            begin = std::chrono::steady_clock::now();
+            Simulation_Step(world, delta_time);
+            tick_ms[tick] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            total_ms += tick_ms[tick];
+        }
+        std::sort(tick_ms.begin(), tick_ms.end());
+
+        double mean_ms = total_ms / HEADLESS_STRESS_TICKS;
+        double p95_ms = tick_ms[HEADLESS_STRESS_TICKS * 95 / 100];
+        printf("%10d %10.1f %10.3f %10.3f %10.3f %12.1f\n", count, spawn_ms, mean_ms,
+               p95_ms, tick_ms.back(), mean_ms * 1e6 / count);
+        fflush(stdout);
+
+        double measured_ms[] = { mean_ms, p95_ms, tick_ms.back() };
+        if (measured_ms[metric] > budget_ms)
+            break;
+        last_within_budget = count;
+    }
+    JobSystem_Terminate();
+
+    if (count > HEADLESS_STRESS_MAX_ENEMIES)
+        printf("\nTodas as waves até %d inimigos couberam em %.2f ms (%s).\n",
+               last_within_budget, budget_ms, metric_descriptions[metric]);
+    else if (last_within_budget > 0)
+        printf("\nMaior wave dentro de %.2f ms (%s): %d inimigos (excedido com %d).\n",
+               budget_ms, metric_descriptions[metric], last_within_budget, count);
+    else
+        printf("\nNem a primeira wave (%d inimigos) coube em %.2f ms (%s).\n",
+               count, budget_ms, metric_descriptions[metric]);
+    return EXIT_SUCCESS;
+}
+
+// Resultado de um raycast no benchmark
+struct BenchRayHit
+{
+    bool  hit;
+    float t;
+};
+
+// Caixa mais próxima (ou, com "occlusion", qualquer caixa até max_distance)
+// testando todas as caixas, como CameraRaycast() fazia antes da BVH
+static BenchRayHit LinearRaycast(const std::vector<BoxAABB>& aabbs, const glm::vec4& origin,
+                                 const glm::vec4& direction, float max_distance, bool occlusion)
+{
+    BenchRayHit result = { false, max_distance };
+    for (const BoxAABB& aabb : aabbs)
+    {
+        float t = 0.0f;
+        if (!RayAABBIntersection(origin, direction, aabb.min, aabb.max, t) || t <= 0.0f)
+            continue;
+        if (occlusion && t <= max_distance)
+            return BenchRayHit{ true, t };
+        if (!occlusion && t < result.t)
+            result = BenchRayHit{ true, t };
+    }
+    return result;
+}
+
+// Raios por segundo de "query" em todos os raios; os resultados ficam em "hits"
+template <typename Query>
+static double TimeRaycasts(const std::vector<glm::vec4>& origins, const std::vector<glm::vec4>& directions,
+                           std::vector<BenchRayHit>& hits, Query query)
+{
+    hits.resize(origins.size());
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < origins.size(); ++i)
+        hits[i] = query(origins[i], directions[i]);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return origins.size() / seconds;
+}
+
+// --bench-raycasts: raycasts contra as caixas, BVH e busca linear
+static int RunRaycastBenchmark(unsigned int seed)
+{
+    World world;
+    Simulation_Init(world, seed);
+    const std::vector<BoxAABB>& aabbs = world.map->box_grid.aabbs;
+    const BoxBVH& bvh = world.map->box_bvh;
+    printf("%zu caixas, BVH com %zu nós e %d níveis.\n", aabbs.size(), bvh.nodes.size(), bvh.depth);
+
+    // Raios pelo mapa na altura das entidades, metade deles na horizontal
+    // (como os tiros em primeira pessoa e os dos inimigos)
+    RandomStream rng;
+    rng.Seed(seed, 0);
+    std::vector<glm::vec4> origins(HEADLESS_BENCH_RAYS);
+    std::vector<glm::vec4> directions(HEADLESS_BENCH_RAYS);
+    for (size_t i = 0; i < origins.size(); ++i)
+    {
+        origins[i] = glm::vec4(rng.NextFloat(MAP_MIN_X, MAP_MAX_X), rng.NextFloat(-1.1f, 1.0f),
+                               rng.NextFloat(MAP_MIN_Z, MAP_MAX_Z), 1.0f);
+        float yaw = rng.NextFloat(0.0f, 6.2831853f);
+        float pitch = (i % 2 == 0) ? 0.0f : rng.NextFloat(-0.5f, 0.5f);
+        directions[i] = glm::vec4(cosf(pitch) * sinf(yaw), sinf(pitch), cosf(pitch) * cosf(yaw), 0.0f);
+    }
+
+    // Mesmas distâncias máximas de CameraRaycast() e EnemyToPlayerRaycast()
+    const float distances[] = { 100.0f, 15.0f };
+    for (int occlusion = 0; occlusion <= 1; ++occlusion)
+    {
+        float max_distance = distances[occlusion];
+        std::vector<BenchRayHit> linear_hits, bvh_hits;
+        double linear_rate = TimeRaycasts(origins, directions, linear_hits,
+            [&](const glm::vec4& origin, const glm::vec4& direction)
+            {
+                return LinearRaycast(aabbs, origin, direction, max_distance, occlusion != 0);
+            });
+        double bvh_rate = TimeRaycasts(origins, directions, bvh_hits,
+            [&](const glm::vec4& origin, const glm::vec4& direction)
+            {
+                BenchRayHit result = { false, max_distance };
+                if (occlusion)
+                    result.hit = BoxBVH_Occluded(bvh, origin, direction, max_distance);
+                else
+                    result.hit = BoxBVH_Raycast(bvh, origin, direction, max_distance, result.t);
+                return result;
+            });
+
+        // Na oclusão a distância não é comparada: a busca linear para na
+        // primeira caixa da lista, não na primeira encontrada pela BVH
+        size_t differences = 0;
+        size_t num_hits = 0;
+        for (size_t i = 0; i < origins.size(); ++i)
+        {
+            num_hits += bvh_hits[i].hit ? 1 : 0;
+            if (linear_hits[i].hit != bvh_hits[i].hit || (!occlusion && linear_hits[i].t != bvh_hits[i].t))
+                differences += 1;
+        }
+
+        printf("\n%s, até %.0f unidades (%.1f%% dos raios atingem uma caixa):\n",
+               occlusion ? "Oclusão (qualquer caixa)" : "Caixa mais próxima", max_distance,
+               100.0 * num_hits / origins.size());
+        printf("  busca linear: %8.2f milhões de raios/s\n", linear_rate / 1e6);
+        printf("  BVH:          %8.2f milhões de raios/s (%.1fx), ", bvh_rate / 1e6, bvh_rate / linear_rate);
+        if (differences == 0)
+            printf("resultados idênticos\n");
+        else
+            printf("%zu resultados DIFERENTES\n", differences);
+    }
+
+    // Pacotes de raios coerentes, como os que RayQueries_Resolve() monta:
+    // origens a até meia unidade e direções a até ~3 graus umas das outras
+    const float max_distance = 100.0f;
+    for (size_t i = 0; i < origins.size(); i += BOX_BVH_PACKET_SIZE)
+    {
+        glm::vec4 origin = origins[i];
+        float yaw = rng.NextFloat(0.0f, 6.2831853f);
+        float pitch = (i / BOX_BVH_PACKET_SIZE % 2 == 0) ? 0.0f : rng.NextFloat(-0.5f, 0.5f);
+        for (size_t r = i; r < i + BOX_BVH_PACKET_SIZE && r < origins.size(); ++r)
+        {
+            origins[r] = origin + glm::vec4(rng.NextFloat(-0.5f, 0.5f), 0.0f, rng.NextFloat(-0.5f, 0.5f), 0.0f);
+            float ray_yaw = yaw + rng.NextFloat(-0.05f, 0.05f);
+            directions[r] = glm::vec4(cosf(pitch) * sinf(ray_yaw), sinf(pitch), cosf(pitch) * cosf(ray_yaw), 0.0f);
+        }
+    }
+
+    std::vector<BenchRayHit> single_hits, packet_hits(origins.size());
+    double single_rate = TimeRaycasts(origins, directions, single_hits,
+        [&](const glm::vec4& origin, const glm::vec4& direction)
+        {
+            BenchRayHit result = { false, max_distance };
+            result.hit = BoxBVH_Raycast(bvh, origin, direction, max_distance, result.t);
+            return result;
+        });
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < origins.size(); i += BOX_BVH_PACKET_SIZE)
+    {
+        int count = (int)std::min(origins.size() - i, (size_t)BOX_BVH_PACKET_SIZE);
+        float t[BOX_BVH_PACKET_SIZE];
+        bool hit[BOX_BVH_PACKET_SIZE];
+        for (int r = 0; r < count; ++r)
+            t[r] = max_distance;
+        BoxBVH_RaycastPacket(bvh, &origins[i], &directions[i], count, t, hit);
+        for (int r = 0; r < count; ++r)
+            packet_hits[i + r] = BenchRayHit{ hit[r], t[r] };
+    }
+    double packet_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    double packet_rate = origins.size() / packet_seconds;
+
+    size_t differences = 0;
+    for (size_t i = 0; i < origins.size(); ++i)
+        if (single_hits[i].hit != packet_hits[i].hit || single_hits[i].t != packet_hits[i].t)
+            differences += 1;
+
+    printf("\nPacotes de %d raios coerentes, caixa mais próxima até %.0f unidades:\n",
+           BOX_BVH_PACKET_SIZE, max_distance);
+    printf("  BVH, um raio por vez: %8.2f milhões de raios/s\n", single_rate / 1e6);
+    printf("  BVH em pacotes:       %8.2f milhões de raios/s (%.1fx), ", packet_rate / 1e6, packet_rate / single_rate);
+    if (differences == 0)
+        printf("resultados idênticos\n");
+    else
+        printf("%zu resultados DIFERENTES\n", differences);
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    long max_ticks = -1;
+    int tick_rate = HEADLESS_DEFAULT_TICK_RATE;
+    unsigned int seed = 1;
+    const char* script_filename = NULL;
+    const char* bounds_filename = SIMULATION_BOUNDS_FILE;
+    bool verbose = false;
+    int num_worlds = 0;
+    int num_threads = 0;
+    const char* record_filename = NULL;
+    const char* replay_filename = NULL;
+    double seek_seconds = 0.0;
+    bool bench_enemies = false;
+    bool bench_raycasts = false;
+    WaveConfig wave_config;
+    bool endless = false;
+    float wave_growth = 0.0f; // 0: o padrão do modo (1, ou WAVE_ENDLESS_GROWTH com --endless)
+    bool has_formation = false;
+    int stress_count = 0;
+    double budget_ms = 0.0;
+    StressMetric budget_metric = STRESS_METRIC_P95;
+    const char* log_filename = NULL;
+    bool log_binary = false;
+    int log_level = LOG_LEVEL_DEBUG;
+    const char* metrics_filename = NULL;
+    const char* load_snapshot_filename = NULL;
+    const char* save_snapshot_filename = NULL;
+    int snapshot_wave = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--ticks") == 0 && has_value)
+            max_ticks = atol(argv[++i]);
+        else if (strcmp(argv[i], "--tick-rate") == 0 && has_value)
+            tick_rate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && has_value)
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--script") == 0 && has_value)
+            script_filename = argv[++i];
+        else if (strcmp(argv[i], "--bounds") == 0 && has_value)
+            bounds_filename = argv[++i];
+        else if (strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else if (strcmp(argv[i], "--worlds") == 0 && has_value)
+            num_worlds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && has_value)
+            num_threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--record") == 0 && has_value)
+            record_filename = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && has_value)
+            replay_filename = argv[++i];
+        else if (strcmp(argv[i], "--seek") == 0 && has_value)
+            seek_seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--bench-enemies") == 0)
+            bench_enemies = true;
+        else if (strcmp(argv[i], "--bench-raycasts") == 0)
+            bench_raycasts = true;
+        else if (strcmp(argv[i], "--endless") == 0)
+            endless = true;
+        else if (strcmp(argv[i], "--wave-size") == 0 && has_value)
+            wave_config.base_count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--wave-growth") == 0 && has_value)
+            wave_growth = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--start-wave") == 0 && has_value)
+            wave_config.first_wave = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--formation") == 0 && has_value && ParseFormation(argv[i + 1], wave_config.formation))
+        {
+            has_formation = true;
+            i += 1;
+        }
+        else if (strcmp(argv[i], "--stress") == 0 && has_value)
+            stress_count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--budget") == 0 && has_value)
+            budget_ms = atof(argv[++i]);
+        else if (strcmp(argv[i], "--budget-metric") == 0 && has_value && ParseStressMetric(argv[i + 1], budget_metric))
+            i += 1;
+        else if (strcmp(argv[i], "--log") == 0 && has_value)
+            log_filename = argv[++i];
+        else if (strcmp(argv[i], "--log-binary") == 0)
+            log_binary = true;
+        else if (strcmp(argv[i], "--log-level") == 0 && has_value && Logger_ParseLevel(argv[i + 1]) >= 0)
+            log_level = Logger_ParseLevel(argv[++i]);
+        else if (strcmp(argv[i], "--metrics") == 0 && has_value)
+            metrics_filename = argv[++i];
+        else if (strcmp(argv[i], "--load-snapshot") == 0 && has_value)
+            load_snapshot_filename = argv[++i];
+        else if (strcmp(argv[i], "--save-snapshot") == 0 && has_value)
+            save_snapshot_filename = argv[++i];
+        else if (strcmp(argv[i], "--snapshot-wave") == 0 && has_value)
+            snapshot_wave = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--decode-log") == 0 && has_value)
+            return Logger_DecodeFile(argv[i + 1], stdout) ? EXIT_SUCCESS : EXIT_FAILURE;
+        else
+        {
+            fprintf(stderr, "Uso: %s [--ticks N] [--tick-rate HZ] [--seed S] [--script ARQUIVO] [--bounds ARQUIVO] [--verbose]\n"
+                            "          [--record ARQUIVO] [--replay ARQUIVO [--seek SEGUNDOS]] [--worlds N] [--threads T]\n"
+                            "          [--bench-enemies] [--bench-raycasts] [--endless] [--wave-size N]\n"
+                            "          [--wave-growth G] [--start-wave N] [--formation ring|scatter|clusters]\n"
+                            "          [--stress N [--budget MS] [--budget-metric mean|p95|max]]\n"
+                            "          [--log ARQUIVO [--log-binary]] [--log-level debug|info|warning|error]\n"
+                            "          [--decode-log ARQUIVO] [--metrics ARQUIVO] [--load-snapshot ARQUIVO]\n"
+                            "          [--save-snapshot ARQUIVO [--snapshot-wave N]]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (max_ticks < 0)
+        max_ticks = num_worlds > 0 ? HEADLESS_DEFAULT_BATCH_TICKS : HEADLESS_DEFAULT_TICKS;
+
+    if (max_ticks <= 0 || tick_rate <= 0 || num_worlds < 0 || num_threads < 0)
+    {
+        fprintf(stderr, "ERROR: --ticks, --tick-rate, --worlds e --threads devem ser positivos.\n");
+        return EXIT_FAILURE;
+    }
+    if (wave_config.base_count <= 0 || wave_config.first_wave <= 0 || wave_growth < 0.0f || stress_count < 0 || budget_ms < 0.0)
+    {
+        fprintf(stderr, "ERROR: --wave-size, --start-wave, --wave-growth, --stress e --budget devem ser positivos.\n");
+        return EXIT_FAILURE;
+    }
+    if (endless)
+        WaveGenerator_SetEndless(wave_config);
+    if (wave_growth > 0.0f)
+        wave_config.count_growth = wave_growth;
+    if (log_binary && !log_filename)
+    {
+        fprintf(stderr, "ERROR: --log-binary precisa de --log.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_worlds > 0 && (script_filename || record_filename || replay_filename || metrics_filename ||
+                           load_snapshot_filename || save_snapshot_filename))
+    {
+        fprintf(stderr, "ERROR: --script, --record, --replay, --metrics e os snapshots não podem ser usados com --worlds.\n");
+        return EXIT_FAILURE;
+    }
+    if (load_snapshot_filename && replay_filename)
+    {
+        fprintf(stderr, "ERROR: --load-snapshot e --replay não podem ser usados juntos.\n");
+        return EXIT_FAILURE;
+    }
+    if (snapshot_wave < 0 || (snapshot_wave > 0 && !save_snapshot_filename))
+    {
+        fprintf(stderr, "ERROR: --snapshot-wave deve ser positivo e precisa de --save-snapshot.\n");
+        return EXIT_FAILURE;
+    }
+    if (script_filename && replay_filename)
+    {
+        fprintf(stderr, "ERROR: --script e --replay não podem ser usados juntos.\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!Simulation_LoadModelBounds(bounds_filename))
+    {
+        fprintf(stderr, "ERROR: Não foi possível ler as bounding boxes dos modelos de \"%s\".\n"
+                        "O arquivo é gravado pelo jogo ao carregar os modelos: rode ./main uma vez.\n",
+                bounds_filename);
+        return EXIT_FAILURE;
+    }
+
+    if (script_filename && !LoadScript(script_filename))
+    {
+        fprintf(stderr, "ERROR: Não foi possível ler o script \"%s\".\n", script_filename);
+        return EXIT_FAILURE;
+    }
+
+    // Com --log, as mensagens vão para o arquivo mesmo sem --verbose
+    if (!Logger_Init(log_filename, log_binary))
+    {
+        fprintf(stderr, "ERROR: Não foi possível criar o log \"%s\".\n", log_filename);
+        return EXIT_FAILURE;
+    }
+    Logger_SetLevel(log_level);
+    Simulation_SetVerbose(verbose || log_filename);
+    if (bench_enemies)
+        return RunEnemyBenchmark(tick_rate, seed, num_threads);
+    if (bench_raycasts)
+        return RunRaycastBenchmark(seed);
+    if (stress_count > 0)
+    {
+        // Sem --formation, os inimigos ficam espalhados pelo mapa (milhares
+        // não cabem em poucos anéis)
+        if (!has_formation)
+            wave_config.formation = WAVE_FORMATION_SCATTER;
+        if (budget_ms == 0.0)
+            budget_ms = 1000.0 / tick_rate;
+        return RunStress(tick_rate, seed, stress_count, budget_ms, budget_metric, num_threads, wave_config);
+    }
+    if (num_worlds > 0)
+        return RunBatch(num_worlds, num_threads, max_ticks, tick_rate, seed);
+
+    const char* input_name = script_filename ? script_filename : "bot aleatório";
+    if (replay_filename)
+    {
+        if (!Replay_Open(replay_filename))
+            return EXIT_FAILURE;
+        tick_rate = Replay_GetTickRate();
+
+        // O keyframe mais próximo é carregado e só o resto é simulado
+        std::chrono::steady_clock::time_point seek_begin = std::chrono::steady_clock::now();
+        if (!Replay_Seek(g_World, (uint32_t)(seek_seconds * tick_rate)))
+            return EXIT_FAILURE;
+        double seek_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - seek_begin).count();
+
+        printf("Replay com %u ticks a %d Hz: tick %u alcançado em %.1f ms.\n",
+               Replay_GetNumTicks(), tick_rate, g_World.tick, seek_ms);
+        input_name = replay_filename;
+        seed = g_World.seed;
+    }
+    else if (load_snapshot_filename)
+    {
+        std::chrono::steady_clock::time_point load_begin = std::chrono::steady_clock::now();
+        if (!Snapshot_Load(load_snapshot_filename, g_World, &tick_rate))
+            return EXIT_FAILURE;
+        double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_begin).count();
+
+        printf("Snapshot \"%s\" carregado em %.2f ms: tick %u, wave %d, %zu inimigos, %d Hz.\n",
+               load_snapshot_filename, load_ms, g_World.tick, g_World.current_wave_number,
+               g_World.enemies.size(), tick_rate);
+        seed = g_World.seed;
+        g_BotRng.Seed(seed, 0);
+    }
+    else
+    {
+        g_World.wave_config = wave_config;
+        Simulation_Init(g_World, seed);
+        g_BotRng.Seed(seed, 0);
+    }
+
+    if (record_filename && !Replay_BeginRecording(record_filename, g_World, tick_rate))
+    {
+        fprintf(stderr, "ERROR: Não foi possível criar o replay \"%s\".\n", record_filename);
+        return EXIT_FAILURE;
+    }
+
+    if (metrics_filename && !(g_MetricsFile = fopen(metrics_filename, "w")))
+    {
+        fprintf(stderr, "ERROR: Não foi possível criar o arquivo de métricas \"%s\".\n", metrics_filename);
+        return EXIT_FAILURE;
+    }
+
+    // Consumidores dos eventos: métricas e, se as mensagens estão ligadas, o
+    // log. A gravação e a conferência do replay têm os seus.
+    BeginMetrics(g_World, tick_rate);
+    if (verbose || log_filename)
+        EventBus_Subscribe(g_World.events, g_LogSubscriber);
+
+    // Um jogo só: --threads é o número de threads do sistema de jobs
+    num_threads = JobSystem_Init(num_threads);
+    printf("Simulando %ld ticks a %d Hz com %d threads (semente %u, entrada: %s)...\n",
+           max_ticks, tick_rate, num_threads, seed, input_name);
+
+    const float delta_time = 1.0f / tick_rate;
+    SimulationTimings timings = { 0.0, 0.0, 0.0 };
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    long tick = 0;
+    const char* end_reason = "limite de ticks";
+    while (tick < max_ticks)
+    {
+        if (replay_filename)
+        {
+            if (!Replay_GetAction(g_World, &g_Action))
+            {
+                end_reason = "fim do replay";
+                break;
+            }
+        }
+        else if (script_filename)
+            ApplyScript(tick);
+        else
+            ApplyRandomInput(tick, tick_rate);
+
+        Replay_RecordTick(g_World, g_Action);
+
+        Simulation_ApplyAction(g_World, g_Action);
+        g_Action.buttons &= ~(SIMULATION_ACTION_SHOOT | SIMULATION_ACTION_RELOAD);
+
+        Simulation_Step(g_World, delta_time, &timings);
+        tick += 1;
+
+        UpdateMetrics(g_World);
+        EventBus_LogEvents(g_World.events, g_LogSubscriber);
+        if (replay_filename)
+            Replay_CheckEvents(g_World);
+
+        if (g_World.player.IsDead())
+        {
+            end_reason = "jogador morreu";
+            break;
+        }
+        if (Simulation_IsFinished(g_World))
+        {
+            end_reason = "todas as waves completas";
+            break;
+        }
+        if (snapshot_wave > 0 && g_World.current_wave_number >= snapshot_wave)
+        {
+            end_reason = "início da wave do snapshot";
+            break;
+        }
+    }
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    Replay_EndRecording();
+    JobSystem_Terminate();
+    Logger_Flush();
+    if (g_MetricsFile)
+    {
+        WriteMetricsWindow();
+        fclose(g_MetricsFile);
+    }
+
+    double simulated_seconds = tick * (double)delta_time;
+    printf("\nFim da simulação (%s) no tick %u.\n", end_reason, g_World.tick);
+    if (save_snapshot_filename)
+    {
+        if (!Snapshot_Save(save_snapshot_filename, g_World, tick_rate))
+        {
+            fprintf(stderr, "ERROR: Não foi possível salvar o snapshot \"%s\".\n", save_snapshot_filename);
+            return EXIT_FAILURE;
+        }
+        printf("Snapshot salvo em \"%s\" (wave %d, %zu inimigos).\n",
+               save_snapshot_filename, g_World.current_wave_number, g_World.enemies.size());
+    }
+    if (g_World.wave_config.max_waves > 0)
+        printf("Wave %d/%d, ", g_World.current_wave_number, g_World.wave_config.max_waves);
+    else
+        printf("Wave %d (sem fim), ", g_World.current_wave_number);
+    const HeadlessMetrics& metrics = g_MetricsTotal;
+    printf("vida do jogador %.0f/%.0f, %u/%zu inimigos mortos, %u tiros (%u acertos).\n",
+           g_World.player.health, g_World.player.max_health,
+           g_World.enemies_killed, g_World.enemies_killed + g_World.enemies.size(),
+           metrics.player_shots, metrics.player_hits);
+    printf("Inimigos: %u tiros, %u acertos, %.0f de dano no jogador; %.0f de dano nos inimigos.\n",
+           metrics.enemy_shots, metrics.enemy_hits, metrics.damage_to_player, metrics.damage_to_enemies);
+    if (replay_filename && Replay_HasEvents())
+        printf("%u eventos conferidos com o replay: %s.\n", Replay_GetCheckedEvents(),
+               Replay_CheckEvents(g_World) ? "sem divergência" : "a simulação divergiu");
+    const EnemyPathStats& paths = g_World.enemy_path_stats;
+    printf("%u curvas de inimigos: %u com outra tentativa, %u sem curva livre, %u replanejadas por colisão "
+           "(%.2f tentativas e %.1f pontos testados por curva).\n",
+           paths.paths, paths.perturbed, paths.unresolved, paths.replans,
+           paths.curves_tested / (double)std::max(paths.paths, 1u), paths.samples / (double)std::max(paths.paths, 1u));
+    printf("%.2f s simulados em %.3f s: %.0f ticks/s (%.0fx tempo real).\n",
+           simulated_seconds, wall_seconds, tick / wall_seconds, simulated_seconds / wall_seconds);
+
+    const char* names[3] = { "player", "enemies", "waves" };
+    double totals[3] = { timings.player, timings.enemies, timings.waves };
+    printf("\n%-10s %10s %10s %7s\n", "sistema", "total ms", "us/tick", "%");
+    for (int i = 0; i < 3; ++i)
+    {
+        printf("%-10s %10.2f %10.3f %6.1f%%\n", names[i], totals[i] * 1.0e3,
+               totals[i] * 1.0e6 / tick, 100.0 * totals[i] / wall_seconds);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// vim: set spell spelllang=pt_br :
@@ -0,0 +1,114 @@
+// Fila de eventos de entrada. Veja "inputqueue.h".
+//
+// O anel é o mesmo do logger ("logger.cpp"): cada posição guarda um número
+// de sequência que diz se ela está livre para a volta corrente do anel
+// (índice de escrita) ou já tem um evento publicado (índice + 1). Um
+// produtor reserva a posição com um compare_exchange no índice de escrita; se
+// ela ainda não foi lida, a fila está cheia e o evento é descartado.
+// Ninguém bloqueia.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "inputqueue.h"
+
+struct InputSlot
+{
+    std::atomic<uint32_t> sequence;
+    InputEvent            event;
+};
+
+// A sequência inicial de cada posição é a própria posição no anel; para o
+// anel estático já começar pronto (com zeros), cada posição guarda a
+// sequência menos a sua posição, ou seja, só o início da volta do anel
+// (índice & ~(INPUT_QUEUE_SIZE - 1)) mais 0 (livre), 1 (publicado) ou
+// INPUT_QUEUE_SIZE (lido, livre na próxima volta)
+static InputSlot             g_InputRing[INPUT_QUEUE_SIZE];
+static std::atomic<uint32_t> g_InputWriteIndex(0);
+static uint32_t              g_InputReadIndex = 0; // Só a thread principal usa
+static std::atomic<int>      g_InputDropped(0);
+
+static std::atomic<bool> g_SyntheticRunning(false);
+static std::thread       g_SyntheticThread;
+
+bool InputQueue_Push(const InputEvent& event)
+{
+    uint32_t index = g_InputWriteIndex.load(std::memory_order_relaxed);
+    InputSlot* slot;
+    for (;;)
+    {
+        slot = &g_InputRing[index & (INPUT_QUEUE_SIZE - 1)];
+        int32_t difference = (int32_t)(slot->sequence.load(std::memory_order_acquire) - (index & ~(INPUT_QUEUE_SIZE - 1)));
+        if (difference == 0)
+        {
+            if (g_InputWriteIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            g_InputDropped.fetch_add(1, std::memory_order_relaxed); // Ainda não lido: fila cheia
+            return false;
+        }
+        else
+            index = g_InputWriteIndex.load(std::memory_order_relaxed); // Outro produtor pegou a posição
+    }
+
+    slot->event = event;
+    slot->sequence.store((index & ~(INPUT_QUEUE_SIZE - 1)) + 1, std::memory_order_release);
+    return true;
+}
+
+bool InputQueue_Pop(double max_time, InputEvent* event)
+{
+    InputSlot& slot = g_InputRing[g_InputReadIndex & (INPUT_QUEUE_SIZE - 1)];
+    uint32_t lap = g_InputReadIndex & ~(INPUT_QUEUE_SIZE - 1);
+    if (slot.sequence.load(std::memory_order_acquire) != lap + 1)
+        return false; // Fila vazia
+    if (slot.event.time > max_time)
+        return false;
+
+    *event = slot.event;
+    slot.sequence.store(lap + INPUT_QUEUE_SIZE, std::memory_order_release);
+    g_InputReadIndex += 1;
+    return true;
+}
+
+int InputQueue_DroppedEvents()
+{
+    return g_InputDropped.load(std::memory_order_relaxed);
+}
+
+void InputQueue_StartSyntheticMouse(double rate, double (*clock)())
+{
+    if (g_SyntheticRunning.exchange(true))
+        return;
+
+    g_SyntheticThread = std::thread([rate, clock]()
+    {
+        // Um "mouse" que anda um pixel para a direita a cada evento
+        std::chrono::duration<double> interval(1.0 / rate);
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+        double x = 0.0;
+        while (g_SyntheticRunning.load(std::memory_order_relaxed))
+        {
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+
+            InputEvent event = {};
+            event.time = clock();
+            event.type = INPUT_EVENT_CURSOR;
+            event.x = (x += 1.0);
+            InputQueue_Push(event);
+        }
+    });
+}
+
+void InputQueue_StopSyntheticMouse()
+{
+    if (!g_SyntheticRunning.exchange(false))
+        return;
+    g_SyntheticThread.join();
+}
+
+// vim: set spell spelllang=pt_br :
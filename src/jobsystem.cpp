@@ -0,0 +1,341 @@
+// Sistema de jobs com roubo de trabalho. Veja "jobsystem.h".
+//
+// As filas são std::deque protegidas por um mutex cada: a dona usa o fim da
+// fila (o job mais recente, com os dados provavelmente ainda no cache) e os
+// ladrões o início (o mais antigo), então as duas pontas raramente disputam
+// o mesmo mutex. Os jobs de um nó são colocados na fila da thread que liberou
+// o nó, e as outras roubam deles.
+//
+// Como em "simulationbatch.cpp", as threads são persistentes e dormem em uma
+// variável de condição quando não há jobs em nenhuma fila (contador
+// g_JobQueued). O estado de cada nó do grafo em andamento (jobs e
+// dependências que faltam) fica em contadores atômicos; quem termina o
+// último job de um nó libera os nós que dependem dele.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpuprofiler.h"
+#include "jobsystem.h"
+
+// Um intervalo de índices de um nó do grafo em andamento
+struct Job
+{
+    int    node;
+    size_t begin;
+    size_t end;
+};
+
+// Fila de uma thread, em sua própria linha de cache
+struct alignas(64) JobQueue
+{
+    std::mutex      mutex;
+    std::deque<Job> jobs;
+};
+
+// Estado de um nó durante JobGraph_Run()
+struct JobNodeState
+{
+    std::atomic<int> pending_jobs;
+    std::atomic<int> pending_dependencies;
+};
+
+static JobQueue g_JobQueues[JOB_SYSTEM_MAX_THREADS];
+static std::vector<std::thread> g_JobThreads;
+static int g_JobNumThreads = 1;
+static thread_local int t_JobThreadIndex = -1;
+
+static std::mutex g_JobMutex;
+static std::condition_variable g_JobWakeUp; // Novos jobs ou término
+static std::atomic<int> g_JobQueued(0);     // Jobs em todas as filas
+static bool g_JobQuit = false;
+
+// Grafo em andamento (só um por vez, rodado pela thread 0)
+static const JobGraph* g_JobGraph = NULL;
+static std::unique_ptr<JobNodeState[]> g_JobNodeStates;
+static size_t g_JobNodeStatesSize = 0;
+static std::atomic<int> g_JobNodesRemaining(0);
+static bool g_JobRunning = false;
+
+// Grafo reutilizado por JobSystem_ParallelFor()
+static JobGraph g_JobParallelFor;
+
+static void FinishNode(int node);
+
+// Coloca os jobs do nó na fila da thread corrente. Os intervalos são
+// colocados do último para o primeiro: a dona começa pelo início dos índices
+// e os ladrões levam os do fim.
+static void ReleaseNode(int node)
+{
+    const JobGraphNode& graph_node = g_JobGraph->nodes[node];
+    if (graph_node.count == 0)
+    {
+        FinishNode(node);
+        return;
+    }
+
+    size_t grain = std::max(graph_node.grain, (size_t)1);
+    size_t num_jobs = (graph_node.count + grain - 1) / grain;
+    g_JobNodeStates[node].pending_jobs.store((int)num_jobs);
+
+    JobQueue& queue = g_JobQueues[t_JobThreadIndex];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (size_t j = num_jobs; j-- > 0;)
+        {
+            Job job;
+            job.node = node;
+            job.begin = j * grain;
+            job.end = std::min(job.begin + grain, graph_node.count);
+            queue.jobs.push_back(job);
+        }
+        // Dentro do mutex da fila: quem tira um job sempre vê o contador já
+        // incrementado
+        g_JobQueued.fetch_add((int)num_jobs);
+    }
+
+    // Um job só: a própria thread o pega em seguida
+    if (num_jobs > 1)
+    {
+        std::lock_guard<std::mutex> lock(g_JobMutex);
+        g_JobWakeUp.notify_all();
+    }
+}
+
+static void FinishNode(int node)
+{
+    for (int dependent : g_JobGraph->nodes[node].dependents)
+        if (g_JobNodeStates[dependent].pending_dependencies.fetch_sub(1) == 1)
+            ReleaseNode(dependent);
+
+    // Por último: depois disso a thread 0 pode retornar de JobGraph_Run()
+    g_JobNodesRemaining.fetch_sub(1);
+}
+
+// Tira um job da própria fila ou, se estiver vazia, rouba de outra
+static bool PopJob(int thread, Job& job)
+{
+    {
+        JobQueue& queue = g_JobQueues[thread];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+            g_JobQueued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (int i = 1; i < g_JobNumThreads; ++i)
+    {
+        JobQueue& victim = g_JobQueues[(thread + i) % g_JobNumThreads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            g_JobQueued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void RunJob(const Job& job)
+{
+    const JobGraphNode& graph_node = g_JobGraph->nodes[job.node];
+    graph_node.function(graph_node.data, job.begin, job.end);
+
+    if (g_JobNodeStates[job.node].pending_jobs.fetch_sub(1) == 1)
+        FinishNode(job.node);
+}
+
+static void WorkerThread(int thread)
+{
+    t_JobThreadIndex = thread;
+    CPU_PROFILE_THREAD_NAME("jobs");
+
+    for (;;)
+    {
+        Job job;
+        if (PopJob(thread, job))
+        {
+            RunJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(g_JobMutex);
+        g_JobWakeUp.wait(lock, [] { return g_JobQuit || g_JobQueued.load() > 0; });
+        if (g_JobQuit)
+            return;
+    }
+}
+
+int JobSystem_Init(int num_threads)
+{
+    JobSystem_Terminate();
+
+    if (num_threads <= 0)
+        num_threads = (int)std::thread::hardware_concurrency();
+    num_threads = std::max(1, std::min(num_threads, JOB_SYSTEM_MAX_THREADS));
+
+    // As threads precisam terminar antes dos destrutores globais, também
+    // quando o programa sai por std::exit()
+    static bool registered_at_exit = false;
+    if (!registered_at_exit)
+    {
+        std::atexit(JobSystem_Terminate);
+        registered_at_exit = true;
+    }
+
+    g_JobQuit = false;
+    g_JobNumThreads = num_threads;
+    t_JobThreadIndex = 0;
+    for (int i = 1; i < num_threads; ++i)
+        g_JobThreads.push_back(std::thread(WorkerThread, i));
+
+    return num_threads;
+}
+
+void JobSystem_Terminate()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_JobMutex);
+        g_JobQuit = true;
+    }
+    g_JobWakeUp.notify_all();
+
+    for (std::thread& thread : g_JobThreads)
+        thread.join();
+    g_JobThreads.clear();
+    g_JobNumThreads = 1;
+}
+
+int JobSystem_NumThreads()
+{
+    return g_JobNumThreads;
+}
+
+int JobSystem_ThreadIndex()
+{
+    return t_JobThreadIndex;
+}
+
+void JobGraph_Clear(JobGraph& graph)
+{
+    graph.nodes.clear();
+}
+
+int JobGraph_Add(JobGraph& graph, JobFunction function, void* data, size_t count, size_t grain)
+{
+    JobGraphNode node;
+    node.function = function;
+    node.data = data;
+    node.count = count;
+    node.grain = grain;
+    node.num_dependencies = 0;
+    graph.nodes.push_back(node);
+    return (int)graph.nodes.size() - 1;
+}
+
+void JobGraph_AddDependency(JobGraph& graph, int node, int dependency)
+{
+    graph.nodes[dependency].dependents.push_back(node);
+    graph.nodes[node].num_dependencies += 1;
+}
+
+// Roda os nós em ordem topológica na thread corrente (entre os nós prontos,
+// o de menor índice primeiro)
+static void RunSerial(const JobGraph& graph)
+{
+    size_t num_nodes = graph.nodes.size();
+    std::vector<int> pending(num_nodes);
+    std::vector<bool> done(num_nodes, false);
+    for (size_t i = 0; i < num_nodes; ++i)
+        pending[i] = graph.nodes[i].num_dependencies;
+
+    for (size_t finished = 0; finished < num_nodes;)
+    {
+        size_t i = 0;
+        while (i < num_nodes && (done[i] || pending[i] > 0))
+            ++i;
+        if (i == num_nodes)
+            break; // Ciclo: os nós restantes nunca ficam prontos
+
+        const JobGraphNode& node = graph.nodes[i];
+        if (node.count > 0)
+            node.function(node.data, 0, node.count);
+        done[i] = true;
+        finished += 1;
+        for (int dependent : node.dependents)
+            pending[dependent] -= 1;
+    }
+}
+
+void JobGraph_Run(JobGraph& graph)
+{
+    if (g_JobThreads.empty() || t_JobThreadIndex != 0 || g_JobRunning)
+    {
+        RunSerial(graph);
+        return;
+    }
+
+    size_t num_nodes = graph.nodes.size();
+    if (num_nodes == 0)
+        return;
+    if (num_nodes > g_JobNodeStatesSize)
+    {
+        g_JobNodeStates.reset(new JobNodeState[num_nodes]);
+        g_JobNodeStatesSize = num_nodes;
+    }
+    for (size_t i = 0; i < num_nodes; ++i)
+    {
+        g_JobNodeStates[i].pending_jobs.store(0);
+        g_JobNodeStates[i].pending_dependencies.store(graph.nodes[i].num_dependencies);
+    }
+
+    g_JobRunning = true;
+    g_JobGraph = &graph;
+    g_JobNodesRemaining.store((int)num_nodes);
+    for (size_t i = 0; i < num_nodes; ++i)
+        if (graph.nodes[i].num_dependencies == 0)
+            ReleaseNode((int)i);
+
+    // Trabalha até o último nó terminar. Sem jobs na fila, outra thread está
+    // rodando o último job de algum nó: só resta esperar por ela.
+    while (g_JobNodesRemaining.load() > 0)
+    {
+        Job job;
+        if (PopJob(0, job))
+            RunJob(job);
+        else
+            std::this_thread::yield();
+    }
+
+    g_JobGraph = NULL;
+    g_JobRunning = false;
+}
+
+void JobSystem_ParallelFor(size_t count, size_t grain, JobFunction function, void* data)
+{
+    if (g_JobThreads.empty() || t_JobThreadIndex != 0 || g_JobRunning)
+    {
+        if (count > 0)
+            function(data, 0, count);
+        return;
+    }
+
+    JobGraph_Clear(g_JobParallelFor);
+    JobGraph_Add(g_JobParallelFor, function, data, count, grain);
+    JobGraph_Run(g_JobParallelFor);
+}
+
+// vim: set spell spelllang=pt_br :
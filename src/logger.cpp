@@ -0,0 +1,510 @@
+// Log assíncrono. Veja "logger.h".
+//
+// O ring buffer é multi-produtor com um único consumidor (a thread do
+// logger), como o de "cpuprofiler.cpp", mas uma posição só é reutilizada
+// depois de lida: cada posição guarda um número de sequência que diz se ela
+// está livre para a volta corrente do anel (índice de escrita) ou já tem uma
+// mensagem publicada (índice + 1). Um produtor reserva a posição com um
+// compare_exchange no índice de escrita; se ela ainda não foi lida, o anel
+// está cheio e a mensagem é descartada. Ninguém bloqueia.
+//
+// A thread do logger acorda a cada LOG_FLUSH_INTERVAL_MS (ou em
+// Logger_Flush()), esvazia o anel e escreve tudo de uma vez.
+//
+// Formato binário: "FCGLOG" e a versão (uint32), seguidos de registros
+// 'F' (uint32 id, uint32 tamanho e o texto de uma string de formato, na
+// primeira vez em que ela aparece) e 'M' (uint64 tempo em ns, uint8 nível,
+// uint8 categoria, uint32 id do formato, uint8 número de argumentos, cada
+// argumento como uint8 tipo e 8 bytes, uint8 tamanho e os bytes de "text").
+// Os números ficam na ordem de bytes da máquina, como nos replays.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cpuprofiler.h"
+#include "logger.h"
+
+#define LOG_BINARY_MAGIC   "FCGLOG"
+#define LOG_BINARY_VERSION 1
+#define LOG_LINE_SIZE      1024 // Maior linha de texto escrita
+
+struct alignas(64) LogSlot
+{
+    std::atomic<uint32_t> sequence;
+    LogMessage            message;
+};
+
+std::atomic<int>      g_LogLevel(LOG_LEVEL_DEBUG);
+std::atomic<uint32_t> g_LogCategories(~0u);
+
+static LogSlot               g_LogRing[LOG_RING_SIZE];
+static std::atomic<uint32_t> g_LogWriteIndex(0);
+static uint32_t              g_LogReadIndex = 0;     // Só a thread do logger usa
+static std::atomic<uint32_t> g_LogWrittenIndex(0);   // Mensagens já escritas no arquivo
+static std::atomic<int>      g_LogDropped(0);
+static int                   g_LogDroppedReported = 0;
+
+static std::atomic<bool>       g_LogRunning(false);
+static std::thread             g_LogThread;
+static std::mutex              g_LogMutex;
+static std::condition_variable g_LogWakeUp;  // Logger_Flush() ou Logger_Terminate()
+static std::condition_variable g_LogWritten; // A thread escreveu um lote
+static bool                    g_LogQuit = false;
+static bool                    g_LogFlushRequested = false;
+static bool                    g_LogAtExit = false;
+
+static FILE* g_LogFile = NULL;
+static bool  g_LogBinary = false;
+static std::chrono::steady_clock::time_point g_LogStart = std::chrono::steady_clock::now();
+
+// Ids das strings de formato já escritas no arquivo binário
+static std::unordered_map<const char*, uint32_t> g_LogFormatIds;
+
+static const char* g_LogLevelNames[LOG_LEVEL_NONE] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+static const char* g_LogCategoryNames[LOG_NUM_CATEGORIES] = { "general", "simulation", "combat", "waves" };
+
+// Valores dos argumentos convertidos para o que a conversão pede
+static long long ArgumentAsInt(const LogArgument& argument)
+{
+    switch (argument.type)
+    {
+        case LOG_ARGUMENT_INT:    return (long long)argument.i;
+        case LOG_ARGUMENT_DOUBLE: return (long long)argument.d;
+        default:                  return (long long)argument.u;
+    }
+}
+
+static unsigned long long ArgumentAsUint(const LogArgument& argument)
+{
+    switch (argument.type)
+    {
+        case LOG_ARGUMENT_INT:    return (unsigned long long)argument.i;
+        case LOG_ARGUMENT_DOUBLE: return (unsigned long long)argument.d;
+        default:                  return (unsigned long long)argument.u;
+    }
+}
+
+static double ArgumentAsDouble(const LogArgument& argument)
+{
+    switch (argument.type)
+    {
+        case LOG_ARGUMENT_INT:    return (double)argument.i;
+        case LOG_ARGUMENT_DOUBLE: return argument.d;
+        default:                  return (double)argument.u;
+    }
+}
+
+size_t Logger_FormatMessage(const LogMessage& message, char* buffer, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    // Cada conversão é formatada sozinha por snprintf(). Flags, largura e
+    // precisão são mantidas; o tamanho (h, l, z...) é trocado pelo do
+    // argumento guardado (long long ou double).
+    size_t length = 0;
+    int next_argument = 0;
+    const char* format = message.format;
+    while (*format && length + 1 < size)
+    {
+        if (*format != '%')
+        {
+            buffer[length++] = *format++;
+            continue;
+        }
+        if (format[1] == '%')
+        {
+            buffer[length++] = '%';
+            format += 2;
+            continue;
+        }
+
+        char spec[32];
+        size_t spec_length = 0;
+        spec[spec_length++] = *format++;
+        while (*format && strchr("-+ #0123456789.", *format) && spec_length < sizeof(spec) - 4)
+            spec[spec_length++] = *format++;
+        while (*format && strchr("hljztL", *format))
+            format++;
+        char conversion = *format;
+        if (!conversion)
+            break;
+        format++;
+
+        char* output = buffer + length;
+        size_t available = size - length;
+        int written = 0;
+        if (next_argument >= message.num_arguments)
+            written = snprintf(output, available, "?");
+        else
+        {
+            const LogArgument& argument = message.arguments[next_argument++];
+            switch (conversion)
+            {
+                case 'd': case 'i':
+                    memcpy(spec + spec_length, "lld", 4);
+                    written = snprintf(output, available, spec, ArgumentAsInt(argument));
+                    break;
+                case 'u': case 'x': case 'X': case 'o':
+                    spec[spec_length++] = 'l';
+                    spec[spec_length++] = 'l';
+                    spec[spec_length++] = conversion;
+                    spec[spec_length] = '\0';
+                    written = snprintf(output, available, spec, ArgumentAsUint(argument));
+                    break;
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                    spec[spec_length++] = conversion;
+                    spec[spec_length] = '\0';
+                    written = snprintf(output, available, spec, ArgumentAsDouble(argument));
+                    break;
+                case 'c':
+                    memcpy(spec + spec_length, "c", 2);
+                    written = snprintf(output, available, spec, (int)ArgumentAsInt(argument));
+                    break;
+                case 's':
+                    memcpy(spec + spec_length, "s", 2);
+                    if (argument.type == LOG_ARGUMENT_STRING && argument.u < message.text_size)
+                        written = snprintf(output, available, spec, message.text + argument.u);
+                    else
+                        written = snprintf(output, available, spec, "");
+                    break;
+                default:
+                    written = snprintf(output, available, "?");
+                    break;
+            }
+        }
+        if (written > 0)
+            length += std::min((size_t)written, available - 1);
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+// Linha de texto com tempo, nível e categoria
+static void WriteText(const LogMessage& message, FILE* file)
+{
+    char line[LOG_LINE_SIZE];
+    int prefix = snprintf(line, sizeof(line), "%10.3f %-7s %-10s ", message.time_ns * 1.0e-9,
+                          g_LogLevelNames[std::min((int)message.level, LOG_LEVEL_NONE - 1)],
+                          message.category < LOG_NUM_CATEGORIES ? g_LogCategoryNames[message.category] : "?");
+    Logger_FormatMessage(message, line + prefix, sizeof(line) - prefix - 1);
+    strcat(line, "\n");
+    fputs(line, file);
+}
+
+static void WriteBinary(const LogMessage& message, FILE* file)
+{
+    std::unordered_map<const char*, uint32_t>::iterator format_id = g_LogFormatIds.find(message.format);
+    if (format_id == g_LogFormatIds.end())
+    {
+        uint32_t id = (uint32_t)g_LogFormatIds.size();
+        uint32_t length = (uint32_t)strlen(message.format);
+        fputc('F', file);
+        fwrite(&id, sizeof(id), 1, file);
+        fwrite(&length, sizeof(length), 1, file);
+        fwrite(message.format, 1, length, file);
+        format_id = g_LogFormatIds.insert(std::make_pair(message.format, id)).first;
+    }
+
+    fputc('M', file);
+    fwrite(&message.time_ns, sizeof(message.time_ns), 1, file);
+    fputc(message.level, file);
+    fputc(message.category, file);
+    fwrite(&format_id->second, sizeof(uint32_t), 1, file);
+    fputc(message.num_arguments, file);
+    for (int i = 0; i < message.num_arguments; ++i)
+    {
+        fputc(message.arguments[i].type, file);
+        fwrite(&message.arguments[i].u, sizeof(uint64_t), 1, file);
+    }
+    fputc(message.text_size, file);
+    fwrite(message.text, 1, message.text_size, file);
+}
+
+static void WriteMessage(const LogMessage& message)
+{
+    if (g_LogBinary)
+        WriteBinary(message, g_LogFile);
+    else
+        WriteText(message, g_LogFile);
+}
+
+// Escreve todas as mensagens publicadas. Retorna quantas foram escritas.
+static int DrainRing()
+{
+    int written = 0;
+    for (;;)
+    {
+        LogSlot& slot = g_LogRing[g_LogReadIndex & (LOG_RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != g_LogReadIndex + 1)
+            break;
+
+        WriteMessage(slot.message);
+        slot.sequence.store(g_LogReadIndex + LOG_RING_SIZE, std::memory_order_release);
+        g_LogReadIndex += 1;
+        written += 1;
+    }
+
+    // As mensagens perdidas viram uma mensagem no próprio log
+    int dropped = g_LogDropped.load(std::memory_order_relaxed);
+    if (dropped != g_LogDroppedReported)
+    {
+        LogMessage message;
+        message.time_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - g_LogStart).count();
+        message.format = "%d log messages dropped (ring buffer full)";
+        message.level = LOG_LEVEL_WARNING;
+        message.category = LOG_CATEGORY_GENERAL;
+        message.num_arguments = 0;
+        message.text_size = 0;
+        Logger_PackArgument(message, dropped - g_LogDroppedReported);
+        WriteMessage(message);
+        g_LogDroppedReported = dropped;
+    }
+
+    if (written > 0)
+        fflush(g_LogFile);
+    return written;
+}
+
+static void LoggerThread()
+{
+    CPU_PROFILE_THREAD_NAME("logger");
+
+    std::unique_lock<std::mutex> lock(g_LogMutex);
+    for (;;)
+    {
+        bool quit = g_LogQuit;
+        g_LogFlushRequested = false;
+        lock.unlock();
+        int written = DrainRing();
+        lock.lock();
+
+        g_LogWrittenIndex.store(g_LogReadIndex, std::memory_order_release);
+        g_LogWritten.notify_all();
+        if (quit && written == 0)
+            break;
+        if (written == 0 && !g_LogQuit && !g_LogFlushRequested)
+            g_LogWakeUp.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+    }
+}
+
+bool Logger_Init(const char* filename, bool binary)
+{
+    if (g_LogRunning.load())
+        Logger_Terminate();
+
+    g_LogFile = filename ? fopen(filename, binary ? "wb" : "w") : stdout;
+    if (!g_LogFile)
+    {
+        g_LogFile = NULL;
+        return false;
+    }
+    g_LogBinary = binary;
+    g_LogFormatIds.clear();
+    if (binary)
+    {
+        uint32_t version = LOG_BINARY_VERSION;
+        fwrite(LOG_BINARY_MAGIC, 1, 6, g_LogFile);
+        fwrite(&version, sizeof(version), 1, g_LogFile);
+    }
+
+    for (uint32_t i = 0; i < LOG_RING_SIZE; ++i)
+        g_LogRing[i].sequence.store(i, std::memory_order_relaxed);
+    g_LogWriteIndex.store(0);
+    g_LogReadIndex = 0;
+    g_LogWrittenIndex.store(0);
+    g_LogDropped.store(0);
+    g_LogDroppedReported = 0;
+    g_LogQuit = false;
+    g_LogStart = std::chrono::steady_clock::now();
+
+    g_LogRunning.store(true);
+    g_LogThread = std::thread(LoggerThread);
+    if (!g_LogAtExit)
+    {
+        atexit(Logger_Terminate);
+        g_LogAtExit = true;
+    }
+    return true;
+}
+
+void Logger_Terminate()
+{
+    if (!g_LogRunning.load())
+        return;
+    g_LogRunning.store(false);
+
+    {
+        std::lock_guard<std::mutex> lock(g_LogMutex);
+        g_LogQuit = true;
+    }
+    g_LogWakeUp.notify_one();
+    g_LogThread.join();
+
+    if (g_LogFile != stdout)
+        fclose(g_LogFile);
+    else
+        fflush(stdout);
+    g_LogFile = NULL;
+}
+
+void Logger_Flush()
+{
+    if (!g_LogRunning.load())
+    {
+        fflush(stdout);
+        return;
+    }
+
+    uint32_t target = g_LogWriteIndex.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(g_LogMutex);
+    g_LogFlushRequested = true;
+    g_LogWakeUp.notify_one();
+    g_LogWritten.wait(lock, [target] {
+        return (int32_t)(g_LogWrittenIndex.load(std::memory_order_acquire) - target) >= 0;
+    });
+}
+
+void Logger_SetLevel(int level)
+{
+    g_LogLevel.store(level, std::memory_order_relaxed);
+}
+
+void Logger_SetCategoryEnabled(LogCategory category, bool enabled)
+{
+    if (enabled)
+        g_LogCategories.fetch_or(1u << category, std::memory_order_relaxed);
+    else
+        g_LogCategories.fetch_and(~(1u << category), std::memory_order_relaxed);
+}
+
+int Logger_ParseLevel(const char* name)
+{
+    static const char* names[LOG_LEVEL_NONE + 1] = { "debug", "info", "warning", "error", "none" };
+    for (int level = 0; level <= LOG_LEVEL_NONE; ++level)
+        if (strcmp(name, names[level]) == 0)
+            return level;
+    return -1;
+}
+
+int Logger_DroppedMessages()
+{
+    return g_LogDropped.load(std::memory_order_relaxed);
+}
+
+void Logger_Push(LogMessage& message)
+{
+    message.time_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_LogStart).count();
+
+    if (!g_LogRunning.load(std::memory_order_acquire))
+    {
+        WriteText(message, stdout);
+        return;
+    }
+
+    uint32_t index = g_LogWriteIndex.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    for (;;)
+    {
+        slot = &g_LogRing[index & (LOG_RING_SIZE - 1)];
+        int32_t difference = (int32_t)(slot->sequence.load(std::memory_order_acquire) - index);
+        if (difference == 0)
+        {
+            if (g_LogWriteIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            g_LogDropped.fetch_add(1, std::memory_order_relaxed); // Ainda não lida: anel cheio
+            return;
+        }
+        else
+            index = g_LogWriteIndex.load(std::memory_order_relaxed); // Outro produtor pegou a posição
+    }
+
+    slot->message = message;
+    slot->sequence.store(index + 1, std::memory_order_release);
+}
+
+// Leitura do log binário
+template <typename T>
+static bool ReadValue(FILE* file, T& value)
+{
+    return fread(&value, sizeof(value), 1, file) == 1;
+}
+
+bool Logger_DecodeFile(const char* filename, FILE* output)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: Não foi possível abrir o log \"%s\".\n", filename);
+        return false;
+    }
+
+    char magic[6];
+    uint32_t version = 0;
+    if (fread(magic, 1, 6, file) != 6 || memcmp(magic, LOG_BINARY_MAGIC, 6) != 0 ||
+        !ReadValue(file, version) || version != LOG_BINARY_VERSION)
+    {
+        fprintf(stderr, "ERROR: \"%s\" não é um log binário (versão %d).\n", filename, LOG_BINARY_VERSION);
+        fclose(file);
+        return false;
+    }
+
+    std::vector<std::string> formats;
+    bool valid = true;
+    int record;
+    while (valid && (record = fgetc(file)) != EOF)
+    {
+        if (record == 'F')
+        {
+            uint32_t id, length;
+            valid = ReadValue(file, id) && ReadValue(file, length) && id == formats.size();
+            if (valid)
+            {
+                std::string format(length, '\0');
+                valid = fread(&format[0], 1, length, file) == length;
+                formats.push_back(format);
+            }
+        }
+        else if (record == 'M')
+        {
+            LogMessage message;
+            uint32_t format_id;
+            valid = ReadValue(file, message.time_ns) && ReadValue(file, message.level) &&
+                    ReadValue(file, message.category) && ReadValue(file, format_id) &&
+                    ReadValue(file, message.num_arguments) && format_id < formats.size() &&
+                    message.num_arguments <= LOG_MAX_ARGUMENTS;
+            for (int i = 0; valid && i < message.num_arguments; ++i)
+                valid = ReadValue(file, message.arguments[i].type) && ReadValue(file, message.arguments[i].u);
+            valid = valid && ReadValue(file, message.text_size) && message.text_size <= LOG_TEXT_SIZE &&
+                    fread(message.text, 1, message.text_size, file) == message.text_size;
+            if (valid)
+            {
+                message.format = formats[format_id].c_str();
+                WriteText(message, output);
+            }
+        }
+        else
+            valid = false;
+    }
+    fclose(file);
+
+    if (!valid)
+        fprintf(stderr, "ERROR: Log \"%s\" corrompido.\n", filename);
+    return valid;
+}
+
+// vim: set spell spelllang=pt_br :
@@ -8,6 +8,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
 
 #include <set>
 #include <map>
@@ -34,6 +35,18 @@
 
 #include "utils.h"
 #include "matrices.h"
+#include "streambuffer.h"
+#include "gpuprofiler.h"
+#include "cpuprofiler.h"
+#include "tracerecorder.h"
+#include "headless.h"
+#include "eventbus.h"
+#include "inputqueue.h"
+#include "jobsystem.h"
+#include "logger.h"
+#include "replay.h"
+#include "simulation.h"
+#include "snapshot.h"
 
 #define M_PI 3.141592f
 
@@ -48,6 +61,7 @@ struct ObjModel
     // Veja: https://github.com/syoyo/tinyobjloader
     ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true)
     {
+        CPU_PROFILE_ZONE_TEXT("ObjModel", filename);
         printf("Carregando objetos do arquivo \"%s\"...\n", filename);
 
         // Se basepath == NULL, então setamos basepath como o dirname do
@@ -106,25 +120,24 @@ void ComputeNormals(ObjModel* model); // Computa normais de um ObjModel, caso n
 void LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando um programa de GPU
 GLuint LoadTextureImage(const char* filename); // Função que carrega imagens de textura
 void DrawVirtualObject(const char* object_name); // Desenha um objeto armazenado em g_VirtualScene
+void DrawVirtualObjectDepth(const char* object_name); // Desenha um objeto de g_VirtualScene apenas com profundidade (passe de sombra)
+void BakeStaticBoxes(ObjModel* cube_model); // Transforma as caixas para o mundo e agrupa em chunks (geometria estática)
+void DrawStaticBoxes(const glm::mat4& projection_view); // Desenha os chunks de caixas visíveis pela câmera
+void DrawStaticBoxesDepth(); // Desenha todos os chunks de caixas no passe de sombra
+void CreateLineVAO(); // Cria o VAO de linhas, lendo do stream buffer
+void CreateShadowMaps(); // Cria os framebuffers e texturas de profundidade dos shadow maps
+void RenderStaticShadowMap(); // Renderiza chão e caixas no shadow map estático (cacheado)
+void RenderDynamicShadowMap(glm::vec4 center); // Renderiza jogador e inimigos no shadow map dinâmico, ao redor de center
 void DrawDirectionIndicator(glm::vec4 position, glm::vec4 forward, float length, glm::mat4 view, glm::mat4 projection, bool is_player = false); // Desenha indicador de direção
 void DrawEnemyHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat4 projection); // Desenha hitbox do inimigo (esfera wireframe)
 void DrawPlayerHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat4 projection); // Desenha hitbox do jogador (esfera wireframe)
-bool CheckPlayerBoxCollision(const glm::vec4& player_position); // Verifica colisão entre jogador e caixas
-bool CheckEnemyBoxCollision(const glm::vec4& enemy_position); // Verifica colisão entre inimigo e caixas
 void DrawCrosshair(GLFWwindow* window); // Desenha crosshair no centro da tela
 void DrawBezierSpline(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3, glm::mat4 view, glm::mat4 projection); // Desenha spline Bezier
 void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, float max_health, glm::mat4 view, glm::mat4 projection); // Desenha barra de vida acima do inimigo
 void DrawHUD(GLFWwindow* window); // Desenha HUD com HP e munição do jogador
-void CameraRaycast(glm::vec4 camera_position, glm::vec4 ray_direction); // Realiza raycast e verifica interseções
-void PlayerRaycast(); // Realiza raycast a partir do centro do jogador na direção que ele está olhando
-void EnemyToPlayerRaycast(size_t enemy_index); // Realiza raycast de um inimigo específico em direção ao jogador
+void UpdateHudEvents(); // Lê os eventos da simulação usados pelo HUD
+void DrawCpuFrameTimeGraph(GLFWwindow* window); // Desenha o gráfico de tempo de quadro do profiler de CPU
 void DrawRaycastLine(glm::vec4 start, glm::vec4 end, glm::mat4 view, glm::mat4 projection); // Desenha linha amarela para visualizar raycast
-int SpawnWave(const std::vector<glm::vec4>& spawn_positions, float enemy_health_multiplier = 1.0f, float enemy_speed_multiplier = 1.0f); // Spawna uma wave de monstros nas posições especificadas, retorna o ID da wave
-bool IsWaveComplete(int wave_id); // Verifica se todos os monstros de uma wave estão mortos
-void UpdateWaves(float delta_time); // Atualiza o status de todas as waves
-void SpawnNextWave(); // Spawna a próxima wave com dificuldade crescente
-std::vector<int> GetActiveWaves(); // Retorna os IDs de todas as waves ativas
-std::vector<int> GetCompleteWaves(); // Retorna os IDs de todas as waves completas
 GLuint LoadShader_Vertex(const char* filename);   // Carrega um vertex shader
 GLuint LoadShader_Fragment(const char* filename); // Carrega um fragment shader
 void LoadShader(const char* filename, GLuint shader_id); // Função utilizada pelas duas acima
@@ -148,6 +161,10 @@ void TextRendering_PrintMatrixVectorProductDivW(GLFWwindow* window, glm::mat4 M,
 void TextRendering_ShowModelViewProjection(GLFWwindow* window, glm::mat4 projection, glm::mat4 view, glm::mat4 model, glm::vec4 p_model);
 void TextRendering_ShowProjection(GLFWwindow* window);
 void TextRendering_ShowFramesPerSecond(GLFWwindow* window);
+void TextRendering_ShowGpuProfiler(GLFWwindow* window);
+void TextRendering_ShowCpuProfiler(GLFWwindow* window);
+void TextRendering_ShowStreamBufferStats(GLFWwindow* window);
+void TextRendering_ShowStaticChunkStats(GLFWwindow* window);
 
 // Funções callback para comunicação com o sistema operacional e interação do
 // usuário. Veja mais comentários nas definições das mesmas, abaixo.
@@ -158,6 +175,20 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 
+// Callbacks registrados na GLFW: só colocam o evento na fila de entrada, e
+// ApplyInputEvents() chama os callbacks acima quando ele é aplicado
+void QueueKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode);
+void QueueMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+void QueueCursorPosCallback(GLFWwindow* window, double xpos, double ypos);
+void QueueScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+void ApplyInputEvents(GLFWwindow* window, double max_time, bool latching);
+void PrintInputLatencies(const char* label, const std::vector<double>& latencies); // Resumo de "--input-latency"
+
+// Equivalentes a glfwGetTime() e glfwGetFramebufferSize() que também
+// funcionam no modo headless (window == NULL)
+double GetTime();
+void GetFramebufferSize(GLFWwindow* window, int* width, int* height);
+
 // Definimos uma estrutura que armazenará dados necessários para renderizar
 // cada objeto da cena virtual.
 struct SceneObject
@@ -173,665 +204,9 @@ struct SceneObject
 };
 
 
-// Câmera
-enum CameraMode {
-    CAMERA_THIRD_PERSON,
-    CAMERA_FIRST_PERSON
-};
-
-CameraMode g_CameraMode = CAMERA_THIRD_PERSON; // modo padrão
+// Câmera (o modo fica em World::camera_mode, pois orienta o movimento do jogador)
 float g_FirstPersonFOV = 3.141592f / 3.0f;  // 60 graus
 
-// Limites do mapa (baseado no plane.obj: -25 a 25 em X e Z)
-const float MAP_MIN_X = -25.0f;
-const float MAP_MAX_X = 25.0f;
-const float MAP_MIN_Z = -25.0f;
-const float MAP_MAX_Z = 25.0f;
-
-// Estrutura que representa o jogador
-struct Player
-{
-    // Posição e orientação
-    glm::vec4 position;           // Posição do jogador no mundo (x, y, z, 1.0)
-    float rotation_y;            // Rotação em torno do eixo Y (em radianos) - direção que o jogador está olhando
-    glm::vec4 forward_vector;    // Vetor direção para frente do jogador (normalizado)
-    glm::vec4 right_vector;      // Vetor direção para direita do jogador (normalizado)
-    glm::vec3 model_center; 	// centro do modelo em coordenadas de modelo
-
-    // Estados de movimento
-    enum MovementState {
-        IDLE,
-        WALKING,
-        RUNNING
-    };
-    MovementState movement_state;
-
-    // Velocidades
-    float walk_speed;            // Velocidade de caminhada
-    float run_speed;             // Velocidade de corrida
-    float current_speed;         // Velocidade atual (calculada baseada no estado)
-
-    // Controles de movimento
-    bool moving_forward;         // Tecla para frente pressionada
-    bool moving_backward;        // Tecla para trás pressionada
-    bool moving_left;            // Tecla para esquerda pressionada
-    bool moving_right;           // Tecla para direita pressionada
-    bool is_running;             // Shift pressionado para correr
-
-    // Status do jogador
-    float health;                // Vida do jogador (0.0 a 100.0)
-    float max_health;            // Vida máxima
-
-    // Sistema de tiro
-    int magazine_ammo;           // Munição atual no carregador
-    int magazine_size;           // Tamanho do carregador (12 balas)
-    float shoot_cooldown;        // Tempo restante do cooldown de tiro (em segundos)
-    float shoot_cooldown_time;   // Tempo total do cooldown de tiro (em segundos)
-    float reload_time;           // Tempo restante do reload (em segundos)
-    float reload_time_total;     // Tempo total do reload (em segundos)
-    bool is_reloading;           // Se está recarregando
-
-    // Câmera em terceira pessoa
-    float camera_distance;       // Distância da câmera ao jogador
-    float camera_height;         // Altura da câmera em relação ao jogador
-    float camera_angle_horizontal; // Ângulo horizontal da câmera (em radianos)
-    float camera_angle_vertical;   // Ângulo vertical da câmera (em radianos)
-
-    // Construtor
-    Player()
-        : position(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f))
-        , rotation_y(0.0f)
-        , forward_vector(glm::vec4(0.0f, 0.0f, -1.0f, 0.0f))
-        , right_vector(glm::vec4(1.0f, 0.0f, 0.0f, 0.0f))
-        , movement_state(IDLE)
-        , walk_speed(2.0f)
-        , run_speed(5.0f)
-        , current_speed(0.0f)
-        , moving_forward(false)
-        , moving_backward(false)
-        , moving_left(false)
-        , moving_right(false)
-        , max_health(100.0f)
-        , health(100.0f)  // Initialize with literal value since max_health isn't initialized yet
-        , magazine_size(20)
-        , magazine_ammo(20)  // Initialize with literal value since magazine_size isn't initialized yet
-        , shoot_cooldown(0.0f)
-        , shoot_cooldown_time(0.2f)  // 0.2 segundos de cooldown entre tiros
-        , reload_time(0.0f)
-        , reload_time_total(2.0f)     // 2 segundos para recarregar
-        , is_reloading(false)
-        , camera_distance(4.0f)
-        , camera_height(1.5f)
-        , camera_angle_horizontal(0.0f)
-        , camera_angle_vertical(0.3f)  // Câmera ligeiramente acima
-    {
-    }
-
-    // Atualiza os vetores de direção baseado na rotação Y
-    void UpdateDirectionVectors()
-    {
-        forward_vector = glm::vec4(
-            sin(rotation_y),
-            0.0f,
-            -cos(rotation_y),
-            0.0f
-        );
-        right_vector = glm::vec4(
-            cos(rotation_y),
-            0.0f,
-            sin(rotation_y),
-            0.0f
-        );
-    }
-
-    // Atualiza o estado de movimento baseado nas teclas pressionadas
-    void UpdateMovementState()
-    {
-        bool is_moving = moving_forward || moving_backward || moving_left || moving_right;
-
-        if (is_moving)
-        {
-            movement_state = is_running ? RUNNING : WALKING;
-            current_speed = is_running ? run_speed : walk_speed;
-        }
-        else
-        {
-            movement_state = IDLE;
-            current_speed = 0.0f;
-        }
-    }
-
-    // Calcula a posição da câmera em terceira pessoa
-    glm::vec4 GetThirdPersonCameraPosition()
-    {
-        float x = position.x + camera_distance * cos(camera_angle_vertical) * sin(camera_angle_horizontal);
-        float y = position.y + camera_height + camera_distance * sin(camera_angle_vertical);
-        float z = position.z + camera_distance * cos(camera_angle_vertical) * cos(camera_angle_horizontal);
-        return glm::vec4(x, y, z, 1.0f);
-    }
-
-    glm::vec4 GetCameraLookAt()
-    {
-        // Compensa o fato de que o modelo foi escalado com 0.3f
-        float scale = 0.3f;
-
-        // Calcula o ponto de referência do jogador (centro do modelo)
-        // Olha diretamente para o centro do cowboy para mantê-lo centralizado
-        glm::vec4 player_reference = glm::vec4(
-            position.x - model_center.x * scale,
-            position.y - model_center.y * scale + camera_height,
-            position.z - model_center.z * scale,
-            1.0f
-        );
-
-        // Retorna o centro do jogador para manter o cowboy centralizado
-        // O crosshair ainda funciona porque é desenhado no centro da tela
-        // e o raycast usa o vetor de visualização da câmera
-        return player_reference;
-    }
-
-    // Aplica dano ao jogador
-    void TakeDamage(float damage)
-    {
-        if (health <= 0.0f)
-            return; // Já está morto
-
-        health -= damage;
-        if (health < 0.0f)
-            health = 0.0f;
-    }
-
-    // Verifica se o jogador está morto
-    bool IsDead() const
-    {
-        return health <= 0.0f;
-    }
-
-    // Atualiza a posição do jogador baseado no movimento e no tempo decorrido
-    // O movimento é relativo à direção da câmera (terceira pessoa ou primeira pessoa)
-    void UpdatePosition(float delta_time)
-    {
-        // Atualiza o estado de movimento
-        UpdateMovementState();
-
-        glm::vec4 camera_forward;
-        glm::vec4 camera_right;
-
-        // Calcula a direção da câmera baseado no modo
-        if (g_CameraMode == CAMERA_FIRST_PERSON)
-        {
-            // Em primeira pessoa, usa o forward_vector calculado pelo mouse
-            camera_forward = forward_vector;
-            
-            // Mantém o movimento apenas no plano horizontal (remove componente Y)
-            camera_forward.y = 0.0f;
-            
-            // Normaliza o vetor forward no plano horizontal
-            float forward_length = sqrt(camera_forward.x * camera_forward.x + camera_forward.z * camera_forward.z);
-            if (forward_length > 0.001f)
-            {
-                camera_forward.x /= forward_length;
-                camera_forward.z /= forward_length;
-            }
-            
-            // Calcula a direção direita da câmera (perpendicular ao forward no plano horizontal)
-            // Usa o mesmo método que terceira pessoa para consistência
-            camera_right = crossproduct(camera_forward, glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
-            float camera_right_length = sqrt(camera_right.x * camera_right.x + camera_right.z * camera_right.z);
-            if (camera_right_length > 0.001f)
-            {
-                camera_right.x /= camera_right_length;
-                camera_right.z /= camera_right_length;
-            }
-            
-            // Atualiza a rotação do jogador para corresponder à direção forward
-            rotation_y = atan2(camera_forward.x, -camera_forward.z);
-        }
-        else
-        {
-            // Em terceira pessoa, calcula a direção da câmera
-            camera_forward = glm::vec4(
-                GetCameraLookAt().x - GetThirdPersonCameraPosition().x,
-                GetCameraLookAt().y - GetThirdPersonCameraPosition().y,
-                GetCameraLookAt().z - GetThirdPersonCameraPosition().z,
-                0.0f // ← ESSENCIAL!!!
-            );
-
-            camera_forward.y = 0.0f; // Mantém o movimento apenas no plano horizontal
-
-            float camera_forward_length = sqrt(camera_forward.x * camera_forward.x + camera_forward.z * camera_forward.z);
-
-            // Atualiza a rotação do jogador para sempre corresponder à direção forward da câmera
-            if (camera_forward_length > 0.001f)
-            {
-                camera_forward.x /= camera_forward_length;
-                camera_forward.z /= camera_forward_length;
-
-                // A rotação do jogador sempre corresponde à direção forward da câmera
-                rotation_y = atan2(camera_forward.x, -camera_forward.z);
-            }
-
-            // Calcula a direção direita da câmera (perpendicular ao forward no plano horizontal)
-            camera_right = crossproduct(camera_forward, glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
-            float camera_right_length = sqrt(camera_right.x * camera_right.x + camera_right.z * camera_right.z);
-            if (camera_right_length > 0.001f)
-            {
-                camera_right.x /= camera_right_length;
-                camera_right.z /= camera_right_length;
-            }
-        }
-
-        // Calcula o vetor de movimento baseado nas teclas pressionadas
-        glm::vec4 movement_direction = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
-
-        if (moving_forward)
-            movement_direction = movement_direction + camera_forward;
-        if (moving_backward)
-            movement_direction = movement_direction - camera_forward;
-        if (moving_right)
-            movement_direction = movement_direction + camera_right;
-        if (moving_left)
-            movement_direction = movement_direction - camera_right;
-
-        // Normaliza o vetor de movimento se não for zero
-        float movement_length = sqrt(movement_direction.x * movement_direction.x + movement_direction.z * movement_direction.z);
-
-        // Atualiza a posição apenas se estiver se movendo
-        if (movement_length > 0.001f && current_speed > 0.0f)
-        {
-            movement_direction.x /= movement_length;
-            movement_direction.z /= movement_length;
-
-            float move_distance = current_speed * delta_time;
-            
-            // Calcula a nova posição
-            glm::vec4 new_position = position;
-            new_position.x += movement_direction.x * move_distance;
-            new_position.z += movement_direction.z * move_distance;
-            
-            // Verifica colisão com caixas antes de atualizar a posição
-            if (!CheckPlayerBoxCollision(new_position))
-            {
-                // Sem colisão, atualiza a posição
-                position = new_position;
-            }
-            // Se houver colisão, a posição não é atualizada (jogador não se move)
-        }
-    }
-};
-
-// Estrutura que representa um inimigo
-struct Enemy
-{
-    // Posição e orientação
-    glm::vec4 position;           // Posição atual do inimigo no mundo (x, y, z, 1.0)
-    glm::vec4 spawn_position;     // Posição inicial de spawn do inimigo
-    float rotation_y;            // Rotação em torno do eixo Y (em radianos) - direção que o inimigo está olhando
-    glm::vec4 forward_vector;    // Vetor direção para frente do inimigo (normalizado)
-    glm::vec4 right_vector;      // Vetor direção para direita do inimigo (normalizado)
-
-    // Estados de movimento
-    enum MovementState {
-        IDLE,
-        WALKING,
-    };
-    MovementState movement_state;
-
-    // Velocidades
-    float walk_speed;            // Velocidade de caminhada
-    float current_speed;         // Velocidade atual (calculada baseada no estado)
-
-    // Status do inimigo
-    float max_health;            // Vida máxima
-    float health;                // Vida do inimigo (0.0 a 100.0)
-
-    // Bezier curve movement
-    glm::vec4 destination;       // Destino final da curva Bezier
-    glm::vec4 bezier_p1;         // Primeiro ponto de controle da curva Bezier
-    glm::vec4 bezier_p2;         // Segundo ponto de controle da curva Bezier
-    float bezier_progress;       // Progresso ao longo da curva (0.0 a 1.0)
-    float bezier_total_distance; // Distância total da curva (para calcular velocidade)
-
-    // Raycast visualization
-    bool draw_raycast;            // Se deve desenhar o raycast deste inimigo
-    glm::vec4 raycast_start;      // Ponto inicial do raycast
-    glm::vec4 raycast_end;        // Ponto final do raycast
-    float raycast_time;           // Tempo quando o raycast foi realizado
-
-    // Sistema de tiro
-    float shoot_cooldown;         // Tempo restante do cooldown de tiro (em segundos)
-    float shoot_cooldown_time;    // Tempo total do cooldown de tiro (em segundos)
-    float shoot_probability_check_timer; // Timer para verificar probabilidade de tiro (verifica a cada 1 segundo)
-    float shoot_probability;      // Probabilidade de atirar por segundo (0.0 a 1.0)
-
-    // Função auxiliar para calcular posição em uma curva Bezier cúbica
-    // t deve estar entre 0.0 e 1.0
-    glm::vec4 CalculateBezierPosition(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3, float t)
-    {
-        float u = 1.0f - t;
-        float tt = t * t;
-        float uu = u * u;
-        float uuu = uu * u;
-        float ttt = tt * t;
-
-        glm::vec4 result = uuu * p0;                    // (1-t)^3 * P0
-        result += 3.0f * uu * t * p1;                   // 3(1-t)^2 * t * P1
-        result += 3.0f * u * tt * p2;                  // 3(1-t) * t^2 * P2
-        result += ttt * p3;                             // t^3 * P3
-
-        return result;
-    }
-
-    // Gera um novo destino aleatório e calcula os pontos de controle da curva Bezier
-    void GenerateNewBezierPath()
-    {
-        // Usa a posição atual como ponto de partida (não sempre o spawn)
-        glm::vec4 start_pos = position;
-
-        // Gera um destino aleatório em um raio de 10 a 20 unidades da posição atual
-        // Tenta evitar caixas procurando por um destino que não colida
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_real_distribution<float> angle_dist(0.0f, 2.0f * M_PI);
-        std::uniform_real_distribution<float> distance_dist(10.0f, 20.0f);
-
-        // Tenta até 10 vezes encontrar um destino que não colida com caixas
-        const int max_attempts = 10;
-        bool found_valid_destination = false;
-        
-        for (int attempt = 0; attempt < max_attempts; ++attempt)
-        {
-            float angle = angle_dist(gen);
-            float distance = distance_dist(gen);
-
-            destination = glm::vec4(
-                start_pos.x + distance * cos(angle),
-                start_pos.y,
-                start_pos.z + distance * sin(angle),
-                1.0f
-            );
-
-            // Garante que o destino está dentro dos limites do mapa
-            destination.x = glm::clamp(destination.x, MAP_MIN_X, MAP_MAX_X);
-            destination.z = glm::clamp(destination.z, MAP_MIN_Z, MAP_MAX_Z);
-            
-            // Verifica se o destino colide com alguma caixa
-            if (!CheckEnemyBoxCollision(destination))
-            {
-                found_valid_destination = true;
-                break; // Encontrou um destino válido
-            }
-        }
-        
-        // Se não encontrou um destino sem colisão após várias tentativas, usa o último gerado mesmo assim
-        // (o inimigo vai recalcular quando detectar colisão durante o movimento)
-
-        // Calcula pontos de controle para criar uma curva suave
-        // Os pontos de controle são posicionados perpendicularmente à direção do movimento
-        glm::vec4 direction = destination - start_pos;
-        float dir_length = sqrt(direction.x * direction.x + direction.z * direction.z);
-        
-        if (dir_length > 0.001f)
-        {
-            direction.x /= dir_length;
-            direction.z /= dir_length;
-        }
-
-        // Cria um vetor perpendicular (rotação de 90 graus no plano XZ)
-        glm::vec4 perpendicular = glm::vec4(-direction.z, 0.0f, direction.x, 0.0f);
-
-        // Primeiro ponto de controle: 1/3 do caminho, desviando para um lado
-        float control_offset = dir_length * 0.3f;
-        bezier_p1 = start_pos + direction * (dir_length * 0.33f) + perpendicular * control_offset;
-        bezier_p1.y = start_pos.y;
-        // Garante que os pontos de controle estão dentro dos limites
-        bezier_p1.x = glm::clamp(bezier_p1.x, MAP_MIN_X, MAP_MAX_X);
-        bezier_p1.z = glm::clamp(bezier_p1.z, MAP_MIN_Z, MAP_MAX_Z);
-
-        // Segundo ponto de controle: 2/3 do caminho, desviando para o outro lado
-        bezier_p2 = start_pos + direction * (dir_length * 0.67f) - perpendicular * control_offset;
-        bezier_p2.y = start_pos.y;
-        // Garante que os pontos de controle estão dentro dos limites
-        bezier_p2.x = glm::clamp(bezier_p2.x, MAP_MIN_X, MAP_MAX_X);
-        bezier_p2.z = glm::clamp(bezier_p2.z, MAP_MIN_Z, MAP_MAX_Z);
-
-        // Calcula a distância aproximada da curva (soma de segmentos)
-        float dist1 = sqrt(pow(bezier_p1.x - start_pos.x, 2) + pow(bezier_p1.z - start_pos.z, 2));
-        float dist2 = sqrt(pow(bezier_p2.x - bezier_p1.x, 2) + pow(bezier_p2.z - bezier_p1.z, 2));
-        float dist3 = sqrt(pow(destination.x - bezier_p2.x, 2) + pow(destination.z - bezier_p2.z, 2));
-        bezier_total_distance = dist1 + dist2 + dist3;
-
-        // Atualiza spawn_position para a posição atual (para a próxima curva começar daqui)
-        spawn_position = start_pos;
-
-        // Reseta o progresso
-        bezier_progress = 0.0f;
-    }
-
-    // Construtor
-    Enemy(glm::vec4 spawn_pos, int wave = -1, float health_multiplier = 1.0f, float speed_multiplier = 1.0f)
-        : position(spawn_pos)
-        , spawn_position(spawn_pos)
-        , rotation_y(0.0f)
-        , forward_vector(glm::vec4(0.0f, 0.0f, -1.0f, 0.0f))
-        , right_vector(glm::vec4(1.0f, 0.0f, 0.0f, 0.0f))
-        , movement_state(IDLE)
-        , walk_speed(1.5f * speed_multiplier)
-        , current_speed(0.0f)
-        , max_health(100.0f * health_multiplier)
-        , health(max_health)
-        , wave_id(wave)
-        , destination(spawn_pos)
-        , bezier_p1(spawn_pos)
-        , bezier_p2(spawn_pos)
-        , bezier_progress(0.0f)
-        , bezier_total_distance(0.0f)
-        , draw_raycast(false)
-        , raycast_start(spawn_pos)
-        , raycast_end(spawn_pos)
-        , raycast_time(0.0f)
-        , shoot_cooldown(2.0f)  // Cooldown inicial de 2 segundos ao spawnar (dá tempo para o jogador se preparar)
-        , shoot_cooldown_time(2.5f)  // 2.5 segundos de cooldown entre tiros
-        , shoot_probability_check_timer(0.0f)
-        , shoot_probability(0.3f)  // 30% de chance de atirar por segundo
-    {
-        // Gera o caminho Bezier inicial
-        GenerateNewBezierPath();
-        
-        // Inicializa o timer de probabilidade com um valor aleatório entre 0 e 1 segundo
-        // para evitar que todos os inimigos atirem ao mesmo tempo
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_real_distribution<float> timer_dist(0.0f, 1.0f);
-        shoot_probability_check_timer = timer_dist(gen);
-    }
-
-    // Atualiza os vetores de direção baseado na rotação Y
-    void UpdateDirectionVectors()
-    {
-        forward_vector = glm::vec4(
-            sin(rotation_y),
-            0.0f,
-            -cos(rotation_y),
-            0.0f
-        );
-        right_vector = glm::vec4(
-            cos(rotation_y),
-            0.0f,
-            sin(rotation_y),
-            0.0f
-        );
-    }
-
-    // Atualiza o estado de movimento
-    void UpdateMovementState()
-    {
-        // Inimigos estão sempre caminhando ao longo da curva Bezier
-        movement_state = WALKING;
-        current_speed = walk_speed;
-    }
-
-    // Atualiza a posição do inimigo ao longo da curva Bezier
-    void UpdatePosition(float delta_time)
-    {
-        // Atualiza o estado de movimento
-        UpdateMovementState();
-
-        // Se chegou ao destino, gera um novo caminho
-        if (bezier_progress >= 1.0f)
-        {
-            GenerateNewBezierPath();
-        }
-
-        // Calcula a distância a percorrer neste frame
-        float distance_to_move = current_speed * delta_time;
-
-        // Calcula quanto progresso isso representa na curva
-        if (bezier_total_distance > 0.001f)
-        {
-            float progress_increment = distance_to_move / bezier_total_distance;
-            bezier_progress += progress_increment;
-
-            // Limita o progresso a 1.0
-            if (bezier_progress > 1.0f)
-                bezier_progress = 1.0f;
-        }
-
-        // Calcula a nova posição na curva Bezier
-        // spawn_position é atualizado quando geramos um novo caminho, então sempre usamos ele como início
-        glm::vec4 new_position = CalculateBezierPosition(
-            spawn_position,
-            bezier_p1,
-            bezier_p2,
-            destination,
-            bezier_progress
-        );
-
-        // Garante que a posição está dentro dos limites do mapa
-        new_position.x = glm::clamp(new_position.x, MAP_MIN_X, MAP_MAX_X);
-        new_position.z = glm::clamp(new_position.z, MAP_MIN_Z, MAP_MAX_Z);
-
-        // Verifica colisão antes de atualizar a posição
-        if (CheckEnemyBoxCollision(new_position))
-        {
-            // Colisão detectada! Recalcula o caminho Bezier para evitar a caixa
-            GenerateNewBezierPath();
-            return; // Não atualiza a posição neste frame
-        }
-
-        // Atualiza a posição
-        position = new_position;
-
-        // Atualiza a rotação para olhar na direção do movimento
-        if (bezier_progress < 1.0f)
-        {
-            // Calcula a direção do movimento (posição atual vs próxima posição)
-            float next_t = bezier_progress + 0.01f;
-            if (next_t > 1.0f)
-                next_t = 1.0f;
-
-            glm::vec4 next_position = CalculateBezierPosition(
-                spawn_position,
-                bezier_p1,
-                bezier_p2,
-                destination,
-                next_t
-            );
-
-            glm::vec4 movement_direction = next_position - position;
-            float dir_length = sqrt(movement_direction.x * movement_direction.x + movement_direction.z * movement_direction.z);
-
-            if (dir_length > 0.001f)
-            {
-                rotation_y = atan2(movement_direction.x, -movement_direction.z);
-            }
-        }
-        else
-        {
-            // Quando chega ao destino, olha na direção do destino
-            glm::vec4 to_destination = destination - position;
-            float dir_length = sqrt(to_destination.x * to_destination.x + to_destination.z * to_destination.z);
-            if (dir_length > 0.001f)
-            {
-                rotation_y = atan2(to_destination.x, -to_destination.z);
-            }
-        }
-    }
-
-    // Aplica dano ao inimigo
-    void TakeDamage(float damage)
-    {
-        if (health <= 0.0f)
-            return; // Já está morto
-
-        health -= damage;
-        if (health < 0.0f)
-            health = 0.0f;
-    }
-
-    // Verifica se o inimigo está morto
-    bool IsDead() const
-    {
-        return health <= 0.0f;
-    }
-
-    // ID da wave à qual este inimigo pertence (-1 se não pertence a nenhuma wave)
-    int wave_id;
-};
-
-// Estrutura que representa uma caixa ou barril no mundo
-struct Box
-{
-    glm::vec4 position;    // Posição da caixa no mundo (x, y, z, 1.0)
-    float rotation_y;      // Rotação em torno do eixo Y (em radianos)
-    glm::vec3 scale;       // Escala da caixa (largura, altura, profundidade)
-
-    Box(glm::vec4 pos, float rot_y = 0.0f, glm::vec3 scl = glm::vec3(0.5f, 0.5f, 0.5f))
-        : position(pos), rotation_y(rot_y), scale(scl)
-    {
-    }
-};
-
-// Estrutura que representa uma wave de monstros
-struct Wave
-{
-    int wave_id;                    // ID único da wave
-    std::vector<size_t> enemy_indices; // Índices dos inimigos desta wave no vetor g_Enemies
-    bool is_active;                  // Se a wave está ativa (ainda tem inimigos vivos)
-    bool is_complete;                // Se todos os inimigos da wave foram derrotados
-
-    Wave(int id) : wave_id(id), is_active(true), is_complete(false)
-    {
-    }
-
-    // Verifica se todos os inimigos da wave estão mortos
-    bool CheckCompletion(const std::vector<Enemy>& enemies)
-    {
-        if (is_complete)
-            return true;
-
-        // Verifica se todos os inimigos da wave estão mortos
-        bool all_dead = true;
-        for (size_t idx : enemy_indices)
-        {
-            if (idx < enemies.size() && !enemies[idx].IsDead())
-            {
-                all_dead = false;
-                break;
-            }
-        }
-
-        if (all_dead)
-        {
-            is_complete = true;
-            is_active = false;
-            return true;
-        }
-
-        return false;
-    }
-};
-
 // # ------------------------------------------------------------------------------- #
 // ##### -------------------------- VARIÁVEIS GLOBAIS -------------------------- #####
 // # ------------------------------------------------------------------------------- #
@@ -841,9 +216,9 @@ struct Wave
 // Veja na função main() como estes são acessados.
 
 std::map<std::string, SceneObject> g_VirtualScene;
-float g_CowboyMinY = 0.0f; // menor y do cowboy em coordenadas de modelo
-float g_BanditMinY = 0.0f;
-glm::vec3 g_BanditCenterModel = glm::vec3(0.0f); // centro do bandit em coordenadas de modelo
+
+// Estado do jogo: jogador, inimigos, caixas e waves (veja "simulation.h")
+World g_World;
 
 // Pilha que guardará as matrizes de modelagem.
 std::stack<glm::mat4>  g_MatrixStack;
@@ -854,6 +229,10 @@ float g_ScreenRatio = 1.0f;
 int g_windowWidth = 1280;
 int g_windowHeight = 960;
 
+// Framebuffer onde a cena é desenhada: 0 (o da janela) ou, no modo headless,
+// o FBO criado por Headless_Init().
+GLuint g_DefaultFramebuffer = 0;
+
 // "g_LeftMouseButtonPressed = true" se o usuário está com o botão esquerdo do mouse
 // pressionado no momento atual. Veja função MouseButtonCallback().
 bool g_LeftMouseButtonPressed = false;
@@ -863,140 +242,6 @@ bool g_MiddleMouseButtonPressed = false;
 // Variáveis que definem a câmera em coordenadas esféricas, controladas pelo usuário.
 float g_CameraDistance = 3.5f; // Distância da câmera para a origem
 
-// Instância do jogador
-Player g_Player;
-
-// Lista de inimigos
-std::vector<Enemy> g_Enemies;
-
-// Lista de waves de monstros
-std::vector<Wave> g_Waves;
-int g_NextWaveID = 0; // Contador para gerar IDs únicos de waves
-int g_CurrentWaveNumber = 0; // Número da wave atual (1-5)
-const int g_MaxWaves = 5; // Número total de waves
-bool g_WaveCleared = false; // Se a wave atual foi completada
-float g_WaveClearedTimer = 0.0f; // Timer para mostrar mensagem e iniciar próxima wave
-const float g_WaveClearedDelay = 3.0f; // Tempo em segundos antes de iniciar próxima wave
-
-// Lista de caixas/barrils no mundo
-std::vector<Box> g_Boxes;
-
-// Função auxiliar para verificar colisão entre jogador (esfera) e caixa (AABB)
-// Retorna true se houver colisão
-bool CheckPlayerBoxCollision(const glm::vec4& player_position)
-{
-    const float player_radius = 0.3f; // Raio da hitbox do jogador
-    const float player_scale = 0.3f;
-    
-    // Calcula o centro da hitbox do jogador em world space
-    glm::vec3 player_center = glm::vec3(
-        player_position.x + g_Player.model_center.x * player_scale,
-        player_position.y + g_Player.model_center.y * player_scale,
-        player_position.z + g_Player.model_center.z * player_scale
-    );
-    
-    // Verifica colisão com cada caixa
-    for (const auto& box : g_Boxes)
-    {
-        // Calcula o AABB da caixa considerando a rotação
-        // Para simplificar, usamos a maior extensão horizontal (diagonal do quadrado)
-        float max_horizontal_extent = sqrt(box.scale.x * box.scale.x + box.scale.z * box.scale.z);
-        
-        // AABB da caixa (axis-aligned, aproximação conservadora)
-        glm::vec3 box_min = glm::vec3(
-            box.position.x - max_horizontal_extent,
-            box.position.y - box.scale.y,
-            box.position.z - max_horizontal_extent
-        );
-        glm::vec3 box_max = glm::vec3(
-            box.position.x + max_horizontal_extent,
-            box.position.y + box.scale.y,
-            box.position.z + max_horizontal_extent
-        );
-        
-        // Encontra o ponto mais próximo da esfera ao AABB
-        glm::vec3 closest_point = glm::vec3(
-            glm::clamp(player_center.x, box_min.x, box_max.x),
-            glm::clamp(player_center.y, box_min.y, box_max.y),
-            glm::clamp(player_center.z, box_min.z, box_max.z)
-        );
-        
-        // Calcula a distância do centro da esfera ao ponto mais próximo
-        float distance_sq = 
-            (player_center.x - closest_point.x) * (player_center.x - closest_point.x) +
-            (player_center.y - closest_point.y) * (player_center.y - closest_point.y) +
-            (player_center.z - closest_point.z) * (player_center.z - closest_point.z);
-        
-        // Se a distância é menor que o raio, há colisão
-        if (distance_sq < player_radius * player_radius)
-        {
-            return true; // Colisão detectada
-        }
-    }
-    
-    return false; // Sem colisão
-}
-
-bool CheckEnemyBoxCollision(const glm::vec4& enemy_position)
-{
-    const float enemy_radius = 0.3f; // Raio da hitbox do inimigo (mesmo usado na detecção)
-    const float enemy_scale_collision = 0.3f;
-    const float enemy_scale_y_collision = 0.3f;
-    
-    // Obtém os offsets do centro do modelo em coordenadas de modelo
-    SceneObject bandit_obj = g_VirtualScene["bandit"];
-    float center_x = (bandit_obj.bbox_min.x + bandit_obj.bbox_max.x) * 0.5f;
-    float center_z = (bandit_obj.bbox_min.z + bandit_obj.bbox_max.z) * 0.5f;
-    
-    // Calcula o centro da hitbox do inimigo em world space (mesma lógica do hitbox rendering)
-    glm::vec3 enemy_center = glm::vec3(
-        enemy_position.x + center_x * enemy_scale_collision,
-        enemy_position.y + g_BanditCenterModel.y * enemy_scale_y_collision,
-        enemy_position.z + center_z * enemy_scale_collision
-    );
-    
-    // Verifica colisão com cada caixa
-    for (const auto& box : g_Boxes)
-    {
-        // Calcula o AABB da caixa considerando a rotação
-        // Para simplificar, usamos a maior extensão horizontal (diagonal do quadrado)
-        float max_horizontal_extent = sqrt(box.scale.x * box.scale.x + box.scale.z * box.scale.z);
-        
-        // AABB da caixa (axis-aligned, aproximação conservadora)
-        glm::vec3 box_min = glm::vec3(
-            box.position.x - max_horizontal_extent,
-            box.position.y - box.scale.y,
-            box.position.z - max_horizontal_extent
-        );
-        glm::vec3 box_max = glm::vec3(
-            box.position.x + max_horizontal_extent,
-            box.position.y + box.scale.y,
-            box.position.z + max_horizontal_extent
-        );
-        
-        // Encontra o ponto mais próximo da esfera ao AABB
-        glm::vec3 closest_point = glm::vec3(
-            glm::clamp(enemy_center.x, box_min.x, box_max.x),
-            glm::clamp(enemy_center.y, box_min.y, box_max.y),
-            glm::clamp(enemy_center.z, box_min.z, box_max.z)
-        );
-        
-        // Calcula a distância do centro da esfera ao ponto mais próximo
-        float distance_sq = 
-            (enemy_center.x - closest_point.x) * (enemy_center.x - closest_point.x) +
-            (enemy_center.y - closest_point.y) * (enemy_center.y - closest_point.y) +
-            (enemy_center.z - closest_point.z) * (enemy_center.z - closest_point.z);
-        
-        // Se a distância é menor que o raio, há colisão
-        if (distance_sq < enemy_radius * enemy_radius)
-        {
-            return true; // Colisão detectada
-        }
-    }
-    
-    return false; // Sem colisão
-}
-
 // Variáveis para visualização de raycast de inimigo
 bool g_DrawEnemyRaycast = false;
 glm::vec4 g_EnemyRaycastStart;
@@ -1010,8 +255,46 @@ bool g_UsePerspectiveProjection = true;
 // Variável que controla se o texto informativo será mostrado na tela.
 bool g_ShowInfoText = true;
 
-// Variáveis para controle de tempo (delta time)
-float g_LastFrameTime = 0.0f;
+// Número de quadros gravados no trace disparado pela tecla F3
+int g_TraceFrames = TRACE_RECORDER_DEFAULT_FRAMES;
+
+// Variáveis para controle de tempo. Usamos double: em float, o tempo desde o
+// início do programa perde precisão em sessões longas.
+double g_LastFrameTime = 0.0;          // Instante do início do último quadro
+double g_SimulationAccumulator = 0.0;  // Tempo real ainda não simulado
+int    g_SimulationTickRate = SIMULATION_TICK_RATE; // Ticks da simulação por segundo
+float  g_RenderAlpha = 1.0f;           // Fração do próximo tick já decorrida, para interpolar a renderização
+
+// Entrada do jogador, aplicada ao World no início de cada tick (e gravada no
+// replay, se houver). Os callbacks de teclado e mouse só alteram estas
+// variáveis: g_PlayerInput guarda o que está sendo mantido (teclas, câmera) e
+// g_PendingButtons as ações pontuais (tiro, recarga) ainda não aplicadas.
+SimulationAction g_PlayerInput = { SIMULATION_ACTION_THIRD_PERSON, 0.0f, 0.0f, 0.0f };
+unsigned int g_PendingButtons = 0;
+bool g_Replaying = false; // Entrada vem de um replay ("--replay")
+
+// Medida da latência entre a entrada e a apresentação do quadro
+// ("--input-latency"): instantes do movimento de mouse mais antigo e do
+// mais recente aplicados desde o último quadro apresentado, e as latências
+// de cada quadro a partir deles
+bool g_MeasureInputLatency = false;
+double g_OldestInputTime = -1.0;
+double g_NewestInputTime = -1.0;
+std::vector<double> g_InputLatencies;       // Desde o movimento mais antigo
+std::vector<double> g_LatchedInputLatencies; // Desde o mais recente
+int g_InputEventsApplied = 0;
+int g_InputEventsLatched = 0; // Aplicados só logo antes da câmera (late latching)
+#define INPUT_LATENCY_SYNTHETIC_RATE 1000.0 // Eventos por segundo do mouse sintético no modo headless
+
+// Consumidores dos eventos da simulação (veja "eventbus.h"), lidos uma vez
+// por quadro depois dos ticks
+EventSubscriber g_HudEvents;  // Avisos de acerto e de dano no HUD
+EventSubscriber g_LogEvents;  // Mensagens de combate e das waves no log
+double g_HudHitTime = -1.0;   // g_World.time do último acerto do jogador em um inimigo
+bool   g_HudHitKilled = false; // O último acerto matou o inimigo
+double g_HudDamageTime = -1.0; // g_World.time do último dano sofrido pelo jogador
+float  g_HudDamageAmount = 0.0f;
+const double g_HudEventDuration = 0.5; // Segundos que os avisos de acerto e dano ficam visíveis
 
 // Variáveis globais que armazenam a última posição do cursor do mouse.
 // Usado para calcular quanto que o mouse se movimentou entre dois instantes de tempo.
@@ -1032,9 +315,64 @@ GLint g_bbox_max_uniform;
 // Número de texturas carregadas pela função LoadTextureImage()
 GLuint g_NumLoadedTextures = 0;
 
-// VAO e VBO para renderização de linhas (indicadores de direção)
+// VAO para renderização de linhas e primitivas de debug/HUD (indicadores de
+// direção, hitboxes, crosshair, barras de vida, raycasts, splines). Os vértices
+// não têm um VBO próprio: são escritos a cada quadro no stream buffer (veja
+// "streambuffer.h"), e cada desenho usa o "first" retornado por
+// StreamBuffer_Upload(). Cada vértice é um vec4 (x,y,z,w).
 GLuint g_LineVAO = 0;
-GLuint g_LineVBO = 0;
+#define LINE_VERTEX_STRIDE (4 * sizeof(float))
+
+// Geometria estática "assada": as caixas nunca se movem depois de geradas em
+// main(), então BakeStaticBoxes() transforma todos os seus vértices para
+// coordenadas do mundo uma única vez e os agrupa em chunks de
+// STATIC_CHUNK_SIZE x STATIC_CHUNK_SIZE unidades no plano XZ. Todos os chunks
+// compartilham um VBO; cada chunk visível é desenhado com uma única chamada.
+struct StaticChunk
+{
+    GLint     first_vertex; // Primeiro vértice do chunk no VBO compartilhado
+    GLsizei   num_vertices; // Número de vértices (GL_TRIANGLES)
+    glm::vec3 bbox_min;     // AABB do chunk em coordenadas do mundo
+    glm::vec3 bbox_max;
+};
+#define STATIC_CHUNK_SIZE 10.0f
+#define BAKED_BOX 15 // object_id das caixas assadas em "shader_fragment.glsl"
+GLuint g_StaticBoxesVAO = 0;
+std::vector<StaticChunk> g_StaticBoxChunks;
+int g_StaticChunksDrawn = 0; // Chunks que passaram pelo frustum culling no último quadro
+
+// Shadow map de uma fonte de luz direcional. Veja CreateShadowMaps().
+struct ShadowMap
+{
+    GLuint    framebuffer_id;        // FBO com apenas um anexo de profundidade
+    GLuint    depth_texture_id;      // Textura de profundidade (amostrada como sampler2DShadow)
+    int       size;                  // Resolução do mapa (size x size texels)
+    glm::mat4 light_view_projection; // Matriz projection*view da luz usada para gerar o mapa
+};
+
+// O mapa estático contém o chão e as caixas, que nunca se movem depois de
+// gerados em main(). Ele só é re-renderizado quando g_StaticShadowMapDirty é
+// true, isto é, quando g_World.map muda. O mapa dinâmico (menor, centrado no
+// jogador) contém o jogador e os inimigos e é re-renderizado a cada quadro.
+ShadowMap g_StaticShadowMap;
+ShadowMap g_DynamicShadowMap;
+bool g_StaticShadowMapDirty = true;
+bool g_UseShadows = true;
+
+// Unidades de textura dos shadow maps. As unidades mais baixas são usadas
+// pelas texturas carregadas em LoadTextureImage() e a 31 pelo texto.
+#define SHADOW_MAP_STATIC_UNIT  40
+#define SHADOW_MAP_DYNAMIC_UNIT 41
+
+// Programa de GPU do passe de sombra (shader_shadow_*.glsl)
+GLuint g_ShadowProgramID = 0;
+GLint g_shadow_model_uniform;
+GLint g_shadow_light_view_projection_uniform;
+
+// Variáveis do programa principal relacionadas às sombras
+GLint g_light_view_projection_static_uniform;
+GLint g_light_view_projection_dynamic_uniform;
+GLint g_use_shadows_uniform;
 
 // ======================================================
 // CARREGA TODAS AS TEXTURAS CORRETAS DO COWBOY
@@ -1102,59 +440,252 @@ void LoadAllBanditTextures(ObjModel& model_bandit)
 GLuint texture_plane = 0;
 GLuint texture_crate = 0;
 
+// Matriz de modelagem de uma caixa. Usada tanto no desenho da cena quanto no
+// passe do shadow map, para que os dois fiquem sempre alinhados.
+glm::mat4 ComputeBoxModelMatrix(const Box& box)
+{
+    glm::mat4 model = Matrix_Translate(box.position.x, box.position.y, box.position.z);
+    model = model * Matrix_Rotate_Y(box.rotation_y);
+    model = model * Matrix_Scale(box.scale.x, box.scale.y, box.scale.z);
+    return model;
+}
+
+// Matriz de modelagem do jogador
+glm::mat4 ComputePlayerModelMatrix()
+{
+    // Calcula o centro do modelo (onde a hitbox está) para alinhar renderização com hitbox
+    // Usa a transformação interpolada entre os dois últimos ticks
+    const float player_scale = 0.3f;
+    glm::vec4 position = g_World.player.GetInterpolatedPosition(g_RenderAlpha);
+    glm::vec4 model_center_world = glm::vec4(
+        position.x + g_World.player.model_center.x * player_scale,
+        position.y + g_World.player.model_center.y * player_scale,
+        position.z + g_World.player.model_center.z * player_scale,
+        1.0f
+    );
+    // Renderiza no centro do modelo, depois translada para compensar o centro do modelo antes de escalar
+    glm::mat4 model = Matrix_Translate(model_center_world.x, model_center_world.y, model_center_world.z);
+    model = model * Matrix_Rotate_Y(g_World.player.GetInterpolatedRotationY(g_RenderAlpha));
+    model = model * Matrix_Translate(-g_World.player.model_center.x * player_scale,
+                                    -g_World.player.model_center.y * player_scale,
+                                    -g_World.player.model_center.z * player_scale);
+    // Escalamos um pouco para que o jogador seja visível
+    model = model * Matrix_Scale(player_scale, player_scale, player_scale);
+    return model;
+}
+
+// Matriz de modelagem do inimigo "index" de g_World.enemies. center_x e
+// center_z são os offsets do centro do modelo "bandit" em coordenadas de
+// modelo.
+glm::mat4 ComputeEnemyModelMatrix(size_t index, float center_x, float center_z)
+{
+    const float enemy_scale = 0.3f;
+    const float scale_y = 0.3f;
+
+    // Calcula o centro do modelo (onde a hitbox está) para alinhar renderização com hitbox,
+    // na transformação interpolada entre os dois últimos ticks
+    glm::vec4 position = Simulation_EnemyInterpolatedPosition(g_World, index, g_RenderAlpha);
+    glm::vec4 model_center_world = glm::vec4(
+        position.x + center_x * enemy_scale,
+        position.y + g_BanditCenterModel.y * scale_y,
+        position.z + center_z * enemy_scale,
+        1.0f
+    );
+    // Renderiza no centro do modelo, depois translada para compensar o centro do modelo antes de escalar
+    glm::mat4 model = Matrix_Translate(model_center_world.x, model_center_world.y, model_center_world.z);
+    model = model * Matrix_Rotate_Y(-Simulation_EnemyInterpolatedRotationY(g_World, index, g_RenderAlpha));
+    model = model * Matrix_Translate(-center_x * enemy_scale,
+                                    -g_BanditCenterModel.y * scale_y,
+                                    -center_z * enemy_scale);
+    model = model * Matrix_Scale(enemy_scale, scale_y, enemy_scale);
+    return model;
+}
+
 int main(int argc, char* argv[])
 {
-    int success = glfwInit();
+    // Nome da thread principal nos traces
+    CPU_PROFILE_THREAD_NAME("main");
+
+    // Opções de linha de comando. O primeiro argumento que não é uma opção é
+    // o caminho de um modelo ".obj" extra a ser carregado.
+    //   --trace-startup        grava um trace da inicialização
+    //   --trace-frames N       grava um trace dos N primeiros quadros (e define
+    //                          o número de quadros gravados pela tecla F3)
+    //   --trace-budget-ms X    grava um trace quando um quadro levar mais de X
+    //                          ms (0 desabilita)
+    //   --headless [backend]   renderiza sem janela (backend: auto, egl ou
+    //                          osmesa; veja "headless.h")
+    //   --size LxA             resolução da janela ou do framebuffer headless
+    //   --frames N             encerra depois de N quadros (padrão no modo
+    //                          headless: HEADLESS_DEFAULT_FRAMES)
+    //   --screenshot arquivo   salva o último quadro em um arquivo PPM
+    //                          (somente no modo headless)
+    //   --tick-rate HZ         ticks da simulação por segundo (padrão:
+    //                          SIMULATION_TICK_RATE)
+    //   --seed S               semente da simulação (padrão: aleatória)
+    //   --endless              waves sem fim, cada vez maiores (veja
+    //                          "wavegenerator.h")
+    //   --record arquivo       grava a partida em um replay
+    //   --replay arquivo       reproduz um replay (a entrada do jogador é
+    //                          ignorada)
+    //   --seek S               começa o replay no segundo S
+    //   --load-snapshot arquivo
+    //                          começa no estado salvo em um snapshot (veja
+    //                          "snapshot.h")
+    //   --input-latency        mede a latência entre os movimentos do mouse
+    //                          e a apresentação dos quadros (no modo
+    //                          headless, com um mouse sintético)
+    const char* model_filename = NULL;
+    bool trace_startup = false;
+    int trace_frames_at_start = 0;
+    double trace_budget_ms = TRACE_RECORDER_DEFAULT_BUDGET_MS;
+    const char* headless_backend = NULL;
+    int max_frames = 0;
+    const char* screenshot_filename = NULL;
+    bool has_seed = false;
+    uint32_t seed = 0;
+    bool endless = false;
+    const char* record_filename = NULL;
+    const char* replay_filename = NULL;
+    double seek_seconds = 0.0;
+    const char* snapshot_filename = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+        {
+            headless_backend = HEADLESS_BACKEND_AUTO;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                headless_backend = argv[++i];
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &g_windowWidth, &g_windowHeight) != 2 || g_windowWidth <= 0 || g_windowHeight <= 0)
+            {
+                fprintf(stderr, "ERROR: Resolução inválida \"%s\" (use LxA, ex.: 1280x960).\n", argv[i]);
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            max_frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc)
+            screenshot_filename = argv[++i];
+        else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+        {
+            g_SimulationTickRate = atoi(argv[++i]);
+            if (g_SimulationTickRate <= 0)
+            {
+                fprintf(stderr, "ERROR: --tick-rate deve ser positivo.\n");
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+            has_seed = true;
+        }
+        else if (strcmp(argv[i], "--endless") == 0)
+            endless = true;
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            record_filename = argv[++i];
+        else if (strcmp(argv[i], "--load-snapshot") == 0 && i + 1 < argc)
+            snapshot_filename = argv[++i];
+        else if (strcmp(argv[i], "--input-latency") == 0)
+            g_MeasureInputLatency = true;
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replay_filename = argv[++i];
+        else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc)
+            seek_seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--trace-startup") == 0)
+            trace_startup = true;
+        else if (strcmp(argv[i], "--trace-frames") == 0 && i + 1 < argc)
+            g_TraceFrames = trace_frames_at_start = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace-budget-ms") == 0 && i + 1 < argc)
+            trace_budget_ms = atof(argv[++i]);
+        else if (argv[i][0] == '-')
+            fprintf(stderr, "WARNING: Opção desconhecida \"%s\".\n", argv[i]);
+        else if (!model_filename)
+            model_filename = argv[i];
+    }
+    if (snapshot_filename && replay_filename)
+    {
+        fprintf(stderr, "ERROR: --load-snapshot e --replay não podem ser usados juntos.\n");
+        std::exit(EXIT_FAILURE);
+    }
 
-    if (!success)
+    // Marcamos o início da inicialização, para o trace de startup
+    TraceRecorder_Init(trace_startup);
+    TraceRecorder_SetHitchBudget(trace_budget_ms);
+    TraceRecorder_CaptureFrames(trace_frames_at_start);
+
+    // As mensagens da simulação (tiros, waves) são escritas no terminal pela
+    // thread do logger, fora do loop principal
+    Logger_Init(NULL, false);
+
+    GLFWwindow* window = NULL;
+    if (headless_backend)
     {
-        fprintf(stderr, "ERROR: glfwInit() failed.\n");
-        std::exit(EXIT_FAILURE);
+        // Sem janela: contexto EGL/OSMesa e um FBO no lugar do framebuffer
+        // padrão. As funções OpenGL são carregadas por Headless_Init().
+        if (!Headless_Init(headless_backend, g_windowWidth, g_windowHeight))
+            std::exit(EXIT_FAILURE);
+        g_DefaultFramebuffer = Headless_GetFramebuffer();
+        if (max_frames == 0)
+            max_frames = HEADLESS_DEFAULT_FRAMES;
     }
+    else
+    {
+        int success = glfwInit();
 
-    glfwSetErrorCallback(ErrorCallback);
+        if (!success)
+        {
+            fprintf(stderr, "ERROR: glfwInit() failed.\n");
+            std::exit(EXIT_FAILURE);
+        }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwSetErrorCallback(ErrorCallback);
 
-    #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    #endif
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window;
-    window = glfwCreateWindow(g_windowWidth, g_windowHeight, "Sunset Riders", NULL, NULL);
+        #ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        #endif
 
-    if (!window)
-    {
-        glfwTerminate();
-        fprintf(stderr, "ERROR: glfwCreateWindow() failed.\n");
-        std::exit(EXIT_FAILURE);
-    }
+        window = glfwCreateWindow(g_windowWidth, g_windowHeight, "Sunset Riders", NULL, NULL);
+
+        if (!window)
+        {
+            glfwTerminate();
+            fprintf(stderr, "ERROR: glfwCreateWindow() failed.\n");
+            std::exit(EXIT_FAILURE);
+        }
+
+        // Centralizamos a janela na tela
+        GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+        int x = (mode->width - g_windowWidth) / 2;
+        int y = (mode->height - g_windowHeight) / 2;
+        glfwSetWindowPos(window, x, y);
 
-    // Centralizamos a janela na tela
-    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
-    const GLFWvidmode* mode = glfwGetVideoMode(monitor);
-    int x = (mode->width - g_windowWidth) / 2;
-    int y = (mode->height - g_windowHeight) / 2;
-    glfwSetWindowPos(window, x, y);
-
-    // Definimos a função de callback que será chamada sempre que o usuário
-    // pressionar alguma tecla do teclado ...
-    glfwSetKeyCallback(window, KeyCallback);
-    // ... ou clicar os botões do mouse ...
-    glfwSetMouseButtonCallback(window, MouseButtonCallback);
-    // ... ou movimentar o cursor do mouse em cima da janela ...
-    glfwSetCursorPosCallback(window, CursorPosCallback);
-    // ... ou rolar a "rodinha" do mouse.
-    glfwSetScrollCallback(window, ScrollCallback);
-
-    // Indicamos que as chamadas OpenGL deverão renderizar nesta janela
-    glfwMakeContextCurrent(window);
-
-    // Carregamento de todas funções definidas por OpenGL 3.3, utilizando a
-    // biblioteca GLAD.
-    gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+        // Definimos a função de callback que será chamada sempre que o usuário
+        // pressionar alguma tecla do teclado ...
+        glfwSetKeyCallback(window, QueueKeyCallback);
+        // ... ou clicar os botões do mouse ...
+        glfwSetMouseButtonCallback(window, QueueMouseButtonCallback);
+        // ... ou movimentar o cursor do mouse em cima da janela ...
+        glfwSetCursorPosCallback(window, QueueCursorPosCallback);
+        // ... ou rolar a "rodinha" do mouse. Os eventos são aplicados no
+        // loop principal (veja ApplyInputEvents()).
+        glfwSetScrollCallback(window, QueueScrollCallback);
+
+        // Indicamos que as chamadas OpenGL deverão renderizar nesta janela
+        glfwMakeContextCurrent(window);
+
+        // Carregamento de todas funções definidas por OpenGL 3.3, utilizando a
+        // biblioteca GLAD.
+        gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    }
 
     texture_plane = LoadTextureImage("../../data/sand.jpg");
 
@@ -1177,17 +708,20 @@ int main(int argc, char* argv[])
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Configuramos o cursor para ficar desabilitado (escondido e travado na janela)
-    // Isso permite movimento ilimitado do mouse para controle da câmera
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (window)
+    {
+        // Configuramos o cursor para ficar desabilitado (escondido e travado na janela)
+        // Isso permite movimento ilimitado do mouse para controle da câmera
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    // Inicializamos a posição do cursor no centro da janela
-    glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
+        // Inicializamos a posição do cursor no centro da janela
+        glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
 
-    // Definimos a função de callback que será chamada sempre que a janela for
-    // redimensionada, por consequência alterando o tamanho do "framebuffer"
-    // (região de memória onde são armazenados os pixels da imagem).
-    glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+        // Definimos a função de callback que será chamada sempre que a janela for
+        // redimensionada, por consequência alterando o tamanho do "framebuffer"
+        // (região de memória onde são armazenados os pixels da imagem).
+        glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+    }
     FramebufferSizeCallback(window, g_windowWidth, g_windowHeight); // Forçamos a chamada do callback acima, para definir g_ScreenRatio.
 
     // Imprimimos no terminal informações sobre a GPU do sistema
@@ -1221,31 +755,6 @@ int main(int argc, char* argv[])
     BuildTrianglesAndAddToVirtualScene(&cowboymodel);
     LoadAllCowboyTextures(cowboymodel);
 
-    const float player_scale = 0.3f;
-    const float ground_y = -1.1f;
-    g_CowboyMinY = std::numeric_limits<float>::max();
-
-    SceneObject cowboy_obj = g_VirtualScene["cowboy"];
-    glm::vec3 g_CowboyCenterModel = (cowboy_obj.bbox_min + cowboy_obj.bbox_max) * 0.5f;
-    g_CowboyMinY = cowboy_obj.bbox_min.y;
-    g_Player.model_center = g_CowboyCenterModel;   // agora o player sabe o centro real do modelo!
-
-    float center_x = (cowboy_obj.bbox_min.x + cowboy_obj.bbox_max.x) * 0.5f;
-    float center_z = (cowboy_obj.bbox_min.z + cowboy_obj.bbox_max.z) * 0.5f;
-
-    float player_y = ground_y - g_CowboyMinY * player_scale;
-
-    g_Player.position = glm::vec4(
-        -center_x * player_scale,
-        player_y,
-        -center_z * player_scale,
-        1.0f
-    );
-    g_Player.UpdateDirectionVectors();
-
-    printf(">>> Player pos = (%f, %f, %f)\n",
-           g_Player.position.x, g_Player.position.y, g_Player.position.z);
-
     // ...e o modelo dos inimigos (bandit)...
     ObjModel banditmodel("../../data/bandit.obj");
     ComputeNormals(&banditmodel);
@@ -1264,93 +773,104 @@ for (const auto& mat : banditmodel.materials)
 printf("============================\n\n");
 
 
-    const float enemy_scale = 0.3f;
-    g_BanditMinY = std::numeric_limits<float>::max();
-
-    SceneObject bandit_obj = g_VirtualScene["bandit"];
-    g_BanditCenterModel = (bandit_obj.bbox_min + bandit_obj.bbox_max) * 0.5f;
-    g_BanditMinY = bandit_obj.bbox_min.y;
+    // A simulação só precisa das bounding boxes dos modelos. Gravamos um
+    // descritor com elas para o executável "fcg_headless", que roda a
+    // simulação sem carregar os modelos.
+    ModelBounds cowboy_bounds = { g_VirtualScene["cowboy"].bbox_min, g_VirtualScene["cowboy"].bbox_max };
+    ModelBounds bandit_bounds = { g_VirtualScene["bandit"].bbox_min, g_VirtualScene["bandit"].bbox_max };
+    Simulation_SetModelBounds(cowboy_bounds, bandit_bounds);
+    if (!Simulation_SaveModelBounds(SIMULATION_BOUNDS_FILE))
+        fprintf(stderr, "ERROR: Não foi possível gravar \"%s\".\n", SIMULATION_BOUNDS_FILE);
 
-    center_x = (bandit_obj.bbox_min.x + bandit_obj.bbox_max.x) * 0.5f;
-    center_z = (bandit_obj.bbox_min.z + bandit_obj.bbox_max.z) * 0.5f;
+    //... e o modelo dos cubos (the_cube)...
+    ObjModel cubemodel("../../data/cube.obj");
+    ComputeNormals(&cubemodel);
+    BuildTrianglesAndAddToVirtualScene(&cubemodel);
 
-    float enemy_y = ground_y - g_BanditMinY * enemy_scale;
+    // Threads que dividem o trabalho de cada tick da simulação, uma por
+    // núcleo (veja "jobsystem.h")
+    JobSystem_Init(0);
 
-    for (auto& enemy : g_Enemies)
+    // Posicionamos o jogador, espalhamos as caixas e spawnamos a primeira
+    // wave, ou carregamos o estado do replay no instante pedido
+    if (replay_filename)
     {
-        enemy.position = glm::vec4(
-            -center_x * enemy_scale,
-            enemy_y,
-            -center_z * enemy_scale,
-            1.0f
-        );
-        enemy.UpdateDirectionVectors();
-        printf(">>> Enemy pos = (%f, %f, %f)\n",
-           enemy.position.x, enemy.position.y, enemy.position.z);
+        if (!Replay_Open(replay_filename))
+            std::exit(EXIT_FAILURE);
+        g_Replaying = true;
+        g_SimulationTickRate = Replay_GetTickRate();
+        if (!Replay_Seek(g_World, (uint32_t)(seek_seconds * g_SimulationTickRate)))
+            std::exit(EXIT_FAILURE);
+        printf("Reproduzindo \"%s\" a partir do tick %u de %u.\n", replay_filename, g_World.tick, Replay_GetNumTicks());
     }
+    else if (snapshot_filename)
+    {
+        // O snapshot traz também a frequência dos ticks com que foi salvo
+        if (!Snapshot_Load(snapshot_filename, g_World, &g_SimulationTickRate))
+            std::exit(EXIT_FAILURE);
+        printf("Snapshot \"%s\" carregado: wave %d, %zu inimigos.\n",
+               snapshot_filename, g_World.current_wave_number, g_World.enemies.size());
+    }
+    else
+    {
+        if (endless)
+            WaveGenerator_SetEndless(g_World.wave_config);
 
+        // A semente (e a configuração das waves, nos keyframes) é gravada no
+        // replay, então uma partida aleatória também pode ser reproduzida
+        Simulation_Init(g_World, has_seed ? seed : std::random_device()());
+    }
 
-    //... e o modelo dos cubos (the_cube)...
-    ObjModel cubemodel("../../data/cube.obj");
-    ComputeNormals(&cubemodel);
-    BuildTrianglesAndAddToVirtualScene(&cubemodel);
+    // A entrada do jogador começa com a câmera do World
+    if (g_World.camera_mode == CAMERA_FIRST_PERSON)
+        g_PlayerInput.buttons &= ~SIMULATION_ACTION_THIRD_PERSON;
+    g_PlayerInput.yaw = g_World.player.camera_angle_horizontal;
+    g_PlayerInput.pitch = g_World.player.camera_angle_vertical;
+    g_PlayerInput.camera_distance = g_World.player.camera_distance;
 
-    // Inicializamos caixas/barrils espalhadas por todo o mapa
-    const float box_y = ground_y + 0.25f; // Caixas ficam meio acima do chão
-    
-    // Espaçamento entre caixas (ajustável) - meio termo entre muito espalhado e muito denso
-    const float box_spacing = 5.5f; // Distância entre caixas (meio termo: 4.0f original, 8.0f muito espalhado)
-    const float box_margin = 2.0f; // Margem das bordas do mapa
-    
-    // Gera caixas em uma grade cobrindo todo o mapa
-    for (float x = MAP_MIN_X + box_margin; x <= MAP_MAX_X - box_margin; x += box_spacing)
+    // Os consumidores recebem os eventos a partir do estado inicial (ou do
+    // tick do replay em que começamos)
+    EventBus_Subscribe(g_World.events, g_HudEvents,
+                       GAME_EVENT_MASK(GAME_EVENT_ENEMY_DAMAGED) | GAME_EVENT_MASK(GAME_EVENT_ENEMY_KILLED) |
+                       GAME_EVENT_MASK(GAME_EVENT_PLAYER_DAMAGED));
+    EventBus_Subscribe(g_World.events, g_LogEvents);
+
+    if (record_filename)
     {
-        for (float z = MAP_MIN_Z + box_margin; z <= MAP_MAX_Z - box_margin; z += box_spacing)
+        if (!Replay_BeginRecording(record_filename, g_World, g_SimulationTickRate))
         {
-            // Adiciona alguma variação aleatória na posição para parecer mais natural
-            float offset_x = (rand() % 100) / 100.0f * 1.0f - 0.5f; // -0.5 a 0.5
-            float offset_z = (rand() % 100) / 100.0f * 1.0f - 0.5f; // -0.5 a 0.5
-            
-            // Variação na rotação
-            float rotation = (rand() % 100) / 100.0f * 2.0f * M_PI; // 0 a 2π
-            
-            // Variação no tamanho (algumas caixas maiores, outras menores)
-            float scale_variation = 0.3f + (rand() % 100) / 100.0f * 0.4f; // 0.3 a 0.7
-            float height_variation = 0.3f + (rand() % 100) / 100.0f * 0.5f; // 0.3 a 0.8
-            
-            // Aplica variação com probabilidade média (meio termo entre 40% e 80%)
-            if ((rand() % 100) < 65) // 65% de chance de ter uma caixa nesta posição
-            {
-                g_Boxes.push_back(Box(
-                    glm::vec4(x + offset_x, box_y, z + offset_z, 1.0f),
-                    rotation,
-                    glm::vec3(scale_variation, height_variation, scale_variation)
-                ));
-            }
+            fprintf(stderr, "ERROR: Não foi possível criar o replay \"%s\".\n", record_filename);
+            std::exit(EXIT_FAILURE);
         }
+        printf("Gravando replay em \"%s\".\n", record_filename);
     }
 
-    // Inicializamos a câmera para começar olhando para o jogador
-    g_Player.camera_angle_horizontal = 0.0f;
-    g_Player.camera_angle_vertical = 0.3f;
-
-    // Inicializa o sistema de waves
-    g_CurrentWaveNumber = 0;
-    g_WaveCleared = false;
-    g_WaveClearedTimer = 0.0f;
-    
-    // Spawna a primeira wave
-    SpawnNextWave();
+    // As caixas não mudam mais: assamos a geometria delas em chunks
+    BakeStaticBoxes(&cubemodel);
+    g_StaticShadowMapDirty = true;
 
-    if ( argc > 1 )
+    if ( model_filename )
     {
-        ObjModel model(argv[1]);
+        ObjModel model(model_filename);
         BuildTrianglesAndAddToVirtualScene(&model);
     }
 
+    // Inicializamos o buffer de geometria dinâmica, usado pelas linhas de
+    // debug, pelo HUD e pelo texto.
+    StreamBuffer_Init();
+    CreateLineVAO();
+
+    // Inicializamos o profiler de GPU (timer queries)
+    GpuProfiler_Init();
+
     // Inicializamos o código para renderização de texto.
     TextRendering_Init();
 
+    // Criamos os shadow maps. O estático será renderizado no primeiro quadro,
+    // já que g_StaticShadowMapDirty começa como true (as caixas acabaram de ser
+    // geradas acima).
+    CreateShadowMaps();
+
     // Habilitamos o Z-buffer. Veja slides 104-116 do documento Aula_09_Projecoes.pdf.
     glEnable(GL_DEPTH_TEST);
 
@@ -1360,22 +880,40 @@ printf("============================\n\n");
     glFrontFace(GL_CCW);
 
     // Inicializamos o tempo do último frame
-    g_LastFrameTime = (float)glfwGetTime();
-
-    // Ficamos em um loop infinito, renderizando, até que o usuário feche a janela
-    while (!glfwWindowShouldClose(window))
-    {
-        // Calculamos o delta time (tempo decorrido desde o último frame)
-        float current_time = (float)glfwGetTime();
-        float delta_time = current_time - g_LastFrameTime;
+    g_LastFrameTime = GetTime();
+
+    // Ficamos em um loop infinito, renderizando, até que o usuário feche a
+    // janela ou, se max_frames > 0 (sempre no modo headless), até renderizar
+    // max_frames quadros.
+    int frame_count = 0;
+    double loop_start_time = GetTime();
+
+    // Sem janela não há mouse: a latência é medida com movimentos sintéticos,
+    // gerados por outra thread como os de um mouse de 1000 Hz
+    if (g_MeasureInputLatency && !window)
+        InputQueue_StartSyntheticMouse(INPUT_LATENCY_SYNTHETIC_RATE, GetTime);
+    while (window ? !glfwWindowShouldClose(window) : true)
+    {
+        if (max_frames > 0 && frame_count == max_frames)
+            break;
+        frame_count += 1;
+
+        // Tempo real decorrido desde o último frame, que será simulado em
+        // ticks de duração fixa
+        double current_time = GetTime();
+        g_SimulationAccumulator += current_time - g_LastFrameTime;
         g_LastFrameTime = current_time;
 
-        // Limita o delta time para evitar problemas com frames muito longos
-        if (delta_time > 0.1f)
-            delta_time = 0.1f;
-
         // Aqui executamos as operações de renderização
 
+        // Início do quadro no stream buffer: a região que será escrita agora
+        // não está mais sendo lida pela GPU.
+        StreamBuffer_BeginFrame();
+
+        // Início do quadro no profiler de GPU. Cada GpuProfiler_BeginPass()
+        // abaixo encerra o pass anterior.
+        GpuProfiler_BeginFrame();
+
         // Definimos a cor do "fundo" do framebuffer como cor de céu (azul-acinzentado médio).
         //           R     G     B     A
         glClearColor(0.4f, 0.5f, 0.6f, 1.0f);
@@ -1386,105 +924,118 @@ printf("============================\n\n");
         // Pedimos para a GPU utilizar o programa de GPU criado acima (contendo os shaders de vértice e fragmentos).
         glUseProgram(g_GpuProgramID);
 
-        // Atualizamos a posição do jogador baseado no movimento
-        g_Player.UpdatePosition(delta_time);
-
-        // Atualizamos os vetores de direção do jogador
-        // IMPORTANTE: só no modo terceira pessoa!
-        // No modo primeira pessoa, o forward/right são atualizados no CursorPosCallback()
-        // com base nos ângulos da câmera, incluindo o pitch.
-        // Se chamarmos UpdateDirectionVectors() aqui, perdemos o componente Y do forward.
-        if (g_CameraMode == CAMERA_THIRD_PERSON)
+        // Avançamos a simulação (jogador, inimigos e waves) em ticks fixos,
+        // quantos couberem no tempo acumulado. Se um quadro muito lento deixar
+        // mais de SIMULATION_MAX_CATCHUP_TICKS pendentes, o excesso é
+        // descartado: o jogo fica mais lento por um instante em vez de gastar
+        // cada vez mais tempo simulando.
         {
-            g_Player.UpdateDirectionVectors();
-        }
+            const double tick_seconds = 1.0 / g_SimulationTickRate;
+            int ticks = 0;
+            while (g_SimulationAccumulator >= tick_seconds && ticks < SIMULATION_MAX_CATCHUP_TICKS)
+            {
+                // Cada tick simula o intervalo de tempo real que termina em
+                // current_time - (acumulador - tick_seconds), e recebe os
+                // eventos de entrada que chegaram até lá e ainda estão na
+                // fila (os da janela já foram aplicados pelo "late latching"
+                // do quadro anterior; sobram os de outras threads, como a
+                // entrada sintética de --input-latency)
+                ApplyInputEvents(window, current_time - g_SimulationAccumulator + tick_seconds, false);
+
+                // A entrada do tick vem do replay ou do jogador; as ações
+                // pontuais entram na primeira vez em que são lidas
+                SimulationAction action = g_PlayerInput;
+                action.buttons |= g_PendingButtons;
+                g_PendingButtons = 0;
+
+                if (g_Replaying && !Replay_GetAction(g_World, &action))
+                {
+                    printf("Fim do replay no tick %u.\n", g_World.tick);
+                    g_Replaying = false;
+                    Replay_Close();
+                    action = g_PlayerInput;
+                }
+                Replay_RecordTick(g_World, action);
 
-        // Atualizamos o cooldown de tiro
-        if (g_Player.shoot_cooldown > 0.0f)
-        {
-            g_Player.shoot_cooldown -= delta_time;
-            if (g_Player.shoot_cooldown < 0.0f)
-                g_Player.shoot_cooldown = 0.0f;
+                Simulation_ApplyAction(g_World, action);
+                Simulation_Step(g_World, (float)tick_seconds);
+                g_SimulationAccumulator -= tick_seconds;
+                ticks += 1;
+
+                // Durante o replay, a câmera segue a gravada e os eventos são
+                // conferidos com os gravados
+                if (g_Replaying)
+                {
+                    Replay_CheckEvents(g_World);
+                    g_PlayerInput = action;
+                    g_PlayerInput.buttons &= ~(SIMULATION_ACTION_SHOOT | SIMULATION_ACTION_RELOAD | SIMULATION_ACTION_ENEMY_RAYCASTS);
+                }
+            }
+            if (g_SimulationAccumulator >= tick_seconds)
+                g_SimulationAccumulator = std::fmod(g_SimulationAccumulator, tick_seconds);
+
+            // Renderizamos entre o tick anterior e o atual, na fração do
+            // próximo tick que já passou
+            g_RenderAlpha = (float)(g_SimulationAccumulator / tick_seconds);
+
+            UpdateHudEvents();
+            EventBus_LogEvents(g_World.events, g_LogEvents);
         }
+        glm::vec4 player_render_position = g_World.player.GetInterpolatedPosition(g_RenderAlpha);
 
-        // Atualizamos o tempo de reload
-        if (g_Player.is_reloading)
+        // Passes de sombra. O mapa estático (chão + caixas) só é re-renderizado
+        // quando as caixas mudam; o dinâmico (jogador + inimigos) a cada quadro.
+        if (g_UseShadows)
         {
-            g_Player.reload_time -= delta_time;
-            if (g_Player.reload_time <= 0.0f)
-            {
-                // Recarregamento completo - recarrega o carregador
-                g_Player.magazine_ammo = g_Player.magazine_size;
-                g_Player.is_reloading = false;
-                g_Player.reload_time = 0.0f;
-            }
+            CPU_PROFILE_ZONE("render_shadows");
+
+            if (g_StaticShadowMapDirty)
+                RenderStaticShadowMap();
+
+            RenderDynamicShadowMap(player_render_position);
+
+            // Os passes de sombra alteram o framebuffer e o viewport; restauramos
+            // os da janela antes de desenhar a cena.
+            int framebuffer_width, framebuffer_height;
+            GetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+            glViewport(0, 0, framebuffer_width, framebuffer_height);
         }
 
-        // Atualizamos todos os inimigos (apenas os vivos)
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_real_distribution<float> prob_dist(0.0f, 1.0f);
-        
-        for (size_t i = 0; i < g_Enemies.size(); ++i)
+        // "Late latching": logo antes de calcular a câmera verificamos com o
+        // sistema operacional se houve alguma interação do usuário (teclado,
+        // mouse, ...), a única vez no quadro. Caso positivo, as funções de
+        // callback definidas anteriormente usando glfwSet*Callback() serão
+        // chamadas pela biblioteca GLFW e colocarão os eventos na fila de
+        // entrada, que aplicamos aqui: a câmera responde ao mouse já neste
+        // quadro. Sem as ações pontuais, Simulation_ApplyAction() só altera o
+        // que o próximo tick vai sobrescrever, então a simulação não muda; as
+        // teclas e os botões aplicados aqui entram no próximo tick.
         {
-            auto& enemy = g_Enemies[i];
-            if (enemy.IsDead())
-                continue;
-            
-            enemy.UpdatePosition(delta_time);
-            enemy.UpdateDirectionVectors();
-            
-            // Atualiza o cooldown de tiro
-            if (enemy.shoot_cooldown > 0.0f)
-            {
-                enemy.shoot_cooldown -= delta_time;
-                if (enemy.shoot_cooldown < 0.0f)
-                    enemy.shoot_cooldown = 0.0f;
-            }
-            
-            // Atualiza o timer de verificação de probabilidade
-            enemy.shoot_probability_check_timer += delta_time;
-            
-            // Verifica probabilidade de tiro a cada 1 segundo
-            if (enemy.shoot_probability_check_timer >= 1.0f)
+            CPU_PROFILE_ZONE("input_latch");
+            if (window)
             {
-                // Reseta o timer
-                enemy.shoot_probability_check_timer = 0.0f;
-                
-                // Verifica se pode atirar (cooldown acabou)
-                if (enemy.shoot_cooldown <= 0.0f)
-                {
-                    // Gera um número aleatório entre 0 e 1
-                    float random_value = prob_dist(gen);
-                    
-                    // Se o valor aleatório for menor que a probabilidade, o inimigo atira
-                    if (random_value < enemy.shoot_probability)
-                    {
-                        // Inimigo atira
-                        EnemyToPlayerRaycast(i);
-                        // Inicia o cooldown
-                        enemy.shoot_cooldown = enemy.shoot_cooldown_time;
-                    }
-                }
+                CPU_PROFILE_ZONE("glfwPollEvents");
+                glfwPollEvents();
             }
+            ApplyInputEvents(window, GetTime(), true);
+            Simulation_ApplyAction(g_World, g_PlayerInput);
         }
 
-        // Atualizamos o status das waves (verifica se estão completas)
-        UpdateWaves(delta_time);
-
-
         glm::vec4 camera_position_c;
         glm::vec4 camera_lookat_l;
 
-        if (g_CameraMode == CAMERA_THIRD_PERSON)
+        if (g_World.camera_mode == CAMERA_THIRD_PERSON)
         {
-            camera_position_c = g_Player.GetThirdPersonCameraPosition();
-            camera_lookat_l   = g_Player.GetCameraLookAt();
+            // A câmera acompanha a posição interpolada do jogador; a orientação
+            // vem direto do mouse, sem esperar o próximo tick
+            glm::vec4 interpolation_offset = player_render_position - g_World.player.position;
+            camera_position_c = g_World.player.GetThirdPersonCameraPosition() + interpolation_offset;
+            camera_lookat_l   = g_World.player.GetCameraLookAt() + interpolation_offset;
         }
         else
         {
-            camera_position_c = g_Player.position + glm::vec4(0.0f, 1.5f, 0.0f, 0.0f); // na cabeça
-            camera_lookat_l   = camera_position_c + g_Player.forward_vector; // segue a direção do olhar
+            camera_position_c = player_render_position + glm::vec4(0.0f, 1.5f, 0.0f, 0.0f); // na cabeça
+            camera_lookat_l   = camera_position_c + g_World.player.forward_vector; // segue a direção do olhar
         }
 
         glm::vec4 camera_view_vector = camera_lookat_l - camera_position_c; // Vetor "view", sentido para onde a câmera está virada
@@ -1503,7 +1054,7 @@ printf("============================\n\n");
 
         if (g_UsePerspectiveProjection)
         {
-            if (g_CameraMode == CAMERA_FIRST_PERSON)
+            if (g_World.camera_mode == CAMERA_FIRST_PERSON)
                 projection = Matrix_Perspective(g_FirstPersonFOV, g_ScreenRatio, nearplane, farplane);
             else
                 projection = Matrix_Perspective(3.141592f / 3.0f, g_ScreenRatio, nearplane, farplane);
@@ -1523,228 +1074,238 @@ printf("============================\n\n");
         glUniformMatrix4fv(g_view_uniform       , 1 , GL_FALSE , glm::value_ptr(view));
         glUniformMatrix4fv(g_projection_uniform , 1 , GL_FALSE , glm::value_ptr(projection));
 
+        // Enviamos as matrizes da luz usadas para amostrar os shadow maps
+        glUniformMatrix4fv(g_light_view_projection_static_uniform  , 1 , GL_FALSE , glm::value_ptr(g_StaticShadowMap.light_view_projection));
+        glUniformMatrix4fv(g_light_view_projection_dynamic_uniform , 1 , GL_FALSE , glm::value_ptr(g_DynamicShadowMap.light_view_projection));
+        glUniform1i(g_use_shadows_uniform, g_UseShadows ? 1 : 0);
+
         #define PLANE  0
         #define PLAYER 1
         #define ENEMY  2
         #define BOX    10
 
         // Desenhamos o plano do chão
-        model = Matrix_Translate(0.0f,-1.1f,0.0f);
-        glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, PLANE);
-        DrawVirtualObject("the_plane");
-
-        // Desenhamos as caixas/barrils
-        for (const auto& box : g_Boxes)
         {
-            model = Matrix_Translate(box.position.x, box.position.y, box.position.z);
-            model = model * Matrix_Rotate_Y(box.rotation_y);
-            model = model * Matrix_Scale(box.scale.x, box.scale.y, box.scale.z);
+            CPU_PROFILE_ZONE("render_ground");
+            GpuProfiler_BeginPass("ground");
+            model = Matrix_Translate(0.0f,-1.1f,0.0f);
             glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, BOX); // Usa shader específico para caixas (cor marrom)
-            DrawVirtualObject("the_cube");
+            glUniform1i(g_object_id_uniform, PLANE);
+            DrawVirtualObject("the_plane");
         }
 
-        if (g_CameraMode == CAMERA_THIRD_PERSON)
+        // Desenhamos as caixas/barrils (chunks visíveis da geometria assada)
         {
-            // Desenhamos o jogador APENAS se for câmera em terceira pessoa
-            // Calcula o centro do modelo (onde a hitbox está) para alinhar renderização com hitbox
-            const float player_scale = 0.3f;
-            glm::vec4 model_center_world = glm::vec4(
-                g_Player.position.x + g_Player.model_center.x * player_scale,
-                g_Player.position.y + g_Player.model_center.y * player_scale,
-                g_Player.position.z + g_Player.model_center.z * player_scale,
-                1.0f
-            );
-            // Renderiza no centro do modelo, depois translada para compensar o centro do modelo antes de escalar
-            model = Matrix_Translate(model_center_world.x, model_center_world.y, model_center_world.z);
-            model = model * Matrix_Rotate_Y(g_Player.rotation_y);
-            model = model * Matrix_Translate(-g_Player.model_center.x * player_scale, 
-                                            -g_Player.model_center.y * player_scale, 
-                                            -g_Player.model_center.z * player_scale);
-            // Escalamos um pouco para que o jogador seja visível
-            model = model * Matrix_Scale(0.3f, 0.3f, 0.3f);
-            glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, PLAYER);
-            for (const auto& obj : g_VirtualScene)
+            CPU_PROFILE_ZONE("render_crates");
+            GpuProfiler_BeginPass("crates");
+            DrawStaticBoxes(projection * view);
+        }
+
+        {
+            CPU_PROFILE_ZONE("render_player");
+            GpuProfiler_BeginPass("player");
+            if (g_World.camera_mode == CAMERA_THIRD_PERSON)
             {
-                // Desenhar apenas os objetos do cowboy
-                if (obj.first.rfind("cowboy_", 0) == 0)
+                // Desenhamos o jogador APENAS se for câmera em terceira pessoa
+                model = ComputePlayerModelMatrix();
+                glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+                glUniform1i(g_object_id_uniform, PLAYER);
+                for (const auto& obj : g_VirtualScene)
                 {
-                    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-                    DrawVirtualObject(obj.first.c_str());
+                    // Desenhar apenas os objetos do cowboy
+                    if (obj.first.rfind("cowboy_", 0) == 0)
+                    {
+                        glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+                        DrawVirtualObject(obj.first.c_str());
+                    }
                 }
             }
         }
 
         // Desenhamos todos os inimigos (apenas os vivos)
-        const float enemy_scale = 0.3f;
-        const float scale_y = 0.3f;
-        // Obtém os offsets do centro do modelo em coordenadas de modelo (calcula uma vez fora do loop)
-        SceneObject bandit_obj_render = g_VirtualScene["bandit"];
-        float center_x_render = (bandit_obj_render.bbox_min.x + bandit_obj_render.bbox_max.x) * 0.5f;
-        float center_z_render = (bandit_obj_render.bbox_min.z + bandit_obj_render.bbox_max.z) * 0.5f;
-        
-        for (const auto& enemy : g_Enemies)
         {
-            // Pula inimigos mortos - eles não devem ser renderizados
-            if (enemy.IsDead())
-                continue;
+            CPU_PROFILE_ZONE("render_enemies");
+            GpuProfiler_BeginPass("enemies");
+            // Obtém os offsets do centro do modelo em coordenadas de modelo (calcula uma vez fora do loop)
+            SceneObject bandit_obj_render = g_VirtualScene["bandit"];
+            float center_x_render = (bandit_obj_render.bbox_min.x + bandit_obj_render.bbox_max.x) * 0.5f;
+            float center_z_render = (bandit_obj_render.bbox_min.z + bandit_obj_render.bbox_max.z) * 0.5f;
 
-            // Calcula o centro do modelo (onde a hitbox está) para alinhar renderização com hitbox
-            glm::vec4 model_center_world = glm::vec4(
-                enemy.position.x + center_x_render * enemy_scale,
-                enemy.position.y + g_BanditCenterModel.y * scale_y,
-                enemy.position.z + center_z_render * enemy_scale,
-                1.0f
-            );
-            // Renderiza no centro do modelo, depois translada para compensar o centro do modelo antes de escalar
-            model = Matrix_Translate(model_center_world.x, model_center_world.y, model_center_world.z);
-            model = model * Matrix_Rotate_Y(-enemy.rotation_y);
-            model = model * Matrix_Translate(-center_x_render * enemy_scale, 
-                                            -g_BanditCenterModel.y * scale_y, 
-                                            -center_z_render * enemy_scale);
-            model = model * Matrix_Scale(0.3f, scale_y, 0.3f);
-            glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, ENEMY);
-            for (const auto& obj : g_VirtualScene)
+            for (size_t i = 0; i < g_World.enemies.size(); ++i)
             {
-                // Desenhar apenas os objetos do inimigo
-                if (obj.first.rfind("bandit_", 0) == 0)
+                model = ComputeEnemyModelMatrix(i, center_x_render, center_z_render);
+                glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+                glUniform1i(g_object_id_uniform, ENEMY);
+                for (const auto& obj : g_VirtualScene)
                 {
-                    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-                    DrawVirtualObject(obj.first.c_str());
+                    // Desenhar apenas os objetos do inimigo
+                    if (obj.first.rfind("bandit_", 0) == 0)
+                    {
+                        glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+                        DrawVirtualObject(obj.first.c_str());
+                    }
                 }
             }
         }
 
         // Desenhamos as hitboxes dos inimigos (apenas para inimigos vivos)
-        const float entity_radius = 0.3f; // Raio da hitbox (mesmo usado na detecção de colisão)
-        // enemy_scale e scale_y já foram declarados acima, reutilizamos
-        const float ground_y = -1.1f;
-        
-        // Obtém os offsets do centro do modelo em coordenadas de modelo
-        SceneObject bandit_obj = g_VirtualScene["bandit"];
-        float center_x = (bandit_obj.bbox_min.x + bandit_obj.bbox_max.x) * 0.5f;
-        float center_z = (bandit_obj.bbox_min.z + bandit_obj.bbox_max.z) * 0.5f;
-        float model_height = bandit_obj.bbox_max.y - bandit_obj.bbox_min.y;
-        
-        for (const auto& enemy : g_Enemies)
         {
-            if (enemy.IsDead())
-                continue;
-            
-            // O modelo é renderizado com: Translate(enemy.position) * RotateY * Scale(enemy_scale, scale_y, enemy_scale)
-            // enemy.position tem offset -center_x*enemy_scale para X e -center_z*enemy_scale para Z
-            // Após a transformação, o centro do modelo em world space é:
-            // X: enemy.position.x + center_x*enemy_scale = -center_x*enemy_scale + center_x*enemy_scale = 0 (relativo ao spawn)
-            // Mas enemy.position.x já inclui a posição de spawn, então o centro X é enemy.position.x + center_x*enemy_scale
-            // Na verdade, como enemy.position.x = spawn_x - center_x*enemy_scale, o centro X é spawn_x
-            // Então o centro absoluto é:
-            glm::vec4 hitbox_center = glm::vec4(
-                enemy.position.x + center_x * enemy_scale,  // X: posição de spawn (cancelando offset)
-                enemy.position.y + g_BanditCenterModel.y * scale_y,  // Y: base + metade da altura escalada
-                enemy.position.z + center_z * enemy_scale,  // Z: posição de spawn (cancelando offset)
-                1.0f
-            );
-            
-            // Ajusta Y para garantir que a hitbox fique acima do chão
-            // O bottom da hitbox deve estar no mínimo no nível do chão
-            float hitbox_bottom = hitbox_center.y - entity_radius;
-            if (hitbox_bottom < ground_y)
-            {
-                // Move a hitbox para cima para que o bottom fique no chão
-                hitbox_center.y = ground_y + entity_radius;
-            }
-            
-            DrawEnemyHitbox(hitbox_center, entity_radius, view, projection);
-        }
-
-        // Desenhamos a hitbox do jogador
-        {
-            const float player_entity_radius = 0.3f; // Raio da hitbox (mesmo usado na detecção de colisão)
-            const float player_scale = 0.3f;
+            CPU_PROFILE_ZONE("render_debug_lines");
+            GpuProfiler_BeginPass("debug_lines");
+            const float entity_radius = 0.3f; // Raio da hitbox (mesmo usado na detecção de colisão)
+            const float enemy_scale = 0.3f;
+            const float scale_y = 0.3f;
             const float ground_y = -1.1f;
-            
+
             // Obtém os offsets do centro do modelo em coordenadas de modelo
-            SceneObject cowboy_obj = g_VirtualScene["cowboy"];
-            float center_x = (cowboy_obj.bbox_min.x + cowboy_obj.bbox_max.x) * 0.5f;
-            float center_z = (cowboy_obj.bbox_min.z + cowboy_obj.bbox_max.z) * 0.5f;
-            
-            // Calcula o centro da hitbox do jogador em world space
-            // O jogador é renderizado com: Translate(g_Player.position) * RotateY * Scale(0.3f, 0.3f, 0.3f)
-            // O centro do modelo após transformação é:
-            glm::vec4 player_hitbox_center = glm::vec4(
-                g_Player.position.x + g_Player.model_center.x * player_scale,  // X: posição + offset do centro
-                g_Player.position.y + g_Player.model_center.y * player_scale,  // Y: posição + offset do centro
-                g_Player.position.z + g_Player.model_center.z * player_scale,  // Z: posição + offset do centro
-                1.0f
-            );
-            
-            // Ajusta Y para garantir que a hitbox fique acima do chão
-            float hitbox_bottom = player_hitbox_center.y - player_entity_radius;
-            if (hitbox_bottom < ground_y)
+            SceneObject bandit_obj = g_VirtualScene["bandit"];
+            float center_x = (bandit_obj.bbox_min.x + bandit_obj.bbox_max.x) * 0.5f;
+            float center_z = (bandit_obj.bbox_min.z + bandit_obj.bbox_max.z) * 0.5f;
+            float model_height = bandit_obj.bbox_max.y - bandit_obj.bbox_min.y;
+
+            for (size_t i = 0; i < g_World.enemies.size(); ++i)
             {
-                // Move a hitbox para cima para que o bottom fique no chão
-                player_hitbox_center.y = ground_y + player_entity_radius;
+                // O modelo é renderizado com: Translate(Simulation_EnemyPosition()) * RotateY * Scale(enemy_scale, scale_y, enemy_scale)
+                // Simulation_EnemyPosition() tem offset -center_x*enemy_scale para X e -center_z*enemy_scale para Z
+                // Após a transformação, o centro do modelo em world space é:
+                // X: Simulation_EnemyPosition().x + center_x*enemy_scale = -center_x*enemy_scale + center_x*enemy_scale = 0 (relativo ao spawn)
+                // Mas Simulation_EnemyPosition().x já inclui a posição de spawn, então o centro X é Simulation_EnemyPosition().x + center_x*enemy_scale
+                // Na verdade, como Simulation_EnemyPosition().x = spawn_x - center_x*enemy_scale, o centro X é spawn_x
+                // Então o centro absoluto é:
+                glm::vec4 enemy_position = Simulation_EnemyInterpolatedPosition(g_World, i, g_RenderAlpha);
+                glm::vec4 hitbox_center = glm::vec4(
+                    enemy_position.x + center_x * enemy_scale,  // X: posição de spawn (cancelando offset)
+                    enemy_position.y + g_BanditCenterModel.y * scale_y,  // Y: base + metade da altura escalada
+                    enemy_position.z + center_z * enemy_scale,  // Z: posição de spawn (cancelando offset)
+                    1.0f
+                );
+
+                // Ajusta Y para garantir que a hitbox fique acima do chão
+                // O bottom da hitbox deve estar no mínimo no nível do chão
+                float hitbox_bottom = hitbox_center.y - entity_radius;
+                if (hitbox_bottom < ground_y)
+                {
+                    // Move a hitbox para cima para que o bottom fique no chão
+                    hitbox_center.y = ground_y + entity_radius;
+                }
+
+                DrawEnemyHitbox(hitbox_center, entity_radius, view, projection);
             }
-            
-            DrawPlayerHitbox(player_hitbox_center, player_entity_radius, view, projection);
-        }
 
-        // Desenha linhas amarelas dos raycasts de todos os inimigos
-        const float g_EnemyRaycastDuration = 3.0f; // Duração em segundos que a linha fica visível
-        
-        for (auto& enemy : g_Enemies)
-        {
-            if (enemy.IsDead())
-                continue;
-            
-            if (enemy.draw_raycast)
+            // Desenhamos a hitbox do jogador
             {
-                float elapsed_time = current_time - enemy.raycast_time;
-
-                if (elapsed_time < g_EnemyRaycastDuration)
+                const float player_entity_radius = 0.3f; // Raio da hitbox (mesmo usado na detecção de colisão)
+                const float player_scale = 0.3f;
+                const float ground_y = -1.1f;
+
+                // Obtém os offsets do centro do modelo em coordenadas de modelo
+                SceneObject cowboy_obj = g_VirtualScene["cowboy"];
+                float center_x = (cowboy_obj.bbox_min.x + cowboy_obj.bbox_max.x) * 0.5f;
+                float center_z = (cowboy_obj.bbox_min.z + cowboy_obj.bbox_max.z) * 0.5f;
+
+                // Calcula o centro da hitbox do jogador em world space
+                // O jogador é renderizado com: Translate(g_World.player.position) * RotateY * Scale(0.3f, 0.3f, 0.3f)
+                // O centro do modelo após transformação é:
+                glm::vec4 player_hitbox_center = glm::vec4(
+                    player_render_position.x + g_World.player.model_center.x * player_scale,  // X: posição + offset do centro
+                    player_render_position.y + g_World.player.model_center.y * player_scale,  // Y: posição + offset do centro
+                    player_render_position.z + g_World.player.model_center.z * player_scale,  // Z: posição + offset do centro
+                    1.0f
+                );
+
+                // Ajusta Y para garantir que a hitbox fique acima do chão
+                float hitbox_bottom = player_hitbox_center.y - player_entity_radius;
+                if (hitbox_bottom < ground_y)
                 {
-                    DrawRaycastLine(enemy.raycast_start, enemy.raycast_end, view, projection);
+                    // Move a hitbox para cima para que o bottom fique no chão
+                    player_hitbox_center.y = ground_y + player_entity_radius;
                 }
-                else
+
+                DrawPlayerHitbox(player_hitbox_center, player_entity_radius, view, projection);
+            }
+
+            // Desenha linhas amarelas dos raycasts de todos os inimigos
+            const float g_EnemyRaycastDuration = 3.0f; // Duração em segundos que a linha fica visível
+
+            for (auto& raycast : g_World.enemy_raycasts)
+            {
+                if (raycast.draw)
                 {
-                    // Desativa o desenho após 3 segundos
-                    enemy.draw_raycast = false;
+                    float elapsed_time = (float)(g_World.time - raycast.time);
+
+                    if (elapsed_time < g_EnemyRaycastDuration)
+                    {
+                        DrawRaycastLine(raycast.start, raycast.end, view, projection);
+                    }
+                    else
+                    {
+                        // Desativa o desenho após 3 segundos
+                        raycast.draw = false;
+                    }
                 }
             }
-        }
 
-        // Desenha splines Bezier para cada inimigo
-        for (const auto& enemy : g_Enemies)
-        {
-            if (enemy.IsDead())
-                continue;
-            
-            DrawBezierSpline(enemy.spawn_position, enemy.bezier_p1, enemy.bezier_p2, enemy.destination, view, projection);
+            // Desenha splines Bezier para cada inimigo
+            const EnemyPaths& paths = g_World.enemy_paths;
+            for (size_t i = 0; i < g_World.enemies.size(); ++i)
+            {
+                float y = paths.y[i];
+                DrawBezierSpline(glm::vec4(paths.p0_x[i], y, paths.p0_z[i], 1.0f),
+                                 glm::vec4(paths.p1_x[i], y, paths.p1_z[i], 1.0f),
+                                 glm::vec4(paths.p2_x[i], y, paths.p2_z[i], 1.0f),
+                                 glm::vec4(paths.p3_x[i], y, paths.p3_z[i], 1.0f),
+                                 view, projection);
+            }
         }
 
         // Desenhamos as barras de vida dos inimigos (apenas para inimigos vivos)
-        for (const auto& enemy : g_Enemies)
         {
-            if (enemy.IsDead())
-                continue;
-            DrawHealthBar(window, enemy.position, enemy.health, enemy.max_health, view, projection);
-        }
+            CPU_PROFILE_ZONE("render_overlays");
+            GpuProfiler_BeginPass("overlays");
+            for (size_t i = 0; i < g_World.enemies.size(); ++i)
+            {
+                const Enemy& enemy = g_World.enemies[i];
+                DrawHealthBar(window, Simulation_EnemyInterpolatedPosition(g_World, i, g_RenderAlpha), enemy.health, enemy.max_health, view, projection);
+            }
 
-        // Desenhamos o crosshair no centro da tela
-        DrawCrosshair(window);
+            // Desenhamos o crosshair no centro da tela
+            DrawCrosshair(window);
+        }
 
         // Desenhamos o HUD com HP e munição
         DrawHUD(window);
 
         // Imprimimos na informação sobre a matriz de projeção sendo utilizada.
-        TextRendering_ShowProjection(window);
+        {
+            CPU_PROFILE_ZONE("render_text");
+            GpuProfiler_BeginPass("text");
+            TextRendering_ShowProjection(window);
+
+            // Imprimimos na tela informação sobre o número de quadros renderizados
+            // por segundo (frames per second).
+            TextRendering_ShowFramesPerSecond(window);
+
+            // Imprimimos na tela quantos bytes de geometria dinâmica foram enviados
+            TextRendering_ShowStreamBufferStats(window);
+
+            // Imprimimos na tela quantos chunks de caixas passaram pelo frustum culling
+            TextRendering_ShowStaticChunkStats(window);
+
+            // Imprimimos na tela a tabela de tempos de GPU por pass
+            TextRendering_ShowGpuProfiler(window);
+
+            // Desenhamos o gráfico de tempo de quadro e a tabela de zonas do
+            // profiler de CPU
+            DrawCpuFrameTimeGraph(window);
+            TextRendering_ShowCpuProfiler(window);
+            GpuProfiler_EndPass();
+        }
+
+        // Fim do quadro no profiler de GPU
+        GpuProfiler_EndFrame();
 
-        // Imprimimos na tela informação sobre o número de quadros renderizados
-        // por segundo (frames per second).
-        TextRendering_ShowFramesPerSecond(window);
+        // Fim do quadro no stream buffer (insere o fence da região corrente)
+        StreamBuffer_EndFrame();
 
         // O framebuffer onde OpenGL executa as operações de renderização não
         // é o mesmo que está sendo mostrado para o usuário, caso contrário
@@ -1752,17 +1313,76 @@ printf("============================\n\n");
         // chamada abaixo faz a troca dos buffers, mostrando para o usuário
         // tudo que foi renderizado pelas funções acima.
         // Veja o link: https://en.wikipedia.org/w/index.php?title=Multiple_buffering&oldid=793452829#Double_buffering_in_computer_graphics
-        glfwSwapBuffers(window);
+        //
+        // No modo headless não há buffers para trocar nem eventos; apenas
+        // enviamos os comandos do quadro para o driver.
+        if (!window)
+        {
+            CPU_PROFILE_ZONE("glFlush");
+            glFlush();
+        }
+        else
+        {
+            CPU_PROFILE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+
+        // Medindo a latência, esperamos a GPU terminar o quadro (com a troca
+        // de buffers) e contamos a partir do movimento mais antigo e do mais
+        // recente que ele mostra
+        if (g_MeasureInputLatency)
+        {
+            glFinish();
+            if (g_OldestInputTime >= 0.0)
+            {
+                double present_time = GetTime();
+                g_InputLatencies.push_back(present_time - g_OldestInputTime);
+                g_LatchedInputLatencies.push_back(present_time - g_NewestInputTime);
+                g_OldestInputTime = -1.0;
+                g_NewestInputTime = -1.0;
+            }
+        }
+
+        // Fim do quadro no profiler de CPU
+        CPU_PROFILE_END_FRAME();
+    }
 
-        // Verificamos com o sistema operacional se houve alguma interação do
-        // usuário (teclado, mouse, ...). Caso positivo, as funções de callback
-        // definidas anteriormente usando glfwSet*Callback() serão chamadas
-        // pela biblioteca GLFW.
-        glfwPollEvents();
+    InputQueue_StopSyntheticMouse();
+
+    // Resumo da execução, útil em benchmarks (modo headless ou --frames)
+    if (max_frames > 0)
+    {
+        double elapsed = GetTime() - loop_start_time;
+        printf("%d quadros em %.2f s (%.3f ms/quadro, %.1f fps)\n",
+               frame_count, elapsed, 1000.0 * elapsed / frame_count, frame_count / elapsed);
+    }
+
+    if (g_MeasureInputLatency)
+    {
+        printf("Entrada: %d eventos aplicados, %d só no late latching, %d descartados (fila cheia).\n",
+               g_InputEventsApplied, g_InputEventsLatched, InputQueue_DroppedEvents());
+        PrintInputLatencies("Latência entrada-apresentação (movimento mais antigo do quadro)", g_InputLatencies);
+        PrintInputLatencies("Latência entrada-apresentação (movimento mais recente do quadro)", g_LatchedInputLatencies);
+    }
+
+    if (screenshot_filename)
+    {
+        if (window)
+            fprintf(stderr, "WARNING: --screenshot só é suportado no modo headless.\n");
+        else
+            Headless_SaveScreenshot(screenshot_filename);
     }
 
+    // Terminamos a gravação do replay, se houver
+    Replay_EndRecording();
+    JobSystem_Terminate();
+    Logger_Terminate();
+
     // Finalizamos o uso dos recursos do sistema operacional
-    glfwTerminate();
+    if (window)
+        glfwTerminate();
+    else
+        Headless_Terminate();
 
     // Fim do programa
     return 0;
@@ -1771,6 +1391,7 @@ printf("============================\n\n");
 // Função que carrega uma imagem para ser utilizada como textura
 GLuint LoadTextureImage(const char* filename)
 {
+    CPU_PROFILE_ZONE_TEXT("LoadTextureImage", filename);
     printf("Carregando imagem \"%s\"... ", filename);
 
     // Primeiro fazemos a leitura da imagem do disco
@@ -1881,9 +1502,197 @@ void DrawVirtualObject(const char* object_name)
         (void*)(g_VirtualScene[object_name].first_index * sizeof(GLuint))
     );
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
-    glBindVertexArray(0);
+    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
+    // alterar o mesmo. Isso evita bugs.
+    glBindVertexArray(0);
+}
+
+// Desenha apenas a geometria de um objeto de g_VirtualScene, sem texturas nem
+// uniforms de material. Usada nos passes de shadow map, onde só a
+// profundidade importa.
+void DrawVirtualObjectDepth(const char* object_name)
+{
+    const SceneObject& obj = g_VirtualScene[object_name];
+
+    glBindVertexArray(obj.vertex_array_object_id);
+    glDrawElements(
+        obj.rendering_mode,
+        obj.num_indices,
+        GL_UNSIGNED_INT,
+        (void*)(obj.first_index * sizeof(GLuint))
+    );
+    glBindVertexArray(0);
+}
+
+// Cria um shadow map: uma textura de profundidade com comparação habilitada
+// (amostrada como sampler2DShadow, com filtragem bilinear do resultado da
+// comparação) e um framebuffer que a usa como único anexo.
+static void CreateShadowMap(ShadowMap& shadow_map, int size, GLuint texture_unit)
+{
+    shadow_map.size = size;
+    shadow_map.light_view_projection = Matrix_Identity();
+
+    // Cada shadow map fica permanentemente ligado à sua unidade de textura.
+    // Removemos qualquer sampler object da unidade, já que ele sobrescreveria
+    // os parâmetros de comparação definidos abaixo.
+    glActiveTexture(GL_TEXTURE0 + texture_unit);
+    glBindSampler(texture_unit, 0);
+
+    glGenTextures(1, &shadow_map.depth_texture_id);
+    glBindTexture(GL_TEXTURE_2D, shadow_map.depth_texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glGenFramebuffers(1, &shadow_map.framebuffer_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, shadow_map.framebuffer_id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadow_map.depth_texture_id, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    if ( glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE )
+    {
+        fprintf(stderr, "ERROR: Shadow map framebuffer (%dx%d) incompleto.\n", size, size);
+        std::exit(EXIT_FAILURE);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, g_DefaultFramebuffer);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void CreateShadowMaps()
+{
+    // O mapa estático cobre o mapa inteiro (MAP_MIN/MAX), então precisa de
+    // mais resolução; o dinâmico cobre apenas uma região ao redor do jogador.
+    CreateShadowMap(g_StaticShadowMap, 2048, SHADOW_MAP_STATIC_UNIT);
+    CreateShadowMap(g_DynamicShadowMap, 1024, SHADOW_MAP_DYNAMIC_UNIT);
+}
+
+// Calcula a matriz projection*view de uma luz direcional cobrindo um quadrado
+// de lado 2*half_extent centrado em center. O centro é alinhado à grade de
+// texels do mapa para que as bordas das sombras não "tremam" quando ele se move.
+static glm::mat4 ComputeLightViewProjection(glm::vec4 center, float half_extent, int size)
+{
+    // Mesma direção da luz usada em "shader_fragment.glsl"
+    const glm::vec4 light_direction = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f) / sqrtf(2.0f);
+    const glm::vec4 up_vector = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+    const float light_distance = 40.0f;
+
+    // Eixos u e v do plano da imagem da luz (mesma construção de Matrix_Camera_View)
+    glm::vec4 w = light_direction;
+    glm::vec4 u = crossproduct(up_vector, w) / norm(crossproduct(up_vector, w));
+    glm::vec4 v = crossproduct(w, u);
+
+    // dotproduct() só aceita vetores (w = 0), então projetamos center - origem
+    float texel_size = 2.0f * half_extent / size;
+    glm::vec4 center_vector = glm::vec4(center.x, center.y, center.z, 0.0f);
+    float center_u = dotproduct(center_vector, u);
+    float center_v = dotproduct(center_vector, v);
+    center += u * (floorf(center_u / texel_size) * texel_size - center_u);
+    center += v * (floorf(center_v / texel_size) * texel_size - center_v);
+    center.w = 1.0f;
+
+    glm::vec4 light_position = center + light_direction * light_distance;
+    glm::mat4 view = Matrix_Camera_View(light_position, -light_direction, up_vector);
+    glm::mat4 projection = Matrix_Orthographic(-half_extent, half_extent, -half_extent, half_extent,
+                                               -1.0f, -2.0f * light_distance);
+    return projection * view;
+}
+
+// Prepara o estado de OpenGL para renderizar no shadow map dado
+static void BeginShadowPass(const ShadowMap& shadow_map)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, shadow_map.framebuffer_id);
+    glViewport(0, 0, shadow_map.size, shadow_map.size);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(g_ShadowProgramID);
+    glUniformMatrix4fv(g_shadow_light_view_projection_uniform, 1, GL_FALSE, glm::value_ptr(shadow_map.light_view_projection));
+
+    // Empurramos a profundidade para longe da luz, reduzindo "shadow acne"
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+}
+
+static void EndShadowPass()
+{
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_DefaultFramebuffer);
+}
+
+void RenderStaticShadowMap()
+{
+    // Mapa inteiro, mais uma margem para as caixas nas bordas
+    const float half_extent = MAP_MAX_X + 2.0f;
+    g_StaticShadowMap.light_view_projection = ComputeLightViewProjection(
+        glm::vec4(0.0f, -1.1f, 0.0f, 1.0f), half_extent, g_StaticShadowMap.size);
+
+    GpuProfiler_BeginPass("shadow_static");
+    BeginShadowPass(g_StaticShadowMap);
+
+    glm::mat4 model = Matrix_Translate(0.0f,-1.1f,0.0f);
+    glUniformMatrix4fv(g_shadow_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+    DrawVirtualObjectDepth("the_plane");
+
+    DrawStaticBoxesDepth();
+
+    EndShadowPass();
+    GpuProfiler_EndPass();
+
+    g_StaticShadowMapDirty = false;
+}
+
+void RenderDynamicShadowMap(glm::vec4 center)
+{
+    // Lista (cacheada) dos objetos que compõem os modelos do jogador e do
+    // inimigo, evitando percorrer g_VirtualScene inteiro a cada quadro.
+    static std::vector<std::string> cowboy_parts;
+    static std::vector<std::string> bandit_parts;
+    if (cowboy_parts.empty() && bandit_parts.empty())
+    {
+        for (const auto& obj : g_VirtualScene)
+        {
+            if (obj.first.rfind("cowboy_", 0) == 0)
+                cowboy_parts.push_back(obj.first);
+            else if (obj.first.rfind("bandit_", 0) == 0)
+                bandit_parts.push_back(obj.first);
+        }
+    }
+
+    GpuProfiler_BeginPass("shadow_dynamic");
+
+    g_DynamicShadowMap.light_view_projection = ComputeLightViewProjection(
+        glm::vec4(center.x, -1.1f, center.z, 1.0f), 12.0f, g_DynamicShadowMap.size);
+
+    BeginShadowPass(g_DynamicShadowMap);
+
+    // O jogador projeta sombra mesmo em primeira pessoa
+    glm::mat4 model = ComputePlayerModelMatrix();
+    glUniformMatrix4fv(g_shadow_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+    for (const auto& part : cowboy_parts)
+        DrawVirtualObjectDepth(part.c_str());
+
+    const SceneObject& bandit_obj = g_VirtualScene["bandit"];
+    float center_x = (bandit_obj.bbox_min.x + bandit_obj.bbox_max.x) * 0.5f;
+    float center_z = (bandit_obj.bbox_min.z + bandit_obj.bbox_max.z) * 0.5f;
+
+    for (size_t i = 0; i < g_World.enemies.size(); ++i)
+    {
+        model = ComputeEnemyModelMatrix(i, center_x, center_z);
+        glUniformMatrix4fv(g_shadow_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+        for (const auto& part : bandit_parts)
+            DrawVirtualObjectDepth(part.c_str());
+    }
+
+    EndShadowPass();
+    GpuProfiler_EndPass();
+
+    // O loop principal assume que o programa de renderização da cena está ativo
+    glUseProgram(g_GpuProgramID);
 }
 
 // Função que carrega os shaders de vértices e de fragmentos que serão
@@ -1934,7 +1743,25 @@ void LoadShadersFromFiles()
     glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage0"), 0);
     glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage1"), 1);
     glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage2"), 2);
+
+    // Shadow maps (veja CreateShadowMaps())
+    g_light_view_projection_static_uniform  = glGetUniformLocation(g_GpuProgramID, "light_view_projection_static");
+    g_light_view_projection_dynamic_uniform = glGetUniformLocation(g_GpuProgramID, "light_view_projection_dynamic");
+    g_use_shadows_uniform                   = glGetUniformLocation(g_GpuProgramID, "use_shadows");
+    glUniform1i(glGetUniformLocation(g_GpuProgramID, "ShadowMapStatic"), SHADOW_MAP_STATIC_UNIT);
+    glUniform1i(glGetUniformLocation(g_GpuProgramID, "ShadowMapDynamic"), SHADOW_MAP_DYNAMIC_UNIT);
     glUseProgram(0);
+
+    // Programa de GPU do passe de sombra, que apenas escreve profundidade
+    GLuint shadow_vertex_shader_id = LoadShader_Vertex("../../src/shader_shadow_vertex.glsl");
+    GLuint shadow_fragment_shader_id = LoadShader_Fragment("../../src/shader_shadow_fragment.glsl");
+
+    if ( g_ShadowProgramID != 0 )
+        glDeleteProgram(g_ShadowProgramID);
+
+    g_ShadowProgramID = CreateGpuProgram(shadow_vertex_shader_id, shadow_fragment_shader_id);
+    g_shadow_model_uniform                 = glGetUniformLocation(g_ShadowProgramID, "model");
+    g_shadow_light_view_projection_uniform = glGetUniformLocation(g_ShadowProgramID, "light_view_projection");
 }
 
 // Função que pega a matriz M e guarda a mesma no topo da pilha
@@ -1961,6 +1788,7 @@ void PopMatrix(glm::mat4& M)
 // especificadas dentro do arquivo ".obj"
 void ComputeNormals(ObjModel* model)
 {
+    CPU_PROFILE_ZONE("ComputeNormals");
     if ( !model->attrib.normals.empty() )
         return;
 
@@ -2078,6 +1906,7 @@ void ComputeNormals(ObjModel* model)
 // Constrói triângulos para futura renderização a partir de um ObjModel.
 void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
 {
+    CPU_PROFILE_ZONE("BuildTrianglesAndAddToVirtualScene");
     GLuint vertex_array_object_id;
     glGenVertexArrays(1, &vertex_array_object_id);
     glBindVertexArray(vertex_array_object_id);
@@ -2265,6 +2094,7 @@ GLuint LoadShader_Fragment(const char* filename)
 // um arquivo GLSL e faz sua compilação.
 void LoadShader(const char* filename, GLuint shader_id)
 {
+    CPU_PROFILE_ZONE_TEXT("LoadShader", filename);
     // Lemos o arquivo de texto indicado pela variável "filename"
     // e colocamos seu conteúdo em memória, apontado pela variável
     // "shader_string".
@@ -2335,6 +2165,7 @@ void LoadShader(const char* filename, GLuint shader_id)
 // Vertex Shader e um Fragment Shader.
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id)
 {
+    CPU_PROFILE_ZONE("CreateGpuProgram");
     // Criamos um identificador (ID) para este programa de GPU
     GLuint program_id = glCreateProgram();
 
@@ -2403,6 +2234,120 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
     g_ScreenRatio = (float)width / height;
 }
 
+double GetTime()
+{
+    return Headless_IsActive() ? Headless_GetTime() : glfwGetTime();
+}
+
+void GetFramebufferSize(GLFWwindow* window, int* width, int* height)
+{
+    if (window)
+        glfwGetFramebufferSize(window, width, height);
+    else
+        Headless_GetFramebufferSize(width, height);
+}
+
+// Callbacks da GLFW: guardamos o evento na fila de entrada (veja
+// "inputqueue.h"). A GLFW não informa quando o sistema operacional recebeu o
+// evento, então o instante guardado é o da chamada a glfwPollEvents() que o
+// entregou: a latência medida com --input-latency não inclui o tempo em que
+// o evento esperou por essa chamada (até um quadro).
+void QueueKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode)
+{
+    InputEvent event = {};
+    event.time = GetTime();
+    event.type = INPUT_EVENT_KEY;
+    event.key = key;
+    event.scancode = scancode;
+    event.action = action;
+    event.mods = mode;
+    InputQueue_Push(event);
+}
+
+void QueueMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    InputEvent event = {};
+    event.time = GetTime();
+    event.type = INPUT_EVENT_MOUSE_BUTTON;
+    event.key = button;
+    event.action = action;
+    event.mods = mods;
+    InputQueue_Push(event);
+}
+
+void QueueCursorPosCallback(GLFWwindow* window, double xpos, double ypos)
+{
+    InputEvent event = {};
+    event.time = GetTime();
+    event.type = INPUT_EVENT_CURSOR;
+    event.x = xpos;
+    event.y = ypos;
+    InputQueue_Push(event);
+}
+
+void QueueScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    InputEvent event = {};
+    event.time = GetTime();
+    event.type = INPUT_EVENT_SCROLL;
+    event.x = xoffset;
+    event.y = yoffset;
+    InputQueue_Push(event);
+}
+
+// Aplica, na ordem em que chegaram, os eventos da fila de entrada até
+// "max_time", chamando os callbacks abaixo. "latching" indica que os eventos
+// são aplicados logo antes de calcular a câmera, e não no início de um tick.
+void ApplyInputEvents(GLFWwindow* window, double max_time, bool latching)
+{
+    InputEvent event;
+    while (InputQueue_Pop(max_time, &event))
+    {
+        switch (event.type)
+        {
+            case INPUT_EVENT_KEY:
+                KeyCallback(window, event.key, event.scancode, event.action, event.mods);
+                break;
+            case INPUT_EVENT_MOUSE_BUTTON:
+                MouseButtonCallback(window, event.key, event.action, event.mods);
+                break;
+            case INPUT_EVENT_CURSOR:
+                CursorPosCallback(window, event.x, event.y);
+                break;
+            case INPUT_EVENT_SCROLL:
+                ScrollCallback(window, event.x, event.y);
+                break;
+        }
+
+        g_InputEventsApplied += 1;
+        if (latching)
+            g_InputEventsLatched += 1;
+
+        // A latência é medida pelos eventos que mexem na câmera
+        bool moves_camera = event.type == INPUT_EVENT_CURSOR || event.type == INPUT_EVENT_SCROLL;
+        if (moves_camera && (g_OldestInputTime < 0.0 || event.time < g_OldestInputTime))
+            g_OldestInputTime = event.time;
+        if (moves_camera && event.time > g_NewestInputTime)
+            g_NewestInputTime = event.time;
+    }
+}
+
+// Imprime média, mediana, percentil 95 e máximo das latências (em segundos)
+void PrintInputLatencies(const char* label, const std::vector<double>& latencies)
+{
+    if (latencies.empty())
+        return;
+
+    std::vector<double> sorted = latencies;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (size_t i = 0; i < sorted.size(); ++i)
+        sum += sorted[i];
+    printf("%s em %zu quadros: média %.2f ms, mediana %.2f ms, p95 %.2f ms, máx %.2f ms\n",
+           label, sorted.size(), 1000.0 * sum / sorted.size(), 1000.0 * sorted[sorted.size() / 2],
+           1000.0 * sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)], 1000.0 * sorted.back());
+}
+
 // Função callback chamada sempre que o usuário aperta algum dos botões do mouse
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
@@ -2417,55 +2362,18 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
         g_LeftMouseButtonPressed = true;
 
         // Debug: Print all player relevant fields
-        // printf("Player Magazine Ammo: %d\n", g_Player.magazine_ammo);
-        // printf("Player Shoot Cooldown: %f\n", g_Player.shoot_cooldown);
-        // printf("Player Is Reloading: %d\n", g_Player.is_reloading);
-        // printf("Player Reload Time: %f\n", g_Player.reload_time);
-        // printf("Player Reload Time Total: %f\n", g_Player.reload_time_total);
-        // printf("Player Health: %f\n", g_Player.health);
-        // printf("Player Max Health: %f\n", g_Player.max_health);
-        // printf("Player Magazine Size: %d\n", g_Player.magazine_size);
-
-        // Verifica se pode atirar (tem munição no carregador, não está em cooldown e não está recarregando)
-        if (g_Player.magazine_ammo > 0 && g_Player.shoot_cooldown <= 0.0f && !g_Player.is_reloading)
-        {
-            // Realiza raycast do centro da tela
-
-            glm::vec4 camera_position;
-            glm::vec4 camera_lookat;
-
-            if (g_CameraMode == CAMERA_THIRD_PERSON)
-            {
-                camera_position = g_Player.GetThirdPersonCameraPosition();
-                camera_lookat   = g_Player.GetCameraLookAt();
-            }
-            else // FIRST PERSON
-            {
-                // posição = cabeça do jogador
-                camera_position = g_Player.position + glm::vec4(0.0f, 1.5f, 0.0f, 0.0f);
-
-                // olha para onde o jogador está olhando
-                camera_lookat = camera_position + g_Player.forward_vector;
-            }
-
-            glm::vec4 camera_view_vector = camera_lookat - camera_position;
-
-            // Normaliza o vetor de direção da câmera
-            float view_length = sqrt(camera_view_vector.x * camera_view_vector.x +
-                                     camera_view_vector.y * camera_view_vector.y +
-                                     camera_view_vector.z * camera_view_vector.z);
-            if (view_length > 0.001f)
-            {
-                camera_view_vector.x /= view_length;
-                camera_view_vector.y /= view_length;
-                camera_view_vector.z /= view_length;
-                CameraRaycast(camera_position, camera_view_vector);
-
-                // Consome munição do carregador e inicia cooldown
-                g_Player.magazine_ammo--;
-                g_Player.shoot_cooldown = g_Player.shoot_cooldown_time;
-            }
-        }
+        // printf("Player Magazine Ammo: %d\n", g_World.player.magazine_ammo);
+        // printf("Player Shoot Cooldown: %f\n", g_World.player.shoot_cooldown);
+        // printf("Player Is Reloading: %d\n", g_World.player.is_reloading);
+        // printf("Player Reload Time: %f\n", g_World.player.reload_time);
+        // printf("Player Reload Time Total: %f\n", g_World.player.reload_time_total);
+        // printf("Player Health: %f\n", g_World.player.health);
+        // printf("Player Max Health: %f\n", g_World.player.max_health);
+        // printf("Player Magazine Size: %d\n", g_World.player.magazine_size);
+
+        // Atira do centro da tela no próximo tick (se tiver munição no
+        // carregador, não estiver em cooldown e não estiver recarregando)
+        g_PendingButtons |= SIMULATION_ACTION_SHOOT;
     }
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE)
     {
@@ -2523,51 +2431,39 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos)
     g_LastCursorPosX = xpos;
     g_LastCursorPosY = ypos;
 
-    if (g_CameraMode == CAMERA_THIRD_PERSON)
+    // Os ângulos vão para a entrada do jogador; Simulation_ApplyAction()
+    // recalcula a partir deles o forward_vector em primeira pessoa
+    if (g_PlayerInput.buttons & SIMULATION_ACTION_THIRD_PERSON)
     {
         float camera_sensitivity = 0.003f;
-        g_Player.camera_angle_horizontal -= dx * 0.002f;
-        g_Player.camera_angle_vertical   += dy * 0.002f;
+        g_PlayerInput.yaw   -= dx * 0.002f;
+        g_PlayerInput.pitch += dy * 0.002f;
 
         float vmax = 3.141592f/3.0f;
         float vmin = -0.15;
 
-        g_Player.camera_angle_vertical = glm::clamp(g_Player.camera_angle_vertical, vmin, vmax);
+        g_PlayerInput.pitch = glm::clamp(g_PlayerInput.pitch, vmin, vmax);
     }
-
-    if (g_CameraMode == CAMERA_FIRST_PERSON)
+    else
     {
         float sensitivity = 0.002f;
-        g_Player.camera_angle_horizontal -= dx * 0.002f;
-        g_Player.camera_angle_vertical   -= dy * 0.002f;
+        g_PlayerInput.yaw   -= dx * 0.002f;
+        g_PlayerInput.pitch -= dy * 0.002f;
 
         // limitar o ângulo vertical para não virar de cabeça pra baixo
         float limit = glm::radians(89.0f);
-        g_Player.camera_angle_vertical = glm::clamp(g_Player.camera_angle_vertical, -limit, limit);
-
-        // recalcular forward_vector
-        g_Player.forward_vector = glm::vec4(
-            cos(g_Player.camera_angle_vertical) * sin(g_Player.camera_angle_horizontal),
-            sin(g_Player.camera_angle_vertical),
-            cos(g_Player.camera_angle_vertical) * cos(g_Player.camera_angle_horizontal),
-            0.0f
-        );
-
-        g_Player.right_vector = glm::vec4(
-            cos(g_Player.camera_angle_horizontal), 0.0f,
-            -sin(g_Player.camera_angle_horizontal), 0.0f
-        );
+        g_PlayerInput.pitch = glm::clamp(g_PlayerInput.pitch, -limit, limit);
     }
 }
 
 // Função callback chamada sempre que o usuário movimenta a "rodinha" do mouse.
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    if (g_CameraMode == CAMERA_THIRD_PERSON)
+    if (g_PlayerInput.buttons & SIMULATION_ACTION_THIRD_PERSON)
     {
         // Atualizamos a distância da câmera em terceira pessoa do jogador utilizando a
         // movimentação da "rodinha", simulando um ZOOM.
-        g_Player.camera_distance -= 0.1f*yoffset;
+        g_PlayerInput.camera_distance -= 0.1f*yoffset;
 
         // Uma câmera look-at nunca pode estar exatamente "em cima" do ponto para
         // onde ela está olhando, pois isto gera problemas de divisão por zero na
@@ -2578,13 +2474,13 @@ void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
         const float maxdistance = 20.0f; // Distância máxima
         const float mindistance = 1.0f;  // Distância mínima
 
-        if (g_Player.camera_distance < mindistance)
-            g_Player.camera_distance = mindistance;
+        if (g_PlayerInput.camera_distance < mindistance)
+            g_PlayerInput.camera_distance = mindistance;
 
-        if (g_Player.camera_distance > maxdistance)
-            g_Player.camera_distance = maxdistance;
+        if (g_PlayerInput.camera_distance > maxdistance)
+            g_PlayerInput.camera_distance = maxdistance;
     }
-    if (g_CameraMode == CAMERA_FIRST_PERSON)
+    else
     {
         g_FirstPersonFOV -= glm::radians(yoffset * 2.0f); // scroll muda só o FOV da primeira pessoa
 
@@ -2635,55 +2531,29 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
 
     // Tab para mudar a câmera
     if (key == GLFW_KEY_TAB && action == GLFW_PRESS) {
-        if (g_CameraMode == CAMERA_THIRD_PERSON)
-            g_CameraMode = CAMERA_FIRST_PERSON;
-        else
-            g_CameraMode = CAMERA_THIRD_PERSON;
+        g_PlayerInput.buttons ^= SIMULATION_ACTION_THIRD_PERSON;
         printf("Camera mode switched! Now: %s\n",
-               g_CameraMode == CAMERA_FIRST_PERSON ? "FIRST PERSON" : "THIRD PERSON");
+               (g_PlayerInput.buttons & SIMULATION_ACTION_THIRD_PERSON) ? "THIRD PERSON" : "FIRST PERSON");
     }
 
-    // Controles WASD para movimento do jogador
+    // Controles WASD para movimento do jogador e Shift para correr. Os
+    // botões ficam na entrada do jogador enquanto a tecla estiver pressionada.
+    unsigned int movement_button = 0;
     if (key == GLFW_KEY_W)
-    {
-        if (action == GLFW_PRESS)
-            g_Player.moving_forward = true;
-        else if (action == GLFW_RELEASE)
-            g_Player.moving_forward = false;
-    }
-
-    if (key == GLFW_KEY_S)
-    {
-        if (action == GLFW_PRESS)
-            g_Player.moving_backward = true;
-        else if (action == GLFW_RELEASE)
-            g_Player.moving_backward = false;
-    }
-
-    if (key == GLFW_KEY_A)
-    {
-        if (action == GLFW_PRESS)
-            g_Player.moving_left = true;
-        else if (action == GLFW_RELEASE)
-            g_Player.moving_left = false;
-    }
-
-    if (key == GLFW_KEY_D)
-    {
-        if (action == GLFW_PRESS)
-            g_Player.moving_right = true;
-        else if (action == GLFW_RELEASE)
-            g_Player.moving_right = false;
-    }
-
-    // Shift para correr
-    if (key == GLFW_KEY_LEFT_SHIFT || key == GLFW_KEY_RIGHT_SHIFT)
-    {
-        if (action == GLFW_PRESS)
-            g_Player.is_running = true;
-        else if (action == GLFW_RELEASE)
-            g_Player.is_running = false;
-    }
+        movement_button = SIMULATION_ACTION_FORWARD;
+    else if (key == GLFW_KEY_S)
+        movement_button = SIMULATION_ACTION_BACKWARD;
+    else if (key == GLFW_KEY_A)
+        movement_button = SIMULATION_ACTION_LEFT;
+    else if (key == GLFW_KEY_D)
+        movement_button = SIMULATION_ACTION_RIGHT;
+    else if (key == GLFW_KEY_LEFT_SHIFT || key == GLFW_KEY_RIGHT_SHIFT)
+        movement_button = SIMULATION_ACTION_RUN;
+
+    if (action == GLFW_PRESS)
+        g_PlayerInput.buttons |= movement_button;
+    else if (action == GLFW_RELEASE)
+        g_PlayerInput.buttons &= ~movement_button;
 
     // Se o usuário apertar a tecla P, utilizamos projeção perspectiva.
     if (key == GLFW_KEY_P && action == GLFW_PRESS)
@@ -2706,29 +2576,34 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
     // Se o usuário apertar a tecla R, recarregamos os shaders dos arquivos "shader_fragment.glsl" e "shader_vertex.glsl".
     if (key == GLFW_KEY_R && action == GLFW_PRESS)
     {
-        // Recarrega o carregador se não estiver recarregando e o carregador não estiver cheio
-        if (!g_Player.is_reloading && g_Player.magazine_ammo < g_Player.magazine_size)
-        {
-            g_Player.is_reloading = true;
-            g_Player.reload_time = g_Player.reload_time_total;
-        }
+        // Recarrega o carregador no próximo tick, se não estiver recarregando e o carregador não estiver cheio
+        g_PendingButtons |= SIMULATION_ACTION_RELOAD;
+    }
+
+    // Se o usuário apertar a tecla F2, salvamos o histórico do profiler de GPU
+    // em um arquivo CSV, para comparação entre builds.
+    if (key == GLFW_KEY_F2 && action == GLFW_PRESS)
+    {
+        char filename[64];
+        time_t now = time(NULL);
+        strftime(filename, sizeof(filename), "gpu_profile_%Y%m%d_%H%M%S.csv", localtime(&now));
+        GpuProfiler_DumpCSV(filename);
     }
 
+    // Se o usuário apertar a tecla F3, gravamos um trace (JSON do Chrome) dos
+    // próximos g_TraceFrames quadros.
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+        TraceRecorder_CaptureFrames(g_TraceFrames);
+
     // Se o usuário apertar a tecla E, realiza raycast de todos os inimigos em direção ao jogador
     // (cada chamada atualiza a linha visual, então múltiplas pressões mostram diferentes inimigos)
     if (key == GLFW_KEY_E && action == GLFW_PRESS)
     {
-        bool found_enemy = false;
-        // Realiza raycast de cada inimigo vivo em direção ao jogador
+        // Os raycasts são feitos no próximo tick (veja Simulation_ApplyAction())
         // A última chamada será a que fica visível na tela
-        for (size_t i = 0; i < g_Enemies.size(); ++i)
-        {
-            if (!g_Enemies[i].IsDead())
-            {
-                EnemyToPlayerRaycast(i);
-                found_enemy = true;
-            }
-        }
+        bool found_enemy = !g_World.enemies.empty();
+        if (found_enemy)
+            g_PendingButtons |= SIMULATION_ACTION_ENEMY_RAYCASTS;
         
         if (found_enemy)
         {
@@ -2787,7 +2662,7 @@ void TextRendering_ShowModelViewProjection(
     TextRendering_PrintMatrixVectorProductDivW(window, projection, p_camera, -1.0f, 1.0f-18*pad, 1.0f);
 
     int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
+    GetFramebufferSize(window, &width, &height);
 
     glm::vec2 a = glm::vec2(-1, -1);
     glm::vec2 b = glm::vec2(+1, +1);
@@ -2833,7 +2708,7 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window)
 
     // Variáveis estáticas (static) mantém seus valores entre chamadas
     // subsequentes da função!
-    static float old_seconds = (float)glfwGetTime();
+    static double old_seconds = GetTime();
     static int   ellapsed_frames = 0;
     static char  buffer[20] = "?? fps";
     static int   numchars = 7;
@@ -2841,10 +2716,10 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window)
     ellapsed_frames += 1;
 
     // Recuperamos o número de segundos que passou desde a execução do programa
-    float seconds = (float)glfwGetTime();
+    double seconds = GetTime();
 
     // Número de segundos desde o último cálculo do fps
-    float ellapsed_seconds = seconds - old_seconds;
+    float ellapsed_seconds = (float)(seconds - old_seconds);
 
     if ( ellapsed_seconds > 1.0f )
     {
@@ -2864,6 +2739,129 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window)
     TextRendering_PrintString(window, buffer, x_pos, y_pos, 1.0f);
 }
 
+// Escrevemos na tela quantos bytes de geometria dinâmica foram enviados para a
+// GPU no último quadro, em quantos uploads, e quantas vezes foi preciso esperar
+// a GPU liberar uma região do stream buffer.
+void TextRendering_ShowStreamBufferStats(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[80];
+    int numchars = snprintf(buffer, 80, "Stream: %.1f KB/frame (%d uploads, %d stalls)",
+                            StreamBuffer_BytesLastFrame() / 1024.0f,
+                            StreamBuffer_UploadsLastFrame(),
+                            StreamBuffer_StallsLastFrame());
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f - (numchars + 1) * charwidth, 1.0f - 2 * lineheight, 1.0f);
+}
+
+// Escrevemos na tela quantos chunks de geometria estática (caixas) foram
+// desenhados no último quadro, do total. Veja DrawStaticBoxes().
+void TextRendering_ShowStaticChunkStats(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[80];
+    int numchars = snprintf(buffer, 80, "Crates: %d/%d chunks drawn",
+                            g_StaticChunksDrawn, (int)g_StaticBoxChunks.size());
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f - (numchars + 1) * charwidth, 1.0f - 3 * lineheight, 1.0f);
+}
+
+// Escrevemos na tela a tabela do profiler de GPU: para cada pass, a média e o
+// máximo do tempo de GPU nos últimos GPU_PROFILER_AVERAGE_FRAMES quadros lidos.
+// A tecla F2 salva o histórico completo em CSV.
+void TextRendering_ShowGpuProfiler(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    // Todas as linhas têm a mesma largura, para que a tabela fique alinhada
+    const int numchars = 32;
+    float x = 1.0f - (numchars + 1) * charwidth;
+    float y = 1.0f - 5 * lineheight;
+
+    char buffer[80];
+    snprintf(buffer, 80, "%-14s %8s %8s", "GPU pass", "avg ms", "max ms");
+    TextRendering_PrintString(window, buffer, x, y, 1.0f);
+
+    for (int pass = 0; pass < GpuProfiler_PassCount(); ++pass)
+    {
+        y -= lineheight;
+        snprintf(buffer, 80, "%-14s %8.3f %8.3f", GpuProfiler_PassName(pass),
+                 GpuProfiler_PassAverageMs(pass), GpuProfiler_PassMaxMs(pass));
+        TextRendering_PrintString(window, buffer, x, y, 1.0f);
+    }
+
+    y -= lineheight;
+    snprintf(buffer, 80, "%-14s %8.3f", "frame", GpuProfiler_FrameAverageMs());
+    TextRendering_PrintString(window, buffer, x, y, 1.0f);
+}
+
+// Área (em NDC) do gráfico de tempo de quadro do profiler de CPU, no canto
+// inferior esquerdo da tela. A tabela de zonas é escrita logo acima dela.
+#define CPU_GRAPH_LEFT    -0.98f
+#define CPU_GRAPH_BOTTOM  -0.98f
+#define CPU_GRAPH_WIDTH    0.60f
+#define CPU_GRAPH_HEIGHT   0.25f
+#define CPU_GRAPH_MAX_MS  50.0f  // Tempo correspondente ao topo do gráfico
+#define CPU_GRAPH_FRAMES  240    // Quadros mostrados no gráfico
+
+// Escrevemos na tela a tabela do profiler de CPU: para cada zona, a média e o
+// máximo por quadro, e os percentis do tempo de quadro, todos nos últimos
+// CPU_PROFILER_WINDOW_SECONDS segundos.
+void TextRendering_ShowCpuProfiler(GLFWwindow* window)
+{
+#ifndef CPU_PROFILER_DISABLED
+    if ( !g_ShowInfoText )
+        return;
+
+    float lineheight = TextRendering_LineHeight(window);
+
+    // Zonas que não executaram na janela (ex.: as da inicialização) são omitidas
+    std::vector<int> active_zones;
+    for (int zone = 0; zone < CpuProfiler_ZoneCount(); ++zone)
+        if (CpuProfiler_ZoneMaxMs(zone) > 0.0)
+            active_zones.push_back(zone);
+
+    // A tabela cresce para cima a partir do topo do gráfico
+    int num_lines = (int)active_zones.size() + 2;
+    float x = CPU_GRAPH_LEFT;
+    float y = CPU_GRAPH_BOTTOM + CPU_GRAPH_HEIGHT + num_lines * lineheight;
+
+    char buffer[80];
+    snprintf(buffer, 80, "%-24s %8s %8s", "CPU zone", "avg ms", "max ms");
+    TextRendering_PrintString(window, buffer, x, y, 1.0f);
+
+    for (size_t i = 0; i < active_zones.size(); ++i)
+    {
+        int zone = active_zones[i];
+        y -= lineheight;
+        snprintf(buffer, 80, "%-24s %8.3f %8.3f", CpuProfiler_ZoneName(zone),
+                 CpuProfiler_ZoneAverageMs(zone), CpuProfiler_ZoneMaxMs(zone));
+        TextRendering_PrintString(window, buffer, x, y, 1.0f);
+    }
+
+    double p50, p95, p99;
+    CpuProfiler_FramePercentiles(&p50, &p95, &p99);
+    y -= lineheight;
+    snprintf(buffer, 80, "frame p50 %.2f  p95 %.2f  p99 %.2f ms (%.0fs)",
+             p50, p95, p99, CPU_PROFILER_WINDOW_SECONDS);
+    TextRendering_PrintString(window, buffer, x, y, 1.0f);
+#endif
+}
+
 // Função para debugging: imprime no terminal todas informações de um modelo
 // geométrico carregado de um arquivo ".obj".
 // Veja: https://github.com/syoyo/tinyobjloader/blob/22883def8db9ef1f3ffb9b404318e7dd25fdbb51/loader_example.cc#L98
@@ -3028,16 +3026,232 @@ void PrintObjModelInfo(ObjModel* model)
   }
 }
 
-// Função que desenha um indicador de direção (linha) mostrando para onde a entidade está olhando
-void DrawDirectionIndicator(glm::vec4 position, glm::vec4 forward, float length, glm::mat4 view, glm::mat4 projection, bool is_player)
+// Coordenadas de textura de um ponto "pos" do cubo (coordenadas de modelo, de
+// -1 a 1). A face é escolhida pelo centro do triângulo, "face_center", e a
+// regra é a mesma usada para BOX em "shader_fragment.glsl".
+static glm::vec2 CrateFaceUV(glm::vec3 pos, glm::vec3 face_center)
+{
+    glm::vec3 abs_center = glm::vec3(fabsf(face_center.x), fabsf(face_center.y), fabsf(face_center.z));
+
+    if (abs_center.x >= abs_center.y && abs_center.x >= abs_center.z)
+    {
+        if (face_center.x > 0.0f)
+            return glm::vec2((-pos.z + 1.0f) * 0.5f, (pos.y + 1.0f) * 0.5f); // Right face (X = 1)
+        else
+            return glm::vec2(( pos.z + 1.0f) * 0.5f, (pos.y + 1.0f) * 0.5f); // Left face (X = -1)
+    }
+    else if (abs_center.y >= abs_center.z)
+    {
+        if (face_center.y > 0.0f)
+            return glm::vec2((pos.x + 1.0f) * 0.5f, (-pos.z + 1.0f) * 0.5f); // Top face (Y = 1)
+        else
+            return glm::vec2((pos.x + 1.0f) * 0.5f, ( pos.z + 1.0f) * 0.5f); // Bottom face (Y = -1)
+    }
+    else
+    {
+        if (face_center.z > 0.0f)
+            return glm::vec2(( pos.x + 1.0f) * 0.5f, (pos.y + 1.0f) * 0.5f); // Front face (Z = 1)
+        else
+            return glm::vec2((-pos.x + 1.0f) * 0.5f, (pos.y + 1.0f) * 0.5f); // Back face (Z = -1)
+    }
+}
+
+// Constrói a geometria estática das caixas. Deve ser chamada depois de
+// ComputeNormals(cube_model), e novamente caso g_World.map seja alterado.
+void BakeStaticBoxes(ObjModel* cube_model)
+{
+    CPU_PROFILE_ZONE("BakeStaticBoxes");
+    // Vértices do cubo (3 por triângulo) em coordenadas de modelo
+    std::vector<glm::vec4> cube_positions;
+    std::vector<glm::vec4> cube_normals;
+    for (size_t shape = 0; shape < cube_model->shapes.size(); ++shape)
+    {
+        const tinyobj::mesh_t& mesh = cube_model->shapes[shape].mesh;
+        for (size_t i = 0; i < mesh.indices.size(); ++i)
+        {
+            tinyobj::index_t idx = mesh.indices[i];
+            cube_positions.push_back(glm::vec4(
+                cube_model->attrib.vertices[3*idx.vertex_index + 0],
+                cube_model->attrib.vertices[3*idx.vertex_index + 1],
+                cube_model->attrib.vertices[3*idx.vertex_index + 2],
+                1.0f));
+            cube_normals.push_back(glm::vec4(
+                cube_model->attrib.normals[3*idx.normal_index + 0],
+                cube_model->attrib.normals[3*idx.normal_index + 1],
+                cube_model->attrib.normals[3*idx.normal_index + 2],
+                0.0f));
+        }
+    }
+
+    // Distribuímos as caixas nos chunks pela posição do seu centro
+    const int chunks_x = (int)ceilf((MAP_MAX_X - MAP_MIN_X) / STATIC_CHUNK_SIZE);
+    const int chunks_z = (int)ceilf((MAP_MAX_Z - MAP_MIN_Z) / STATIC_CHUNK_SIZE);
+    std::vector< std::vector<size_t> > boxes_per_chunk(chunks_x * chunks_z);
+    for (size_t i = 0; i < g_World.map->boxes.size(); ++i)
+    {
+        int cx = (int)floorf((g_World.map->boxes[i].position.x - MAP_MIN_X) / STATIC_CHUNK_SIZE);
+        int cz = (int)floorf((g_World.map->boxes[i].position.z - MAP_MIN_Z) / STATIC_CHUNK_SIZE);
+        cx = std::max(0, std::min(cx, chunks_x - 1));
+        cz = std::max(0, std::min(cz, chunks_z - 1));
+        boxes_per_chunk[cz * chunks_x + cx].push_back(i);
+    }
+
+    // Vértices intercalados: posição (vec4), normal (vec4), UV (vec2)
+    std::vector<float> vertices;
+    vertices.reserve(g_World.map->boxes.size() * cube_positions.size() * 10);
+    g_StaticBoxChunks.clear();
+
+    for (size_t c = 0; c < boxes_per_chunk.size(); ++c)
+    {
+        if (boxes_per_chunk[c].empty())
+            continue;
+
+        const float maxval = std::numeric_limits<float>::max();
+        StaticChunk chunk;
+        chunk.first_vertex = (GLint)(vertices.size() / 10);
+        chunk.bbox_min = glm::vec3(maxval, maxval, maxval);
+        chunk.bbox_max = glm::vec3(-maxval, -maxval, -maxval);
+
+        for (size_t b : boxes_per_chunk[c])
+        {
+            // Mesmas transformações que o vertex shader faria com a matriz "model"
+            glm::mat4 model = ComputeBoxModelMatrix(g_World.map->boxes[b]);
+            glm::mat4 normal_matrix = glm::inverse(glm::transpose(model));
+
+            for (size_t v = 0; v < cube_positions.size(); ++v)
+            {
+                size_t triangle_start = v - v % 3;
+                glm::vec3 face_center = glm::vec3(cube_positions[triangle_start]
+                                                + cube_positions[triangle_start + 1]
+                                                + cube_positions[triangle_start + 2]) / 3.0f;
+
+                glm::vec4 p = model * cube_positions[v];
+                glm::vec4 n = normal_matrix * cube_normals[v];
+                glm::vec2 uv = CrateFaceUV(glm::vec3(cube_positions[v]), face_center);
+
+                float vertex[10] = { p.x, p.y, p.z, 1.0f, n.x, n.y, n.z, 0.0f, uv.x, uv.y };
+                vertices.insert(vertices.end(), vertex, vertex + 10);
+
+                chunk.bbox_min = glm::min(chunk.bbox_min, glm::vec3(p));
+                chunk.bbox_max = glm::max(chunk.bbox_max, glm::vec3(p));
+            }
+        }
+
+        chunk.num_vertices = (GLsizei)(vertices.size() / 10 - chunk.first_vertex);
+        g_StaticBoxChunks.push_back(chunk);
+    }
+
+    if (g_StaticBoxesVAO == 0)
+        glGenVertexArrays(1, &g_StaticBoxesVAO);
+    glBindVertexArray(g_StaticBoxesVAO);
+
+    static GLuint vbo_id = 0;
+    if (vbo_id == 0)
+        glGenBuffers(1, &vbo_id);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    // Mesmos "location" de "shader_vertex.glsl"
+    const GLsizei stride = 10 * sizeof(float);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    printf("Caixas assadas: %d caixas em %d chunks (%.1f KB)\n",
+           (int)g_World.map->boxes.size(), (int)g_StaticBoxChunks.size(), vertices.size() * sizeof(float) / 1024.0f);
+}
+
+// Testa se uma AABB está completamente fora do frustum definido pela matriz
+// projection*view M. Os seis planos são extraídos das linhas de M (método de
+// Gribb e Hartmann); para cada plano testamos apenas o vértice da AABB mais
+// "à frente" na direção da normal do plano.
+static bool AABBOutsideFrustum(const glm::mat4& M, glm::vec3 bbox_min, glm::vec3 bbox_max)
+{
+    glm::vec4 row0 = glm::vec4(M[0][0], M[1][0], M[2][0], M[3][0]);
+    glm::vec4 row1 = glm::vec4(M[0][1], M[1][1], M[2][1], M[3][1]);
+    glm::vec4 row2 = glm::vec4(M[0][2], M[1][2], M[2][2], M[3][2]);
+    glm::vec4 row3 = glm::vec4(M[0][3], M[1][3], M[2][3], M[3][3]);
+
+    glm::vec4 planes[6] = {
+        row3 + row0, row3 - row0, // esquerda, direita
+        row3 + row1, row3 - row1, // baixo, cima
+        row3 + row2, row3 - row2  // near, far
+    };
+
+    for (int i = 0; i < 6; ++i)
+    {
+        glm::vec4 plane = planes[i];
+        glm::vec3 p = glm::vec3(
+            plane.x >= 0.0f ? bbox_max.x : bbox_min.x,
+            plane.y >= 0.0f ? bbox_max.y : bbox_min.y,
+            plane.z >= 0.0f ? bbox_max.z : bbox_min.z);
+        if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f)
+            return true;
+    }
+    return false;
+}
+
+void DrawStaticBoxes(const glm::mat4& projection_view)
 {
-    // Cria VAO e VBO se ainda não existirem
-    if (g_LineVAO == 0)
+    // Vértices já estão em coordenadas do mundo
+    glm::mat4 model = Matrix_Identity();
+    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1i(g_object_id_uniform, BAKED_BOX);
+
+    glUniform1i(glGetUniformLocation(g_GpuProgramID, "use_texture"), 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture_crate);
+
+    glBindVertexArray(g_StaticBoxesVAO);
+
+    g_StaticChunksDrawn = 0;
+    for (const auto& chunk : g_StaticBoxChunks)
     {
-        glGenVertexArrays(1, &g_LineVAO);
-        glGenBuffers(1, &g_LineVBO);
+        if (AABBOutsideFrustum(projection_view, chunk.bbox_min, chunk.bbox_max))
+            continue;
+
+        glDrawArrays(GL_TRIANGLES, chunk.first_vertex, chunk.num_vertices);
+        g_StaticChunksDrawn += 1;
     }
 
+    glBindVertexArray(0);
+}
+
+void DrawStaticBoxesDepth()
+{
+    glm::mat4 model = Matrix_Identity();
+    glUniformMatrix4fv(g_shadow_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+
+    // O shadow map estático cobre o mapa inteiro, então todos os chunks são desenhados
+    glBindVertexArray(g_StaticBoxesVAO);
+    for (const auto& chunk : g_StaticBoxChunks)
+        glDrawArrays(GL_TRIANGLES, chunk.first_vertex, chunk.num_vertices);
+    glBindVertexArray(0);
+}
+
+// Cria o VAO de linhas. O atributo de posição (location 0) aponta para o início
+// do stream buffer; os desenhos escolhem seus vértices pelo parâmetro "first"
+// de glDrawArrays().
+void CreateLineVAO()
+{
+    glGenVertexArrays(1, &g_LineVAO);
+    glBindVertexArray(g_LineVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, StreamBuffer_GetBufferID());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, LINE_VERTEX_STRIDE, 0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Função que desenha um indicador de direção (linha) mostrando para onde a entidade está olhando
+void DrawDirectionIndicator(glm::vec4 position, glm::vec4 forward, float length, glm::mat4 view, glm::mat4 projection, bool is_player)
+{
     // Calcula o ponto final da linha
     glm::vec4 end_position = position + forward * length;
 
@@ -3048,11 +3262,10 @@ void DrawDirectionIndicator(glm::vec4 position, glm::vec4 forward, float length,
     };
 
     // Configura o VAO
+    GLint first_vertex = StreamBuffer_Upload(line_vertices, sizeof(line_vertices), LINE_VERTEX_STRIDE);
+    if (first_vertex < 0)
+        return;
     glBindVertexArray(g_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_LineVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(line_vertices), line_vertices, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
 
     // Usa o shader principal
     glUseProgram(g_GpuProgramID);
@@ -3073,7 +3286,7 @@ void DrawDirectionIndicator(glm::vec4 position, glm::vec4 forward, float length,
 
     // Desenha a linha
     glLineWidth(3.0f);
-    glDrawArrays(GL_LINES, 0, 2);
+    glDrawArrays(GL_LINES, first_vertex, 2);
     glLineWidth(1.0f);
 
     // Reabilita culling
@@ -3085,13 +3298,6 @@ void DrawDirectionIndicator(glm::vec4 position, glm::vec4 forward, float length,
 // Desenha hitbox do jogador (esfera wireframe)
 void DrawPlayerHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat4 projection)
 {
-    // Cria VAO e VBO se ainda não existirem
-    if (g_LineVAO == 0)
-    {
-        glGenVertexArrays(1, &g_LineVAO);
-        glGenBuffers(1, &g_LineVBO);
-    }
-
     // Desenha círculos em 3 planos para formar uma esfera wireframe
     const int num_segments = 32; // Número de segmentos do círculo
     std::vector<float> vertices;
@@ -3127,11 +3333,10 @@ void DrawPlayerHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat
     }
 
     // Configura o VAO
+    GLint first_vertex = StreamBuffer_Upload(vertices.data(), vertices.size() * sizeof(float), LINE_VERTEX_STRIDE);
+    if (first_vertex < 0)
+        return;
     glBindVertexArray(g_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_LineVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
 
     // Usa o shader principal
     glUseProgram(g_GpuProgramID);
@@ -3152,9 +3357,9 @@ void DrawPlayerHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat
     // Desenha os 3 círculos
     glLineWidth(2.0f);
     int vertices_per_circle = num_segments + 1;
-    glDrawArrays(GL_LINE_STRIP, 0, vertices_per_circle); // Círculo XY
-    glDrawArrays(GL_LINE_STRIP, vertices_per_circle, vertices_per_circle); // Círculo XZ
-    glDrawArrays(GL_LINE_STRIP, vertices_per_circle * 2, vertices_per_circle); // Círculo YZ
+    glDrawArrays(GL_LINE_STRIP, first_vertex, vertices_per_circle); // Círculo XY
+    glDrawArrays(GL_LINE_STRIP, first_vertex + vertices_per_circle, vertices_per_circle); // Círculo XZ
+    glDrawArrays(GL_LINE_STRIP, first_vertex + vertices_per_circle * 2, vertices_per_circle); // Círculo YZ
     glLineWidth(1.0f);
 
     // Reabilita culling
@@ -3166,13 +3371,6 @@ void DrawPlayerHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat
 // Desenha hitbox do inimigo (esfera wireframe)
 void DrawEnemyHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat4 projection)
 {
-    // Cria VAO e VBO se ainda não existirem
-    if (g_LineVAO == 0)
-    {
-        glGenVertexArrays(1, &g_LineVAO);
-        glGenBuffers(1, &g_LineVBO);
-    }
-
     // Desenha círculos em 3 planos para formar uma esfera wireframe
     const int num_segments = 32; // Número de segmentos do círculo
     std::vector<float> vertices;
@@ -3208,11 +3406,10 @@ void DrawEnemyHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat4
     }
 
     // Configura o VAO
+    GLint first_vertex = StreamBuffer_Upload(vertices.data(), vertices.size() * sizeof(float), LINE_VERTEX_STRIDE);
+    if (first_vertex < 0)
+        return;
     glBindVertexArray(g_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_LineVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
 
     // Usa o shader principal
     glUseProgram(g_GpuProgramID);
@@ -3233,9 +3430,9 @@ void DrawEnemyHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat4
     // Desenha os 3 círculos
     glLineWidth(2.0f);
     int vertices_per_circle = num_segments + 1;
-    glDrawArrays(GL_LINE_STRIP, 0, vertices_per_circle); // Círculo XY
-    glDrawArrays(GL_LINE_STRIP, vertices_per_circle, vertices_per_circle); // Círculo XZ
-    glDrawArrays(GL_LINE_STRIP, vertices_per_circle * 2, vertices_per_circle); // Círculo YZ
+    glDrawArrays(GL_LINE_STRIP, first_vertex, vertices_per_circle); // Círculo XY
+    glDrawArrays(GL_LINE_STRIP, first_vertex + vertices_per_circle, vertices_per_circle); // Círculo XZ
+    glDrawArrays(GL_LINE_STRIP, first_vertex + vertices_per_circle * 2, vertices_per_circle); // Círculo YZ
     glLineWidth(1.0f);
 
     // Reabilita culling
@@ -3248,7 +3445,7 @@ void DrawEnemyHitbox(glm::vec4 position, float radius, glm::mat4 view, glm::mat4
 void DrawCrosshair(GLFWwindow* window)
 {
     int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
+    GetFramebufferSize(window, &width, &height);
 
     // Salva o estado atual
     GLint viewport[4];
@@ -3262,13 +3459,6 @@ void DrawCrosshair(GLFWwindow* window)
     // Configura viewport para coordenadas de tela
     glViewport(0, 0, width, height);
 
-    // Cria VAO e VBO se ainda não existirem
-    if (g_LineVAO == 0)
-    {
-        glGenVertexArrays(1, &g_LineVAO);
-        glGenBuffers(1, &g_LineVBO);
-    }
-
     // Tamanho do crosshair em pixels
     float crosshair_size = 10.0f;
     float outline_offset = 1.5f; // Offset do contorno em pixels
@@ -3308,15 +3498,13 @@ void DrawCrosshair(GLFWwindow* window)
     };
 
     // Configura o VAO para o contorno
+    GLint first_vertex = StreamBuffer_Upload(outline_vertices, sizeof(outline_vertices), LINE_VERTEX_STRIDE);
     glBindVertexArray(g_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_LineVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(outline_vertices), outline_vertices, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
 
     // Desenha o contorno (mais grosso)
     glLineWidth(4.0f);
-    glDrawArrays(GL_LINES, 0, 4);
+    if (first_vertex >= 0)
+        glDrawArrays(GL_LINES, first_vertex, 4);
 
     // Agora desenha o crosshair verde (sobre o contorno)
     #define CROSSHAIR 4
@@ -3333,28 +3521,95 @@ void DrawCrosshair(GLFWwindow* window)
     };
 
     // Atualiza o buffer com os vértices do crosshair verde
-    glBufferData(GL_ARRAY_BUFFER, sizeof(crosshair_vertices), crosshair_vertices, GL_DYNAMIC_DRAW);
+    first_vertex = StreamBuffer_Upload(crosshair_vertices, sizeof(crosshair_vertices), LINE_VERTEX_STRIDE);
 
     // Desenha o crosshair verde (mais fino, sobre o contorno)
     glLineWidth(2.0f);
-    glDrawArrays(GL_LINES, 0, 4);
+    if (first_vertex >= 0)
+        glDrawArrays(GL_LINES, first_vertex, 4);
     glLineWidth(1.0f);
 
-    glBindVertexArray(0);
+    glBindVertexArray(0);
+
+    // Restaura o viewport original
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    // Restaura estados
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+// Desenha o gráfico dos tempos dos últimos CPU_GRAPH_FRAMES quadros medidos
+// pelo profiler de CPU, com linhas de referência em 16.7ms (60 fps) e 33.3ms
+// (30 fps). Picos isolados ("hitches"), escondidos pela média de FPS, ficam
+// visíveis aqui.
+void DrawCpuFrameTimeGraph(GLFWwindow* window)
+{
+#ifndef CPU_PROFILER_DISABLED
+    if ( !g_ShowInfoText )
+        return;
+
+    float frame_ms[CPU_GRAPH_FRAMES];
+    int num_frames = CpuProfiler_RecentFrameTimes(frame_ms, CPU_GRAPH_FRAMES);
+    if (num_frames < 2)
+        return;
+
+    // Linhas de referência: base do gráfico, 60 fps e 30 fps
+    const float guide_ms[3] = { 0.0f, 1000.0f / 60.0f, 1000.0f / 30.0f };
+    float guide_vertices[3 * 8];
+    for (int i = 0; i < 3; ++i)
+    {
+        float y = CPU_GRAPH_BOTTOM + CPU_GRAPH_HEIGHT * guide_ms[i] / CPU_GRAPH_MAX_MS;
+        float line[8] = { CPU_GRAPH_LEFT, y, 0.0f, 1.0f, CPU_GRAPH_LEFT + CPU_GRAPH_WIDTH, y, 0.0f, 1.0f };
+        std::copy(line, line + 8, guide_vertices + 8 * i);
+    }
+
+    // Os quadros mais recentes ficam à direita
+    std::vector<float> graph_vertices;
+    graph_vertices.reserve(num_frames * 4);
+    for (int i = 0; i < num_frames; ++i)
+    {
+        float x = CPU_GRAPH_LEFT + CPU_GRAPH_WIDTH * (CPU_GRAPH_FRAMES - num_frames + i) / (CPU_GRAPH_FRAMES - 1);
+        float y = CPU_GRAPH_BOTTOM + CPU_GRAPH_HEIGHT * std::min(frame_ms[i], CPU_GRAPH_MAX_MS) / CPU_GRAPH_MAX_MS;
+        graph_vertices.push_back(x);
+        graph_vertices.push_back(y);
+        graph_vertices.push_back(0.0f);
+        graph_vertices.push_back(1.0f);
+    }
+
+    glDisable(GL_DEPTH_TEST);
+
+    // Já estamos em coordenadas normalizadas (NDC)
+    glUseProgram(g_GpuProgramID);
+    glm::mat4 identity = Matrix_Identity();
+    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(g_view_uniform, 1, GL_FALSE, glm::value_ptr(identity));
+    glUniformMatrix4fv(g_projection_uniform, 1, GL_FALSE, glm::value_ptr(identity));
+
+    glBindVertexArray(g_LineVAO);
+
+    #define PROFILER_GRAPH_GUIDE 17
+    glUniform1i(g_object_id_uniform, PROFILER_GRAPH_GUIDE);
+    GLint first_vertex = StreamBuffer_Upload(guide_vertices, sizeof(guide_vertices), LINE_VERTEX_STRIDE);
+    if (first_vertex >= 0)
+        glDrawArrays(GL_LINES, first_vertex, 6);
 
-    // Restaura o viewport original
-    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    #define PROFILER_GRAPH 16
+    glUniform1i(g_object_id_uniform, PROFILER_GRAPH);
+    first_vertex = StreamBuffer_Upload(graph_vertices.data(), graph_vertices.size() * sizeof(float), LINE_VERTEX_STRIDE);
+    if (first_vertex >= 0)
+        glDrawArrays(GL_LINE_STRIP, first_vertex, num_frames);
 
-    // Restaura estados
-    glDisable(GL_BLEND);
+    glBindVertexArray(0);
     glEnable(GL_DEPTH_TEST);
+#endif
 }
 
 // Função que desenha uma barra de vida acima de um inimigo
 void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, float max_health, glm::mat4 view, glm::mat4 projection)
 {
     int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
+    GetFramebufferSize(window, &width, &height);
 
     // Projeta a posição 3D do mundo para coordenadas de tela
     glm::mat4 model = Matrix_Identity();
@@ -3408,13 +3663,6 @@ void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, f
     // Configura viewport para coordenadas de tela
     glViewport(0, 0, width, height);
 
-    // Cria VAO e VBO se ainda não existirem
-    if (g_LineVAO == 0)
-    {
-        glGenVertexArrays(1, &g_LineVAO);
-        glGenBuffers(1, &g_LineVBO);
-    }
-
     // Usa o shader principal
     glUseProgram(g_GpuProgramID);
 
@@ -3429,9 +3677,7 @@ void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, f
 
     // Configura o VAO
     glBindVertexArray(g_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_LineVBO);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
+    GLint first_vertex = 0;
 
     // Desenha o contorno escuro (retângulo externo)
     #define HEALTH_BAR_OUTLINE 7
@@ -3449,9 +3695,10 @@ void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, f
         bar_x_ndc - bar_width_ndc/2.0f - outline_ndc, bar_y_ndc - bar_height_ndc/2.0f - outline_ndc, 0.0f, 1.0f
     };
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(outline_vertices), outline_vertices, GL_DYNAMIC_DRAW);
+    first_vertex = StreamBuffer_Upload(outline_vertices, sizeof(outline_vertices), LINE_VERTEX_STRIDE);
     glLineWidth(2.0f);
-    glDrawArrays(GL_LINES, 0, 8);
+    if (first_vertex >= 0)
+        glDrawArrays(GL_LINES, first_vertex, 8);
 
     // Desenha o fundo cinza (HP faltando) - usando triângulos para preencher
     #define HEALTH_BAR_BACKGROUND 8
@@ -3468,9 +3715,10 @@ void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, f
         bar_x_ndc - bar_width_ndc/2.0f, bar_y_ndc + bar_height_ndc/2.0f, 0.0f, 1.0f
     };
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(background_vertices), background_vertices, GL_DYNAMIC_DRAW);
+    first_vertex = StreamBuffer_Upload(background_vertices, sizeof(background_vertices), LINE_VERTEX_STRIDE);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    if (first_vertex >= 0)
+        glDrawArrays(GL_TRIANGLES, first_vertex, 6);
 
     // Desenha a barra verde (HP atual) - apenas a parte proporcional
     // IMPORTANTE: Desenha DEPOIS do fundo cinza para ficar por cima
@@ -3498,10 +3746,11 @@ void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, f
             fill_left + inner_offset, bar_y_ndc + bar_height_ndc/2.0f - inner_offset, 0.0f, 1.0f
         };
 
-        glBufferData(GL_ARRAY_BUFFER, sizeof(fill_vertices), fill_vertices, GL_DYNAMIC_DRAW);
+        first_vertex = StreamBuffer_Upload(fill_vertices, sizeof(fill_vertices), LINE_VERTEX_STRIDE);
         // Garante que está desenhando com fill mode
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (first_vertex >= 0)
+            glDrawArrays(GL_TRIANGLES, first_vertex, 6);
     }
 
     glBindVertexArray(0);
@@ -3518,8 +3767,36 @@ void DrawHealthBar(GLFWwindow* window, glm::vec4 world_position, float health, f
 }
 
 // Função que desenha o HUD com HP e munição do jogador
+void UpdateHudEvents()
+{
+    GameEvent events[64];
+    size_t count;
+    while ((count = EventBus_Poll(g_World.events, g_HudEvents, events, 64)) > 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const GameEvent& event = events[i];
+            if (event.type == GAME_EVENT_PLAYER_DAMAGED)
+            {
+                // Danos no mesmo aviso se somam
+                if (g_World.time - g_HudDamageTime > g_HudEventDuration)
+                    g_HudDamageAmount = 0.0f;
+                g_HudDamageAmount += event.damage.amount;
+                g_HudDamageTime = g_World.time;
+            }
+            else
+            {
+                g_HudHitKilled = event.type == GAME_EVENT_ENEMY_KILLED;
+                g_HudHitTime = g_World.time;
+            }
+        }
+    }
+}
+
 void DrawHUD(GLFWwindow* window)
 {
+    CPU_PROFILE_ZONE("DrawHUD");
+
     // Configurações de texto
     float text_scale = 1.0f;
     float line_height = TextRendering_LineHeight(window);
@@ -3532,40 +3809,34 @@ void DrawHUD(GLFWwindow* window)
     float hud_y_start = 1.0f - 5.0f * line_height;  // Posição inicial do topo para caber tudo
 
     // Usa o número da wave atual
-    int current_wave = g_CurrentWaveNumber;
+    int current_wave = g_World.current_wave_number;
 
-    // Conta inimigos vivos (não mortos)
-    int enemies_left = 0;
-    for (const auto& enemy : g_Enemies)
-    {
-        if (!enemy.IsDead())
-        {
-            enemies_left++;
-        }
-    }
+    // Só os inimigos vivos ficam em g_World.enemies
+    int enemies_left = (int)g_World.enemies.size();
 
     // Desenha HP (garante que está usando os dados corretos do jogador)
     float current_y = hud_y_start;
     char hp_text[64];
-    snprintf(hp_text, 64, "HP: %.0f/%.0f", g_Player.health, g_Player.max_health);
+    snprintf(hp_text, 64, "HP: %.0f/%.0f", g_World.player.health, g_World.player.max_health);
     TextRendering_PrintString(window, hp_text, hud_x, current_y, text_scale);
 
     // Desenha munição do carregador (garante que está usando os dados corretos do jogador)
     current_y -= 1.5f * line_height;
     char ammo_text[64];
-    snprintf(ammo_text, 64, "Ammo: %d/%d", g_Player.magazine_ammo, g_Player.magazine_size);
+    snprintf(ammo_text, 64, "Ammo: %d/%d", g_World.player.magazine_ammo, g_World.player.magazine_size);
     TextRendering_PrintString(window, ammo_text, hud_x, current_y, text_scale);
 
     // Desenha número da wave
     current_y -= 1.5f * line_height;
     char wave_text[64];
-    if (current_wave > 0)
+    int max_waves = g_World.wave_config.max_waves;
+    if (max_waves > 0)
     {
-        snprintf(wave_text, 64, "Wave: %d/%d", current_wave, g_MaxWaves);
+        snprintf(wave_text, 64, "Wave: %d/%d", current_wave, max_waves);
     }
     else
     {
-        snprintf(wave_text, 64, "Wave: 0/%d", g_MaxWaves);
+        snprintf(wave_text, 64, "Wave: %d", current_wave); // Waves sem fim
     }
     TextRendering_PrintString(window, wave_text, hud_x, current_y, text_scale);
 
@@ -3575,22 +3846,36 @@ void DrawHUD(GLFWwindow* window)
     snprintf(enemies_text, 64, "Enemies: %d", enemies_left);
     TextRendering_PrintString(window, enemies_text, hud_x, current_y, text_scale);
 
+    // Avisos dos eventos recentes (veja UpdateHudEvents())
+    if (g_HudHitTime >= 0.0 && g_World.time - g_HudHitTime <= g_HudEventDuration)
+    {
+        current_y -= 1.5f * line_height;
+        TextRendering_PrintString(window, g_HudHitKilled ? "Kill!" : "Hit!", hud_x, current_y, text_scale);
+    }
+    if (g_HudDamageTime >= 0.0 && g_World.time - g_HudDamageTime <= g_HudEventDuration)
+    {
+        current_y -= 1.5f * line_height;
+        char damage_text[64];
+        snprintf(damage_text, 64, "-%.0f HP", g_HudDamageAmount);
+        TextRendering_PrintString(window, damage_text, hud_x, current_y, text_scale);
+    }
+
     // Desenha status de reload se estiver recarregando
-    if (g_Player.is_reloading)
+    if (g_World.player.is_reloading)
     {
         current_y -= 1.5f * line_height;
         char reload_text[64];
-        snprintf(reload_text, 64, "Reloading: %.1fs", g_Player.reload_time);
+        snprintf(reload_text, 64, "Reloading: %.1fs", g_World.player.reload_time);
         TextRendering_PrintString(window, reload_text, hud_x, current_y, text_scale * 0.9f);
     }
 
     // Desenha mensagem de wave cleared se aplicável
-    if (g_WaveCleared)
+    if (g_World.wave_cleared)
     {
         current_y -= 1.5f * line_height;
-        float time_remaining = g_WaveClearedDelay - g_WaveClearedTimer;
+        float time_remaining = g_WaveClearedDelay - g_World.wave_cleared_timer;
         char cleared_text[64];
-        if (g_CurrentWaveNumber < g_MaxWaves)
+        if (max_waves == 0 || g_World.current_wave_number < max_waves)
         {
             snprintf(cleared_text, 64, "Wave Cleared! Next wave in %.1fs", time_remaining);
         }
@@ -3602,250 +3887,9 @@ void DrawHUD(GLFWwindow* window)
     }
 }
 
-// Função auxiliar para verificar interseção de raio com AABB (Axis-Aligned Bounding Box)
-// Retorna true se houver interseção e armazena a distância em t
-bool RayAABBIntersection(const glm::vec4& ray_origin, const glm::vec4& ray_dir,
-                         const glm::vec3& box_min, const glm::vec3& box_max, float& t)
-{
-    // Algoritmo de interseção raio-AABB (Slab method)
-    float tmin = 0.0f;
-    float tmax = std::numeric_limits<float>::max();
-
-    for (int i = 0; i < 3; ++i)
-    {
-        // Evita divisão por zero quando o raio é paralelo ao eixo
-        if (fabs(ray_dir[i]) < 1e-6f)
-        {
-            // Raio paralelo ao eixo - verifica se está dentro do AABB neste eixo
-            if (ray_origin[i] < box_min[i] || ray_origin[i] > box_max[i])
-                return false;
-            continue;
-        }
-
-        float invD = 1.0f / ray_dir[i];
-        float t0 = (box_min[i] - ray_origin[i]) * invD;
-        float t1 = (box_max[i] - ray_origin[i]) * invD;
-
-        if (invD < 0.0f)
-        {
-            float temp = t0;
-            t0 = t1;
-            t1 = temp;
-        }
-
-        tmin = t0 > tmin ? t0 : tmin;
-        tmax = t1 < tmax ? t1 : tmax;
-
-        if (tmax < tmin)
-            return false;
-    }
-
-    t = tmin;
-    return tmin >= 0.0f;
-}
-
-// Função que realiza raycast e verifica interseções com entidades
-void CameraRaycast(glm::vec4 camera_position, glm::vec4 ray_direction)
-{
-    const float max_ray_distance = 100.0f;
-    const float entity_radius = 0.3f; // Raio aproximado das entidades (baseado na escala)
-
-    // Verifica interseção com caixas (obstáculos) e encontra a mais próxima
-    float closest_box_t = max_ray_distance;
-    bool hit_box = false;
-
-    for (const auto& box : g_Boxes)
-    {
-        // Calcula o AABB da caixa no espaço do mundo
-        // O cubo base tem coordenadas de -1 a 1, então precisamos escalar e transladar
-        // Como a rotação é apenas em torno do eixo Y, o AABB em Y não muda,
-        // mas em X e Z precisamos considerar a diagonal máxima após rotação
-        float max_horizontal_extent = sqrt(box.scale.x * box.scale.x + box.scale.z * box.scale.z);
-
-        glm::vec3 box_min = glm::vec3(
-            box.position.x - max_horizontal_extent,
-            box.position.y - box.scale.y,
-            box.position.z - max_horizontal_extent
-        );
-        glm::vec3 box_max = glm::vec3(
-            box.position.x + max_horizontal_extent,
-            box.position.y + box.scale.y,
-            box.position.z + max_horizontal_extent
-        );
-
-        float t_box = 0.0f;
-        if (RayAABBIntersection(camera_position, ray_direction, box_min, box_max, t_box))
-        {
-            if (t_box > 0.0f && t_box < closest_box_t)
-            {
-                closest_box_t = t_box;
-                hit_box = true;
-            }
-        }
-    }
-
-    // Verifica interseção com o jogador
-    float closest_player_t = max_ray_distance;
-    bool hit_player = false;
-
-    glm::vec4 to_player = glm::vec4(
-        g_Player.position.x - camera_position.x,
-        g_Player.position.y - camera_position.y,
-        g_Player.position.z - camera_position.z,
-        0.0f
-    );
-
-    float t_player = glm::dot(glm::vec3(to_player), glm::vec3(ray_direction));
-
-    if (t_player > 0.0f && t_player < max_ray_distance)
-    {
-        glm::vec4 closest_point = camera_position + ray_direction * t_player;
-        glm::vec4 to_closest = closest_point - g_Player.position;
-        float distance_sq = to_closest.x * to_closest.x + to_closest.y * to_closest.y + to_closest.z * to_closest.z;
-
-        if (distance_sq <= entity_radius * entity_radius)
-        {
-            closest_player_t = t_player;
-            hit_player = true;
-        }
-    }
-
-    // Verifica interseção com inimigos
-    const float player_damage_amount = 34.0f; // Quantidade de dano por tiro
-    float closest_enemy_t = max_ray_distance;
-    size_t closest_enemy_index = SIZE_MAX;
-    bool hit_enemy = false;
-
-    for (size_t i = 0; i < g_Enemies.size(); ++i)
-    {
-        auto& enemy = g_Enemies[i];
-
-        // Pula inimigos que já estão mortos
-        if (enemy.IsDead())
-            continue;
-
-        glm::vec4 to_enemy = glm::vec4(
-            enemy.position.x - camera_position.x,
-            enemy.position.y - camera_position.y,
-            enemy.position.z - camera_position.z,
-            0.0f
-        );
-
-        float t_enemy = glm::dot(glm::vec3(to_enemy), glm::vec3(ray_direction));
-
-        if (t_enemy > 0.0f && t_enemy < max_ray_distance)
-        {
-            glm::vec4 closest_point = camera_position + ray_direction * t_enemy;
-            glm::vec4 to_closest = closest_point - enemy.position;
-            float distance_sq = to_closest.x * to_closest.x + to_closest.y * to_closest.y + to_closest.z * to_closest.z;
-
-            if (distance_sq <= entity_radius * entity_radius)
-            {
-                if (t_enemy < closest_enemy_t)
-                {
-                    closest_enemy_t = t_enemy;
-                    closest_enemy_index = i;
-                    hit_enemy = true;
-                }
-            }
-        }
-    }
-
-    // Verifica qual foi o hit mais próximo: caixa, jogador ou inimigo
-    // A caixa bloqueia se estiver na frente de qualquer outro objeto
-    if (hit_box)
-    {
-        // Verifica se a caixa está na frente do jogador
-        if (hit_player && closest_box_t < closest_player_t)
-        {
-            printf("Raycast hit: BOX at distance %.2f (blocking player)\n", closest_box_t);
-            return;
-        }
-
-        // Verifica se a caixa está na frente do inimigo
-        if (hit_enemy && closest_box_t < closest_enemy_t)
-        {
-            printf("Raycast hit: BOX at distance %.2f (blocking enemy)\n", closest_box_t);
-            return;
-        }
-
-        // Se não há jogador nem inimigo, ou se a caixa não está na frente, ainda pode ser o hit mais próximo
-        if (!hit_player && !hit_enemy)
-        {
-            printf("Raycast hit: BOX at distance %.2f\n", closest_box_t);
-            return;
-        }
-    }
-
-    // Se o jogador foi atingido (e não há caixa na frente)
-    if (hit_player && (!hit_box || closest_player_t < closest_box_t))
-    {
-        printf("Raycast hit: PLAYER at distance %.2f\n", closest_player_t);
-        // Aqui você pode adicionar lógica adicional, como dano, etc.
-        return;
-    }
-
-    // Se um inimigo foi atingido (e não há caixa na frente)
-    if (hit_enemy && closest_enemy_index != SIZE_MAX && (!hit_box || closest_enemy_t < closest_box_t))
-    {
-        auto& enemy = g_Enemies[closest_enemy_index];
-
-        // Aplica dano ao inimigo através do método TakeDamage
-        enemy.TakeDamage(player_damage_amount);
-
-        printf("Raycast hit: ENEMY %zu at distance %.2f - Health: %.1f/%.1f\n",
-               closest_enemy_index, closest_enemy_t, enemy.health, enemy.max_health);
-
-        // Se o inimigo morreu
-        if (enemy.IsDead())
-        {
-            printf("ENEMY %zu DEFEATED!\n", closest_enemy_index);
-        }
-
-        return;
-    }
-
-    printf("Raycast: No hit\n");
-}
-
-// Realiza raycast a partir do centro do jogador na direção que ele está olhando
-void PlayerRaycast()
-{
-    // Posição do centro do jogador (usando a posição do jogador)
-    glm::vec4 ray_origin = g_Player.position;
-
-    // Direção é o vetor forward do jogador (direção que ele está olhando)
-    glm::vec4 ray_direction = g_Player.forward_vector;
-
-    // Normaliza o vetor de direção
-    float dir_length = sqrt(ray_direction.x * ray_direction.x +
-                           ray_direction.y * ray_direction.y +
-                           ray_direction.z * ray_direction.z);
-    if (dir_length > 0.001f)
-    {
-        ray_direction.x /= dir_length;
-        ray_direction.y /= dir_length;
-        ray_direction.z /= dir_length;
-    }
-
-    printf("=== PlayerRaycast: From player center (%.2f, %.2f, %.2f) in direction (%.2f, %.2f, %.2f) ===\n",
-           ray_origin.x, ray_origin.y, ray_origin.z,
-           ray_direction.x, ray_direction.y, ray_direction.z);
-
-    // Usa a mesma lógica do CameraRaycast mas com origem e direção diferentes
-    CameraRaycast(ray_origin, ray_direction);
-}
-
 // Função auxiliar para desenhar linha de raycast (amarela)
 void DrawRaycastLine(glm::vec4 start, glm::vec4 end, glm::mat4 view, glm::mat4 projection)
 {
-    // Cria VAO e VBO se ainda não existirem
-    if (g_LineVAO == 0)
-    {
-        glGenVertexArrays(1, &g_LineVAO);
-        glGenBuffers(1, &g_LineVBO);
-    }
-
     // Define os vértices da linha
     float line_vertices[] = {
         start.x, start.y, start.z, 1.0f,
@@ -3853,11 +3897,10 @@ void DrawRaycastLine(glm::vec4 start, glm::vec4 end, glm::mat4 view, glm::mat4 p
     };
 
     // Configura o VAO
+    GLint first_vertex = StreamBuffer_Upload(line_vertices, sizeof(line_vertices), LINE_VERTEX_STRIDE);
+    if (first_vertex < 0)
+        return;
     glBindVertexArray(g_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_LineVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(line_vertices), line_vertices, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
 
     // Usa o shader principal
     glUseProgram(g_GpuProgramID);
@@ -3877,7 +3920,7 @@ void DrawRaycastLine(glm::vec4 start, glm::vec4 end, glm::mat4 view, glm::mat4 p
 
     // Desenha a linha
     glLineWidth(3.0f);
-    glDrawArrays(GL_LINES, 0, 2);
+    glDrawArrays(GL_LINES, first_vertex, 2);
     glLineWidth(1.0f);
 
     // Reabilita culling
@@ -3889,13 +3932,6 @@ void DrawRaycastLine(glm::vec4 start, glm::vec4 end, glm::mat4 view, glm::mat4 p
 // Desenha uma spline Bezier cúbica usando múltiplos segmentos de linha
 void DrawBezierSpline(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3, glm::mat4 view, glm::mat4 projection)
 {
-    // Cria VAO e VBO se ainda não existirem
-    if (g_LineVAO == 0)
-    {
-        glGenVertexArrays(1, &g_LineVAO);
-        glGenBuffers(1, &g_LineVBO);
-    }
-
     // Número de segmentos para desenhar a curva (mais segmentos = curva mais suave)
     const int num_segments = 50;
     std::vector<float> line_vertices;
@@ -3925,11 +3961,10 @@ void DrawBezierSpline(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3, gl
     }
 
     // Configura o VAO
+    GLint first_vertex = StreamBuffer_Upload(line_vertices.data(), line_vertices.size() * sizeof(float), LINE_VERTEX_STRIDE);
+    if (first_vertex < 0)
+        return;
     glBindVertexArray(g_LineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_LineVBO);
-    glBufferData(GL_ARRAY_BUFFER, line_vertices.size() * sizeof(float), line_vertices.data(), GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
 
     // Usa o shader principal
     glUseProgram(g_GpuProgramID);
@@ -3949,7 +3984,7 @@ void DrawBezierSpline(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3, gl
 
     // Desenha a linha como uma linha em tira (GL_LINE_STRIP)
     glLineWidth(2.0f);
-    glDrawArrays(GL_LINE_STRIP, 0, num_segments + 1);
+    glDrawArrays(GL_LINE_STRIP, first_vertex, num_segments + 1);
     glLineWidth(1.0f);
 
     // Reabilita culling
@@ -3958,332 +3993,6 @@ void DrawBezierSpline(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2, glm::vec4 p3, gl
     glBindVertexArray(0);
 }
 
-// Realiza raycast de um inimigo específico em direção ao jogador
-void EnemyToPlayerRaycast(size_t enemy_index)
-{
-    // Verifica se o índice é válido
-    if (enemy_index >= g_Enemies.size())
-    {
-        printf("EnemyToPlayerRaycast: Invalid enemy index %zu (total enemies: %zu)\n",
-               enemy_index, g_Enemies.size());
-        return;
-    }
-
-    auto& enemy = g_Enemies[enemy_index];
-
-    // Verifica se o inimigo está morto
-    if (enemy.IsDead())
-    {
-        printf("EnemyToPlayerRaycast: Enemy %zu is dead\n", enemy_index);
-        return;
-    }
-
-    // Posição do centro do inimigo
-    glm::vec4 ray_origin = enemy.position;
-
-    // Limita o alcance do raycast de inimigo
-    const float max_ray_distance = 15.0f; // Limita o alcance do raycast de inimigo
-
-    // Direção do inimigo para o jogador
-    glm::vec4 ray_direction = glm::vec4(
-        g_Player.position.x - enemy.position.x,
-        g_Player.position.y - enemy.position.y,
-        g_Player.position.z - enemy.position.z,
-        0.0f
-    );
-
-    // Normaliza o vetor de direção
-    float dir_length = sqrt(ray_direction.x * ray_direction.x +
-                           ray_direction.y * ray_direction.y +
-                           ray_direction.z * ray_direction.z);
-    if (dir_length > 0.001f)
-    {
-        // Verifica distância antes de normalizar - se o jogador está muito longe, não realiza raycast
-        if (dir_length > max_ray_distance)
-        {
-            // Jogador está muito longe, não realiza raycast
-            return;
-        }
-        
-        ray_direction.x /= dir_length;
-        ray_direction.y /= dir_length;
-        ray_direction.z /= dir_length;
-    }
-    else
-    {
-        printf("EnemyToPlayerRaycast: Enemy %zu is at same position as player\n", enemy_index);
-        return;
-    }
-
-    // Rotaciona o inimigo para enfrentar o jogador
-    // Usa atan2 para calcular o ângulo de rotação em torno do eixo Y
-    // Similar ao que é feito para o jogador, mas com sinal invertido para corrigir direção
-    enemy.rotation_y = atan2(ray_direction.x, -ray_direction.z);
-    enemy.UpdateDirectionVectors();
-
-    printf("=== EnemyToPlayerRaycast: From enemy %zu (%.2f, %.2f, %.2f) to player (%.2f, %.2f, %.2f) ===\n",
-           enemy_index,
-           ray_origin.x, ray_origin.y, ray_origin.z,
-           g_Player.position.x, g_Player.position.y, g_Player.position.z);
-
-    // Realiza o raycast e encontra o ponto de impacto
-    glm::vec4 hit_point = ray_origin + ray_direction * max_ray_distance; // Default: max distance
-
-    // Verifica interseção com caixas primeiro
-    float closest_box_t = max_ray_distance;
-    bool hit_box = false;
-
-    for (const auto& box : g_Boxes)
-    {
-        float max_horizontal_extent = sqrt(box.scale.x * box.scale.x + box.scale.z * box.scale.z);
-        glm::vec3 box_min = glm::vec3(
-            box.position.x - max_horizontal_extent,
-            box.position.y - box.scale.y,
-            box.position.z - max_horizontal_extent
-        );
-        glm::vec3 box_max = glm::vec3(
-            box.position.x + max_horizontal_extent,
-            box.position.y + box.scale.y,
-            box.position.z + max_horizontal_extent
-        );
-
-        float t_box = 0.0f;
-        if (RayAABBIntersection(ray_origin, ray_direction, box_min, box_max, t_box))
-        {
-            if (t_box > 0.0f && t_box < closest_box_t)
-            {
-                closest_box_t = t_box;
-                hit_box = true;
-            }
-        }
-    }
-
-    // Verifica interseção com o jogador
-    const float entity_radius = 0.3f;
-    float closest_player_t = max_ray_distance;
-    bool hit_player = false;
-
-    glm::vec4 to_player = glm::vec4(
-        g_Player.position.x - ray_origin.x,
-        g_Player.position.y - ray_origin.y,
-        g_Player.position.z - ray_origin.z,
-        0.0f
-    );
-
-    float t_player = glm::dot(glm::vec3(to_player), glm::vec3(ray_direction));
-
-    if (t_player > 0.0f && t_player < max_ray_distance)
-    {
-        glm::vec4 closest_point = ray_origin + ray_direction * t_player;
-        glm::vec4 to_closest = closest_point - g_Player.position;
-        float distance_sq = to_closest.x * to_closest.x + to_closest.y * to_closest.y + to_closest.z * to_closest.z;
-
-        if (distance_sq <= entity_radius * entity_radius)
-        {
-            closest_player_t = t_player;
-            hit_player = true;
-        }
-    }
-
-    // Determina o ponto de impacto mais próximo
-    bool player_hit_and_not_blocked = false;
-    if (hit_box && (!hit_player || closest_box_t < closest_player_t))
-    {
-        hit_point = ray_origin + ray_direction * closest_box_t;
-        // Caixa bloqueou o raycast, não causa dano ao jogador
-    }
-    else if (hit_player)
-    {
-        hit_point = ray_origin + ray_direction * closest_player_t;
-        // Jogador foi atingido e não há caixa bloqueando
-        player_hit_and_not_blocked = true;
-    }
-
-    // Aplica dano ao jogador se foi atingido e não foi bloqueado por uma caixa
-    if (player_hit_and_not_blocked)
-    {
-        const float enemy_damage_amount = 2.0f; // Quantidade de dano que o inimigo causa
-        g_Player.TakeDamage(enemy_damage_amount);
-        printf("Enemy %zu hit player! Player health: %.1f/%.1f\n",
-               enemy_index, g_Player.health, g_Player.max_health);
-        
-        if (g_Player.IsDead())
-        {
-            printf("PLAYER DEFEATED!\n");
-        }
-    }
-
-    // Usa a mesma lógica do CameraRaycast para aplicar dano, etc.
-    CameraRaycast(ray_origin, ray_direction);
-
-    // Armazena informações do raycast para desenhar a linha amarela (por inimigo)
-    enemy.raycast_start = ray_origin;
-    enemy.raycast_end = hit_point;
-    enemy.raycast_time = (float)glfwGetTime(); // Registra o tempo atual
-    enemy.draw_raycast = true;
-}
-
-// Spawna uma wave de monstros nas posições especificadas
-// Retorna o ID da wave criada
-int SpawnWave(const std::vector<glm::vec4>& spawn_positions, float enemy_health_multiplier, float enemy_speed_multiplier)
-{
-    int wave_id = g_NextWaveID++;
-    Wave new_wave(wave_id);
-
-    // Cria os inimigos e adiciona à lista global
-    for (const auto& pos : spawn_positions)
-    {
-        size_t enemy_index = g_Enemies.size();
-        g_Enemies.push_back(Enemy(pos, wave_id, enemy_health_multiplier, enemy_speed_multiplier));
-        new_wave.enemy_indices.push_back(enemy_index);
-        
-        // Log das coordenadas do inimigo spawnado
-        printf("Enemy spawned at coordinates: (%.2f, %.2f, %.2f)\n", pos.x, pos.y, pos.z);
-    }
-
-    g_Waves.push_back(new_wave);
-
-    printf("Wave %d spawned with %zu enemies (health: %.1fx, speed: %.1fx)\n", wave_id, spawn_positions.size(), enemy_health_multiplier, enemy_speed_multiplier);
-    return wave_id;
-}
-
-// Verifica se todos os monstros de uma wave estão mortos
-bool IsWaveComplete(int wave_id)
-{
-    for (auto& wave : g_Waves)
-    {
-        if (wave.wave_id == wave_id)
-        {
-            return wave.CheckCompletion(g_Enemies);
-        }
-    }
-    return false; // Wave não encontrada
-}
-
-// Função para spawnar a próxima wave com dificuldade crescente
-void SpawnNextWave()
-{
-    if (g_CurrentWaveNumber >= g_MaxWaves)
-    {
-        printf("All waves completed! Game finished!\n");
-        return;
-    }
-
-    g_CurrentWaveNumber++;
-    g_WaveCleared = false;
-    g_WaveClearedTimer = 0.0f;
-
-    // Restaura completamente a vida do jogador após cada round
-    g_Player.health = g_Player.max_health;
-
-    // Calcula posições de spawn ao redor do jogador
-    glm::vec4 player_pos = g_Player.position;
-    const float spawn_distance = 8.0f;
-    
-    // Calcula a posição Y correta para os inimigos (mesma lógica do código original)
-    const float enemy_scale = 0.3f;
-    const float ground_y = -1.1f; // Altura do chão (mesma usada na inicialização)
-    float enemy_y = ground_y - g_BanditMinY * enemy_scale;
-
-    // Número de inimigos aumenta com a wave (4, 6, 8, 10, 12)
-    int enemy_count = 4 + (g_CurrentWaveNumber - 1) * 2;
-    
-    // Multiplicadores de dificuldade aumentam com a wave
-    float health_multiplier = 1.0f + (g_CurrentWaveNumber - 1) * 0.5f; // 1.0, 1.5, 2.0, 2.5, 3.0
-    float speed_multiplier = 1.0f + (g_CurrentWaveNumber - 1) * 0.2f; // 1.0, 1.2, 1.4, 1.6, 1.8
-
-    std::vector<glm::vec4> spawn_positions;
-    
-    // Gera posições de spawn em círculo ao redor do jogador
-    for (int i = 0; i < enemy_count; i++)
-    {
-        float angle = (2.0f * M_PI * i) / enemy_count;
-        glm::vec4 spawn_pos(
-            player_pos.x + spawn_distance * cos(angle),
-            enemy_y,
-            player_pos.z + spawn_distance * sin(angle),
-            1.0f
-        );
-        spawn_positions.push_back(spawn_pos);
-    }
-
-    SpawnWave(spawn_positions, health_multiplier, speed_multiplier);
-    printf("Wave %d/%d started!\n", g_CurrentWaveNumber, g_MaxWaves);
-}
-
-// Atualiza o status de todas as waves
-void UpdateWaves(float delta_time)
-{
-    // Atualiza timer de wave cleared
-    if (g_WaveCleared)
-    {
-        g_WaveClearedTimer += delta_time;
-        
-        // Se passou o tempo de delay, spawna próxima wave
-        if (g_WaveClearedTimer >= g_WaveClearedDelay)
-        {
-            SpawnNextWave();
-        }
-    }
-
-    // Verifica se alguma wave foi completada
-    // Encontra a wave mais recente (maior wave_id) que ainda não está completa
-    int most_recent_wave_id = -1;
-    for (const auto& wave : g_Waves)
-    {
-        if (wave.wave_id > most_recent_wave_id)
-            most_recent_wave_id = wave.wave_id;
-    }
-    
-    // Verifica se a wave mais recente foi completada
-    if (most_recent_wave_id >= 0)
-    {
-        for (auto& wave : g_Waves)
-        {
-            if (wave.wave_id == most_recent_wave_id && wave.is_active && !wave.is_complete)
-            {
-                if (wave.CheckCompletion(g_Enemies))
-                {
-                    printf("Wave %d COMPLETE! All enemies defeated!\n", wave.wave_id);
-                    
-                    // Marca como cleared para mostrar mensagem e iniciar próxima wave
-                    g_WaveCleared = true;
-                    g_WaveClearedTimer = 0.0f;
-                }
-                break;
-            }
-        }
-    }
-}
-
-// Retorna os IDs de todas as waves ativas (ainda não completas)
-std::vector<int> GetActiveWaves()
-{
-    std::vector<int> active_waves;
-    for (const auto& wave : g_Waves)
-    {
-        if (wave.is_active && !wave.is_complete)
-        {
-            active_waves.push_back(wave.wave_id);
-        }
-    }
-    return active_waves;
-}
-
-// Retorna os IDs de todas as waves completas
-std::vector<int> GetCompleteWaves()
-{
-    std::vector<int> complete_waves;
-    for (const auto& wave : g_Waves)
-    {
-        if (wave.is_complete)
-        {
-            complete_waves.push_back(wave.wave_id);
-        }
-    }
-    return complete_waves;
-}
-
 // set makeprg=cd\ ..\ &&\ make\ run\ >/dev/null
 // vim: set spell spelllang=pt_br :
 
@@ -0,0 +1,147 @@
+// Resolução dos raios pedidos durante o tick. Veja "rayqueries.h".
+//
+// Todos os raios são resolvidos contra o mesmo estado: o dano só é aplicado
+// depois, por Simulation_ResolveShots(). Para cada raio o resultado é o
+// objeto mais próximo entre as camadas pedidas, com os mesmos testes que
+// CameraRaycast() fazia um a um: slab test com as AABBs das caixas e
+// distância do raio ao centro do jogador e dos inimigos.
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "boxbvh.h"
+#include "rayqueries.h"
+
+#define RAY_ENTITY_RADIUS 0.3f // Raio aproximado do jogador e dos inimigos (baseado na escala)
+
+size_t RayQueries_Submit(World& world, const RayQuery& query)
+{
+    world.ray_queries.push_back(query);
+    return world.ray_queries.size() - 1;
+}
+
+// Chave que agrupa os raios em pacotes: sinais da direção e célula da origem
+static uint32_t PacketKey(const RayQuery& query)
+{
+    uint32_t octant = (query.direction.x < 0.0f ? 1u : 0u) |
+                      (query.direction.y < 0.0f ? 2u : 0u) |
+                      (query.direction.z < 0.0f ? 4u : 0u);
+
+    int cells_x = (int)ceilf((MAP_MAX_X - MAP_MIN_X) / RAY_PACKET_CELL_SIZE);
+    int cells_z = (int)ceilf((MAP_MAX_Z - MAP_MIN_Z) / RAY_PACKET_CELL_SIZE);
+    int cell_x = glm::clamp((int)floorf((query.origin.x - MAP_MIN_X) / RAY_PACKET_CELL_SIZE), 0, cells_x - 1);
+    int cell_z = glm::clamp((int)floorf((query.origin.z - MAP_MIN_Z) / RAY_PACKET_CELL_SIZE), 0, cells_z - 1);
+    return (octant * cells_z + cell_z) * cells_x + cell_x;
+}
+
+// true se o raio passa a até RAY_ENTITY_RADIUS de "position", com o ponto
+// mais próximo em 0 < t < max_distance; armazena a distância em t
+static bool RayEntityIntersection(const RayQuery& query, const glm::vec4& position, float& t)
+{
+    glm::vec4 to_entity = glm::vec4(
+        position.x - query.origin.x,
+        position.y - query.origin.y,
+        position.z - query.origin.z,
+        0.0f
+    );
+
+    float t_entity = glm::dot(glm::vec3(to_entity), glm::vec3(query.direction));
+    if (t_entity <= 0.0f || t_entity >= query.max_distance)
+        return false;
+
+    glm::vec4 closest_point = query.origin + query.direction * t_entity;
+    glm::vec4 to_closest = closest_point - position;
+    float distance_sq = to_closest.x * to_closest.x + to_closest.y * to_closest.y + to_closest.z * to_closest.z;
+    if (distance_sq > RAY_ENTITY_RADIUS * RAY_ENTITY_RADIUS)
+        return false;
+
+    t = t_entity;
+    return true;
+}
+
+void RayQueries_Resolve(World& world)
+{
+    const std::vector<RayQuery>& queries = world.ray_queries;
+    std::vector<RayHit>& hits = world.ray_hits;
+    hits.resize(queries.size());
+
+    // Raios que atingem caixas, ordenados pela chave do pacote (e pelo
+    // índice, para a ordem não depender do algoritmo de ordenação)
+    std::vector<std::pair<uint32_t, uint32_t> > order;
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        hits[i].layer = RAY_LAYER_NONE;
+        hits[i].t = queries[i].max_distance;
+        hits[i].enemy = EnemyHandle();
+        if (queries[i].layers & RAY_LAYER_WORLD)
+            order.push_back(std::make_pair(PacketKey(queries[i]), (uint32_t)i));
+    }
+    std::sort(order.begin(), order.end());
+
+    for (size_t begin = 0; begin < order.size(); begin += BOX_BVH_PACKET_SIZE)
+    {
+        int count = (int)std::min(order.size() - begin, (size_t)BOX_BVH_PACKET_SIZE);
+        glm::vec4 origins[BOX_BVH_PACKET_SIZE];
+        glm::vec4 directions[BOX_BVH_PACKET_SIZE];
+        float t[BOX_BVH_PACKET_SIZE];
+        bool hit[BOX_BVH_PACKET_SIZE];
+        for (int r = 0; r < count; ++r)
+        {
+            const RayQuery& query = queries[order[begin + r].second];
+            origins[r] = query.origin;
+            directions[r] = query.direction;
+            t[r] = query.max_distance;
+        }
+
+        BoxBVH_RaycastPacket(world.map->box_bvh, origins, directions, count, t, hit);
+
+        for (int r = 0; r < count; ++r)
+        {
+            if (!hit[r])
+                continue;
+            RayHit& result = hits[order[begin + r].second];
+            result.layer = RAY_LAYER_WORLD;
+            result.t = t[r];
+        }
+    }
+
+    // Jogador e inimigos só contam se estiverem mais perto que a caixa
+    // atingida (hits[i].t começa em max_distance). Em distâncias iguais fica
+    // o que foi encontrado antes: caixa, jogador e então o primeiro inimigo.
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        const RayQuery& query = queries[i];
+        RayHit& result = hits[i];
+        float t = 0.0f;
+
+        if ((query.layers & RAY_LAYER_PLAYER) &&
+            RayEntityIntersection(query, world.player.position, t) && t < result.t)
+        {
+            result.layer = RAY_LAYER_PLAYER;
+            result.t = t;
+        }
+
+        if (query.layers & RAY_LAYER_ENEMIES)
+        {
+            for (size_t e = 0; e < world.enemies.size(); ++e)
+            {
+                const Enemy& enemy = world.enemies[e];
+                if (enemy.IsDead())
+                    continue;
+
+                if (RayEntityIntersection(query, Simulation_EnemyPosition(world, e), t) && t < result.t)
+                {
+                    result.layer = RAY_LAYER_ENEMIES;
+                    result.t = t;
+                    result.enemy = enemy.handle;
+                }
+            }
+        }
+    }
+}
+
+// vim: set spell spelllang=pt_br :
@@ -0,0 +1,515 @@
+// Gravação e reprodução de partidas. Veja "replay.h".
+//
+// Formato do arquivo (inteiros little-endian, floats IEEE 754):
+//
+//     cabeçalho:  "FCGRPLAY", u32 versão, u32 tick_rate, u32 semente
+//     blocos:     u8 tipo, u32 tamanho do conteúdo, conteúdo
+//
+//     bloco 'K' (keyframe): u32 tick, estado de Simulation_SaveState()
+//     bloco 'I' (entradas): u32 primeiro tick, u32 número de ticks e, para
+//                           cada tick, um byte com os campos alterados
+//                           (REPLAY_FIELD_*) seguido dos campos: u16
+//                           buttons, f32 yaw, f32 pitch, f32 camera_distance
+//     bloco 'E' (eventos):  u32 primeiro tick, u32 número de ticks, u32
+//                           número de eventos e os GameEvent ("eventbus.h")
+//                           publicados nesses ticks, como na memória
+//
+// O primeiro bloco é sempre um keyframe. Um bloco de entradas termina a cada
+// keyframe, e a comparação com o tick anterior recomeça em cada bloco (a
+// partir de uma ação zerada), então cada bloco pode ser decodificado sozinho.
+// Cada bloco de entradas é seguido do bloco com os eventos dos mesmos ticks,
+// que a reprodução usa para conferir se a simulação não divergiu.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <vector>
+
+#include "replay.h"
+
+#define REPLAY_MAGIC   "FCGRPLAY"
+#define REPLAY_VERSION 10 // Incrementada quando a simulação muda de forma que os replays antigos divergem
+
+#define REPLAY_BLOCK_KEYFRAME 'K'
+#define REPLAY_BLOCK_INPUTS   'I'
+#define REPLAY_BLOCK_EVENTS   'E'
+
+#define REPLAY_EVENT_BATCH 256 // Eventos lidos de uma vez do EventBus
+
+// Campos de SimulationAction que mudaram desde o tick anterior
+#define REPLAY_FIELD_BUTTONS         (1u << 0)
+#define REPLAY_FIELD_YAW             (1u << 1)
+#define REPLAY_FIELD_PITCH           (1u << 2)
+#define REPLAY_FIELD_CAMERA_DISTANCE (1u << 3)
+
+struct ReplayKeyframe
+{
+    uint32_t tick;
+    size_t   offset; // Posição do estado em g_ReplayData
+    size_t   size;
+};
+
+// Gravação em andamento
+static FILE* g_RecordFile = NULL;
+static uint32_t g_RecordFirstTick = 0;
+static std::vector<unsigned char> g_RecordInputs; // Entradas codificadas do bloco atual
+static uint32_t g_RecordBlockFirstTick = 0;
+static uint32_t g_RecordBlockTicks = 0;
+static SimulationAction g_RecordPrevious;
+static std::vector<unsigned char> g_RecordState;
+static const EventBus* g_RecordBus = NULL;
+static EventSubscriber g_RecordSubscriber;
+static std::vector<GameEvent> g_RecordEvents; // Eventos dos ticks do bloco atual
+
+// Replay aberto
+static std::vector<unsigned char> g_ReplayData; // Arquivo inteiro
+static std::vector<SimulationAction> g_ReplayActions; // Uma por tick, a partir de g_ReplayFirstTick
+static std::vector<ReplayKeyframe> g_ReplayKeyframes;
+static uint32_t g_ReplayFirstTick = 0;
+static int g_ReplayTickRate = 0;
+static std::vector<GameEvent> g_ReplayEvents; // Eventos gravados, em ordem
+static uint32_t g_ReplayEventsEndTick = 0;    // Ticks antes deste têm os eventos gravados
+
+// Conferência dos eventos da reprodução com g_ReplayEvents
+static const EventBus* g_CheckBus = NULL;
+static EventSubscriber g_CheckSubscriber;
+static size_t g_CheckNext = 0;       // Próximo evento de g_ReplayEvents esperado
+static uint32_t g_CheckedEvents = 0;
+static bool g_CheckDiverged = false;
+
+static const SimulationAction g_NoAction = { 0, 0.0f, 0.0f, 0.0f };
+
+template <typename T>
+static void Append(std::vector<unsigned char>* out, T value)
+{
+    const unsigned char* bytes = (const unsigned char*)&value;
+    out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+static void WriteBlock(char type, const std::vector<unsigned char>& header, const std::vector<unsigned char>& content)
+{
+    uint32_t size = (uint32_t)(header.size() + content.size());
+    fputc(type, g_RecordFile);
+    fwrite(&size, sizeof(size), 1, g_RecordFile);
+    fwrite(header.data(), 1, header.size(), g_RecordFile);
+    fwrite(content.data(), 1, content.size(), g_RecordFile);
+}
+
+// Guarda os eventos publicados desde a última chamada (todos de ticks já
+// simulados)
+static void PollRecordEvents()
+{
+    GameEvent events[REPLAY_EVENT_BATCH];
+    size_t count;
+    while ((count = EventBus_Poll(*g_RecordBus, g_RecordSubscriber, events, REPLAY_EVENT_BATCH)) > 0)
+        g_RecordEvents.insert(g_RecordEvents.end(), events, events + count);
+}
+
+static void FlushInputs()
+{
+    if (g_RecordBlockTicks == 0)
+        return;
+
+    std::vector<unsigned char> header;
+    Append(&header, g_RecordBlockFirstTick);
+    Append(&header, g_RecordBlockTicks);
+    WriteBlock(REPLAY_BLOCK_INPUTS, header, g_RecordInputs);
+
+    // Um consumidor que perdeu eventos não tem o que gravar: sem o bloco, a
+    // reprodução não confere esses ticks
+    PollRecordEvents();
+    if (g_RecordSubscriber.lost == 0)
+    {
+        Append(&header, (uint32_t)g_RecordEvents.size());
+        std::vector<unsigned char> content((const unsigned char*)g_RecordEvents.data(),
+                                           (const unsigned char*)(g_RecordEvents.data() + g_RecordEvents.size()));
+        WriteBlock(REPLAY_BLOCK_EVENTS, header, content);
+    }
+    g_RecordEvents.clear();
+    g_RecordSubscriber.lost = 0;
+
+    g_RecordInputs.clear();
+    g_RecordBlockTicks = 0;
+}
+
+static void WriteKeyframe(const World& world)
+{
+    std::vector<unsigned char> header;
+    Append(&header, world.tick);
+    Simulation_SaveState(world, &g_RecordState);
+    WriteBlock(REPLAY_BLOCK_KEYFRAME, header, g_RecordState);
+}
+
+bool Replay_BeginRecording(const char* filename, const World& world, int tick_rate)
+{
+    Replay_EndRecording();
+
+    g_RecordFile = fopen(filename, "wb");
+    if (!g_RecordFile)
+        return false;
+
+    fwrite(REPLAY_MAGIC, 1, 8, g_RecordFile);
+    uint32_t header[3] = { REPLAY_VERSION, (uint32_t)tick_rate, world.seed };
+    fwrite(header, sizeof(header), 1, g_RecordFile);
+
+    g_RecordFirstTick = world.tick;
+    g_RecordInputs.clear();
+    g_RecordBlockTicks = 0;
+    WriteKeyframe(world);
+
+    g_RecordBus = &world.events;
+    EventBus_Subscribe(*g_RecordBus, g_RecordSubscriber);
+    g_RecordEvents.clear();
+    return true;
+}
+
+static bool SameFloat(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+void Replay_RecordTick(const World& world, const SimulationAction& action)
+{
+    if (!g_RecordFile)
+        return;
+
+    // Os eventos vão sendo lidos a cada tick, para o anel não encher
+    PollRecordEvents();
+    if (world.tick != g_RecordFirstTick && (world.tick - g_RecordFirstTick) % REPLAY_KEYFRAME_INTERVAL == 0)
+    {
+        FlushInputs();
+        WriteKeyframe(world);
+    }
+
+    if (g_RecordBlockTicks == 0)
+    {
+        g_RecordBlockFirstTick = world.tick;
+        g_RecordPrevious = g_NoAction;
+    }
+
+    unsigned char fields = 0;
+    if (action.buttons != g_RecordPrevious.buttons)
+        fields |= REPLAY_FIELD_BUTTONS;
+    if (!SameFloat(action.yaw, g_RecordPrevious.yaw))
+        fields |= REPLAY_FIELD_YAW;
+    if (!SameFloat(action.pitch, g_RecordPrevious.pitch))
+        fields |= REPLAY_FIELD_PITCH;
+    if (!SameFloat(action.camera_distance, g_RecordPrevious.camera_distance))
+        fields |= REPLAY_FIELD_CAMERA_DISTANCE;
+
+    g_RecordInputs.push_back(fields);
+    if (fields & REPLAY_FIELD_BUTTONS)
+        Append(&g_RecordInputs, (uint16_t)action.buttons);
+    if (fields & REPLAY_FIELD_YAW)
+        Append(&g_RecordInputs, action.yaw);
+    if (fields & REPLAY_FIELD_PITCH)
+        Append(&g_RecordInputs, action.pitch);
+    if (fields & REPLAY_FIELD_CAMERA_DISTANCE)
+        Append(&g_RecordInputs, action.camera_distance);
+
+    g_RecordPrevious = action;
+    g_RecordBlockTicks += 1;
+}
+
+void Replay_EndRecording()
+{
+    if (!g_RecordFile)
+        return;
+
+    FlushInputs();
+    fclose(g_RecordFile);
+    g_RecordFile = NULL;
+
+    EventBus_Unsubscribe(*g_RecordBus, g_RecordSubscriber);
+    g_RecordBus = NULL;
+}
+
+bool Replay_IsRecording()
+{
+    return g_RecordFile != NULL;
+}
+
+// Leitura sequencial de g_ReplayData
+struct ReplayReader
+{
+    size_t offset;
+    size_t end;
+
+    template <typename T>
+    bool Read(T* value)
+    {
+        if (end - offset < sizeof(T))
+            return false;
+        memcpy(value, g_ReplayData.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+};
+
+static bool DecodeInputs(ReplayReader reader)
+{
+    uint32_t first_tick, num_ticks;
+    if (!reader.Read(&first_tick) || !reader.Read(&num_ticks))
+        return false;
+    if (first_tick != g_ReplayFirstTick + g_ReplayActions.size())
+        return false; // Blocos fora de ordem ou faltando
+
+    SimulationAction action = g_NoAction;
+    for (uint32_t i = 0; i < num_ticks; ++i)
+    {
+        unsigned char fields;
+        if (!reader.Read(&fields))
+            return false;
+
+        uint16_t buttons;
+        if (fields & REPLAY_FIELD_BUTTONS)
+        {
+            if (!reader.Read(&buttons))
+                return false;
+            action.buttons = buttons;
+        }
+        if ((fields & REPLAY_FIELD_YAW) && !reader.Read(&action.yaw))
+            return false;
+        if ((fields & REPLAY_FIELD_PITCH) && !reader.Read(&action.pitch))
+            return false;
+        if ((fields & REPLAY_FIELD_CAMERA_DISTANCE) && !reader.Read(&action.camera_distance))
+            return false;
+
+        g_ReplayActions.push_back(action);
+    }
+    return reader.offset == reader.end;
+}
+
+static bool DecodeEvents(ReplayReader reader)
+{
+    uint32_t first_tick, num_ticks, num_events;
+    if (!reader.Read(&first_tick) || !reader.Read(&num_ticks) || !reader.Read(&num_events) ||
+        reader.end - reader.offset != (size_t)num_events * sizeof(GameEvent))
+        return false;
+    if (first_tick != g_ReplayEventsEndTick)
+        return true; // Faltam eventos de ticks anteriores: paramos de conferir aqui
+
+    size_t first = g_ReplayEvents.size();
+    g_ReplayEvents.resize(first + num_events);
+    memcpy(g_ReplayEvents.data() + first, g_ReplayData.data() + reader.offset, (size_t)num_events * sizeof(GameEvent));
+    g_ReplayEventsEndTick = first_tick + num_ticks;
+    return true;
+}
+
+bool Replay_Open(const char* filename)
+{
+    Replay_Close();
+
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: Não foi possível abrir o replay \"%s\".\n", filename);
+        return false;
+    }
+
+    unsigned char buffer[65536];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        g_ReplayData.insert(g_ReplayData.end(), buffer, buffer + read);
+    fclose(file);
+
+    ReplayReader reader = { 0, g_ReplayData.size() };
+    char magic[8];
+    uint32_t version, tick_rate, seed;
+    if (!reader.Read(&magic) || memcmp(magic, REPLAY_MAGIC, 8) != 0 ||
+        !reader.Read(&version) || !reader.Read(&tick_rate) || !reader.Read(&seed))
+    {
+        fprintf(stderr, "ERROR: \"%s\" não é um replay.\n", filename);
+        Replay_Close();
+        return false;
+    }
+    if (version != REPLAY_VERSION || tick_rate == 0)
+    {
+        fprintf(stderr, "ERROR: Replay \"%s\" com versão %u não suportada (esperada %d).\n", filename, version, REPLAY_VERSION);
+        Replay_Close();
+        return false;
+    }
+    g_ReplayTickRate = (int)tick_rate;
+
+    while (reader.offset < reader.end)
+    {
+        unsigned char type;
+        uint32_t size;
+        if (!reader.Read(&type) || !reader.Read(&size) || reader.end - reader.offset < size)
+            break; // Arquivo truncado: usamos os blocos completos
+
+        ReplayReader block = { reader.offset, reader.offset + size };
+        reader.offset += size;
+
+        if (type == REPLAY_BLOCK_KEYFRAME)
+        {
+            ReplayKeyframe keyframe;
+            if (!block.Read(&keyframe.tick))
+                break;
+            keyframe.offset = block.offset;
+            keyframe.size = block.end - block.offset;
+
+            if (g_ReplayKeyframes.empty())
+            {
+                g_ReplayFirstTick = keyframe.tick;
+                g_ReplayEventsEndTick = keyframe.tick;
+            }
+            g_ReplayKeyframes.push_back(keyframe);
+        }
+        else if (type == REPLAY_BLOCK_INPUTS)
+        {
+            if (g_ReplayKeyframes.empty() || !DecodeInputs(block))
+            {
+                fprintf(stderr, "ERROR: Replay \"%s\" corrompido.\n", filename);
+                Replay_Close();
+                return false;
+            }
+        }
+        else if (type == REPLAY_BLOCK_EVENTS)
+        {
+            if (g_ReplayKeyframes.empty() || !DecodeEvents(block))
+            {
+                fprintf(stderr, "ERROR: Replay \"%s\" corrompido.\n", filename);
+                Replay_Close();
+                return false;
+            }
+        }
+        // Outros tipos de bloco são ignorados
+    }
+
+    if (g_ReplayKeyframes.empty())
+    {
+        fprintf(stderr, "ERROR: Replay \"%s\" sem keyframes.\n", filename);
+        Replay_Close();
+        return false;
+    }
+    return true;
+}
+
+void Replay_Close()
+{
+    if (g_CheckBus)
+        EventBus_Unsubscribe(*g_CheckBus, g_CheckSubscriber);
+    g_CheckBus = NULL;
+    g_ReplayEvents.clear();
+    g_ReplayEventsEndTick = 0;
+
+    g_ReplayData.clear();
+    g_ReplayActions.clear();
+    g_ReplayKeyframes.clear();
+    g_ReplayFirstTick = 0;
+    g_ReplayTickRate = 0;
+}
+
+int Replay_GetTickRate()
+{
+    return g_ReplayTickRate;
+}
+
+uint32_t Replay_GetNumTicks()
+{
+    return (uint32_t)g_ReplayActions.size();
+}
+
+bool Replay_Seek(World& world, uint32_t tick)
+{
+    if (g_ReplayKeyframes.empty())
+        return false;
+
+    if (tick < g_ReplayFirstTick)
+        tick = g_ReplayFirstTick;
+    if (tick > g_ReplayFirstTick + g_ReplayActions.size())
+        tick = g_ReplayFirstTick + (uint32_t)g_ReplayActions.size();
+
+    // Último keyframe que não passa do tick pedido
+    const ReplayKeyframe* keyframe = &g_ReplayKeyframes[0];
+    for (const ReplayKeyframe& candidate : g_ReplayKeyframes)
+        if (candidate.tick <= tick)
+            keyframe = &candidate;
+
+    if (!Simulation_LoadState(world, g_ReplayData.data() + keyframe->offset, keyframe->size) ||
+        world.tick != keyframe->tick)
+    {
+        fprintf(stderr, "ERROR: Keyframe do tick %u inválido (replay gravado por outro executável?).\n", keyframe->tick);
+        return false;
+    }
+
+    const float delta_time = 1.0f / g_ReplayTickRate;
+    SimulationAction action;
+    while (world.tick < tick && Replay_GetAction(world, &action))
+    {
+        Simulation_ApplyAction(world, action);
+        Simulation_Step(world, delta_time);
+    }
+
+    // A conferência dos eventos começa no tick alcançado
+    if (g_CheckBus)
+        EventBus_Unsubscribe(*g_CheckBus, g_CheckSubscriber);
+    g_CheckBus = &world.events;
+    EventBus_Subscribe(*g_CheckBus, g_CheckSubscriber);
+    g_CheckNext = 0;
+    while (g_CheckNext < g_ReplayEvents.size() && g_ReplayEvents[g_CheckNext].tick < world.tick)
+        g_CheckNext += 1;
+    g_CheckedEvents = 0;
+    g_CheckDiverged = false;
+    return true;
+}
+
+bool Replay_CheckEvents(const World& world)
+{
+    if (g_CheckBus != &world.events || g_CheckDiverged)
+        return !g_CheckDiverged;
+
+    GameEvent events[REPLAY_EVENT_BATCH];
+    size_t count;
+    while (!g_CheckDiverged && (count = EventBus_Poll(world.events, g_CheckSubscriber, events, REPLAY_EVENT_BATCH)) > 0)
+    {
+        for (size_t i = 0; i < count && !g_CheckDiverged; ++i)
+        {
+            if (events[i].tick >= g_ReplayEventsEndTick)
+                continue; // Ticks sem eventos gravados
+
+            const GameEvent* expected = g_CheckNext < g_ReplayEvents.size() ? &g_ReplayEvents[g_CheckNext] : NULL;
+            if (!expected || memcmp(expected, &events[i], sizeof(GameEvent)) != 0)
+            {
+                fprintf(stderr, "WARNING: A simulação divergiu do replay no tick %u (evento %u conferido).\n",
+                        events[i].tick, g_CheckedEvents);
+                g_CheckDiverged = true;
+                break;
+            }
+            g_CheckNext += 1;
+            g_CheckedEvents += 1;
+        }
+    }
+
+    // Eventos gravados que não aconteceram também são uma divergência
+    if (!g_CheckDiverged && g_CheckNext < g_ReplayEvents.size() && g_ReplayEvents[g_CheckNext].tick < world.tick)
+    {
+        fprintf(stderr, "WARNING: A simulação divergiu do replay no tick %u (evento gravado não aconteceu).\n",
+                g_ReplayEvents[g_CheckNext].tick);
+        g_CheckDiverged = true;
+    }
+    return !g_CheckDiverged;
+}
+
+uint32_t Replay_GetCheckedEvents()
+{
+    return g_CheckedEvents;
+}
+
+bool Replay_HasEvents()
+{
+    return g_ReplayEventsEndTick > g_ReplayFirstTick;
+}
+
+bool Replay_GetAction(const World& world, SimulationAction* action)
+{
+    if (world.tick < g_ReplayFirstTick || world.tick - g_ReplayFirstTick >= g_ReplayActions.size())
+        return false;
+
+    *action = g_ReplayActions[world.tick - g_ReplayFirstTick];
+    return true;
+}
+
+// vim: set spell spelllang=pt_br :
@@ -26,6 +26,7 @@ uniform mat4 projection;
 #define PLAYER 1
 #define ENEMY  2
 #define BOX    10
+#define BAKED_BOX 15
 uniform int object_id;
 
 // Parâmetros da axis-aligned bounding box (AABB) do modelo
@@ -38,6 +39,16 @@ uniform sampler2D TextureImage1;
 uniform sampler2D TextureImage2;
 uniform int use_texture;
 
+// Shadow maps da fonte de luz direcional. O mapa estático contém o chão e as
+// caixas e só é re-renderizado quando o mapa muda; o dinâmico contém o jogador
+// e os inimigos e é re-renderizado a cada quadro em uma região ao redor do
+// jogador. Veja RenderStaticShadowMap() e RenderDynamicShadowMap() em "main.cpp".
+uniform sampler2DShadow ShadowMapStatic;
+uniform sampler2DShadow ShadowMapDynamic;
+uniform mat4 light_view_projection_static;
+uniform mat4 light_view_projection_dynamic;
+uniform int use_shadows;
+
 // O valor de saída ("out") de um Fragment Shader é a cor final do fragmento.
 out vec4 color;
 
@@ -45,6 +56,42 @@ out vec4 color;
 #define M_PI   3.14159265358979323846
 #define M_PI_2 1.57079632679489661923
 
+// Amostra um shadow map com PCF 3x3. Retorna 1.0 se o ponto p está iluminado e
+// 0.0 se está totalmente na sombra. Pontos fora da região coberta pelo mapa
+// são considerados iluminados.
+float SampleShadowMap(sampler2DShadow shadow_map, mat4 light_view_projection, vec4 p, float bias)
+{
+    vec4 p_light = light_view_projection * p;
+    vec3 coords = p_light.xyz / p_light.w * 0.5 + 0.5;
+
+    if (coords.x < 0.0 || coords.x > 1.0 || coords.y < 0.0 || coords.y > 1.0 || coords.z > 1.0)
+        return 1.0;
+
+    vec2 texel = 1.0 / vec2(textureSize(shadow_map, 0));
+    float visibility = 0.0;
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            visibility += texture(shadow_map, vec3(coords.xy + vec2(x, y) * texel, coords.z - bias));
+
+    return visibility / 9.0;
+}
+
+// Combina o shadow map estático (cacheado) com o dinâmico (por quadro).
+float ShadowFactor(vec4 p, vec4 n, vec4 l)
+{
+    if (use_shadows == 0)
+        return 1.0;
+
+    // Bias proporcional à inclinação da superfície em relação à luz, para
+    // evitar "shadow acne".
+    float bias = max(0.002 * (1.0 - dot(n, l)), 0.0005);
+
+    float static_visibility  = SampleShadowMap(ShadowMapStatic,  light_view_projection_static,  p, bias);
+    float dynamic_visibility = SampleShadowMap(ShadowMapDynamic, light_view_projection_dynamic, p, bias);
+
+    return min(static_visibility, dynamic_visibility);
+}
+
 void main()
 {
     // Obtemos a posição da câmera utilizando a inversa da matriz que define o
@@ -73,6 +120,15 @@ void main()
     float U = 0.0;
     float V = 0.0;
 
+    // Fator de sombra (1.0 = iluminado, 0.0 = na sombra). Afeta apenas os
+    // termos difuso e especular; o termo ambiente é mantido. Linhas de debug,
+    // crosshair, barras de vida e gráficos de profiling (object_id de 3 a 14,
+    // exceto BOX, e 16 e 17) não são iluminados, então não pagam pela
+    // amostragem dos shadow maps.
+    float shadow = 1.0;
+    if (object_id < 3 || object_id == BOX || object_id == BAKED_BOX || object_id > 17)
+        shadow = ShadowFactor(p, n, l);
+
     // ------------------------------
     // SE MODO = GOURAUD → usa cor pronta
     // ------------------------------
@@ -83,7 +139,11 @@ void main()
         if (use_texture == 1)
             texcolor = texture(TextureImage0, texcoords).rgb;
     
-        color.rgb = texcolor * gouraud_color;
+        // gouraud_color é o ambiente (0.2, veja "shader_vertex.glsl") mais os
+        // termos difuso e especular; a sombra atenua só estes dois, como no
+        // modelo por fragmento.
+        float gouraud_ambient = 0.2;
+        color.rgb = texcolor * (gouraud_ambient + (gouraud_color - gouraud_ambient) * shadow);
         color.a = 1.0;
         color.rgb = pow(color.rgb, vec3(1.0/2.2));
         return;
@@ -96,7 +156,7 @@ void main()
         vec3 texcolor = texture(TextureImage0, uv).rgb;
 
         float lambert = max(0.0, dot(n, l));
-        color.rgb = texcolor * (lambert + 0.2);
+        color.rgb = texcolor * (lambert * shadow + 0.2);
         return;
     }
 
@@ -156,6 +216,14 @@ void main()
         // Cor verde para hitbox do jogador
         color.rgb = vec3(0.0, 1.0, 0.0);
     }
+    else if ( object_id == 16 ) // PROFILER_GRAPH - gráfico de tempo de quadro (laranja)
+    {
+        color.rgb = vec3(1.0, 0.6, 0.0);
+    }
+    else if ( object_id == 17 ) // PROFILER_GRAPH_GUIDE - linhas de referência do gráfico (cinza)
+    {
+        color.rgb = vec3(0.6, 0.6, 0.6);
+    }
     else if (object_id == PLAYER)
     {
         // Difusa (Lambert) a partir da textura
@@ -178,7 +246,7 @@ void main()
         vec3 ks = vec3(0.25);            // intensidade especular
 
         // Cor final: difusa + especular + um ambientezinho
-        color.rgb = kd * (lambert + 0.2) + ks * spec;
+        color.rgb = kd * (lambert * shadow + 0.2) + ks * spec * shadow;
     }
     else if (object_id == ENEMY)
     {
@@ -208,82 +276,93 @@ void main()
         float spec = pow(max(dot(N, H), 0.0), shininess);
         vec3 ks = vec3(0.20);          // especular um pouco mais fraca
 
-        color.rgb = kd * (lambert + 0.2) + ks * spec;
+        color.rgb = kd * (lambert * shadow + 0.2) + ks * spec * shadow;
     }
 
-    else if (object_id == BOX)
+    else if (object_id == BOX || object_id == BAKED_BOX)
     {
         // Usa textura de crate para caixas
-        // Gera coordenadas de textura baseadas na posição do modelo
-        // O cubo vai de -1 a 1 em cada eixo
-        // Como cube.obj não tem coordenadas de textura, sempre geramos UVs baseados na face
-        vec3 pos = position_model.xyz;
-        vec3 absPos = abs(pos);
         vec2 uv;
-        
-        // Determina qual face do cubo baseado na coordenada mais próxima de 1.0
-        // Isso garante que cada face tenha o mapeamento correto
-        if (absPos.x >= absPos.y && absPos.x >= absPos.z)
+
+        if (object_id == BAKED_BOX)
         {
-            // Face lateral (X é dominante)
-            if (pos.x > 0.0)
-            {
-                // Right face (X = 1): usa -Z e Y
-                uv = vec2(
-                    (-pos.z + 1.0) * 0.5,
-                    (pos.y + 1.0) * 0.5
-                );
-            }
-            else
-            {
-                // Left face (X = -1): usa Z e Y
-                uv = vec2(
-                    (pos.z + 1.0) * 0.5,
-                    (pos.y + 1.0) * 0.5
-                );
-            }
+            // Caixas "assadas" em coordenadas do mundo (veja BakeStaticBoxes()
+            // em main.cpp): position_model não é mais a posição no cubo, então
+            // as UVs por face foram calculadas na CPU com a mesma regra abaixo.
+            uv = texcoords;
         }
-        else if (absPos.y >= absPos.z)
+        else
         {
-            // Face superior/inferior (Y é dominante)
-            if (pos.y > 0.0)
+            // Gera coordenadas de textura baseadas na posição do modelo
+            // O cubo vai de -1 a 1 em cada eixo
+            // Como cube.obj não tem coordenadas de textura, sempre geramos UVs baseados na face
+            vec3 pos = position_model.xyz;
+            vec3 absPos = abs(pos);
+
+            // Determina qual face do cubo baseado na coordenada mais próxima de 1.0
+            // Isso garante que cada face tenha o mapeamento correto
+            if (absPos.x >= absPos.y && absPos.x >= absPos.z)
             {
-                // Top face (Y = 1): usa X e -Z
-                uv = vec2(
-                    (pos.x + 1.0) * 0.5,
-                    (-pos.z + 1.0) * 0.5
-                );
+                // Face lateral (X é dominante)
+                if (pos.x > 0.0)
+                {
+                    // Right face (X = 1): usa -Z e Y
+                    uv = vec2(
+                        (-pos.z + 1.0) * 0.5,
+                        (pos.y + 1.0) * 0.5
+                    );
+                }
+                else
+                {
+                    // Left face (X = -1): usa Z e Y
+                    uv = vec2(
+                        (pos.z + 1.0) * 0.5,
+                        (pos.y + 1.0) * 0.5
+                    );
+                }
             }
-            else
-            {
-                // Bottom face (Y = -1): usa X e Z
-                uv = vec2(
-                    (pos.x + 1.0) * 0.5,
-                    (pos.z + 1.0) * 0.5
-                );
-            }
-        }
-        else
-        {
-            // Face frontal/traseira (Z é dominante)
-            if (pos.z > 0.0)
+            else if (absPos.y >= absPos.z)
             {
-                // Front face (Z = 1): usa X e Y
-                uv = vec2(
-                    (pos.x + 1.0) * 0.5,
-                    (pos.y + 1.0) * 0.5
-                );
+                // Face superior/inferior (Y é dominante)
+                if (pos.y > 0.0)
+                {
+                    // Top face (Y = 1): usa X e -Z
+                    uv = vec2(
+                        (pos.x + 1.0) * 0.5,
+                        (-pos.z + 1.0) * 0.5
+                    );
+                }
+                else
+                {
+                    // Bottom face (Y = -1): usa X e Z
+                    uv = vec2(
+                        (pos.x + 1.0) * 0.5,
+                        (pos.z + 1.0) * 0.5
+                    );
+                }
             }
             else
             {
-                // Back face (Z = -1): usa -X e Y (flip X)
-                uv = vec2(
-                    (-pos.x + 1.0) * 0.5,
-                    (pos.y + 1.0) * 0.5
-                );
+                // Face frontal/traseira (Z é dominante)
+                if (pos.z > 0.0)
+                {
+                    // Front face (Z = 1): usa X e Y
+                    uv = vec2(
+                        (pos.x + 1.0) * 0.5,
+                        (pos.y + 1.0) * 0.5
+                    );
+                }
+                else
+                {
+                    // Back face (Z = -1): usa -X e Y (flip X)
+                    uv = vec2(
+                        (-pos.x + 1.0) * 0.5,
+                        (pos.y + 1.0) * 0.5
+                    );
+                }
             }
         }
-        
+
         vec3 kd = texture(TextureImage0, uv).rgb;
         
         // Normaliza vetores
@@ -301,13 +380,13 @@ void main()
         vec3 ks = vec3(0.15);
         
         // Cor final: difusa + especular + ambiente
-        color.rgb = kd * (lambert + 0.2) + ks * spec;
+        color.rgb = kd * (lambert * shadow + 0.2) + ks * spec * shadow;
     }
     else
     {
         vec3 neutral_color = vec3(0.75, 0.75, 0.8);
         float lambert = max(0,dot(n,l));
-        color.rgb = neutral_color * (lambert + 0.1);
+        color.rgb = neutral_color * (lambert * shadow + 0.1);
     }
 
 
@@ -0,0 +1,7 @@
+#version 330 core
+
+// Fragment Shader do passe de shadow map. Apenas a profundidade é escrita (o
+// framebuffer não possui anexo de cor), então não há nenhuma saída de cor.
+void main()
+{
+}
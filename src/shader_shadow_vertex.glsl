@@ -0,0 +1,15 @@
+#version 330 core
+
+// Vertex Shader utilizado apenas para gerar os shadow maps (passe de
+// profundidade a partir da fonte de luz direcional). Veja as funções
+// RenderStaticShadowMap() e RenderDynamicShadowMap() em "main.cpp".
+layout (location = 0) in vec4 model_coefficients;
+
+// Matriz de modelagem do objeto e matriz view*projection da fonte de luz
+uniform mat4 model;
+uniform mat4 light_view_projection;
+
+void main()
+{
+    gl_Position = light_view_projection * model * model_coefficients;
+}
@@ -0,0 +1,1843 @@
+// Lógica do jogo, sem OpenGL nem GLFW. Veja "simulation.h".
+//
+// O código aqui foi separado de "main.cpp" para que a simulação possa rodar
+// sem janela (executável "fcg_headless"). Tudo o que depende de renderização
+// (modelos, texturas, linhas dos raycasts) continua em "main.cpp"; a
+// simulação só conhece as bounding boxes dos modelos (ModelBounds).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
+#include "boxbvh.h"
+#include "boxgrid.h"
+#include "cpuprofiler.h"
+#include "eventbus.h"
+#include "flowfield.h"
+#include "freespace.h"
+#include "jobsystem.h"
+#include "logger.h"
+#include "rayqueries.h"
+#include "simulation.h"
+
+#define SIMULATION_PI 3.141592f
+
+#define ENEMY_PURSUIT_MIN_DISTANCE 8.0f // Mais perto que isto do jogador, os inimigos andam ao acaso em vez de se aproximar
+#define ENEMY_HITBOX_RADIUS        0.3f // Raio da hitbox do inimigo (mesmo usado na detecção)
+#define ENEMY_FLOW_FIELD_RADIUS    0.4f // Margem das caixas no campo de fluxo (raio da hitbox do inimigo mais folga)
+
+#define SIMULATION_PARALLEL_MIN_ENEMIES 2048 // Com menos inimigos, UpdateEnemies() roda em uma thread só
+#define SIMULATION_ENEMY_JOB_SIZE       512  // Inimigos por job em UpdateEnemies()
+
+ModelBounds g_CowboyBounds = { glm::vec3(0.0f), glm::vec3(0.0f) };
+ModelBounds g_BanditBounds = { glm::vec3(0.0f), glm::vec3(0.0f) };
+float g_CowboyMinY = 0.0f; // menor y do cowboy em coordenadas de modelo
+float g_BanditMinY = 0.0f;
+glm::vec3 g_BanditCenterModel = glm::vec3(0.0f); // centro do bandit em coordenadas de modelo
+glm::vec3 g_CowboyCenterModel = glm::vec3(0.0f); // centro do cowboy em coordenadas de modelo
+
+// Mapa compartilhado pelos World (veja WorldMap), criado por DefaultMap() e
+// descartado quando as bounding boxes mudam
+static std::shared_ptr<const WorldMap> g_DefaultMap;
+static std::mutex g_DefaultMapMutex;
+
+// As mensagens da simulação ficam nas categorias "simulation", "combat" e
+// "waves" do logger ("logger.h"): rodando milhares de ticks por segundo, elas
+// dominariam o tempo medido, então o fcg_headless as desliga.
+void Simulation_SetVerbose(bool verbose)
+{
+    Logger_SetCategoryEnabled(LOG_CATEGORY_SIMULATION, verbose);
+    Logger_SetCategoryEnabled(LOG_CATEGORY_COMBAT, verbose);
+    Logger_SetCategoryEnabled(LOG_CATEGORY_WAVES, verbose);
+}
+
+void Simulation_SetModelBounds(const ModelBounds& cowboy, const ModelBounds& bandit)
+{
+    g_CowboyBounds = cowboy;
+    g_BanditBounds = bandit;
+
+    g_CowboyMinY = cowboy.bbox_min.y;
+    g_CowboyCenterModel = (cowboy.bbox_min + cowboy.bbox_max) * 0.5f;
+
+    g_BanditMinY = bandit.bbox_min.y;
+    g_BanditCenterModel = (bandit.bbox_min + bandit.bbox_max) * 0.5f;
+
+    // O espaço livre dos inimigos depende da hitbox: o próximo
+    // Simulation_Init() cria o mapa de novo (os World já iniciados mantêm o
+    // seu)
+    std::lock_guard<std::mutex> lock(g_DefaultMapMutex);
+    g_DefaultMap.reset();
+}
+
+// Centro da hitbox do inimigo em relação à sua posição (mesma lógica do
+// hitbox rendering)
+static glm::vec3 EnemyHitboxOffset()
+{
+    const float enemy_scale_collision = 0.3f;
+    const float enemy_scale_y_collision = 0.3f;
+    
+    // Obtém os offsets do centro do modelo em coordenadas de modelo
+    float center_x = (g_BanditBounds.bbox_min.x + g_BanditBounds.bbox_max.x) * 0.5f;
+    float center_z = (g_BanditBounds.bbox_min.z + g_BanditBounds.bbox_max.z) * 0.5f;
+    
+    return glm::vec3(
+        center_x * enemy_scale_collision,
+        g_BanditCenterModel.y * enemy_scale_y_collision,
+        center_z * enemy_scale_collision
+    );
+}
+
+// Formato do descritor: uma linha por modelo, com o nome seguido de bbox_min
+// e bbox_max.
+//
+//     cowboy -1.02 0.00 -0.31 1.02 5.86 0.40
+//     bandit -0.95 0.00 -0.35 0.95 5.70 0.41
+bool Simulation_LoadModelBounds(const char* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if (!file)
+        return false;
+
+    ModelBounds cowboy, bandit;
+    bool has_cowboy = false;
+    bool has_bandit = false;
+
+    char name[32];
+    ModelBounds bounds;
+    while (fscanf(file, "%31s %f %f %f %f %f %f", name,
+                  &bounds.bbox_min.x, &bounds.bbox_min.y, &bounds.bbox_min.z,
+                  &bounds.bbox_max.x, &bounds.bbox_max.y, &bounds.bbox_max.z) == 7)
+    {
+        if (strcmp(name, "cowboy") == 0)
+        {
+            cowboy = bounds;
+            has_cowboy = true;
+        }
+        else if (strcmp(name, "bandit") == 0)
+        {
+            bandit = bounds;
+            has_bandit = true;
+        }
+    }
+    fclose(file);
+
+    if (!has_cowboy || !has_bandit)
+        return false;
+
+    Simulation_SetModelBounds(cowboy, bandit);
+    return true;
+}
+
+bool Simulation_SaveModelBounds(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if (!file)
+        return false;
+
+    const char* names[2] = { "cowboy", "bandit" };
+    const ModelBounds* bounds[2] = { &g_CowboyBounds, &g_BanditBounds };
+    for (int i = 0; i < 2; ++i)
+    {
+        fprintf(file, "%s %.6f %.6f %.6f %.6f %.6f %.6f\n", names[i],
+                bounds[i]->bbox_min.x, bounds[i]->bbox_min.y, bounds[i]->bbox_min.z,
+                bounds[i]->bbox_max.x, bounds[i]->bbox_max.y, bounds[i]->bbox_max.z);
+    }
+    fclose(file);
+    return true;
+}
+
+// Caixas/barrils espalhados por todo o mapa. A stream de números aleatórios
+// tem semente fixa, então o layout é sempre o mesmo; ele vai para o mapa
+// compartilhado por todos os World (DefaultMap()).
+#define SIMULATION_BOXES_SEED 0x5eed
+static std::vector<Box> BoxLayout()
+{
+    std::vector<Box> boxes;
+    RandomStream rng;
+    rng.Seed(SIMULATION_BOXES_SEED, SIMULATION_STREAM_BOXES);
+
+    const float ground_y = -1.1f;
+    const float box_y = ground_y + 0.25f; // Caixas ficam meio acima do chão
+    
+    // Espaçamento entre caixas (ajustável) - meio termo entre muito espalhado e muito denso
+    const float box_spacing = 5.5f; // Distância entre caixas (meio termo: 4.0f original, 8.0f muito espalhado)
+    const float box_margin = 2.0f; // Margem das bordas do mapa
+    
+    // Gera caixas em uma grade cobrindo todo o mapa
+    for (float x = MAP_MIN_X + box_margin; x <= MAP_MAX_X - box_margin; x += box_spacing)
+    {
+        for (float z = MAP_MIN_Z + box_margin; z <= MAP_MAX_Z - box_margin; z += box_spacing)
+        {
+            // Adiciona alguma variação aleatória na posição para parecer mais natural
+            float offset_x = rng.NextBelow(100) / 100.0f * 1.0f - 0.5f; // -0.5 a 0.5
+            float offset_z = rng.NextBelow(100) / 100.0f * 1.0f - 0.5f; // -0.5 a 0.5
+            
+            // Variação na rotação
+            float rotation = rng.NextBelow(100) / 100.0f * 2.0f * SIMULATION_PI; // 0 a 2π
+            
+            // Variação no tamanho (algumas caixas maiores, outras menores)
+            float scale_variation = 0.3f + rng.NextBelow(100) / 100.0f * 0.4f; // 0.3 a 0.7
+            float height_variation = 0.3f + rng.NextBelow(100) / 100.0f * 0.5f; // 0.3 a 0.8
+            
+            // Aplica variação com probabilidade média (meio termo entre 40% e 80%)
+            if (rng.NextBelow(100) < 65) // 65% de chance de ter uma caixa nesta posição
+            {
+                boxes.push_back(Box(
+                    glm::vec4(x + offset_x, box_y, z + offset_z, 1.0f),
+                    rotation,
+                    glm::vec3(scale_variation, height_variation, scale_variation)
+                ));
+            }
+        }
+    }
+
+    return boxes;
+}
+
+// Calcula as estruturas de consulta das caixas "boxes"
+static std::shared_ptr<const WorldMap> BuildMap(const std::vector<Box>& boxes)
+{
+    std::shared_ptr<WorldMap> map = std::make_shared<WorldMap>();
+    map->boxes = boxes;
+    BoxGrid_Build(map->box_grid, map->boxes);
+    BoxBVH_Build(map->box_bvh, map->box_grid.aabbs);
+    FlowField_Build(map->flow_field, map->box_grid.aabbs, ENEMY_FLOW_FIELD_RADIUS);
+    FreeSpace_Build(map->enemy_free_space, map->box_grid.aabbs, ENEMY_HITBOX_RADIUS, EnemyHitboxOffset());
+    return map;
+}
+
+// Mapa das caixas de BoxLayout(), criado no primeiro uso. Simulation_Init()
+// pode ser chamada de várias threads ao mesmo tempo (SimulationBatch_Step()).
+static std::shared_ptr<const WorldMap> DefaultMap()
+{
+    std::lock_guard<std::mutex> lock(g_DefaultMapMutex);
+    if (!g_DefaultMap)
+        g_DefaultMap = BuildMap(BoxLayout());
+    return g_DefaultMap;
+}
+
+void Simulation_Init(World& world, uint32_t seed)
+{
+    // Os vetores são esvaziados mas mantêm a memória já alocada, então
+    // reiniciar um World não aloca de novo.
+    world.player = Player();
+    world.enemies.clear();
+    EnemyPaths_Clear(world.enemy_paths);
+    world.enemy_raycasts.clear();
+    world.enemy_slots.clear();
+    world.enemy_free_slots.clear();
+    world.enemies_dying = 0;
+    world.enemies_killed = 0;
+    world.enemy_damage_total = 0.0f;
+    world.enemy_path_stats = EnemyPathStats();
+    world.waves.clear();
+    world.map = DefaultMap();
+    world.flow_field = world.map->flow_field; // Copiar mantém a memória do campo anterior
+    world.next_wave_id = 0;
+    world.time = 0.0;
+    world.tick = 0;
+    world.seed = seed;
+    world.enemy_paths_rng.Seed(seed, SIMULATION_STREAM_ENEMY_PATHS);
+    world.enemy_shots_rng.Seed(seed, SIMULATION_STREAM_ENEMY_SHOTS);
+    world.enemy_spawn_rng.Seed(seed, SIMULATION_STREAM_ENEMY_SPAWN);
+
+    const float player_scale = 0.3f;
+    const float ground_y = -1.1f;
+
+    // Posiciona o jogador com os pés no chão, centralizado na origem
+    world.player.model_center = g_CowboyCenterModel; // agora o player sabe o centro real do modelo!
+
+    float center_x = (g_CowboyBounds.bbox_min.x + g_CowboyBounds.bbox_max.x) * 0.5f;
+    float center_z = (g_CowboyBounds.bbox_min.z + g_CowboyBounds.bbox_max.z) * 0.5f;
+
+    float player_y = ground_y - g_CowboyMinY * player_scale;
+
+    world.player.position = glm::vec4(
+        -center_x * player_scale,
+        player_y,
+        -center_z * player_scale,
+        1.0f
+    );
+    world.player.UpdateDirectionVectors();
+    world.player.SavePreviousTransform();
+
+    LOG_DEBUG(LOG_CATEGORY_SIMULATION, ">>> Player pos = (%f, %f, %f)",
+        world.player.position.x, world.player.position.y, world.player.position.z);
+
+    // Inicializamos a câmera para começar olhando para o jogador
+    world.player.camera_angle_horizontal = 0.0f;
+    world.player.camera_angle_vertical = 0.3f;
+
+    // Campo de fluxo até o jogador, para as curvas da primeira wave
+    FlowField_Update(world.flow_field, world.player.position);
+
+    // Inicializa o sistema de waves; a primeira spawnada é
+    // wave_config.first_wave
+    int first_wave = std::max(world.wave_config.first_wave, 1);
+    if (world.wave_config.max_waves > 0)
+        first_wave = std::min(first_wave, world.wave_config.max_waves);
+    world.current_wave_number = first_wave - 1;
+    world.wave_cleared = false;
+    world.wave_cleared_timer = 0.0f;
+    
+    // Spawna a primeira wave
+    SpawnNextWave(world);
+}
+
+// Atualiza o jogador: movimento, cooldown de tiro e recarregamento
+static void UpdatePlayer(World& world, float delta_time)
+{
+    // Atualizamos a posição do jogador baseado no movimento
+    world.player.UpdatePosition(world, delta_time);
+
+    // Atualizamos os vetores de direção do jogador
+    // IMPORTANTE: só no modo terceira pessoa!
+    // No modo primeira pessoa, o forward/right são atualizados no CursorPosCallback()
+    // com base nos ângulos da câmera, incluindo o pitch.
+    // Se chamarmos UpdateDirectionVectors() aqui, perdemos o componente Y do forward.
+    if (world.camera_mode == CAMERA_THIRD_PERSON)
+    {
+        world.player.UpdateDirectionVectors();
+    }
+
+    // Atualizamos o cooldown de tiro
+    if (world.player.shoot_cooldown > 0.0f)
+    {
+        world.player.shoot_cooldown -= delta_time;
+        if (world.player.shoot_cooldown < 0.0f)
+            world.player.shoot_cooldown = 0.0f;
+    }
+
+    // Atualizamos o tempo de reload
+    if (world.player.is_reloading)
+    {
+        world.player.reload_time -= delta_time;
+        if (world.player.reload_time <= 0.0f)
+        {
+            // Recarregamento completo - recarrega o carregador
+            world.player.magazine_ammo = world.player.magazine_size;
+            world.player.is_reloading = false;
+            world.player.reload_time = 0.0f;
+        }
+    }
+}
+
+static void GenerateEnemyPath(World& world, size_t enemy_index);
+
+// Dados dos jobs de UpdateEnemies()
+struct EnemyUpdateJob
+{
+    World* world;
+    float delta_time;
+};
+
+// Buffer de comandos da thread corrente. Fora do sistema de jobs (ex.:
+// threads de "simulationbatch.h") UpdateEnemies() roda inteira na thread
+// que chama, com o buffer 0 do próprio World.
+static std::vector<EnemyCommand>& EnemyCommands(World& world)
+{
+    int thread = JobSystem_ThreadIndex();
+    return world.enemy_commands[thread > 0 ? thread : 0];
+}
+
+static bool CompareEnemyCommands(const EnemyCommand& a, const EnemyCommand& b)
+{
+    if (a.type != b.type)
+        return a.type < b.type;
+    return a.enemy < b.enemy;
+}
+
+// Inimigos que chegaram ao destino no tick anterior pedem uma nova curva.
+// Os mortos já foram removidos no fim do tick anterior, e os tiros só são
+// resolvidos depois de UpdateEnemies() (Simulation_ResolveShots()).
+static void PrepareEnemies(void* data, size_t begin, size_t end)
+{
+    World& world = *((EnemyUpdateJob*)data)->world;
+    std::vector<EnemyCommand>& commands = EnemyCommands(world);
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (world.enemy_paths.progress[i] >= 1.0f)
+            commands.push_back(EnemyCommand{ ENEMY_COMMAND_NEW_PATH, (uint32_t)i });
+    }
+}
+
+// Posição e direção dos inimigos na curva, com o kernel SIMD
+static void MoveEnemies(void* data, size_t begin, size_t end)
+{
+    CPU_PROFILE_ZONE("enemy_paths");
+    EnemyUpdateJob* job = (EnemyUpdateJob*)data;
+    EnemyPaths_UpdateRange(job->world->enemy_paths, begin, end, job->delta_time);
+}
+
+// Corrige as saídas do kernel, que passam a ser a posição e a direção do
+// inimigo: limites do mapa, colisão com as caixas e direção. Depois, os
+// timers de tiro. Só altera o próprio inimigo; novas curvas e sorteios de
+// tiro viram comandos.
+static void CommitEnemies(void* data, size_t begin, size_t end)
+{
+    EnemyUpdateJob* job = (EnemyUpdateJob*)data;
+    World& world = *job->world;
+    float delta_time = job->delta_time;
+    EnemyPaths& paths = world.enemy_paths;
+    std::vector<EnemyCommand>& commands = EnemyCommands(world);
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        auto& enemy = world.enemies[i];
+
+        // Garante que a posição está dentro dos limites do mapa
+        glm::vec4 new_position = glm::vec4(
+            glm::clamp(paths.x[i], MAP_MIN_X, MAP_MAX_X),
+            paths.y[i],
+            glm::clamp(paths.z[i], MAP_MIN_Z, MAP_MAX_Z),
+            1.0f
+        );
+        glm::vec4 old_position = glm::vec4(paths.previous_x[i], paths.y[i], paths.previous_z[i], 1.0f);
+
+        // Um inimigo que já encosta em uma caixa (ex.: nasceu dentro dela)
+        // pode andar até sair
+        bool blocked = CheckEnemyBoxCollision(world, new_position) && !CheckEnemyBoxCollision(world, old_position);
+        if (blocked)
+        {
+            // Colisão detectada! Recalcula o caminho Bezier para evitar a
+            // caixa e não se move neste tick. Com as curvas validadas por
+            // GenerateEnemyPath(), só acontece quando nenhuma curva livre
+            // foi encontrada.
+            commands.push_back(EnemyCommand{ ENEMY_COMMAND_REPLAN, (uint32_t)i });
+            new_position = old_position;
+        }
+        paths.x[i] = new_position.x;
+        paths.z[i] = new_position.z;
+
+        // Olha na direção do movimento; parado (ou bloqueado), mantém a
+        // direção anterior
+        if (blocked || (paths.heading_x[i] == 0.0f && paths.heading_z[i] == 0.0f))
+        {
+            paths.heading_x[i] = paths.previous_heading_x[i];
+            paths.heading_z[i] = paths.previous_heading_z[i];
+        }
+
+        // Atualiza o cooldown de tiro
+        if (enemy.shoot_cooldown > 0.0f)
+        {
+            enemy.shoot_cooldown -= delta_time;
+            if (enemy.shoot_cooldown < 0.0f)
+                enemy.shoot_cooldown = 0.0f;
+        }
+
+        // Atualiza o timer de verificação de probabilidade
+        enemy.shoot_probability_check_timer += delta_time;
+
+        // Verifica probabilidade de tiro a cada 1 segundo
+        if (enemy.shoot_probability_check_timer >= 1.0f)
+        {
+            // Reseta o timer
+            enemy.shoot_probability_check_timer = 0.0f;
+
+            // Verifica se pode atirar (cooldown acabou)
+            if (enemy.shoot_cooldown <= 0.0f)
+                commands.push_back(EnemyCommand{ ENEMY_COMMAND_SHOOT_CHECK, (uint32_t)i });
+        }
+    }
+}
+
+// Junta os buffers de todas as threads e aplica os comandos em ordem de
+// inimigo. Cada tipo de comando sorteia de uma stream diferente, e um não
+// altera o que o outro lê, então o resultado é o mesmo de aplicar cada
+// comando no momento em que foi pedido.
+static void ApplyEnemyCommands(void* data, size_t, size_t)
+{
+    World& world = *((EnemyUpdateJob*)data)->world;
+    std::vector<EnemyCommand>& commands = world.enemy_commands[0];
+    for (size_t thread = 1; thread < world.enemy_commands.size(); ++thread)
+    {
+        std::vector<EnemyCommand>& other = world.enemy_commands[thread];
+        commands.insert(commands.end(), other.begin(), other.end());
+        other.clear();
+    }
+    std::sort(commands.begin(), commands.end(), CompareEnemyCommands);
+
+    for (const EnemyCommand& command : commands)
+    {
+        if (command.type == ENEMY_COMMAND_NEW_PATH || command.type == ENEMY_COMMAND_REPLAN)
+        {
+            if (command.type == ENEMY_COMMAND_REPLAN)
+                world.enemy_path_stats.replans += 1;
+            GenerateEnemyPath(world, command.enemy);
+            continue;
+        }
+
+        // Gera um número aleatório entre 0 e 1
+        Enemy& enemy = world.enemies[command.enemy];
+        float random_value = world.enemy_shots_rng.NextFloat(0.0f, 1.0f);
+
+        // Se o valor aleatório for menor que a probabilidade, o inimigo atira
+        if (random_value < enemy.shoot_probability)
+        {
+            // Inimigo atira
+            EnemyToPlayerRaycast(world, command.enemy);
+            // Inicia o cooldown
+            enemy.shoot_cooldown = enemy.shoot_cooldown_time;
+        }
+    }
+    commands.clear();
+}
+
+// Atualizamos todos os inimigos (apenas os vivos): movimento e tiros. Com
+// pelo menos SIMULATION_PARALLEL_MIN_ENEMIES inimigos, as partes que só
+// alteram o próprio inimigo são divididas entre as threads do sistema de
+// jobs ("jobsystem.h"); o resultado é o mesmo com qualquer número de threads.
+static void UpdateEnemies(World& world, float delta_time)
+{
+    CPU_PROFILE_ZONE("enemy_update");
+
+    size_t count = world.enemies.size();
+    size_t num_threads = (size_t)JobSystem_NumThreads();
+    if (world.enemy_commands.size() < num_threads)
+        world.enemy_commands.resize(num_threads);
+
+    EnemyUpdateJob job = { &world, delta_time };
+    if (count < SIMULATION_PARALLEL_MIN_ENEMIES || num_threads == 1 || JobSystem_ThreadIndex() != 0)
+    {
+        PrepareEnemies(&job, 0, count);
+        ApplyEnemyCommands(&job, 0, 1);
+        MoveEnemies(&job, 0, count);
+        CommitEnemies(&job, 0, count);
+        ApplyEnemyCommands(&job, 0, 1);
+        return;
+    }
+
+    // Mesma sequência, como um grafo: cada parte começa quando a anterior
+    // termina. Só a thread 0 chega aqui, então o grafo pode ser global.
+    static JobGraph graph;
+    JobGraph_Clear(graph);
+    int prepare = JobGraph_Add(graph, PrepareEnemies, &job, count, SIMULATION_ENEMY_JOB_SIZE);
+    int new_paths = JobGraph_Add(graph, ApplyEnemyCommands, &job, 1, 1);
+    int move = JobGraph_Add(graph, MoveEnemies, &job, count, SIMULATION_ENEMY_JOB_SIZE);
+    int commit = JobGraph_Add(graph, CommitEnemies, &job, count, SIMULATION_ENEMY_JOB_SIZE);
+    int shots = JobGraph_Add(graph, ApplyEnemyCommands, &job, 1, 1);
+    JobGraph_AddDependency(graph, new_paths, prepare);
+    JobGraph_AddDependency(graph, move, new_paths);
+    JobGraph_AddDependency(graph, commit, move);
+    JobGraph_AddDependency(graph, shots, commit);
+    JobGraph_Run(graph);
+}
+
+// Segundos decorridos desde "begin", somados a "total" (se não for NULL)
+static void AddElapsed(double* total, std::chrono::steady_clock::time_point begin)
+{
+    if (total)
+        *total += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void Simulation_Step(World& world, float delta_time, SimulationTimings* timings)
+{
+    // Transformações antes do tick, para a renderização interpolar
+    world.player.SavePreviousTransform();
+    EnemyPaths_SavePrevious(world.enemy_paths);
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    UpdatePlayer(world, delta_time);
+    AddElapsed(timings ? &timings->player : NULL, begin);
+
+    begin = std::chrono::steady_clock::now();
+    {
+        CPU_PROFILE_ZONE("flow_field");
+        FlowField_Update(world.flow_field, world.player.position);
+    }
+    UpdateEnemies(world, delta_time);
+    Simulation_ResolveShots(world); // Tiros do jogador e dos inimigos deste tick
+    Simulation_RemoveDeadEnemies(world);
+    AddElapsed(timings ? &timings->enemies : NULL, begin);
+
+    // Atualizamos o status das waves (verifica se estão completas)
+    begin = std::chrono::steady_clock::now();
+    UpdateWaves(world, delta_time);
+    AddElapsed(timings ? &timings->waves : NULL, begin);
+
+    world.time += delta_time;
+    world.tick += 1;
+}
+
+void Simulation_ApplyAction(World& world, const SimulationAction& action)
+{
+    Player& player = world.player;
+
+    if (action.buttons & SIMULATION_ACTION_THIRD_PERSON)
+    {
+        // Os vetores de direção são recalculados no tick, a partir da rotação
+        world.camera_mode = CAMERA_THIRD_PERSON;
+        player.camera_angle_horizontal = action.yaw;
+        player.camera_angle_vertical = action.pitch;
+        player.camera_distance = action.camera_distance;
+    }
+    else
+    {
+        // Mesmo cálculo de CursorPosCallback() em primeira pessoa ("main.cpp")
+        float limit = 89.0f * SIMULATION_PI / 180.0f;
+        float pitch = glm::clamp(action.pitch, -limit, limit);
+
+        world.camera_mode = CAMERA_FIRST_PERSON;
+        player.camera_angle_horizontal = action.yaw;
+        player.camera_angle_vertical = pitch;
+        player.forward_vector = glm::vec4(cos(pitch) * sin(action.yaw), sin(pitch),
+                                          cos(pitch) * cos(action.yaw), 0.0f);
+        player.right_vector = glm::vec4(cos(action.yaw), 0.0f, -sin(action.yaw), 0.0f);
+    }
+
+    player.moving_forward  = (action.buttons & SIMULATION_ACTION_FORWARD) != 0;
+    player.moving_backward = (action.buttons & SIMULATION_ACTION_BACKWARD) != 0;
+    player.moving_left     = (action.buttons & SIMULATION_ACTION_LEFT) != 0;
+    player.moving_right    = (action.buttons & SIMULATION_ACTION_RIGHT) != 0;
+    player.is_running      = (action.buttons & SIMULATION_ACTION_RUN) != 0;
+
+    if (action.buttons & SIMULATION_ACTION_SHOOT)
+        Simulation_PlayerShoot(world);
+    if (action.buttons & SIMULATION_ACTION_RELOAD)
+        Simulation_PlayerReload(world);
+
+    if (action.buttons & SIMULATION_ACTION_ENEMY_RAYCASTS)
+    {
+        // Raycast de cada inimigo vivo em direção ao jogador
+        for (size_t i = 0; i < world.enemies.size(); ++i)
+            if (!world.enemies[i].IsDead())
+                EnemyToPlayerRaycast(world, i);
+    }
+}
+
+Enemy* Simulation_GetEnemy(World& world, EnemyHandle handle)
+{
+    if (handle.slot >= world.enemy_slots.size())
+        return NULL;
+    const EnemySlot& slot = world.enemy_slots[handle.slot];
+    if (slot.generation != handle.generation)
+        return NULL;
+    return &world.enemies[slot.index];
+}
+
+const Enemy* Simulation_GetEnemy(const World& world, EnemyHandle handle)
+{
+    return Simulation_GetEnemy(const_cast<World&>(world), handle);
+}
+
+// Adiciona um inimigo ao fim de World::enemies, em um slot livre (ou novo),
+// em "position", e gera sua primeira curva, andando "speed" unidades por
+// segundo
+static EnemyHandle AddEnemy(World& world, const Enemy& enemy, const glm::vec4& position, float speed)
+{
+    uint32_t slot;
+    if (!world.enemy_free_slots.empty())
+    {
+        slot = world.enemy_free_slots.back();
+        world.enemy_free_slots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t)world.enemy_slots.size();
+        EnemySlot new_slot = { 0, 0 };
+        world.enemy_slots.push_back(new_slot);
+    }
+
+    size_t index = world.enemies.size();
+    world.enemy_slots[slot].index = (uint32_t)index;
+    EnemyHandle handle = { slot, world.enemy_slots[slot].generation };
+
+    world.enemies.push_back(enemy);
+    world.enemies.back().handle = handle;
+    world.enemy_raycasts.push_back(EnemyRaycast());
+
+    // Recém-criado: não há tick anterior para interpolar
+    EnemyPaths& paths = world.enemy_paths;
+    EnemyPaths_Resize(paths, world.enemies.size());
+    paths.x[index] = paths.previous_x[index] = position.x;
+    paths.y[index] = position.y;
+    paths.z[index] = paths.previous_z[index] = position.z;
+    paths.speed[index] = speed;
+    GenerateEnemyPath(world, index);
+    return handle;
+}
+
+void Simulation_RemoveDeadEnemies(World& world)
+{
+    if (world.enemies_dying == 0)
+        return;
+
+    size_t i = 0;
+    while (i < world.enemies.size())
+    {
+        if (!world.enemies[i].IsDead())
+        {
+            ++i;
+            continue;
+        }
+
+        // Libera o slot: os handles deste inimigo deixam de valer
+        uint32_t slot = world.enemies[i].handle.slot;
+        world.enemy_slots[slot].generation += 1;
+        world.enemy_free_slots.push_back(slot);
+
+        // O último inimigo ocupa o lugar do removido (i é verificado de novo)
+        world.enemies[i] = world.enemies.back();
+        world.enemies.pop_back();
+        world.enemy_raycasts[i] = world.enemy_raycasts.back();
+        world.enemy_raycasts.pop_back();
+        EnemyPaths_SwapRemove(world.enemy_paths, i);
+        if (i < world.enemies.size())
+            world.enemy_slots[world.enemies[i].handle.slot].index = (uint32_t)i;
+
+        world.enemies_killed += 1;
+    }
+    world.enemies_dying = 0;
+}
+
+// Escrita e leitura de valores com memcpy (os tipos são trivialmente
+// copiáveis) em Simulation_SaveState() e Simulation_LoadState(). Sem "data",
+// StateWriter só conta os bytes, para o estado ser escrito em um bloco
+// alocado uma única vez.
+struct StateWriter
+{
+    unsigned char* data;
+    size_t offset;
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        if (data)
+            memcpy(data + offset, &value, sizeof(T));
+        offset += sizeof(T);
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values)
+    {
+        Write((uint32_t)values.size());
+        if (data && !values.empty())
+            memcpy(data + offset, (const void*)values.data(), values.size() * sizeof(T));
+        offset += values.size() * sizeof(T);
+    }
+};
+
+// Sem "apply", StateReader só confere se os valores cabem em "data", sem
+// escrever nada: Simulation_LoadState() lê o estado duas vezes, a primeira
+// só para validá-lo.
+struct StateReader
+{
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    bool apply;
+
+    // Número de elementos de um vetor (lido mesmo sem "apply")
+    bool ReadCount(uint32_t* count)
+    {
+        if (size - offset < sizeof(uint32_t))
+            return false;
+        memcpy(count, data + offset, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+        return true;
+    }
+
+    template <typename T>
+    bool Read(T* value)
+    {
+        if (size - offset < sizeof(T))
+            return false;
+        if (apply)
+            memcpy(value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    // Pula um vetor de T, guardando o número de elementos e onde eles
+    // começam em "data"
+    template <typename T>
+    bool Skip(uint32_t* count, const unsigned char** elements)
+    {
+        if (!ReadCount(count) || (size - offset) / sizeof(T) < *count)
+            return false;
+        *elements = data + offset;
+        offset += *count * sizeof(T);
+        return true;
+    }
+
+    // Copia um vetor para "values", que mantém a memória já alocada. "make"
+    // é copiado nos elementos que faltam, antes de serem sobrescritos (Enemy
+    // não tem construtor padrão).
+    template <typename T>
+    bool ReadArray(std::vector<T>* values, const T& make, uint32_t* count, const unsigned char** elements = NULL)
+    {
+        const unsigned char* begin;
+        if (!Skip<T>(count, &begin))
+            return false;
+        if (elements)
+            *elements = begin;
+        if (apply)
+        {
+            if (values->size() < *count)
+                values->resize(*count, make);
+            else
+                values->erase(values->begin() + *count, values->end());
+            if (*count > 0)
+                memcpy((void*)values->data(), begin, *count * sizeof(T));
+        }
+        return true;
+    }
+};
+
+// Valor de tipo T guardado em "bytes", que pode não estar alinhado
+template <typename T>
+static T LoadBytes(const unsigned char* bytes)
+{
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+static void WriteState(const World& world, StateWriter& out)
+{
+    out.Write(world.player);
+    out.WriteArray(world.enemies);
+
+    // Curvas, posição e direção dos inimigos
+    const EnemyPaths& paths = world.enemy_paths;
+    const std::vector<float>* path_fields[] = {
+        &paths.p0_x, &paths.p0_z, &paths.p1_x, &paths.p1_z, &paths.p2_x, &paths.p2_z,
+        &paths.p3_x, &paths.p3_z, &paths.distance, &paths.speed, &paths.y, &paths.progress,
+        &paths.x, &paths.z, &paths.heading_x, &paths.heading_z,
+        &paths.previous_x, &paths.previous_z, &paths.previous_heading_x, &paths.previous_heading_z
+    };
+    for (const std::vector<float>* field : path_fields)
+        out.WriteArray(*field);
+    for (const std::vector<float>& field : paths.arc_length)
+        out.WriteArray(field);
+
+    out.WriteArray(world.enemy_slots);
+    out.WriteArray(world.enemy_free_slots);
+    out.Write(world.enemies_dying);
+    out.Write(world.enemies_killed);
+    out.Write(world.enemy_damage_total);
+    out.Write(world.enemy_path_stats);
+
+    out.WriteArray(world.map->boxes);
+
+    out.Write((uint32_t)world.waves.size());
+    for (const Wave& wave : world.waves)
+    {
+        out.Write(wave.wave_id);
+        out.Write(wave.is_active);
+        out.Write(wave.is_complete);
+        out.WriteArray(wave.enemy_handles);
+    }
+
+    out.Write(world.wave_config);
+    out.Write(world.next_wave_id);
+    out.Write(world.current_wave_number);
+    out.Write(world.wave_cleared);
+    out.Write(world.wave_cleared_timer);
+    out.Write(world.camera_mode);
+    out.Write(world.time);
+    out.Write(world.tick);
+    out.Write(world.seed);
+    out.Write(world.enemy_paths_rng);
+    out.Write(world.enemy_shots_rng);
+    out.Write(world.enemy_spawn_rng);
+}
+
+void Simulation_SaveState(const World& world, std::vector<unsigned char>* out)
+{
+    StateWriter counter = { NULL, 0 };
+    WriteState(world, counter);
+
+    out->resize(counter.offset); // Não realoca se "out" já tem espaço (ex.: keyframes de um replay)
+    StateWriter writer = { out->data(), 0 };
+    WriteState(world, writer);
+}
+
+// Lê o estado escrito por WriteState(). Sem in.apply, só confere os tamanhos
+// e as referências entre os vetores, sem alterar "world"; com in.apply,
+// copia o estado (já conferido) para os vetores e os Wave que "world" já tem.
+static bool ReadState(World& world, StateReader& in)
+{
+    uint32_t num_enemies, count;
+    const unsigned char* enemies;
+    if (!in.Read(&world.player))
+        return false;
+    // O construtor sorteia das streams de "world", que são sobrescritas
+    // no fim
+    if (in.apply ? !in.ReadArray(&world.enemies, Enemy(world), &num_enemies, &enemies)
+                 : !in.Skip<Enemy>(&num_enemies, &enemies))
+        return false;
+
+    EnemyPaths& paths = world.enemy_paths;
+    std::vector<float>* path_fields[] = {
+        &paths.p0_x, &paths.p0_z, &paths.p1_x, &paths.p1_z, &paths.p2_x, &paths.p2_z,
+        &paths.p3_x, &paths.p3_z, &paths.distance, &paths.speed, &paths.y, &paths.progress,
+        &paths.x, &paths.z, &paths.heading_x, &paths.heading_z,
+        &paths.previous_x, &paths.previous_z, &paths.previous_heading_x, &paths.previous_heading_z
+    };
+    for (std::vector<float>* field : path_fields)
+        if (!in.ReadArray(field, 0.0f, &count) || count != num_enemies)
+            return false;
+    for (std::vector<float>& field : paths.arc_length)
+        if (!in.ReadArray(&field, 0.0f, &count) || count != num_enemies)
+            return false;
+    if (in.apply)
+        world.enemy_raycasts.assign(num_enemies, EnemyRaycast());
+
+    uint32_t num_slots, num_free_slots, num_boxes, num_waves;
+    const unsigned char* slots;
+    const unsigned char* free_slots;
+    const unsigned char* boxes;
+    if (!in.ReadArray(&world.enemy_slots, EnemySlot(), &num_slots, &slots) ||
+        !in.ReadArray(&world.enemy_free_slots, (uint32_t)0, &num_free_slots, &free_slots) ||
+        !in.Read(&world.enemies_dying) || !in.Read(&world.enemies_killed) ||
+        !in.Read(&world.enemy_damage_total) || !in.Read(&world.enemy_path_stats) ||
+        !in.Skip<Box>(&num_boxes, &boxes) ||
+        !in.ReadCount(&num_waves))
+        return false;
+
+    // Cada inimigo deve ocupar o slot do seu handle, e os handles das waves
+    // (mesmo os antigos) devem apontar para slots existentes
+    if (!in.apply)
+    {
+        for (uint32_t i = 0; i < num_enemies; ++i)
+        {
+            EnemyHandle handle = LoadBytes<EnemyHandle>(enemies + i * sizeof(Enemy) + offsetof(Enemy, handle));
+            if (handle.slot >= num_slots)
+                return false;
+            EnemySlot slot = LoadBytes<EnemySlot>(slots + handle.slot * sizeof(EnemySlot));
+            if (slot.index != i || slot.generation != handle.generation)
+                return false;
+        }
+        for (uint32_t i = 0; i < num_free_slots; ++i)
+            if (LoadBytes<uint32_t>(free_slots + i * sizeof(uint32_t)) >= num_slots)
+                return false;
+    }
+
+    // Os Wave de "world" (e os seus enemy_handles) são reaproveitados
+    if (in.apply)
+    {
+        if (world.waves.size() > num_waves)
+            world.waves.erase(world.waves.begin() + num_waves, world.waves.end());
+        while (world.waves.size() < num_waves)
+            world.waves.push_back(Wave(0));
+    }
+    Wave unused(0); // Destino das leituras sem in.apply, que não escrevem nada
+    for (uint32_t i = 0; i < num_waves; ++i)
+    {
+        Wave& wave = in.apply ? world.waves[i] : unused;
+        const unsigned char* handles;
+        if (!in.Read(&wave.wave_id) || !in.Read(&wave.is_active) || !in.Read(&wave.is_complete) ||
+            !in.ReadArray(&wave.enemy_handles, EnemyHandle(), &count, &handles))
+            return false;
+        for (uint32_t h = 0; !in.apply && h < count; ++h)
+            if (LoadBytes<EnemyHandle>(handles + h * sizeof(EnemyHandle)).slot >= num_slots)
+                return false;
+    }
+
+    if (!in.Read(&world.wave_config) || !in.Read(&world.next_wave_id) || !in.Read(&world.current_wave_number) ||
+        !in.Read(&world.wave_cleared) || !in.Read(&world.wave_cleared_timer) ||
+        !in.Read(&world.camera_mode) || !in.Read(&world.time) ||
+        !in.Read(&world.tick) || !in.Read(&world.seed) ||
+        !in.Read(&world.enemy_paths_rng) || !in.Read(&world.enemy_shots_rng) ||
+        !in.Read(&world.enemy_spawn_rng) || in.offset != in.size)
+        return false;
+    if (!in.apply)
+        return true;
+
+    // O mapa só é refeito se as caixas são outras: voltar a um keyframe ou
+    // snapshot da mesma partida (ou do mesmo mapa) reaproveita o de "world"
+    // ou o compartilhado
+    std::shared_ptr<const WorldMap> map;
+    std::shared_ptr<const WorldMap> candidates[2] = { world.map, DefaultMap() };
+    for (const std::shared_ptr<const WorldMap>& candidate : candidates)
+    {
+        if (candidate && num_boxes > 0 && candidate->boxes.size() == num_boxes &&
+            memcmp((const void*)candidate->boxes.data(), boxes, num_boxes * sizeof(Box)) == 0)
+        {
+            map = candidate;
+            break;
+        }
+    }
+    if (!map)
+    {
+        std::vector<Box> map_boxes(num_boxes, Box(glm::vec4(0.0f)));
+        if (num_boxes > 0)
+            memcpy((void*)map_boxes.data(), boxes, num_boxes * sizeof(Box));
+        map = BuildMap(map_boxes);
+    }
+    world.map = map;
+
+    world.flow_field = world.map->flow_field; // Mesmo mapa: não realoca
+    FlowField_Update(world.flow_field, world.player.position); // Só depende da célula do jogador
+    return true;
+}
+
+bool Simulation_LoadState(World& world, const unsigned char* data, size_t size)
+{
+    // Confere tudo antes de copiar, para não deixar "world" pela metade em
+    // caso de erro
+    StateReader check = { data, size, 0, false };
+    if (!ReadState(world, check))
+        return false;
+
+    StateReader reader = { data, size, 0, true };
+    return ReadState(world, reader);
+}
+
+bool Simulation_PlayerShoot(World& world)
+{
+    // Verifica se pode atirar (tem munição no carregador, não está em cooldown e não está recarregando)
+    if (world.player.magazine_ammo <= 0 || world.player.shoot_cooldown > 0.0f || world.player.is_reloading)
+        return false;
+
+    // Realiza raycast do centro da tela
+
+    glm::vec4 camera_position;
+    glm::vec4 camera_lookat;
+
+    if (world.camera_mode == CAMERA_THIRD_PERSON)
+    {
+        camera_position = world.player.GetThirdPersonCameraPosition();
+        camera_lookat   = world.player.GetCameraLookAt();
+    }
+    else // FIRST PERSON
+    {
+        // posição = cabeça do jogador
+        camera_position = world.player.position + glm::vec4(0.0f, 1.5f, 0.0f, 0.0f);
+
+        // olha para onde o jogador está olhando
+        camera_lookat = camera_position + world.player.forward_vector;
+    }
+
+    glm::vec4 camera_view_vector = camera_lookat - camera_position;
+
+    // Normaliza o vetor de direção da câmera
+    float view_length = sqrt(camera_view_vector.x * camera_view_vector.x +
+                             camera_view_vector.y * camera_view_vector.y +
+                             camera_view_vector.z * camera_view_vector.z);
+    if (view_length <= 0.001f)
+        return false;
+
+    camera_view_vector.x /= view_length;
+    camera_view_vector.y /= view_length;
+    camera_view_vector.z /= view_length;
+    CameraRaycast(world, camera_position, camera_view_vector);
+
+    // Consome munição do carregador e inicia cooldown
+    world.player.magazine_ammo--;
+    world.player.shoot_cooldown = world.player.shoot_cooldown_time;
+    return true;
+}
+
+void Simulation_PlayerReload(World& world)
+{
+    // Recarrega o carregador se não estiver recarregando e o carregador não estiver cheio
+    if (!world.player.is_reloading && world.player.magazine_ammo < world.player.magazine_size)
+    {
+        world.player.is_reloading = true;
+        world.player.reload_time = world.player.reload_time_total;
+    }
+}
+
+bool Simulation_IsFinished(const World& world)
+{
+    int max_waves = world.wave_config.max_waves;
+    return max_waves > 0 && world.current_wave_number >= max_waves && world.wave_cleared;
+}
+
+void Player::UpdatePosition(World& world, float delta_time)
+{
+    CPU_PROFILE_ZONE("Player::UpdatePosition");
+
+    // Atualiza o estado de movimento
+    UpdateMovementState();
+
+    glm::vec4 camera_forward;
+    glm::vec4 camera_right;
+
+    // Calcula a direção da câmera baseado no modo
+    if (world.camera_mode == CAMERA_FIRST_PERSON)
+    {
+        // Em primeira pessoa, usa o forward_vector calculado pelo mouse
+        camera_forward = forward_vector;
+        
+        // Mantém o movimento apenas no plano horizontal (remove componente Y)
+        camera_forward.y = 0.0f;
+        
+        // Normaliza o vetor forward no plano horizontal
+        float forward_length = sqrt(camera_forward.x * camera_forward.x + camera_forward.z * camera_forward.z);
+        if (forward_length > 0.001f)
+        {
+            camera_forward.x /= forward_length;
+            camera_forward.z /= forward_length;
+        }
+        
+        // Calcula a direção direita da câmera (perpendicular ao forward no plano horizontal)
+        // Usa o mesmo método que terceira pessoa para consistência
+        camera_right = glm::vec4(glm::cross(glm::vec3(camera_forward), glm::vec3(0.0f, 1.0f, 0.0f)), 0.0f);
+        float camera_right_length = sqrt(camera_right.x * camera_right.x + camera_right.z * camera_right.z);
+        if (camera_right_length > 0.001f)
+        {
+            camera_right.x /= camera_right_length;
+            camera_right.z /= camera_right_length;
+        }
+        
+        // Atualiza a rotação do jogador para corresponder à direção forward
+        rotation_y = atan2(camera_forward.x, -camera_forward.z);
+    }
+    else
+    {
+        // Em terceira pessoa, calcula a direção da câmera
+        camera_forward = glm::vec4(
+            GetCameraLookAt().x - GetThirdPersonCameraPosition().x,
+            GetCameraLookAt().y - GetThirdPersonCameraPosition().y,
+            GetCameraLookAt().z - GetThirdPersonCameraPosition().z,
+            0.0f // ← ESSENCIAL!!!
+        );
+
+        camera_forward.y = 0.0f; // Mantém o movimento apenas no plano horizontal
+
+        float camera_forward_length = sqrt(camera_forward.x * camera_forward.x + camera_forward.z * camera_forward.z);
+
+        // Atualiza a rotação do jogador para sempre corresponder à direção forward da câmera
+        if (camera_forward_length > 0.001f)
+        {
+            camera_forward.x /= camera_forward_length;
+            camera_forward.z /= camera_forward_length;
+
+            // A rotação do jogador sempre corresponde à direção forward da câmera
+            rotation_y = atan2(camera_forward.x, -camera_forward.z);
+        }
+
+        // Calcula a direção direita da câmera (perpendicular ao forward no plano horizontal)
+        camera_right = glm::vec4(glm::cross(glm::vec3(camera_forward), glm::vec3(0.0f, 1.0f, 0.0f)), 0.0f);
+        float camera_right_length = sqrt(camera_right.x * camera_right.x + camera_right.z * camera_right.z);
+        if (camera_right_length > 0.001f)
+        {
+            camera_right.x /= camera_right_length;
+            camera_right.z /= camera_right_length;
+        }
+    }
+
+    // Calcula o vetor de movimento baseado nas teclas pressionadas
+    glm::vec4 movement_direction = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+
+    if (moving_forward)
+        movement_direction = movement_direction + camera_forward;
+    if (moving_backward)
+        movement_direction = movement_direction - camera_forward;
+    if (moving_right)
+        movement_direction = movement_direction + camera_right;
+    if (moving_left)
+        movement_direction = movement_direction - camera_right;
+
+    // Normaliza o vetor de movimento se não for zero
+    float movement_length = sqrt(movement_direction.x * movement_direction.x + movement_direction.z * movement_direction.z);
+
+    // Atualiza a posição apenas se estiver se movendo
+    if (movement_length > 0.001f && current_speed > 0.0f)
+    {
+        movement_direction.x /= movement_length;
+        movement_direction.z /= movement_length;
+
+        float move_distance = current_speed * delta_time;
+        
+        // Calcula a nova posição
+        glm::vec4 new_position = position;
+        new_position.x += movement_direction.x * move_distance;
+        new_position.z += movement_direction.z * move_distance;
+        
+        // Verifica colisão com caixas antes de atualizar a posição
+        if (!CheckPlayerBoxCollision(world, new_position))
+        {
+            // Sem colisão, atualiza a posição
+            position = new_position;
+        }
+        // Se houver colisão, a posição não é atualizada (jogador não se move)
+    }
+}
+
+// Destino de um inimigo que persegue o jogador: segue o campo de fluxo a
+// partir da célula do inimigo por até path_length unidades e fica com a
+// última célula vista em linha reta (a curva até ela não passa por caixas),
+// parando antes se chegar a ENEMY_PURSUIT_MIN_DISTANCE do jogador. Retorna
+// false se o inimigo já está perto do jogador ou não há caminho até ele.
+static bool PursuitDestination(const World& world, const glm::vec4& start_pos, float path_length,
+                               glm::vec4& destination)
+{
+    const FlowField& field = world.flow_field;
+    if (field.target_cell < 0)
+        return false;
+
+    int start_cell = FlowField_Cell(field, start_pos.x, start_pos.z);
+    if (field.distance[start_cell] <= ENEMY_PURSUIT_MIN_DISTANCE || field.next[start_cell] < 0)
+        return false;
+
+    int chosen = field.next[start_cell]; // Pelo menos uma célula adiante
+    int cell = start_cell;
+    float walked = 0.0f;
+    while (walked < path_length && field.next[cell] >= 0)
+    {
+        int next = field.next[cell];
+        walked += field.distance[cell] - field.distance[next];
+        cell = next;
+
+        float x, z;
+        FlowField_CellCenter(field, cell, x, z);
+        if (!FlowField_LineOfSight(field, start_pos.x, start_pos.z, x, z))
+            break;
+        chosen = cell;
+        if (field.distance[cell] <= ENEMY_PURSUIT_MIN_DISTANCE)
+            break;
+    }
+
+    float x, z;
+    FlowField_CellCenter(field, chosen, x, z);
+    destination = glm::vec4(x, start_pos.y, z, 1.0f);
+    return true;
+}
+
+// Pontos de controle da curva de "start" até "destination": a 1/3 e 2/3 do
+// caminho, desviados para lados opostos de "bend" vezes o comprimento
+static void BezierControlPoints(const glm::vec4& start, const glm::vec4& destination, float bend,
+                                float control_x[4], float control_z[4])
+{
+    // Os pontos de controle são posicionados perpendicularmente à direção do movimento
+    glm::vec4 direction = destination - start;
+    float dir_length = sqrt(direction.x * direction.x + direction.z * direction.z);
+    
+    if (dir_length > 0.001f)
+    {
+        direction.x /= dir_length;
+        direction.z /= dir_length;
+    }
+
+    // Cria um vetor perpendicular (rotação de 90 graus no plano XZ)
+    glm::vec4 perpendicular = glm::vec4(-direction.z, 0.0f, direction.x, 0.0f);
+
+    // Primeiro ponto de controle: 1/3 do caminho, desviando para um lado
+    float control_offset = dir_length * bend;
+    glm::vec4 bezier_p1 = start + direction * (dir_length * 0.33f) + perpendicular * control_offset;
+    // Segundo ponto de controle: 2/3 do caminho, desviando para o outro lado
+    glm::vec4 bezier_p2 = start + direction * (dir_length * 0.67f) - perpendicular * control_offset;
+
+    // Garante que os pontos de controle estão dentro dos limites
+    control_x[0] = start.x;
+    control_z[0] = start.z;
+    control_x[1] = glm::clamp(bezier_p1.x, MAP_MIN_X, MAP_MAX_X);
+    control_z[1] = glm::clamp(bezier_p1.z, MAP_MIN_Z, MAP_MAX_Z);
+    control_x[2] = glm::clamp(bezier_p2.x, MAP_MIN_X, MAP_MAX_X);
+    control_z[2] = glm::clamp(bezier_p2.z, MAP_MIN_Z, MAP_MAX_Z);
+    control_x[3] = destination.x;
+    control_z[3] = destination.z;
+}
+
+// Desvios dos pontos de controle tentados por FindFreeCurve(), em fração do
+// comprimento da curva: o de sempre, o lado oposto, desvios menores e por
+// fim a linha reta
+static const float g_EnemyPathBends[] = { 0.3f, -0.3f, 0.15f, -0.15f, 0.0f };
+
+// Procura, entre os desvios de g_EnemyPathBends, uma curva de "start" até
+// "destination" que a hitbox percorre sem encostar em caixas
+// (FreeSpace_SweepBezier()). Soma as curvas testadas em "curves_tested".
+static bool FindFreeCurve(World& world, const glm::vec4& start, const glm::vec4& destination,
+                          float control_x[4], float control_z[4], int& curves_tested)
+{
+    for (float bend : g_EnemyPathBends)
+    {
+        int samples = 0;
+        BezierControlPoints(start, destination, bend, control_x, control_z);
+        bool free = FreeSpace_SweepBezier(world.map->enemy_free_space, world.map->box_grid, control_x, control_z,
+                                          start.y, &samples);
+        curves_tested += 1;
+        world.enemy_path_stats.samples += (uint32_t)samples;
+        if (free)
+            return true;
+    }
+    return false;
+}
+
+// Gera um novo destino para o inimigo enemy_index e calcula os pontos de
+// controle da curva Bezier até ele, em World::enemy_paths. Longe do jogador,
+// o destino segue o campo de fluxo até ele (PursuitDestination()); perto, é
+// um ponto aleatório em volta do inimigo. A curva inteira é validada antes
+// (FindFreeCurve()), então o inimigo não precisa descobrir uma caixa no
+// caminho quando já está encostado nela.
+static void GenerateEnemyPath(World& world, size_t enemy_index)
+{
+    EnemyPathStats& stats = world.enemy_path_stats;
+    stats.paths += 1;
+
+    // Usa a posição atual como ponto de partida (não sempre o spawn)
+    glm::vec4 start_pos = Simulation_EnemyPosition(world, enemy_index);
+    glm::vec4 destination = start_pos;
+    float control_x[4], control_z[4];
+    int curves_tested = 0;
+    bool found = false;
+
+    float path_length = world.enemy_paths_rng.NextFloat(10.0f, 20.0f);
+    if (PursuitDestination(world, start_pos, path_length, destination))
+        found = FindFreeCurve(world, start_pos, destination, control_x, control_z, curves_tested);
+
+    // Gera um destino aleatório em um raio de 10 a 20 unidades da posição atual
+    // Tenta até 10 vezes encontrar um destino com uma curva livre até ele
+    const int max_attempts = 10;
+    for (int attempt = 0; attempt < max_attempts && !found; ++attempt)
+    {
+        float angle = world.enemy_paths_rng.NextFloat(0.0f, 2.0f * SIMULATION_PI);
+        float distance = world.enemy_paths_rng.NextFloat(10.0f, 20.0f);
+
+        destination = glm::vec4(
+            start_pos.x + distance * cos(angle),
+            start_pos.y,
+            start_pos.z + distance * sin(angle),
+            1.0f
+        );
+
+        // Garante que o destino está dentro dos limites do mapa
+        destination.x = glm::clamp(destination.x, MAP_MIN_X, MAP_MAX_X);
+        destination.z = glm::clamp(destination.z, MAP_MIN_Z, MAP_MAX_Z);
+
+        // O fim da curva também é testado, então um destino dentro de uma
+        // caixa nunca é aceito
+        found = FindFreeCurve(world, start_pos, destination, control_x, control_z, curves_tested);
+    }
+
+    if (!found)
+    {
+        // Sem curva livre após várias tentativas, usa o último destino em
+        // linha reta mesmo assim (o inimigo vai recalcular quando detectar
+        // colisão durante o movimento)
+        BezierControlPoints(start_pos, destination, 0.0f, control_x, control_z);
+        stats.unresolved += 1;
+    }
+    else if (curves_tested > 1)
+    {
+        stats.perturbed += 1;
+    }
+    stats.curves_tested += (uint32_t)curves_tested;
+
+    // A tabela de comprimento de arco da curva é calculada aqui, e o inimigo
+    // anda na mesma velocidade em toda ela (veja "enemypaths.h")
+    float speed = world.enemy_paths.speed[enemy_index];
+    EnemyPaths_SetCurve(world.enemy_paths, enemy_index, control_x, control_z, speed);
+}
+
+Enemy::Enemy(World& world, int wave, float health_multiplier)
+    : max_health(100.0f * health_multiplier)
+    , health(max_health)
+    , shoot_cooldown(2.0f)  // Cooldown inicial de 2 segundos ao spawnar (dá tempo para o jogador se preparar)
+    , shoot_cooldown_time(2.5f)  // 2.5 segundos de cooldown entre tiros
+    , shoot_probability_check_timer(0.0f)
+    , shoot_probability(0.3f)  // 30% de chance de atirar por segundo
+    , wave_id(wave)
+{
+    // Inicializa o timer de probabilidade com um valor aleatório entre 0 e 1 segundo
+    // para evitar que todos os inimigos atirem ao mesmo tempo
+    shoot_probability_check_timer = world.enemy_spawn_rng.NextFloat(0.0f, 1.0f);
+
+    // Atribuído ao entrar em World::enemies
+    handle = EnemyHandle();
+}
+
+// Função auxiliar para verificar colisão entre jogador (esfera) e caixa (AABB)
+// Retorna true se houver colisão
+bool CheckPlayerBoxCollision(const World& world, const glm::vec4& player_position)
+{
+    const float player_radius = 0.3f; // Raio da hitbox do jogador
+    const float player_scale = 0.3f;
+    
+    // Calcula o centro da hitbox do jogador em world space
+    glm::vec3 player_center = glm::vec3(
+        player_position.x + world.player.model_center.x * player_scale,
+        player_position.y + world.player.model_center.y * player_scale,
+        player_position.z + world.player.model_center.z * player_scale
+    );
+    
+    // Só as caixas das células próximas são testadas
+    return BoxGrid_OverlapsSphere(world.map->box_grid, player_center, player_radius);
+}
+
+bool CheckEnemyBoxCollision(const World& world, const glm::vec4& enemy_position)
+{
+    // Calcula o centro da hitbox do inimigo em world space
+    glm::vec3 enemy_center = glm::vec3(enemy_position) + EnemyHitboxOffset();
+    
+    // Só as caixas das células próximas são testadas
+    return BoxGrid_OverlapsSphere(world.map->box_grid, enemy_center, ENEMY_HITBOX_RADIUS);
+}
+
+// Função auxiliar para verificar interseção de raio com AABB (Axis-Aligned Bounding Box)
+// Retorna true se houver interseção e armazena a distância em t
+bool RayAABBIntersection(const glm::vec4& ray_origin, const glm::vec4& ray_dir,
+                         const glm::vec3& box_min, const glm::vec3& box_max, float& t)
+{
+    // Algoritmo de interseção raio-AABB (Slab method)
+    float tmin = 0.0f;
+    float tmax = std::numeric_limits<float>::max();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        // Evita divisão por zero quando o raio é paralelo ao eixo
+        if (fabs(ray_dir[i]) < 1e-6f)
+        {
+            // Raio paralelo ao eixo - verifica se está dentro do AABB neste eixo
+            if (ray_origin[i] < box_min[i] || ray_origin[i] > box_max[i])
+                return false;
+            continue;
+        }
+
+        float invD = 1.0f / ray_dir[i];
+        float t0 = (box_min[i] - ray_origin[i]) * invD;
+        float t1 = (box_max[i] - ray_origin[i]) * invD;
+
+        if (invD < 0.0f)
+        {
+            float temp = t0;
+            t0 = t1;
+            t1 = temp;
+        }
+
+        tmin = t0 > tmin ? t0 : tmin;
+        tmax = t1 < tmax ? t1 : tmax;
+
+        if (tmax < tmin)
+            return false;
+    }
+
+    t = tmin;
+    return tmin >= 0.0f;
+}
+
+// Pede um tiro do jogador de camera_position na direção ray_direction
+// (normalizada). O tiro atinge caixas e inimigos, mas não o próprio jogador, e
+// é resolvido por Simulation_ResolveShots().
+void CameraRaycast(World& world, glm::vec4 camera_position, glm::vec4 ray_direction)
+{
+    const float max_ray_distance = 100.0f;
+    const float player_damage_amount = 34.0f; // Quantidade de dano por tiro
+
+    RayQuery query;
+    query.origin = camera_position;
+    query.direction = ray_direction;
+    query.max_distance = max_ray_distance;
+    query.layers = RAY_LAYER_WORLD | RAY_LAYER_ENEMIES;
+    query.shooter = RAY_LAYER_PLAYER;
+    query.shooter_enemy = EnemyHandle();
+    query.damage = player_damage_amount;
+    RayQueries_Submit(world, query);
+}
+
+// Evento do tick corrente envolvendo "enemy", com os outros campos zerados
+static GameEvent NewEvent(const World& world, GameEventType type, EnemyHandle enemy)
+{
+    GameEvent event;
+    memset(&event, 0, sizeof(event));
+    event.tick = world.tick;
+    event.type = type;
+    event.enemy_slot = enemy.slot;
+    event.enemy_generation = enemy.generation;
+    return event;
+}
+
+void Simulation_ResolveShots(World& world)
+{
+    CPU_PROFILE_ZONE("resolve_shots");
+
+    if (world.ray_queries.empty())
+        return;
+    RayQueries_Resolve(world);
+
+    for (size_t i = 0; i < world.ray_queries.size(); ++i)
+    {
+        const RayQuery& query = world.ray_queries[i];
+        const RayHit& hit = world.ray_hits[i];
+
+        if (query.shooter == RAY_LAYER_ENEMIES)
+        {
+            // Um inimigo morto por um tiro anterior do mesmo tick não atira
+            Enemy* shooter = Simulation_GetEnemy(world, query.shooter_enemy);
+            if (!shooter || shooter->IsDead())
+                continue;
+
+            // Armazena informações do raycast para desenhar a linha amarela
+            float hit_t = hit.layer != RAY_LAYER_NONE ? hit.t : query.max_distance;
+            EnemyRaycast& raycast = world.enemy_raycasts[world.enemy_slots[query.shooter_enemy.slot].index];
+            raycast.start = query.origin;
+            raycast.end = query.origin + query.direction * hit_t;
+            raycast.time = world.time; // Registra o tempo atual
+            raycast.draw = true;
+        }
+
+        EnemyHandle involved = query.shooter == RAY_LAYER_ENEMIES ? query.shooter_enemy :
+                               hit.layer == RAY_LAYER_ENEMIES ? hit.enemy : EnemyHandle();
+        GameEvent shot = NewEvent(world, GAME_EVENT_SHOT, involved);
+        shot.shot.shooter = query.shooter;
+        shot.shot.layer = hit.layer;
+        shot.shot.distance = hit.layer != RAY_LAYER_NONE ? hit.t : query.max_distance;
+        EventBus_Publish(world.events, shot);
+
+        if (hit.layer == RAY_LAYER_PLAYER)
+        {
+            bool was_dead = world.player.IsDead();
+            float health_before = world.player.health;
+            world.player.TakeDamage(query.damage);
+
+            GameEvent damage = NewEvent(world, GAME_EVENT_PLAYER_DAMAGED, EnemyHandle());
+            damage.damage.amount = health_before - world.player.health;
+            damage.damage.health = world.player.health;
+            damage.damage.max_health = world.player.max_health;
+            EventBus_Publish(world.events, damage);
+
+            if (!was_dead && world.player.IsDead())
+                EventBus_Publish(world.events, NewEvent(world, GAME_EVENT_PLAYER_KILLED, EnemyHandle()));
+        }
+        else if (hit.layer == RAY_LAYER_ENEMIES)
+        {
+            // O inimigo pode ter sido morto por um tiro anterior do mesmo tick
+            Enemy* enemy = Simulation_GetEnemy(world, hit.enemy);
+            if (!enemy || enemy->IsDead())
+                continue;
+
+            // Aplica dano ao inimigo através do método TakeDamage
+            float health_before = enemy->health;
+            enemy->TakeDamage(query.damage);
+            world.enemy_damage_total += health_before - enemy->health;
+
+            GameEvent damage = NewEvent(world, GAME_EVENT_ENEMY_DAMAGED, hit.enemy);
+            damage.damage.amount = health_before - enemy->health;
+            damage.damage.health = enemy->health;
+            damage.damage.max_health = enemy->max_health;
+            EventBus_Publish(world.events, damage);
+
+            // Se o inimigo morreu
+            if (enemy->IsDead())
+            {
+                world.enemies_dying += 1; // Removido por Simulation_RemoveDeadEnemies()
+
+                GameEvent kill = NewEvent(world, GAME_EVENT_ENEMY_KILLED, hit.enemy);
+                glm::vec4 position = Simulation_EnemyPosition(world, world.enemy_slots[hit.enemy.slot].index);
+                kill.kill.x = position.x;
+                kill.kill.y = position.y;
+                kill.kill.z = position.z;
+                EventBus_Publish(world.events, kill);
+            }
+        }
+    }
+
+    world.ray_queries.clear();
+}
+
+// Realiza raycast a partir do centro do jogador na direção que ele está olhando
+void PlayerRaycast(World& world)
+{
+    // Posição do centro do jogador (usando a posição do jogador)
+    glm::vec4 ray_origin = world.player.position;
+
+    // Direção é o vetor forward do jogador (direção que ele está olhando)
+    glm::vec4 ray_direction = world.player.forward_vector;
+
+    // Normaliza o vetor de direção
+    float dir_length = sqrt(ray_direction.x * ray_direction.x +
+                           ray_direction.y * ray_direction.y +
+                           ray_direction.z * ray_direction.z);
+    if (dir_length > 0.001f)
+    {
+        ray_direction.x /= dir_length;
+        ray_direction.y /= dir_length;
+        ray_direction.z /= dir_length;
+    }
+
+    LOG_DEBUG(LOG_CATEGORY_COMBAT, "=== PlayerRaycast: From player center (%.2f, %.2f, %.2f) in direction (%.2f, %.2f, %.2f) ===",
+           ray_origin.x, ray_origin.y, ray_origin.z,
+           ray_direction.x, ray_direction.y, ray_direction.z);
+
+    // Usa a mesma lógica do CameraRaycast mas com origem e direção diferentes
+    CameraRaycast(world, ray_origin, ray_direction);
+}
+
+// Realiza raycast de um inimigo específico em direção ao jogador
+void EnemyToPlayerRaycast(World& world, size_t enemy_index)
+{
+    // Verifica se o índice é válido
+    if (enemy_index >= world.enemies.size())
+    {
+        LOG_WARNING(LOG_CATEGORY_COMBAT, "EnemyToPlayerRaycast: Invalid enemy index %zu (total enemies: %zu)",
+               enemy_index, world.enemies.size());
+        return;
+    }
+
+    auto& enemy = world.enemies[enemy_index];
+
+    // Verifica se o inimigo está morto
+    if (enemy.IsDead())
+    {
+        LOG_DEBUG(LOG_CATEGORY_COMBAT, "EnemyToPlayerRaycast: Enemy %zu is dead", enemy_index);
+        return;
+    }
+
+    // Posição do centro do inimigo
+    glm::vec4 ray_origin = Simulation_EnemyPosition(world, enemy_index);
+
+    // Limita o alcance do raycast de inimigo
+    const float max_ray_distance = 15.0f; // Limita o alcance do raycast de inimigo
+
+    // Direção do inimigo para o jogador
+    glm::vec4 ray_direction = glm::vec4(
+        world.player.position.x - ray_origin.x,
+        world.player.position.y - ray_origin.y,
+        world.player.position.z - ray_origin.z,
+        0.0f
+    );
+
+    // Normaliza o vetor de direção
+    float dir_length = sqrt(ray_direction.x * ray_direction.x +
+                           ray_direction.y * ray_direction.y +
+                           ray_direction.z * ray_direction.z);
+    if (dir_length > 0.001f)
+    {
+        // Verifica distância antes de normalizar - se o jogador está muito longe, não realiza raycast
+        if (dir_length > max_ray_distance)
+        {
+            // Jogador está muito longe, não realiza raycast
+            return;
+        }
+        
+        ray_direction.x /= dir_length;
+        ray_direction.y /= dir_length;
+        ray_direction.z /= dir_length;
+    }
+    else
+    {
+        LOG_DEBUG(LOG_CATEGORY_COMBAT, "EnemyToPlayerRaycast: Enemy %zu is at same position as player", enemy_index);
+        return;
+    }
+
+    // Rotaciona o inimigo para enfrentar o jogador
+    // Usa atan2 para calcular o ângulo de rotação em torno do eixo Y
+    // Similar ao que é feito para o jogador, mas com sinal invertido para corrigir direção
+    // (a direção é (sin, -cos) do ângulo, normalizada no plano XZ)
+    float rotation_y = atan2(ray_direction.x, -ray_direction.z);
+    world.enemy_paths.heading_x[enemy_index] = sin(rotation_y);
+    world.enemy_paths.heading_z[enemy_index] = -cos(rotation_y);
+
+    LOG_DEBUG(LOG_CATEGORY_COMBAT, "=== EnemyToPlayerRaycast: From enemy %zu (%.2f, %.2f, %.2f) to player (%.2f, %.2f, %.2f) ===",
+           enemy_index,
+           ray_origin.x, ray_origin.y, ray_origin.z,
+           world.player.position.x, world.player.position.y, world.player.position.z);
+
+    // O tiro é resolvido por Simulation_ResolveShots(), que também guarda o
+    // ponto de impacto para desenhar a linha amarela (por inimigo)
+    const float enemy_damage_amount = 2.0f; // Quantidade de dano que o inimigo causa
+    RayQuery query;
+    query.origin = ray_origin;
+    query.direction = ray_direction;
+    query.max_distance = max_ray_distance;
+    query.layers = RAY_LAYER_WORLD | RAY_LAYER_PLAYER;
+    query.shooter = RAY_LAYER_ENEMIES;
+    query.shooter_enemy = enemy.handle;
+    query.damage = enemy_damage_amount;
+    RayQueries_Submit(world, query);
+}
+
+// Spawna uma wave de monstros nas posições especificadas
+// Retorna o ID da wave criada
+int SpawnWave(World& world, const std::vector<glm::vec4>& spawn_positions, float enemy_health_multiplier, float enemy_speed_multiplier)
+{
+    int wave_id = world.next_wave_id++;
+    Wave new_wave(wave_id);
+
+    // Cria os inimigos e adiciona à lista global
+    const float walk_speed = 1.5f * enemy_speed_multiplier; // Velocidade de caminhada
+    for (const auto& pos : spawn_positions)
+    {
+        Enemy enemy(world, wave_id, enemy_health_multiplier);
+        new_wave.enemy_handles.push_back(AddEnemy(world, enemy, pos, walk_speed));
+        
+        // Log das coordenadas do inimigo spawnado
+        LOG_DEBUG(LOG_CATEGORY_WAVES, "Enemy spawned at coordinates: (%.2f, %.2f, %.2f)", pos.x, pos.y, pos.z);
+    }
+
+    world.waves.push_back(new_wave);
+    return wave_id;
+}
+
+bool Wave::CheckCompletion(const World& world)
+{
+    if (is_complete)
+        return true;
+
+    // Inimigos mortos são removidos, então basta um handle ainda válido (e
+    // um inimigo que ainda não foi removido) para a wave continuar
+    for (const EnemyHandle& handle : enemy_handles)
+    {
+        const Enemy* enemy = Simulation_GetEnemy(world, handle);
+        if (enemy && !enemy->IsDead())
+            return false;
+    }
+
+    is_complete = true;
+    is_active = false;
+    std::vector<EnemyHandle>().swap(enemy_handles); // Não são mais usados
+    return true;
+}
+
+// Verifica se todos os monstros de uma wave estão mortos
+bool IsWaveComplete(World& world, int wave_id)
+{
+    for (auto& wave : world.waves)
+    {
+        if (wave.wave_id == wave_id)
+        {
+            return wave.CheckCompletion(world);
+        }
+    }
+    return wave_id >= 0 && wave_id < world.next_wave_id; // Já completa e removida por UpdateWaves()
+}
+
+// Função para spawnar a próxima wave com dificuldade crescente, de acordo com
+// World::wave_config ("wavegenerator.h")
+void SpawnNextWave(World& world)
+{
+    const WaveConfig& config = world.wave_config;
+    if (config.max_waves > 0 && world.current_wave_number >= config.max_waves)
+        return; // Todas as waves completas (GAME_EVENT_GAME_FINISHED)
+
+    world.current_wave_number++;
+    world.wave_cleared = false;
+    world.wave_cleared_timer = 0.0f;
+
+    // Restaura completamente a vida do jogador após cada round
+    world.player.health = world.player.max_health;
+
+    // Calcula a posição Y correta para os inimigos (mesma lógica do código original)
+    const float enemy_scale = 0.3f;
+    const float ground_y = -1.1f; // Altura do chão (mesma usada na inicialização)
+    float enemy_y = ground_y - g_BanditMinY * enemy_scale;
+
+    // Número de inimigos e multiplicadores de dificuldade aumentam com a wave
+    // (no padrão: 4, 6, 8, 10, 12 inimigos, vida 1.0x a 3.0x e velocidade
+    // 1.0x a 1.8x)
+    int wave = world.current_wave_number;
+    int enemy_count = WaveGenerator_EnemyCount(config, wave);
+    float health_multiplier = WaveGenerator_HealthMultiplier(config, wave);
+    float speed_multiplier = WaveGenerator_SpeedMultiplier(config, wave);
+
+    // Posições de spawn em células livres, na formação da configuração
+    // (World::spawn_positions mantém a memória entre as waves)
+    WaveGenerator_SpawnPositions(config, enemy_count, world.map->enemy_free_space, world.player.position, enemy_y,
+                                 world.enemy_spawn_rng, world.spawn_positions);
+
+    SpawnWave(world, world.spawn_positions, health_multiplier, speed_multiplier);
+    int spawned = (int)world.spawn_positions.size();
+    world.spawn_positions.clear();
+
+    GameEvent started = NewEvent(world, GAME_EVENT_WAVE_STARTED, EnemyHandle());
+    started.wave.wave = wave;
+    started.wave.enemy_count = (int32_t)spawned;
+    started.wave.health_multiplier = health_multiplier;
+    started.wave.speed_multiplier = speed_multiplier;
+    EventBus_Publish(world.events, started);
+}
+
+// Atualiza o status de todas as waves
+void UpdateWaves(World& world, float delta_time)
+{
+    CPU_PROFILE_ZONE("UpdateWaves");
+
+    // Atualiza timer de wave cleared
+    if (world.wave_cleared)
+    {
+        world.wave_cleared_timer += delta_time;
+        
+        // Se passou o tempo de delay, spawna próxima wave
+        if (world.wave_cleared_timer >= g_WaveClearedDelay)
+        {
+            SpawnNextWave(world);
+        }
+    }
+
+    // Verifica se alguma wave foi completada
+    // Encontra a wave mais recente (maior wave_id) que ainda não está completa
+    int most_recent_wave_id = -1;
+    for (const auto& wave : world.waves)
+    {
+        if (wave.wave_id > most_recent_wave_id)
+            most_recent_wave_id = wave.wave_id;
+    }
+    
+    // Verifica se a wave mais recente foi completada
+    if (most_recent_wave_id >= 0)
+    {
+        for (size_t i = 0; i < world.waves.size(); ++i)
+        {
+            Wave& wave = world.waves[i];
+            if (wave.wave_id == most_recent_wave_id && wave.is_active && !wave.is_complete)
+            {
+                if (wave.CheckCompletion(world))
+                {
+                    // Waves completas saem da lista, que senão cresceria para
+                    // sempre no modo sem fim; os IDs menores que
+                    // World::next_wave_id que não estão nela são as completas
+                    world.waves.erase(world.waves.begin() + i);
+
+                    GameEvent complete = NewEvent(world, GAME_EVENT_WAVE_COMPLETE, EnemyHandle());
+                    complete.wave.wave = world.current_wave_number;
+                    EventBus_Publish(world.events, complete);
+
+                    int max_waves = world.wave_config.max_waves;
+                    if (max_waves > 0 && world.current_wave_number >= max_waves)
+                        EventBus_Publish(world.events, NewEvent(world, GAME_EVENT_GAME_FINISHED, EnemyHandle()));
+
+                    // Marca como cleared para mostrar mensagem e iniciar próxima wave
+                    world.wave_cleared = true;
+                    world.wave_cleared_timer = 0.0f;
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Retorna os IDs de todas as waves ativas (ainda não completas)
+std::vector<int> GetActiveWaves(const World& world)
+{
+    std::vector<int> active_waves;
+    for (const auto& wave : world.waves)
+    {
+        if (wave.is_active && !wave.is_complete)
+        {
+            active_waves.push_back(wave.wave_id);
+        }
+    }
+    return active_waves;
+}
+
+// Retorna os IDs de todas as waves completas
+std::vector<int> GetCompleteWaves(const World& world)
+{
+    // As completas são removidas de World::waves por UpdateWaves(), então são
+    // os IDs já usados que não estão mais na lista (ou estão, mas completos)
+    std::vector<int> complete_waves;
+    for (int wave_id = 0; wave_id < world.next_wave_id; ++wave_id)
+    {
+        bool listed_incomplete = false;
+        for (const auto& wave : world.waves)
+            if (wave.wave_id == wave_id && !wave.is_complete)
+                listed_incomplete = true;
+        if (!listed_incomplete)
+            complete_waves.push_back(wave_id);
+    }
+    return complete_waves;
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+// Passo em lote de muitos World em paralelo. Veja "simulationbatch.h".
+//
+// O pool de threads é persistente: as threads dormem em uma variável de
+// condição e são acordadas a cada SimulationBatch_Step() (contador
+// g_BatchGeneration). Os World são distribuídos em blocos de
+// SIMULATION_BATCH_CHUNK por um contador atômico, então threads que pegam
+// World mais baratos (ex.: entre waves) simplesmente pegam mais blocos.
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "simulationbatch.h"
+
+#define SIMULATION_BATCH_CHUNK 64 // World por bloco de trabalho
+
+// Número de vetores de SimulationObservations com um valor por World e com
+// SIMULATION_OBS_MAX_ENEMIES valores por World
+#define SIMULATION_OBS_WORLD_FIELDS 9
+#define SIMULATION_OBS_ENEMY_FIELDS 3
+
+static std::vector<std::thread> g_BatchThreads;
+static std::mutex g_BatchMutex;
+static std::condition_variable g_BatchWakeUp;   // Novo passo ou término
+static std::condition_variable g_BatchFinished; // Todas as threads terminaram o passo
+static unsigned long g_BatchGeneration = 0;     // Incrementado a cada passo
+static int g_BatchWorkersRunning = 0;
+static bool g_BatchQuit = false;
+
+// Passo em andamento
+static World* g_BatchWorlds = NULL;
+static const SimulationAction* g_BatchActions = NULL;
+static int g_BatchNumWorlds = 0;
+static float g_BatchDeltaTime = 0.0f;
+static SimulationObservations* g_BatchObservations = NULL;
+static std::atomic<int> g_BatchNextWorld(0);
+
+bool SimulationBatch_AllocObservations(SimulationObservations* observations, int num_worlds)
+{
+    memset(observations, 0, sizeof(*observations));
+    if (num_worlds <= 0)
+        return false;
+
+    size_t world_floats = (size_t)num_worlds;
+    size_t enemy_floats = world_floats * SIMULATION_OBS_MAX_ENEMIES;
+    size_t total = SIMULATION_OBS_WORLD_FIELDS * world_floats + SIMULATION_OBS_ENEMY_FIELDS * enemy_floats;
+
+    float* storage = (float*)calloc(total, sizeof(float));
+    if (!storage)
+        return false;
+
+    observations->num_worlds = num_worlds;
+    observations->storage = storage;
+
+    float* next = storage;
+    float** world_fields[SIMULATION_OBS_WORLD_FIELDS] = {
+        &observations->player_x, &observations->player_z, &observations->player_health,
+        &observations->player_ammo, &observations->player_reloading, &observations->wave,
+        &observations->enemies_alive, &observations->reward, &observations->done
+    };
+    for (int i = 0; i < SIMULATION_OBS_WORLD_FIELDS; ++i)
+    {
+        *world_fields[i] = next;
+        next += world_floats;
+    }
+
+    float** enemy_fields[SIMULATION_OBS_ENEMY_FIELDS] = {
+        &observations->enemy_x, &observations->enemy_z, &observations->enemy_health
+    };
+    for (int i = 0; i < SIMULATION_OBS_ENEMY_FIELDS; ++i)
+    {
+        *enemy_fields[i] = next;
+        next += enemy_floats;
+    }
+
+    return true;
+}
+
+void SimulationBatch_FreeObservations(SimulationObservations* observations)
+{
+    free(observations->storage);
+    memset(observations, 0, sizeof(*observations));
+}
+
+void SimulationBatch_Observe(const World& world, SimulationObservations* observations, int index)
+{
+    const Player& player = world.player;
+    observations->player_x[index] = player.position.x;
+    observations->player_z[index] = player.position.z;
+    observations->player_health[index] = player.health;
+    observations->player_ammo[index] = (float)player.magazine_ammo;
+    observations->player_reloading[index] = player.is_reloading ? 1.0f : 0.0f;
+    observations->wave[index] = (float)world.current_wave_number;
+
+    // Inimigos da wave atual: a última criada
+    float* enemy_x = observations->enemy_x + (size_t)index * SIMULATION_OBS_MAX_ENEMIES;
+    float* enemy_z = observations->enemy_z + (size_t)index * SIMULATION_OBS_MAX_ENEMIES;
+    float* enemy_health = observations->enemy_health + (size_t)index * SIMULATION_OBS_MAX_ENEMIES;
+
+    int alive = 0;
+    int observed = 0;
+    if (!world.waves.empty())
+    {
+        // Só os vivos: os handles dos mortos não valem mais
+        const std::vector<EnemyHandle>& handles = world.waves.back().enemy_handles;
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            const Enemy* enemy = Simulation_GetEnemy(world, handles[i]);
+            if (!enemy)
+                continue;
+            alive += 1;
+            if (observed < SIMULATION_OBS_MAX_ENEMIES)
+            {
+                size_t enemy_index = world.enemy_slots[handles[i].slot].index;
+                enemy_x[observed] = world.enemy_paths.x[enemy_index];
+                enemy_z[observed] = world.enemy_paths.z[enemy_index];
+                enemy_health[observed] = enemy->health;
+                observed += 1;
+            }
+        }
+    }
+    for (; observed < SIMULATION_OBS_MAX_ENEMIES; ++observed)
+    {
+        enemy_x[observed] = 0.0f;
+        enemy_z[observed] = 0.0f;
+        enemy_health[observed] = 0.0f;
+    }
+    observations->enemies_alive[index] = (float)alive;
+}
+
+static bool IsEpisodeOver(const World& world)
+{
+    return world.player.IsDead() || Simulation_IsFinished(world);
+}
+
+static void StepWorld(World& world, const SimulationAction& action, float delta_time,
+                      SimulationObservations* observations, int index)
+{
+    if (IsEpisodeOver(world))
+        Simulation_Init(world, world.enemy_spawn_rng.Next());
+
+    // Dano antes do passo, para a recompensa
+    float enemy_damage_before = world.enemy_damage_total;
+    float player_health_before = world.player.health;
+
+    Simulation_ApplyAction(world, action);
+    Simulation_Step(world, delta_time);
+
+    float damage_dealt = world.enemy_damage_total - enemy_damage_before;
+    float damage_taken = player_health_before - world.player.health;
+
+    SimulationBatch_Observe(world, observations, index);
+    observations->reward[index] = (damage_dealt - damage_taken) / 100.0f;
+    observations->done[index] = IsEpisodeOver(world) ? 1.0f : 0.0f;
+}
+
+// Pega blocos de World do passo em andamento até acabarem
+static void RunChunks()
+{
+    for (;;)
+    {
+        int begin = g_BatchNextWorld.fetch_add(SIMULATION_BATCH_CHUNK);
+        if (begin >= g_BatchNumWorlds)
+            break;
+
+        int end = begin + SIMULATION_BATCH_CHUNK;
+        if (end > g_BatchNumWorlds)
+            end = g_BatchNumWorlds;
+
+        for (int i = begin; i < end; ++i)
+            StepWorld(g_BatchWorlds[i], g_BatchActions[i], g_BatchDeltaTime, g_BatchObservations, i);
+    }
+}
+
+static void WorkerThread()
+{
+    unsigned long seen_generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(g_BatchMutex);
+            g_BatchWakeUp.wait(lock, [&] { return g_BatchQuit || g_BatchGeneration != seen_generation; });
+            if (g_BatchQuit)
+                return;
+            seen_generation = g_BatchGeneration;
+        }
+
+        RunChunks();
+
+        std::lock_guard<std::mutex> lock(g_BatchMutex);
+        g_BatchWorkersRunning -= 1;
+        if (g_BatchWorkersRunning == 0)
+            g_BatchFinished.notify_one();
+    }
+}
+
+int SimulationBatch_Init(int num_threads)
+{
+    SimulationBatch_Terminate();
+
+    if (num_threads <= 0)
+        num_threads = (int)std::thread::hardware_concurrency();
+    if (num_threads <= 0)
+        num_threads = 1;
+
+    g_BatchQuit = false;
+    g_BatchGeneration = 0;
+    for (int i = 1; i < num_threads; ++i) // A thread que chama o passo também trabalha
+        g_BatchThreads.push_back(std::thread(WorkerThread));
+
+    return num_threads;
+}
+
+void SimulationBatch_Terminate()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_BatchMutex);
+        g_BatchQuit = true;
+    }
+    g_BatchWakeUp.notify_all();
+
+    for (std::thread& thread : g_BatchThreads)
+        thread.join();
+    g_BatchThreads.clear();
+}
+
+void SimulationBatch_Step(World* worlds, const SimulationAction* actions, int num_worlds,
+                          float delta_time, SimulationObservations* observations)
+{
+    g_BatchWorlds = worlds;
+    g_BatchActions = actions;
+    g_BatchNumWorlds = num_worlds;
+    g_BatchDeltaTime = delta_time;
+    g_BatchObservations = observations;
+    g_BatchNextWorld.store(0);
+
+    // Poucos World: não vale a pena acordar as threads
+    if (g_BatchThreads.empty() || num_worlds <= SIMULATION_BATCH_CHUNK)
+    {
+        RunChunks();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_BatchMutex);
+        g_BatchWorkersRunning = (int)g_BatchThreads.size();
+        g_BatchGeneration += 1;
+    }
+    g_BatchWakeUp.notify_all();
+
+    RunChunks();
+
+    std::unique_lock<std::mutex> lock(g_BatchMutex);
+    g_BatchFinished.wait(lock, [] { return g_BatchWorkersRunning == 0; });
+}
+
+// vim: set spell spelllang=pt_br :
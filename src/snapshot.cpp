@@ -0,0 +1,233 @@
+// Snapshots do estado do jogo. Veja "snapshot.h".
+//
+// Formato do arquivo (na ordem de bytes da máquina, como nos replays):
+//
+//     "FCGSNAP", u32 versão, u32 layout, u32 tick_rate, u32 versão do
+//     estado (SIMULATION_STATE_VERSION), u64 tamanho do estado, estado de
+//     Simulation_SaveState()
+//
+// "layout" combina o tamanho de cada estrutura copiada para o estado e a
+// posição, o tamanho e o tipo (float, inteiro com ou sem sinal, enum) de cada
+// um dos seus campos: um executável compilado com campos em outra ordem ou de
+// outro tipo recusa o arquivo. O que o layout não vê (a ordem em que
+// Simulation_SaveState() escreve os valores) é coberto pela versão do estado.
+// O estado é escrito de um bloco só e lido para um buffer que é reutilizado
+// entre os carregamentos.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#include <vector>
+
+#include "snapshot.h"
+
+#define SNAPSHOT_MAGIC "FCGSNAP" // 8 bytes, com o '\0'
+
+struct SnapshotHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t layout;
+    uint32_t tick_rate;
+    uint32_t state_version;
+    uint64_t state_size;
+};
+
+static std::vector<unsigned char> g_SnapshotState; // Reutilizado por Snapshot_Save() e Snapshot_Load()
+
+// Acrescenta "value" ao hash FNV-1a "hash"
+static void AddToLayout(uint32_t& hash, uint32_t value)
+{
+    for (int byte = 0; byte < 4; ++byte)
+    {
+        hash ^= (value >> (8 * byte)) & 0xFF;
+        hash *= 16777619u;
+    }
+}
+
+// Tipo de um campo: trocar um float por um int32_t muda o layout, mesmo com
+// o mesmo tamanho. Os vetores da glm contam só pelo tamanho.
+template <typename T>
+static uint32_t FieldKind()
+{
+    if (std::is_floating_point<T>::value)
+        return 1;
+    if (std::is_enum<T>::value)
+        return 2;
+    if (std::is_integral<T>::value)
+        return std::is_signed<T>::value ? 3 : 4;
+    return 5;
+}
+
+#define LAYOUT_STRUCT(type) AddToLayout(hash, (uint32_t)sizeof(type))
+#define LAYOUT_FIELD(type, field)                                          \
+    do                                                                     \
+    {                                                                      \
+        AddToLayout(hash, (uint32_t)offsetof(type, field));                \
+        AddToLayout(hash, (uint32_t)sizeof(((type*)NULL)->field));         \
+        AddToLayout(hash, FieldKind<decltype(((type*)NULL)->field)>());    \
+    } while (0)
+
+// FNV-1a do layout das estruturas copiadas para o estado
+static uint32_t StateLayout()
+{
+    uint32_t hash = 2166136261u;
+
+    LAYOUT_STRUCT(Player);
+    LAYOUT_FIELD(Player, position);
+    LAYOUT_FIELD(Player, rotation_y);
+    LAYOUT_FIELD(Player, forward_vector);
+    LAYOUT_FIELD(Player, right_vector);
+    LAYOUT_FIELD(Player, model_center);
+    LAYOUT_FIELD(Player, previous_position);
+    LAYOUT_FIELD(Player, previous_rotation_y);
+    LAYOUT_FIELD(Player, movement_state);
+    LAYOUT_FIELD(Player, walk_speed);
+    LAYOUT_FIELD(Player, run_speed);
+    LAYOUT_FIELD(Player, current_speed);
+    LAYOUT_FIELD(Player, moving_forward);
+    LAYOUT_FIELD(Player, moving_backward);
+    LAYOUT_FIELD(Player, moving_left);
+    LAYOUT_FIELD(Player, moving_right);
+    LAYOUT_FIELD(Player, is_running);
+    LAYOUT_FIELD(Player, health);
+    LAYOUT_FIELD(Player, max_health);
+    LAYOUT_FIELD(Player, magazine_ammo);
+    LAYOUT_FIELD(Player, magazine_size);
+    LAYOUT_FIELD(Player, shoot_cooldown);
+    LAYOUT_FIELD(Player, shoot_cooldown_time);
+    LAYOUT_FIELD(Player, reload_time);
+    LAYOUT_FIELD(Player, reload_time_total);
+    LAYOUT_FIELD(Player, is_reloading);
+    LAYOUT_FIELD(Player, camera_distance);
+    LAYOUT_FIELD(Player, camera_height);
+    LAYOUT_FIELD(Player, camera_angle_horizontal);
+    LAYOUT_FIELD(Player, camera_angle_vertical);
+
+    LAYOUT_STRUCT(Enemy);
+    LAYOUT_FIELD(Enemy, max_health);
+    LAYOUT_FIELD(Enemy, health);
+    LAYOUT_FIELD(Enemy, shoot_cooldown);
+    LAYOUT_FIELD(Enemy, shoot_cooldown_time);
+    LAYOUT_FIELD(Enemy, shoot_probability_check_timer);
+    LAYOUT_FIELD(Enemy, shoot_probability);
+    LAYOUT_FIELD(Enemy, wave_id);
+    LAYOUT_FIELD(Enemy, handle);
+
+    LAYOUT_STRUCT(EnemySlot);
+    LAYOUT_FIELD(EnemySlot, index);
+    LAYOUT_FIELD(EnemySlot, generation);
+
+    LAYOUT_STRUCT(EnemyHandle);
+    LAYOUT_FIELD(EnemyHandle, slot);
+    LAYOUT_FIELD(EnemyHandle, generation);
+
+    LAYOUT_STRUCT(EnemyPathStats);
+    LAYOUT_FIELD(EnemyPathStats, paths);
+    LAYOUT_FIELD(EnemyPathStats, perturbed);
+    LAYOUT_FIELD(EnemyPathStats, unresolved);
+    LAYOUT_FIELD(EnemyPathStats, replans);
+    LAYOUT_FIELD(EnemyPathStats, curves_tested);
+    LAYOUT_FIELD(EnemyPathStats, samples);
+
+    LAYOUT_STRUCT(Box);
+    LAYOUT_FIELD(Box, position);
+    LAYOUT_FIELD(Box, rotation_y);
+    LAYOUT_FIELD(Box, scale);
+
+    LAYOUT_STRUCT(WaveConfig);
+    LAYOUT_FIELD(WaveConfig, max_waves);
+    LAYOUT_FIELD(WaveConfig, first_wave);
+    LAYOUT_FIELD(WaveConfig, base_count);
+    LAYOUT_FIELD(WaveConfig, count_step);
+    LAYOUT_FIELD(WaveConfig, count_growth);
+    LAYOUT_FIELD(WaveConfig, max_count);
+    LAYOUT_FIELD(WaveConfig, health_step);
+    LAYOUT_FIELD(WaveConfig, speed_step);
+    LAYOUT_FIELD(WaveConfig, max_speed_multiplier);
+    LAYOUT_FIELD(WaveConfig, formation);
+    LAYOUT_FIELD(WaveConfig, spawn_distance);
+    LAYOUT_FIELD(WaveConfig, num_clusters);
+
+    LAYOUT_STRUCT(RandomStream);
+    LAYOUT_FIELD(RandomStream, state);
+    LAYOUT_FIELD(RandomStream, increment);
+
+    LAYOUT_STRUCT(CameraMode);
+    return hash;
+}
+
+bool Snapshot_Save(const char* filename, const World& world, int tick_rate)
+{
+    Simulation_SaveState(world, &g_SnapshotState);
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.layout = StateLayout();
+    header.tick_rate = (uint32_t)tick_rate;
+    header.state_version = SIMULATION_STATE_VERSION;
+    header.state_size = g_SnapshotState.size();
+
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(g_SnapshotState.data(), 1, g_SnapshotState.size(), file) == g_SnapshotState.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool Snapshot_Load(const char* filename, World& world, int* tick_rate)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: Não foi possível abrir o snapshot \"%s\".\n", filename);
+        return false;
+    }
+
+    SnapshotHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+    {
+        fprintf(stderr, "ERROR: \"%s\" não é um snapshot.\n", filename);
+        fclose(file);
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION || header.state_version != SIMULATION_STATE_VERSION || header.tick_rate == 0)
+    {
+        fprintf(stderr, "ERROR: Snapshot \"%s\" com versão %u.%u não suportada (esperada %d.%d).\n",
+                filename, header.version, header.state_version, SNAPSHOT_VERSION, SIMULATION_STATE_VERSION);
+        fclose(file);
+        return false;
+    }
+    if (header.layout != StateLayout())
+    {
+        fprintf(stderr, "ERROR: Snapshot \"%s\" salvo por um executável com outras estruturas.\n", filename);
+        fclose(file);
+        return false;
+    }
+
+    // O estado vai até o fim do arquivo
+    long state_begin = ftell(file);
+    bool complete = fseek(file, 0, SEEK_END) == 0 && (uint64_t)(ftell(file) - state_begin) == header.state_size &&
+                    fseek(file, state_begin, SEEK_SET) == 0;
+    if (complete)
+    {
+        g_SnapshotState.resize((size_t)header.state_size);
+        complete = fread(g_SnapshotState.data(), 1, g_SnapshotState.size(), file) == g_SnapshotState.size();
+    }
+    fclose(file);
+    if (!complete || !Simulation_LoadState(world, g_SnapshotState.data(), g_SnapshotState.size()))
+    {
+        fprintf(stderr, "ERROR: Snapshot \"%s\" corrompido.\n", filename);
+        return false;
+    }
+
+    *tick_rate = (int)header.tick_rate;
+    return true;
+}
+
+// vim: set spell spelllang=pt_br :
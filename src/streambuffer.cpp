@@ -0,0 +1,168 @@
+// Alocador de geometria dinâmica por quadro. Veja "streambuffer.h".
+//
+// OpenGL 3.3 não possui glBufferStorage(), então não podemos manter o buffer
+// mapeado permanentemente. Em vez disso, cada upload mapeia apenas o trecho
+// que será escrito com GL_MAP_UNSYNCHRONIZED_BIT: como o fence garante que a
+// GPU não está mais lendo a região corrente, o driver não precisa nem
+// sincronizar nem fazer "orphaning" do buffer inteiro a cada chamada (que é o
+// que acontecia com glBufferData()/glBufferSubData() repetidos no mesmo VBO).
+
+#include <cstdio>
+#include <cstring>
+
+#include "streambuffer.h"
+#include "utils.h"
+
+static GLuint g_StreamBufferID = 0;
+static GLsync g_RegionFences[STREAM_BUFFER_REGION_COUNT];
+static int    g_CurrentRegion = 0;
+static size_t g_RegionOffset = 0; // Próximo byte livre dentro da região corrente
+
+static size_t g_BytesThisFrame = 0;
+static int    g_UploadsThisFrame = 0;
+static int    g_StallsThisFrame = 0;
+static size_t g_BytesLastFrame = 0;
+static int    g_UploadsLastFrame = 0;
+static int    g_StallsLastFrame = 0;
+
+void StreamBuffer_Init()
+{
+    glGenBuffers(1, &g_StreamBufferID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_StreamBufferID);
+    glBufferData(GL_COPY_WRITE_BUFFER, STREAM_BUFFER_REGION_COUNT * STREAM_BUFFER_REGION_SIZE, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glCheckError();
+
+    for (int i = 0; i < STREAM_BUFFER_REGION_COUNT; ++i)
+        g_RegionFences[i] = 0;
+
+    g_CurrentRegion = 0;
+    g_RegionOffset = 0;
+}
+
+// Insere um fence protegendo os comandos que leem a região corrente
+static void FenceCurrentRegion()
+{
+    if (g_RegionFences[g_CurrentRegion])
+        glDeleteSync(g_RegionFences[g_CurrentRegion]);
+    g_RegionFences[g_CurrentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Passa para a próxima região, esperando a GPU liberá-la caso ainda esteja em uso
+static void AdvanceRegion()
+{
+    g_CurrentRegion = (g_CurrentRegion + 1) % STREAM_BUFFER_REGION_COUNT;
+    g_RegionOffset = 0;
+
+    GLsync fence = g_RegionFences[g_CurrentRegion];
+    if (!fence)
+        return;
+
+    // Teste sem espera: no caso comum a GPU já terminou há muito tempo
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+    {
+        g_StallsThisFrame += 1;
+        do
+        {
+            // Timeout de 1ms por tentativa; GL_SYNC_FLUSH_COMMANDS_BIT garante
+            // que os comandos pendentes foram enviados para a GPU.
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        if (result == GL_WAIT_FAILED)
+            fprintf(stderr, "ERROR: glClientWaitSync() falhou no stream buffer.\n");
+    }
+
+    glDeleteSync(fence);
+    g_RegionFences[g_CurrentRegion] = 0;
+}
+
+void StreamBuffer_BeginFrame()
+{
+    g_BytesLastFrame   = g_BytesThisFrame;
+    g_UploadsLastFrame = g_UploadsThisFrame;
+    g_StallsLastFrame  = g_StallsThisFrame;
+    g_BytesThisFrame   = 0;
+    g_UploadsThisFrame = 0;
+    g_StallsThisFrame  = 0;
+
+    AdvanceRegion();
+}
+
+void StreamBuffer_EndFrame()
+{
+    FenceCurrentRegion();
+}
+
+GLint StreamBuffer_Upload(const void* data, size_t bytes, size_t vertex_stride)
+{
+    if (bytes == 0 || vertex_stride == 0 || bytes > STREAM_BUFFER_REGION_SIZE)
+    {
+        fprintf(stderr, "ERROR: StreamBuffer_Upload() com tamanho inválido (%zu bytes, stride %zu).\n", bytes, vertex_stride);
+        return -1;
+    }
+
+    // O offset absoluto no buffer deve ser múltiplo do tamanho do vértice,
+    // para que possamos desenhar com "first = offset / vertex_stride".
+    size_t region_base = (size_t)g_CurrentRegion * STREAM_BUFFER_REGION_SIZE;
+    size_t offset = region_base + g_RegionOffset;
+    offset = (offset + vertex_stride - 1) / vertex_stride * vertex_stride;
+
+    if (offset + bytes > region_base + STREAM_BUFFER_REGION_SIZE)
+    {
+        // A região do quadro acabou: protegemos o que já foi escrito e
+        // continuamos na próxima região.
+        FenceCurrentRegion();
+        AdvanceRegion();
+        region_base = (size_t)g_CurrentRegion * STREAM_BUFFER_REGION_SIZE;
+        offset = (region_base + vertex_stride - 1) / vertex_stride * vertex_stride;
+
+        // O alinhamento no início da nova região pode empurrar o fim da
+        // cópia para a região seguinte, que a GPU ainda pode estar lendo
+        if (offset + bytes > region_base + STREAM_BUFFER_REGION_SIZE)
+        {
+            fprintf(stderr, "ERROR: StreamBuffer_Upload() de %zu bytes (stride %zu) não cabe em uma região.\n", bytes, vertex_stride);
+            return -1;
+        }
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_StreamBufferID);
+    void* destination = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!destination)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        fprintf(stderr, "ERROR: glMapBufferRange() falhou no stream buffer.\n");
+        return -1;
+    }
+    memcpy(destination, data, bytes);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    g_RegionOffset = offset + bytes - region_base;
+    g_BytesThisFrame += bytes;
+    g_UploadsThisFrame += 1;
+
+    return (GLint)(offset / vertex_stride);
+}
+
+GLuint StreamBuffer_GetBufferID()
+{
+    return g_StreamBufferID;
+}
+
+size_t StreamBuffer_BytesLastFrame()
+{
+    return g_BytesLastFrame;
+}
+
+int StreamBuffer_UploadsLastFrame()
+{
+    return g_UploadsLastFrame;
+}
+
+int StreamBuffer_StallsLastFrame()
+{
+    return g_StallsLastFrame;
+}
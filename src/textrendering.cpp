@@ -1,6 +1,7 @@
 // Based on http://hamelot.io/visualization/opengl-text-without-any-external-libraries/
 //   and on https://github.com/rougier/freetype-gl
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -9,10 +10,21 @@
 #include <glm/vec4.hpp>
 
 #include "utils.h"
+#include "streambuffer.h"
 #include "dejavufont.h"
+#include "headless.h"
 
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Função definida em main.cpp
 
+// Tamanho da janela; no modo headless (window == NULL), do FBO
+static void GetWindowSize(GLFWwindow* window, int* width, int* height)
+{
+    if (window)
+        glfwGetWindowSize(window, width, height);
+    else
+        Headless_GetFramebufferSize(width, height);
+}
+
 const GLchar* const textvertexshader_source = ""
 "#version 330\n"
 "layout (location = 0) in vec4 position;\n"
@@ -82,8 +94,9 @@ void TextRendering_LoadShader(const GLchar* const shader_string, GLuint shader_i
     delete [] log;
 }
 
+// Os vértices do texto são escritos no stream buffer (veja "streambuffer.h"),
+// então o VAO do texto não possui um VBO próprio.
 GLuint textVAO;
-GLuint textVBO;
 GLuint textprogram_id;
 GLuint texttexture_id;
 
@@ -91,7 +104,6 @@ void TextRendering_Init()
 {
     GLuint sampler;
 
-    glGenBuffers(1, &textVBO);
     glGenVertexArrays(1, &textVAO);
     glGenTextures(1, &texttexture_id);
     glGenSamplers(1, &sampler);
@@ -126,9 +138,8 @@ void TextRendering_Init()
 
     glBindVertexArray(textVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, StreamBuffer_GetBufferID());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
     glEnableVertexAttribArray(0);
     glCheckError();
 
@@ -148,10 +159,17 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
 {
     scale *= textscale;
     int width, height;
-    glfwGetWindowSize(window, &width, &height);
+    GetWindowSize(window, &width, &height);
     float sx = scale / width;
     float sy = scale / height;
 
+    // Os quads de todos os caracteres são acumulados e enviados para a GPU
+    // de uma só vez, com um único desenho por string. O vetor é reutilizado
+    // entre as chamadas, para não alocar memória a cada string.
+    struct TextVertex {float x, y, s, t;};
+    static std::vector<TextVertex> vertices;
+    vertices.clear();
+
     for (size_t i = 0; i < str.size(); i++)
     {
         // Find the glyph for the character we are looking for
@@ -178,7 +196,7 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
         float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
         float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
 
-        struct {float x, y, s, t;} data[6] = {
+        TextVertex data[6] = {
             { x0, y0, s0, t0 },
             { x0, y1, s0, t1 },
             { x1, y1, s1, t1 },
@@ -186,42 +204,47 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
             { x1, y1, s1, t1 },
             { x1, y0, s1, t0 }
         };
+        vertices.insert(vertices.end(), data, data + 6);
+
+        x += (glyph->advance_x * sx);
+    }
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (vertices.empty())
+        return;
 
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDepthFunc(GL_ALWAYS);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, 24 * sizeof(float), data);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLint first_vertex = StreamBuffer_Upload(vertices.data(), vertices.size() * sizeof(TextVertex), sizeof(TextVertex));
+    if (first_vertex < 0)
+        return;
 
-        glUseProgram(textprogram_id);
-        glBindVertexArray(textVAO);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDepthFunc(GL_ALWAYS);
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-        glDepthFunc(GL_LESS);
+    glUseProgram(textprogram_id);
+    glBindVertexArray(textVAO);
 
-        glDisable(GL_BLEND);
+    glDrawArrays(GL_TRIANGLES, first_vertex, (GLsizei)vertices.size());
 
-        x += (glyph->advance_x * sx);
-    }
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDepthFunc(GL_LESS);
+
+    glDisable(GL_BLEND);
 }
 
 float TextRendering_LineHeight(GLFWwindow* window)
 {
     int width, height;
-    glfwGetWindowSize(window, &width, &height);
+    GetWindowSize(window, &width, &height);
     return dejavufont.height / height * textscale;
 }
 
 float TextRendering_CharWidth(GLFWwindow* window)
 {
     int width, height;
-    glfwGetWindowSize(window, &width, &height);
+    GetWindowSize(window, &width, &height);
     return dejavufont.glyphs[32].advance_x / width * textscale;
 }
 
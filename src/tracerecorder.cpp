@@ -0,0 +1,237 @@
+// Gravação de traces do Chrome. Veja "tracerecorder.h".
+//
+// Todas as funções são chamadas da thread que fecha os quadros (a mesma de
+// CpuProfiler_EndFrame()), então não há sincronização aqui: a concorrência
+// entre threads já é resolvida pelo ring buffer do profiler de CPU.
+
+#ifndef CPU_PROFILER_DISABLED
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "cpuprofiler.h"
+#include "tracerecorder.h"
+
+struct TraceEvent
+{
+    const char* name;
+    int         thread;
+    uint64_t    begin_ns;
+    uint64_t    end_ns;
+    std::string detail;
+};
+
+// Últimos quadros, sempre mantidos para os traces de hitch
+static std::deque<TraceEvent> g_History;
+static std::deque<uint64_t>   g_HistoryFrameBegins;
+
+// Captura em andamento
+static std::vector<TraceEvent> g_Captured;
+static const char*             g_CaptureKind = NULL; // NULL se não há captura
+static int                     g_CaptureFramesLeft = 0;
+static int                     g_PendingCaptureFrames = 0; // Pedida durante outra captura
+
+static uint64_t     g_StartupBegin = 0;
+static uint64_t     g_LastFrameEnd = 0;
+static unsigned int g_FrameNumber = 0;
+static double       g_HitchBudgetMs = TRACE_RECORDER_DEFAULT_BUDGET_MS;
+static int          g_HitchTraces = 0;
+static int          g_HitchCooldown = 0; // Quadros até um novo hitch poder disparar
+
+void TraceRecorder_Init(bool capture_startup)
+{
+    g_StartupBegin = CpuProfiler_Now();
+    g_LastFrameEnd = g_StartupBegin;
+
+    // A "captura" da inicialização termina junto com o primeiro quadro
+    if (capture_startup)
+    {
+        g_CaptureKind = "startup";
+        g_CaptureFramesLeft = 1;
+    }
+}
+
+void TraceRecorder_SetHitchBudget(double budget_ms)
+{
+    g_HitchBudgetMs = budget_ms;
+}
+
+void TraceRecorder_CaptureFrames(int num_frames)
+{
+    if (num_frames <= 0)
+        return;
+
+    // Só gravamos um trace por vez; a captura começa quando a atual terminar
+    if (g_CaptureKind)
+    {
+        g_PendingCaptureFrames = num_frames;
+        return;
+    }
+
+    g_Captured.clear();
+    g_CaptureKind = "frames";
+    g_CaptureFramesLeft = num_frames;
+    printf("Gravando trace dos próximos %d quadros...\n", num_frames);
+}
+
+bool TraceRecorder_IsCapturing()
+{
+    return g_CaptureKind != NULL;
+}
+
+static void AddEvent(const TraceEvent& event)
+{
+    g_History.push_back(event);
+    if (g_CaptureKind)
+        g_Captured.push_back(event);
+}
+
+void TraceRecorder_AddZone(const char* name, int thread, uint64_t begin_ns, uint64_t end_ns, const char* detail)
+{
+    TraceEvent event = { name, thread, begin_ns, end_ns, detail ? detail : "" };
+    AddEvent(event);
+}
+
+// Escreve uma string JSON, escapando aspas, barras invertidas (caminhos no
+// Windows) e caracteres de controle
+static void WriteJsonString(FILE* file, const char* s)
+{
+    fputc('"', file);
+    for (; *s; ++s)
+    {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            fprintf(file, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(file, "\\u%04x", c);
+        else
+            fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+static void WriteTrace(const std::vector<TraceEvent>& events, const char* kind)
+{
+    if (events.empty())
+        return;
+
+    char filename[64];
+    time_t now = time(NULL);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", localtime(&now));
+    snprintf(filename, sizeof(filename), "trace_%s_%s.json", kind, timestamp);
+
+    FILE* file = fopen(filename, "w");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: Não foi possível criar o arquivo \"%s\".\n", filename);
+        return;
+    }
+
+    // Os tempos do formato são em microssegundos, relativos ao primeiro evento
+    uint64_t origin = events[0].begin_ns;
+    for (size_t i = 1; i < events.size(); ++i)
+        origin = std::min(origin, events[i].begin_ns);
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Sunset Riders\"}}");
+    for (int thread = 0; thread < CpuProfiler_ThreadCount(); ++thread)
+    {
+        const char* name = CpuProfiler_ThreadName(thread);
+        if (!name)
+            continue;
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", thread);
+        WriteJsonString(file, name);
+        fprintf(file, "}}");
+    }
+
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const TraceEvent& event = events[i];
+        fprintf(file, ",\n{\"name\":");
+        WriteJsonString(file, event.name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                event.thread, (event.begin_ns - origin) / 1.0e3, (event.end_ns - event.begin_ns) / 1.0e3);
+        if (!event.detail.empty())
+        {
+            fprintf(file, ",\"args\":{\"detail\":");
+            WriteJsonString(file, event.detail.c_str());
+            fprintf(file, "}");
+        }
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n]}\n");
+
+    fclose(file);
+    printf("Trace (%zu eventos) salvo em \"%s\".\n", events.size(), filename);
+}
+
+void TraceRecorder_EndFrame(int thread, uint64_t end_ns)
+{
+    // O primeiro "quadro" cobre toda a inicialização
+    char detail[32];
+    snprintf(detail, sizeof(detail), "%u", g_FrameNumber);
+    TraceEvent frame = { g_FrameNumber == 0 ? "startup" : "frame", thread, g_LastFrameEnd, end_ns, detail };
+    AddEvent(frame);
+
+    double frame_ms = (end_ns - g_LastFrameEnd) / 1.0e6;
+    g_HistoryFrameBegins.push_back(g_LastFrameEnd);
+    g_LastFrameEnd = end_ns;
+    g_FrameNumber += 1;
+
+    // Descartamos os eventos anteriores ao quadro mais antigo mantido
+    while (g_HistoryFrameBegins.size() > TRACE_RECORDER_HISTORY_FRAMES)
+        g_HistoryFrameBegins.pop_front();
+    while (!g_History.empty() && g_History.front().begin_ns < g_HistoryFrameBegins.front())
+        g_History.pop_front();
+
+    if (g_CaptureKind)
+    {
+        g_CaptureFramesLeft -= 1;
+        if (g_CaptureFramesLeft > 0)
+            return;
+
+        bool hitch_capture = strcmp(g_CaptureKind, "hitch") == 0;
+        WriteTrace(g_Captured, g_CaptureKind);
+        g_Captured.clear();
+        g_CaptureKind = NULL;
+
+        if (g_PendingCaptureFrames > 0)
+        {
+            TraceRecorder_CaptureFrames(g_PendingCaptureFrames);
+            g_PendingCaptureFrames = 0;
+        }
+
+        // Escrever o arquivo atrasa o próximo quadro; não queremos que isso
+        // dispare outro trace. Depois de um trace de hitch também esperamos o
+        // histórico ser preenchido de novo, para que o próximo não repita os
+        // mesmos quadros; depois da inicialização ou de uma captura pedida,
+        // um hitch pode ser gravado logo em seguida.
+        g_HitchCooldown = hitch_capture ? TRACE_RECORDER_HISTORY_FRAMES : std::max(g_HitchCooldown, 1);
+        return;
+    }
+
+    if (g_HitchCooldown > 0)
+    {
+        g_HitchCooldown -= 1;
+        return;
+    }
+
+    if (g_HitchBudgetMs > 0.0 && frame_ms > g_HitchBudgetMs && g_FrameNumber > 1
+        && g_HitchTraces < TRACE_RECORDER_MAX_HITCH_TRACES)
+    {
+        printf("Quadro %u levou %.1f ms (orçamento de %.1f ms), gravando trace...\n",
+               g_FrameNumber - 1, frame_ms, g_HitchBudgetMs);
+        g_HitchTraces += 1;
+        g_Captured.assign(g_History.begin(), g_History.end());
+        g_CaptureKind = "hitch";
+        g_CaptureFramesLeft = TRACE_RECORDER_POST_HITCH_FRAMES;
+    }
+}
+
+#endif // CPU_PROFILER_DISABLED
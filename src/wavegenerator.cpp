@@ -0,0 +1,199 @@
+// Gerador das waves. Veja "wavegenerator.h".
+//
+// As formações só escolhem pontos; SnapToFree() leva cada ponto para dentro
+// do mapa e, se a célula dele em FreeSpaceGrid não é livre, para o centro da
+// célula livre mais próxima. Com milhares de inimigos os anéis vão se
+// afastando do jogador (WAVE_RING_SPACING entre inimigos vizinhos), e nas
+// outras formações vários inimigos podem dividir a mesma célula.
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/common.hpp>
+
+#include "simulation.h"
+#include "wavegenerator.h"
+
+#define WAVE_GENERATOR_PI    3.141592f // Mesmo valor de SIMULATION_PI, para os anéis de sempre não mudarem
+#define WAVE_RING_SPACING    0.75f     // Distância entre inimigos vizinhos e entre anéis
+#define WAVE_MAP_MARGIN      0.5f      // Distância mínima das bordas do mapa
+#define WAVE_SNAP_MAX_RADIUS 16        // Maior distância (em células) procurada por SnapToFree()
+
+void WaveGenerator_SetEndless(WaveConfig& config)
+{
+    config.max_waves = 0;
+    config.count_growth = WAVE_ENDLESS_GROWTH;
+}
+
+int WaveGenerator_EnemyCount(const WaveConfig& config, int wave)
+{
+    double count = config.base_count * pow((double)config.count_growth, wave - 1) + config.count_step * (wave - 1);
+    count = std::min(std::max(count, 0.0), (double)config.max_count);
+    return (int)(count + 0.5);
+}
+
+float WaveGenerator_HealthMultiplier(const WaveConfig& config, int wave)
+{
+    return 1.0f + (wave - 1) * config.health_step;
+}
+
+float WaveGenerator_SpeedMultiplier(const WaveConfig& config, int wave)
+{
+    return std::min(1.0f + (wave - 1) * config.speed_step, config.max_speed_multiplier);
+}
+
+// Índice da célula livre que contém (x, z), ou -1
+static int FreeCell(const FreeSpaceGrid& grid, float x, float z)
+{
+    int cell_x = (int)floorf((x - grid.origin_x) / FREE_SPACE_CELL_SIZE);
+    int cell_z = (int)floorf((z - grid.origin_z) / FREE_SPACE_CELL_SIZE);
+    if (cell_x < 0 || cell_x >= grid.cells_x || cell_z < 0 || cell_z >= grid.cells_z)
+        return -1;
+    int cell = cell_z * grid.cells_x + cell_x;
+    return grid.free_cells[cell] ? cell : -1;
+}
+
+static void CellCenter(const FreeSpaceGrid& grid, int cell, float& x, float& z)
+{
+    x = grid.origin_x + (cell % grid.cells_x + 0.5f) * FREE_SPACE_CELL_SIZE;
+    z = grid.origin_z + (cell / grid.cells_x + 0.5f) * FREE_SPACE_CELL_SIZE;
+}
+
+// Posição de spawn para o ponto (x, z): o próprio ponto (dentro do mapa) se
+// a célula dele é livre, ou o centro da célula livre mais próxima. A busca
+// anda em quadrados cada vez maiores em volta da célula; no primeiro
+// quadrado com células livres fica a mais perto do ponto.
+static glm::vec4 SnapToFree(const FreeSpaceGrid& grid, float x, float z, float y)
+{
+    x = glm::clamp(x, MAP_MIN_X + WAVE_MAP_MARGIN, MAP_MAX_X - WAVE_MAP_MARGIN);
+    z = glm::clamp(z, MAP_MIN_Z + WAVE_MAP_MARGIN, MAP_MAX_Z - WAVE_MAP_MARGIN);
+    if (grid.free_cells.empty() || FreeCell(grid, x, z) >= 0)
+        return glm::vec4(x, y, z, 1.0f);
+
+    int cell_x = (int)floorf((x - grid.origin_x) / FREE_SPACE_CELL_SIZE);
+    int cell_z = (int)floorf((z - grid.origin_z) / FREE_SPACE_CELL_SIZE);
+    for (int radius = 1; radius <= WAVE_SNAP_MAX_RADIUS; ++radius)
+    {
+        int best = -1;
+        float best_distance = 0.0f;
+        for (int dz = -radius; dz <= radius; ++dz)
+        {
+            for (int dx = -radius; dx <= radius; ++dx)
+            {
+                if (std::max(abs(dx), abs(dz)) != radius)
+                    continue; // Só a borda do quadrado
+                int nx = cell_x + dx;
+                int nz = cell_z + dz;
+                if (nx < 0 || nx >= grid.cells_x || nz < 0 || nz >= grid.cells_z)
+                    continue;
+                int cell = nz * grid.cells_x + nx;
+                if (!grid.free_cells[cell])
+                    continue;
+
+                float center_x, center_z;
+                CellCenter(grid, cell, center_x, center_z);
+                float distance = (center_x - x) * (center_x - x) + (center_z - z) * (center_z - z);
+                if (best < 0 || distance < best_distance)
+                {
+                    best = cell;
+                    best_distance = distance;
+                }
+            }
+        }
+        if (best >= 0)
+        {
+            CellCenter(grid, best, x, z);
+            break;
+        }
+    }
+    return glm::vec4(x, y, z, 1.0f);
+}
+
+// Anéis em volta do jogador: o primeiro a spawn_distance, com até 2 pi r /
+// WAVE_RING_SPACING inimigos, e os seguintes cada vez mais longe
+static void RingPositions(const WaveConfig& config, int count, const FreeSpaceGrid& grid,
+                          const glm::vec4& player, float y, std::vector<glm::vec4>& positions)
+{
+    float radius = config.spawn_distance;
+    for (int placed = 0; placed < count; radius += WAVE_RING_SPACING)
+    {
+        int capacity = std::max(1, (int)(2.0f * WAVE_GENERATOR_PI * radius / WAVE_RING_SPACING));
+        int in_ring = std::min(capacity, count - placed);
+        for (int i = 0; i < in_ring; i++)
+        {
+            float angle = (2.0f * WAVE_GENERATOR_PI * i) / in_ring;
+            positions.push_back(SnapToFree(grid, player.x + radius * cos(angle), player.z + radius * sin(angle), y));
+        }
+        placed += in_ring;
+    }
+}
+
+void WaveGenerator_SpawnPositions(const WaveConfig& config, int count, const FreeSpaceGrid& free_space,
+                                  const glm::vec4& player, float y, RandomStream& rng,
+                                  std::vector<glm::vec4>& positions)
+{
+    positions.clear();
+    if (count <= 0)
+        return;
+    positions.reserve(count);
+
+    // Células livres a pelo menos spawn_distance do jogador, para as
+    // formações espalhadas pelo mapa. O vetor é reutilizado entre as waves
+    // (um por thread: SimulationBatch_Step() cria waves em paralelo).
+    static thread_local std::vector<int> candidates;
+    candidates.clear();
+    if (config.formation != WAVE_FORMATION_RING)
+    {
+        float min_distance_sq = config.spawn_distance * config.spawn_distance;
+        for (size_t cell = 0; cell < free_space.free_cells.size(); ++cell)
+        {
+            if (!free_space.free_cells[cell])
+                continue;
+            float x, z;
+            CellCenter(free_space, (int)cell, x, z);
+            if ((x - player.x) * (x - player.x) + (z - player.z) * (z - player.z) >= min_distance_sq)
+                candidates.push_back((int)cell);
+        }
+    }
+
+    if (config.formation == WAVE_FORMATION_RING || candidates.empty())
+    {
+        RingPositions(config, count, free_space, player, y, positions);
+        return;
+    }
+
+    const float jitter = FREE_SPACE_CELL_SIZE * 0.45f; // Continua dentro da célula
+    if (config.formation == WAVE_FORMATION_SCATTER)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            float x, z;
+            CellCenter(free_space, candidates[rng.NextBelow((uint32_t)candidates.size())], x, z);
+            x += rng.NextFloat(-jitter, jitter);
+            z += rng.NextFloat(-jitter, jitter);
+            positions.push_back(glm::vec4(x, y, z, 1.0f));
+        }
+        return;
+    }
+
+    // WAVE_FORMATION_CLUSTERS: cada grupo ocupa um disco com área
+    // proporcional ao número de inimigos
+    int num_clusters = std::max(1, std::min(config.num_clusters, count));
+    for (int c = 0; c < num_clusters; ++c)
+    {
+        float center_x, center_z;
+        CellCenter(free_space, candidates[rng.NextBelow((uint32_t)candidates.size())], center_x, center_z);
+
+        int members = count / num_clusters + (c < count % num_clusters ? 1 : 0);
+        float radius = std::max(1.0f, sqrtf((float)members) * WAVE_RING_SPACING * 0.5f);
+        for (int i = 0; i < members; ++i)
+        {
+            float angle = rng.NextFloat(0.0f, 2.0f * WAVE_GENERATOR_PI);
+            float distance = radius * sqrtf(rng.NextFloat(0.0f, 1.0f)); // Uniforme no disco
+            positions.push_back(SnapToFree(free_space, center_x + distance * cos(angle),
+                                           center_z + distance * sin(angle), y));
+        }
+    }
+}
+
+// vim: set spell spelllang=pt_br :